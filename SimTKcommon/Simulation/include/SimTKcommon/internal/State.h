@@ -39,6 +39,8 @@ done in a separate internal class. **/
 #include <algorithm>
 #include <mutex>
 #include <array>
+#include <atomic>
+#include <memory>
 
 namespace SimTK {
 
@@ -288,6 +290,9 @@ State();
 /// source %State, copying only state variables and not the cache. If the source
 /// state hasn't been realized to at least Stage::Model, then we don't copy its
 /// state variables either, except those associated with the Topology stage.
+/// Discrete variable values are shared with the source until one of the two
+/// States writes to them (see getDiscreteVariable() for what that means for
+/// references you are holding); the continuous variables are always copied.
 State(const State&);
 
 /// The move constructor is very fast. The source object is left empty.
@@ -574,7 +579,15 @@ getDiscreteVarInvalidatesStage(SubsystemIndex, DiscreteVariableIndex) const;
 
 
 /** Get the current value of the indicated discrete variable. This requires
-only that the variable has already been allocated and will fail otherwise. **/
+only that the variable has already been allocated and will fail otherwise.
+
+The returned reference is valid only until the next write access to the same
+variable in this %State (updDiscreteVariable(), setDiscreteVariable(), or an
+auto-update swap). A copy of a %State shares its values with the original
+until one of them is written, and the first write gives the written %State
+its own value object, so after such a write an old reference no longer shows
+this %State's value and may be left dangling. Get a new reference after
+writing instead of keeping one across the write. **/
 inline const AbstractValue& 
 getDiscreteVariable(SubsystemIndex, DiscreteVariableIndex) const;
 /** Return the time of last update for this discrete variable. **/
@@ -740,7 +753,9 @@ getCacheEntryAllocationStage(SubsystemIndex, CacheEntryIndex) const;
 /** Retrieve a const reference to the value contained in a particular cache 
 entry. The value must be up to date with respect to the state variables it 
 depends on or this will throw an exception. No calculation will be 
-performed here.
+performed here. As for getDiscreteVariable(), the returned reference must
+not be used after a write access to the same entry through updCacheEntry() or
+updDiscreteVarUpdateValue().
 @see updCacheEntry()
 @see allocateCacheEntry(), isCacheValueRealized(), markCacheValueRealized() **/
 inline const AbstractValue& 
@@ -149,6 +149,80 @@ private:
 // to do that explicitly in the higher-level destructor or you'll have a nasty
 // leak.
 
+//==============================================================================
+//                           SHARED STATE VALUE
+//==============================================================================
+/* This is a copy-on-write holder for the AbstractValue of a discrete variable
+or cache entry. Copying a holder just shares the value object, so copying a
+State doesn't have to clone every value it contains. The object is cloned when
+a holder that is sharing it asks for write access; after that the holder has
+its own copy and write access is free.
+
+Note that a reference obtained with get() before the first upd() after a copy
+continues to refer to the shared object, not to the holder's new private one.
+It no longer shows this holder's value, and it dangles as soon as the other
+holders let go of the shared object, so a reference from get() must not be
+used after an upd() on the same holder. The public State accessors document
+the same rule.
+
+Only discrete variable and cache entry values are shared this way. The
+continuous variables (q, u, z) and the other State Vectors are still copied
+elementwise with the State, since subsystems hold views into them.
+
+Different States that share values may be read and written in different 
+threads. The reference count is released with release-acquire ordering and 
+read with acquire ordering, so a holder that finds it is the only remaining
+owner sees all accesses made through the other holders before they let go, 
+and can safely write in place. As for any object, a single State must not be
+written in one thread while it is being read or copied in another. */
+class SharedStateValue {
+public:
+    SharedStateValue() = default;
+    explicit SharedStateValue(AbstractValue* v) 
+    :   m_rep(v ? new Rep(v) : nullptr) {}
+
+    // Copying is shallow, sharing the value.
+    SharedStateValue(const SharedStateValue& src) : m_rep(src.m_rep) 
+    {   if (m_rep) m_rep->refs.fetch_add(1, std::memory_order_relaxed); }
+    SharedStateValue(SharedStateValue&& src) : m_rep(src.m_rep) 
+    {   src.m_rep = nullptr; }
+    SharedStateValue& operator=(SharedStateValue src) 
+    {   swap(src); return *this; }
+    ~SharedStateValue() {reset();}
+
+    bool isEmpty() const {return !m_rep;}
+    bool isShared() const 
+    {   return m_rep && m_rep->refs.load(std::memory_order_acquire) > 1; }
+
+    const AbstractValue& get() const {assert(m_rep); return *m_rep->value;}
+    AbstractValue& upd() {
+        assert(m_rep);
+        if (isShared()) {
+            Rep* mine = new Rep(m_rep->value->clone());
+            reset();
+            m_rep = mine;
+        }
+        return *m_rep->value;
+    }
+
+    void reset() {
+        if (m_rep && m_rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete m_rep;
+        m_rep = nullptr;
+    }
+    void swap(SharedStateValue& other) {std::swap(m_rep, other.m_rep);}
+
+private:
+    struct Rep {
+        explicit Rep(AbstractValue* v) : refs(1), value(v) {}
+        std::atomic<int>                refs;
+        std::unique_ptr<AbstractValue>  value;
+    };
+    Rep*    m_rep = nullptr;
+};
+
+
+
 //==============================================================================
 //                           DISCRETE VAR INFO
 //==============================================================================
@@ -163,9 +237,8 @@ public:
 
     // Default copy constructor, copy assignment, destructor are shallow.
 
-    // Use this to make this entry contain a *copy* of the source value.
-    // If the destination already has a value, the new value must be
-    // assignment compatible.
+    // Use this to make this entry contain a *copy* of the source value. The
+    // value is shared with the source until one of them is written.
     DiscreteVarInfo& deepAssign(const DiscreteVarInfo& src) {
         *this = src; // copy assignment forgets dependents
         return *this;
@@ -179,24 +252,23 @@ public:
     const Stage& getAllocationStage()  const {return m_allocationStage;}
 
     // Exchange value pointers (should be from this dv's update cache entry).
-    void swapValue(Real updTime, ClonePtr<AbstractValue>& other) 
+    void swapValue(Real updTime, SharedStateValue& other) 
     {   m_value.swap(other); m_timeLastUpdated=updTime; }
 
-    const AbstractValue& getValue() const {assert(m_value); return *m_value;}
+    const AbstractValue& getValue() const {return m_value.get();}
 
     // Whenever we hand out this variables value for write access we update
     // the value version, note the update time, and notify any dependents that
     // they are now invalid with respect to this variable's value.
     AbstractValue& updValue(const StateImpl& stateImpl, Real updTime) {
-       assert(m_value); 
        ++m_valueVersion;
        m_timeLastUpdated=updTime; 
        m_dependents.notePrerequisiteChange(stateImpl);
-       return *m_value; 
+       return m_value.upd(); 
     }
     ValueVersion getValueVersion() const {return m_valueVersion;}
     Real getTimeLastUpdated() const 
-    {   assert(m_value); return m_timeLastUpdated; }
+    {   assert(!m_value.isEmpty()); return m_timeLastUpdated; }
 
     const Stage&    getInvalidatedStage() const {return m_invalidatedStage;}
     CacheEntryIndex getAutoUpdateEntry()  const {return m_autoUpdateEntry;}
@@ -218,7 +290,7 @@ private:
     ResetOnCopy<ListOfDependents>   m_dependents;
 
     // These change at run time.
-    ClonePtr<AbstractValue>         m_value;
+    SharedStateValue                m_value;
     ValueVersion                    m_valueVersion{1};
     Real                            m_timeLastUpdated{NaN};
 
@@ -226,7 +298,7 @@ private:
     {    return (m_allocationStage==Stage::Topology 
                  || m_allocationStage==Stage::Model)
              && (m_invalidatedStage > m_allocationStage)
-             && (m_value != nullptr); }
+             && !m_value.isEmpty(); }
 };
 
 
@@ -331,7 +403,8 @@ public:
         m_dependents.notePrerequisiteChange(stateImpl);
     }
 
-    // Use this to make this entry contain a *copy* of the source value.
+    // Use this to make this entry contain a *copy* of the source value. The
+    // value is shared with the source until one of them is written.
     CacheEntryInfo& deepAssign(const CacheEntryInfo& src) {
         *this = src; // copy assignment forgets dependents
         return *this;
@@ -351,7 +424,7 @@ public:
     void swapValue(Real updTime, DiscreteVarInfo& dv) 
     {   dv.swapValue(updTime, m_value); }
 
-    const AbstractValue& getValue() const {assert(m_value); return *m_value;}
+    const AbstractValue& getValue() const {return m_value.get();}
 
     // Merely handing out the cache entry's value with write access does not
     // trigger invalidation of dependents. (Maybe it should, but currently it
@@ -359,9 +432,10 @@ public:
     // So be sure that the cache entry gets invalidated first either by an
     // explicit prerequisite change notification, or because the depends-on
     // stage got invalidated.
-    AbstractValue& updValue(const StateImpl& stateImpl) {
-       assert(m_value); 
-       return *m_value; 
+    // If the value is shared with a copy of this State, this is where it gets
+    // cloned.
+    AbstractValue& updValue() {
+       return m_value.upd(); 
     }
     ValueVersion getValueVersion() const {return m_valueVersion;}
 
@@ -424,7 +498,7 @@ private:
     // prerequisites so we are up to date with respect to them. We'll change
     // the initial value to false in registerWithPrerequisites() if there
     // are some.
-    ClonePtr<AbstractValue>     m_value;
+    SharedStateValue            m_value;
     ValueVersion                m_valueVersion{1};
     StageVersion                m_dependsOnVersionWhenLastComputed{0};
     bool                        m_isUpToDateWithPrerequisites{true};
@@ -445,7 +519,7 @@ private:
                 || m_allocationStage==Stage::Model
                 || m_allocationStage==Stage::Instance)
             && (m_computedByStage >= m_dependsOnStage)
-            && (m_value != nullptr)
+            && !m_value.isEmpty()
             && (m_dependsOnVersionWhenLastComputed >= 0)
             && (ListOfDependents::isCacheEntryKeyValid(m_myKey)); 
     }
@@ -2020,7 +2094,7 @@ public:
     // allocated. This does not affect the stage.
     AbstractValue& 
     updCacheEntry(const CacheEntryKey& ck) const {
-        return updCacheEntryInfo(ck).updValue(*this);
+        return updCacheEntryInfo(ck).updValue();
     }
 
     bool isCacheValueRealized(const CacheEntryKey& ck) const {
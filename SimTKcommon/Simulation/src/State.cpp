@@ -172,7 +172,9 @@ bool State::isConsistent(const SimTK::State& otherState) const {
 // The methods are templatized and expect the stacks to be in Arrays
 // of the same template. The template value must be a type that supports
 // three methods (the template analog to virtual functions):
-//      deepAssign()            a non-shallow assignment, i.e. clone the value
+//      deepAssign()            a non-shallow assignment, i.e. copy the value
+//                              (discrete variable and cache entry values are
+//                              shared copy-on-write; see SharedStateValue)
 //      deepDestruct()          destroy any owned heap space
 //      getAllocationStage()    return the stage being worked on when this was 
 //                              allocated
@@ -95,6 +95,7 @@
 #include "SimTKcommon/internal/Mat.h"
 #include "SimTKcommon/internal/SymMat.h"
 #include "SimTKcommon/internal/SmallMatrixMixed.h"
+#include "SimTKcommon/internal/SmallMatrixSIMD.h"
 
 // Friendly abbreviations.
 namespace SimTK {
@@ -0,0 +1,186 @@
+#ifndef SimTK_SIMMATRIX_SMALLMATRIX_SIMD_H_
+#define SimTK_SIMMATRIX_SMALLMATRIX_SIMD_H_
+
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/**@file
+ * This file provides hand-vectorized versions of the handful of fixed-size,
+ * double precision small matrix operations that dominate multibody
+ * computations: 3x3 matrix times 3-vector, 3x3 matrix products, symmetric
+ * 3x3 matrix times 3-vector, 3- and 4-vector dot products and 6x6 spatial
+ * matrix times spatial vector. They are ordinary non-template
+ * overloads so they are preferred over the generic templates in Mat.h and
+ * SmallMatrixMixed.h for exactly these types (with default, packed strides)
+ * and everything built from them, such as SpatialMat products, picks them up
+ * automatically.
+ *
+ * Each kernel performs the same multiplies and adds in the same order as the
+ * generic template code and never fuses a multiply with an add, so results
+ * are bitwise identical to the generic code's as long as the compiler is not
+ * permitted to contract the generic code's multiply-adds into FMA
+ * instructions (for example when building with -mfma); only the number of
+ * instructions changes. TestSmallMatrix checks this exactly. SSE2 is used on
+ * any x86 target that supports it (always true for 64 bit builds) and the
+ * 3-vector kernels use 256-bit AVX when the compiler is permitted to (see the
+ * BUILD_INST_SET CMake variable).
+ * Elsewhere, or if SimTK_SMALLMATRIX_NO_SIMD is defined before including
+ * this file, none of this is compiled and the generic templates are used.
+ */
+
+#if !defined(SimTK_SMALLMATRIX_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define SimTK_SMALLMATRIX_USE_SSE2
+    #include <emmintrin.h>
+    #if defined(__AVX__)
+        #define SimTK_SMALLMATRIX_USE_AVX
+        #include <immintrin.h>
+    #endif
+#endif
+
+#ifdef SimTK_SMALLMATRIX_USE_SSE2
+
+namespace SimTK {
+
+/** @cond **/ // Hide from Doxygen; these are just faster overloads.
+namespace SIMD {
+
+#ifdef SimTK_SMALLMATRIX_USE_AVX
+// Lanes 0-2 of a 256-bit register hold a 3-vector; lane 3 is never touched
+// in memory.
+inline __m256i mask3() {return _mm256_set_epi64x(0, -1, -1, -1);}
+inline __m256d load3(const double* p) {return _mm256_maskload_pd(p, mask3());}
+inline void store3(double* p, __m256d x) {_mm256_maskstore_pd(p, mask3(), x);}
+#endif
+
+// r = c0*v0 + c1*v1 + c2*v2 for 3-element columns c0,c1,c2 stored
+// consecutively starting at c. This is the packed 3x3 matrix times vector.
+inline void mat33TimesVec3(const double* c, const double* v, double* r) {
+#ifdef SimTK_SMALLMATRIX_USE_AVX
+    __m256d sum = _mm256_mul_pd(load3(c), _mm256_broadcast_sd(v));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(load3(c+3),
+                                           _mm256_broadcast_sd(v+1)));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(load3(c+6),
+                                           _mm256_broadcast_sd(v+2)));
+    store3(r, sum);
+#else
+    const __m128d v0 = _mm_set1_pd(v[0]), v1 = _mm_set1_pd(v[1]),
+                  v2 = _mm_set1_pd(v[2]);
+    __m128d top = _mm_mul_pd(_mm_loadu_pd(c), v0);
+    top = _mm_add_pd(top, _mm_mul_pd(_mm_loadu_pd(c+3), v1));
+    top = _mm_add_pd(top, _mm_mul_pd(_mm_loadu_pd(c+6), v2));
+    _mm_storeu_pd(r, top);
+    r[2] = c[2]*v[0] + c[5]*v[1] + c[8]*v[2];
+#endif
+}
+
+// r += c0*v0 + c1*v1 + c2*v2, added term by term to r in that order.
+inline void addMat33TimesVec3(const double* c, const double* v, double* r) {
+#ifdef SimTK_SMALLMATRIX_USE_AVX
+    __m256d prod = _mm256_mul_pd(load3(c), _mm256_broadcast_sd(v));
+    prod = _mm256_add_pd(prod, _mm256_mul_pd(load3(c+3),
+                                             _mm256_broadcast_sd(v+1)));
+    prod = _mm256_add_pd(prod, _mm256_mul_pd(load3(c+6),
+                                             _mm256_broadcast_sd(v+2)));
+    store3(r, _mm256_add_pd(load3(r), prod));
+#else
+    double prod[3];
+    mat33TimesVec3(c, v, prod);
+    _mm_storeu_pd(r, _mm_add_pd(_mm_loadu_pd(r), _mm_loadu_pd(prod)));
+    r[2] += prod[2];
+#endif
+}
+
+// Return a0*b0 + a1*b1 (the first two terms of a dot product).
+inline double dot2(const double* a, const double* b) {
+    const __m128d p = _mm_mul_pd(_mm_loadu_pd(a), _mm_loadu_pd(b));
+    return _mm_cvtsd_f64(_mm_add_sd(p, _mm_unpackhi_pd(p, p)));
+}
+
+} // namespace SIMD
+/** @endcond **/
+
+// 3x3 * 3-vector
+inline Vec<3,double>
+operator*(const Mat<3,3,double>& m, const Vec<3,double>& v) {
+    Vec<3,double> result;
+    SIMD::mat33TimesVec3(&m(0,0), &v[0], &result[0]);
+    return result;
+}
+
+// 3x3 * 3x3; each result column is the left matrix times a right column.
+inline Mat<3,3,double>
+operator*(const Mat<3,3,double>& l, const Mat<3,3,double>& r) {
+    Mat<3,3,double> result;
+    for (int j=0; j < 3; ++j)
+        SIMD::mat33TimesVec3(&l(0,0), &r(0,j), &result(0,j));
+    return result;
+}
+
+// Symmetric 3x3 * 3-vector. SymMat stores the diagonal followed by the
+// lower triangle by columns: d0 d1 d2 l10 l20 l21.
+inline Vec<3,double>
+operator*(const SymMat<3,double>& m, const Vec<3,double>& v) {
+    const double* d = &m.getDiag()[0];
+    const double* l = &m.getLower()[0];
+    // Rows 0 and 1 together, then row 2.
+    __m128d top = _mm_mul_pd(_mm_set_pd(l[0], d[0]), _mm_set1_pd(v[0]));
+    top = _mm_add_pd(top, _mm_mul_pd(_mm_set_pd(d[1], l[0]),
+                                     _mm_set1_pd(v[1])));
+    top = _mm_add_pd(top, _mm_mul_pd(_mm_set_pd(l[2], l[1]),
+                                     _mm_set1_pd(v[2])));
+    Vec<3,double> result;
+    _mm_storeu_pd(&result[0], top);
+    result[2] = l[1]*v[0] + l[2]*v[1] + d[2]*v[2];
+    return result;
+}
+
+// 3-vector and 4-vector dot products.
+inline double dot(const Vec<3,double>& a, const Vec<3,double>& b) {
+    return SIMD::dot2(&a[0], &b[0]) + a[2]*b[2];
+}
+inline double dot(const Vec<4,double>& a, const Vec<4,double>& b) {
+    const __m128d lo = _mm_mul_pd(_mm_loadu_pd(&a[0]), _mm_loadu_pd(&b[0]));
+    const double sum = _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    return (sum + a[2]*b[2]) + a[3]*b[3];
+}
+
+// 6x6 spatial matrix * spatial vector. The blocks of a Mat<2,2,Mat33> are
+// packed by columns: (0,0), (1,0), (0,1), (1,1).
+inline Vec<2,Vec<3,double> >
+operator*(const Mat<2,2,Mat<3,3,double> >& m, const Vec<2,Vec<3,double> >& v){
+    const double* b = &m(0,0)(0,0);
+    Vec<2,Vec<3,double> > result;
+    SIMD::mat33TimesVec3   (b,    &v[0][0], &result[0][0]); // M00*v0
+    SIMD::addMat33TimesVec3(b+18, &v[1][0], &result[0][0]); //   + M01*v1
+    SIMD::mat33TimesVec3   (b+9,  &v[0][0], &result[1][0]); // M10*v0
+    SIMD::addMat33TimesVec3(b+27, &v[1][0], &result[1][0]); //   + M11*v1
+    return result;
+}
+
+} // namespace SimTK
+
+#endif // SimTK_SMALLMATRIX_USE_SSE2
+
+#endif // SimTK_SIMMATRIX_SMALLMATRIX_SIMD_H_
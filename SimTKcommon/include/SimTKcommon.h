@@ -53,6 +53,7 @@
 #include "SimTKcommon/internal/ParallelExecutor.h"
 #include "SimTKcommon/internal/Parallel2DExecutor.h"
 #include "SimTKcommon/internal/ParallelWorkQueue.h"
+#include "SimTKcommon/internal/ScratchArena.h"
 #include "SimTKcommon/internal/Pathname.h"
 #include "SimTKcommon/internal/Plugin.h"
 #include "SimTKcommon/internal/Timing.h"
@@ -0,0 +1,221 @@
+#ifndef SimTK_SimTKCOMMON_SCRATCH_ARENA_H_
+#define SimTK_SimTKCOMMON_SCRATCH_ARENA_H_
+
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon/internal/common.h"
+#include "SimTKcommon/internal/Array.h"
+#include "SimTKcommon/internal/BigMatrix.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace SimTK {
+
+/** This is a stack-like region of memory used for short-lived temporaries in
+computational hot spots, so that the storage for those temporaries is reused
+from call to call rather than taken from the heap each time.
+
+Memory is handed out from large chunks by bumping a pointer. You don't free
+individual allocations; instead you note the arena's current position with
+a Scope object (or with getMark()) and everything allocated after that point
+is released at once when the Scope is destructed (or when you call
+rewind()). Chunks are never returned to the heap until the arena itself is
+destructed, so once an arena has grown large enough for the work it is
+used for, the arena itself stops allocating. The number of times an arena
+had to go to the heap is available from getNumHeapAllocations(), which is how
+you can verify that a steady-state calculation has stopped growing its
+arena; it does not show that the calculation as a whole is free of heap
+allocation. That count covers only the arena's own chunks; other heap activity in
+the same calculation, such as the handles of the Vector_ and Matrix_ views 
+described below, is not included.
+
+Every thread has its own arena, obtained with getThreadArena(), so code that
+runs on worker threads can use scratch space without locking. An arena
+must not be shared among threads.
+
+The allocateVector(), allocateMatrix(), and allocateArray() methods return
+fixed-size views of arena memory. They can be used anywhere a Vector_,
+Matrix_ or Array_ is expected as long as nothing tries to resize them, and
+they must not outlive the Scope in which they were allocated. Note that
+constructing a Vector_ or Matrix_ view still allocates its small handle;
+only the element storage comes from the arena.
+
+@code
+void calcSomething(int n) {
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scope(arena);
+    Vector tmp = arena.allocateVector<Real>(n);
+    ...
+} // tmp's space is released here
+@endcode **/
+class SimTK_SimTKCOMMON_EXPORT ScratchArena {
+public:
+    class Scope;
+
+    /** A position in an arena, obtained with getMark() and passed later to
+    rewind(). **/
+    struct Mark {
+        int         chunk;
+        std::size_t offset;
+    };
+
+    /** Create an empty arena. No memory is allocated until the first
+    request for scratch space. **/
+    ScratchArena() = default;
+    ~ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /** Return the arena belonging to the calling thread, creating it on
+    first use. **/
+    static ScratchArena& getThreadArena();
+
+    /** Obtain uninitialized space for `nBytes` bytes with the given
+    alignment, which must be a power of 2 no larger than that of
+    std::max_align_t. **/
+    void* allocateBytes(std::size_t nBytes,
+                        std::size_t alignment = alignof(std::max_align_t)) {
+        assert(alignment && (alignment & (alignment-1)) == 0);
+        if (m_current < (int)m_chunks.size()) {
+            Chunk& c = m_chunks[m_current];
+            const std::size_t start = (m_offset + alignment-1) & ~(alignment-1);
+            if (start + nBytes <= c.size) {
+                m_offset = start + nBytes;
+                return c.data + start;
+            }
+        }
+        return allocateFromNextChunk(nBytes);
+    }
+
+    /** Obtain space for `n` default-initialized objects of type T. Their
+    destructors are never called, so T must be trivially destructible. **/
+    template <class T>
+    T* allocate(int n) {
+        static_assert(std::is_trivially_destructible<T>::value,
+            "ScratchArena can only hold trivially destructible types.");
+        SimTK_SIZECHECK_NONNEG(n, "ScratchArena::allocate()");
+        T* p = static_cast<T*>(allocateBytes(n*sizeof(T), alignof(T)));
+        for (int i=0; i < n; ++i)
+            new (p+i) T;
+        return p;
+    }
+
+    /** Return a Vector_ of length `m` whose elements live in this arena. The
+    element values are uninitialized if ELT is a built-in type; otherwise
+    they are default-constructed, which for SimTK numerical types means
+    NaN in Debug builds. **/
+    template <class ELT>
+    Vector_<ELT> allocateVector(int m) {
+        ELT* data = allocate<ELT>(m);
+        return Vector_<ELT>(m, reinterpret_cast<typename CNT<ELT>::Scalar*>
+                                    (data), true);
+    }
+
+    /** Same as allocateVector(m) but with all elements set to `init`. **/
+    template <class ELT>
+    Vector_<ELT> allocateVector(int m, const ELT& init) {
+        ELT* data = allocate<ELT>(m);
+        std::fill(data, data+m, init);
+        return Vector_<ELT>(m, reinterpret_cast<typename CNT<ELT>::Scalar*>
+                                    (data), true);
+    }
+
+    /** Return an m X n Matrix_ whose elements live in this arena, stored
+    by columns. **/
+    template <class ELT>
+    Matrix_<ELT> allocateMatrix(int m, int n) {
+        SimTK_SIZECHECK_NONNEG(n, "ScratchArena::allocateMatrix()");
+        typedef typename CNT<ELT>::Scalar S;
+        const int cppNScalarsPerElt = (int)(sizeof(ELT)/sizeof(S));
+        S* data = reinterpret_cast<S*>(allocate<ELT>(m*n));
+        return Matrix_<ELT>(m, n, m*cppNScalarsPerElt, data);
+    }
+
+    /** Return an Array_ of `n` default-initialized elements that live in
+    this arena. The Array_ can't be resized. **/
+    template <class T, class X=unsigned>
+    Array_<T,X> allocateArray(int n) {
+        T* data = allocate<T>(n);
+        return Array_<T,X>(data, data+n, DontCopy());
+    }
+
+    /** Return the arena's current position. **/
+    Mark getMark() const {return Mark{m_current, m_offset};}
+
+    /** Release everything allocated since `mark` was obtained. **/
+    void rewind(const Mark& mark) {
+        assert(mark.chunk <= m_current);
+        m_current = mark.chunk;
+        m_offset  = mark.offset;
+    }
+
+    /** Release everything that has been allocated from this arena. The
+    memory is kept for reuse. **/
+    void reset() {m_current = 0; m_offset = 0;}
+
+    /** Return the total number of bytes held by this arena. **/
+    std::size_t getCapacity() const;
+
+    /** Return the number of times this arena has had to allocate heap
+    memory for its chunks since it was created. Allocations made elsewhere,
+    including the handles of views returned by this arena, aren't counted. **/
+    long long getNumHeapAllocations() const {return m_numHeapAllocations;}
+
+private:
+    struct Chunk {
+        char*       data;
+        std::size_t size;
+    };
+
+    void* allocateFromNextChunk(std::size_t nBytes);
+
+    std::vector<Chunk>  m_chunks;
+    int                 m_current = 0;  // index of the chunk in use
+    std::size_t         m_offset = 0;   // first free byte in that chunk
+    long long           m_numHeapAllocations = 0;
+};
+
+/** Construct a Scope on the stack to release everything allocated from an
+arena during the Scope's lifetime when it goes out of scope. **/
+class ScratchArena::Scope {
+public:
+    explicit Scope(ScratchArena& arena)
+    :   m_arena(arena), m_mark(arena.getMark()) {}
+    ~Scope() {m_arena.rewind(m_mark);}
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    ScratchArena&   m_arena;
+    Mark            m_mark;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SimTKCOMMON_SCRATCH_ARENA_H_
@@ -0,0 +1,76 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon/internal/ScratchArena.h"
+
+#include <algorithm>
+
+namespace SimTK {
+
+// The first chunk is big enough for the temporaries of a moderately sized
+// multibody system; after that each new chunk doubles the arena's capacity.
+static const std::size_t MinChunkSize = 64*1024;
+
+ScratchArena::~ScratchArena() {
+    for (Chunk& c : m_chunks)
+        ::operator delete(c.data);
+}
+
+ScratchArena& ScratchArena::getThreadArena() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+std::size_t ScratchArena::getCapacity() const {
+    std::size_t capacity = 0;
+    for (const Chunk& c : m_chunks)
+        capacity += c.size;
+    return capacity;
+}
+
+// The current chunk can't satisfy the request. Move on to the first later
+// chunk that can, or add one to the end if none of them is big enough. Any
+// space we skip over is wasted only until the arena is rewound. Since the
+// chunks are revisited in the same order each time the arena is reused, a
+// calculation that makes the same sequence of requests settles into the same
+// chunks and stops allocating.
+void* ScratchArena::allocateFromNextChunk(std::size_t nBytes) {
+    int next = m_chunks.empty() ? 0 : m_current+1;
+    while (next < (int)m_chunks.size() && m_chunks[next].size < nBytes)
+        ++next;
+
+    if (next == (int)m_chunks.size()) {
+        const std::size_t size = 
+            std::max(std::max(MinChunkSize, nBytes), getCapacity());
+        m_chunks.push_back(Chunk{static_cast<char*>(::operator new(size)), 
+                                 size});
+        ++m_numHeapAllocations;
+    }
+
+    // Chunk data is aligned for any fundamental type.
+    m_current = next;
+    m_offset  = nBytes;
+    return m_chunks[next].data;
+}
+
+} // namespace SimTK
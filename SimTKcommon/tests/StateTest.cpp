@@ -30,6 +30,8 @@
 #include <iostream>
 #include <exception>
 #include <cmath>
+#include <thread>
+#include <vector>
 using std::cout;
 using std::endl;
 using std::string;
@@ -352,6 +354,113 @@ void testCacheValidity() {
 
 }
 
+// Discrete variable and cache entry values are shared between a State and its
+// copy until one of them writes to the value; check that the copies behave
+// as though they had been cloned.
+void testCopyOnWrite() {
+    const SubsystemIndex Sub0(0);
+    State s;
+    s.setNumSubsystems(1);
+    const DiscreteVariableIndex dvx = s.allocateDiscreteVariable(Sub0, 
+        Stage::Position, new Value<int>(1));
+    const DiscreteVariableIndex autox = s.allocateAutoUpdateDiscreteVariable(
+        Sub0, Stage::Velocity, new Value<string>("first"), Stage::Position);
+    const CacheEntryIndex cx = s.allocateCacheEntry(Sub0, Stage::Model, 
+        new Value<Vector>(Vector(1000, Real(1))));
+    for (Stage g = Stage::Topology; g <= Stage::Position; g = g.next())
+        advanceStage(s, g);
+    Value<Vector>::updDowncast(s.updCacheEntry(Sub0, cx)).upd() = Real(2);
+    s.markCacheValueRealized(Sub0, cx);
+
+    // Copying shares the values themselves.
+    State s2(s);
+    SimTK_TEST(&s2.getDiscreteVariable(Sub0, dvx) 
+               == &s.getDiscreteVariable(Sub0, dvx));
+    SimTK_TEST(&s2.getCacheEntry(Sub0, cx) == &s.getCacheEntry(Sub0, cx));
+
+    // Writing to the copy's discrete variable leaves the original alone.
+    Value<int>::updDowncast(s2.updDiscreteVariable(Sub0, dvx)).upd() = 2;
+    SimTK_TEST(Value<int>::downcast(s.getDiscreteVariable(Sub0, dvx)) == 1);
+    SimTK_TEST(Value<int>::downcast(s2.getDiscreteVariable(Sub0, dvx)) == 2);
+    SimTK_TEST(&s2.getDiscreteVariable(Sub0, dvx) 
+               != &s.getDiscreteVariable(Sub0, dvx));
+
+    // Likewise for cache entries, and in either direction.
+    Value<Vector>::updDowncast(s.updCacheEntry(Sub0, cx)).upd()[0] = 3;
+    SimTK_TEST(Value<Vector>::downcast(s.getCacheEntry(Sub0, cx)).get()[0] == 3);
+    SimTK_TEST(Value<Vector>::downcast(s2.getCacheEntry(Sub0, cx)).get()[0] == 2);
+    SimTK_TEST(Value<Vector>::downcast(s2.getCacheEntry(Sub0, cx)).get()[1] == 2);
+
+    // Once a value is private, writing to it again doesn't reallocate.
+    const AbstractValue* cv = &s.getCacheEntry(Sub0, cx);
+    Value<Vector>::updDowncast(s.updCacheEntry(Sub0, cx)).upd()[1] = 4;
+    SimTK_TEST(&s.getCacheEntry(Sub0, cx) == cv);
+
+    // Assignment shares values too.
+    State s3;
+    s3 = s;
+    SimTK_TEST(&s3.getCacheEntry(Sub0, cx) == cv);
+    Value<Vector>::updDowncast(s3.updCacheEntry(Sub0, cx)).upd()[1] = 5;
+    SimTK_TEST(Value<Vector>::downcast(s.getCacheEntry(Sub0, cx)).get()[1] == 4);
+
+    // Auto-update values get swapped into the discrete variable in one State
+    // without disturbing the copy. Copying only keeps stages through
+    // Instance, so the copy has to be realized again to get its own update.
+    Value<string>::updDowncast(s.updDiscreteVarUpdateValue(Sub0, autox)) 
+        = "second";
+    s.markDiscreteVarUpdateValueRealized(Sub0, autox);
+    State s4(s);
+    s.autoUpdateDiscreteVariables();
+    SimTK_TEST(Value<string>::downcast(s.getDiscreteVariable(Sub0, autox)).get()
+               == "second");
+    SimTK_TEST(Value<string>::downcast(s4.getDiscreteVariable(Sub0, autox)).get()
+               == "first");
+    advanceStage(s4, Stage::Time);
+    advanceStage(s4, Stage::Position);
+    Value<string>::updDowncast(s4.updDiscreteVarUpdateValue(Sub0, autox)) 
+        = "third";
+    s4.markDiscreteVarUpdateValueRealized(Sub0, autox);
+    s4.autoUpdateDiscreteVariables();
+    SimTK_TEST(Value<string>::downcast(s4.getDiscreteVariable(Sub0, autox)).get()
+               == "third");
+    SimTK_TEST(Value<string>::downcast(s.getDiscreteVariable(Sub0, autox)).get()
+               == "second");
+}
+
+// Copies of a State that share values may be written in different threads;
+// each must end up with its own value while the original is left alone.
+void testCopiesWrittenConcurrently() {
+    const SubsystemIndex Sub0(0);
+    State s;
+    s.setNumSubsystems(1);
+    const DiscreteVariableIndex dvx = s.allocateDiscreteVariable(Sub0, 
+        Stage::Position, new Value<Vector>(Vector(100, Real(0))));
+    for (Stage g = Stage::Topology; g <= Stage::Position; g = g.next())
+        advanceStage(s, g);
+
+    const int NumCopies = 8;
+    for (int trial=0; trial < 20; ++trial) {
+        std::vector<State> copies(NumCopies, s);
+        std::vector<std::thread> threads;
+        for (int i=0; i < NumCopies; ++i)
+            threads.push_back(std::thread([&copies, i, Sub0, dvx]() {
+                Vector& v = Value<Vector>::updDowncast
+                    (copies[i].updDiscreteVariable(Sub0, dvx)).upd();
+                for (int j=0; j < v.size(); ++j)
+                    v[j] = i+1;
+            }));
+        for (auto& t : threads)
+            t.join();
+        for (int i=0; i < NumCopies; ++i) {
+            const Vector& v = Value<Vector>::downcast
+                (copies[i].getDiscreteVariable(Sub0, dvx)).get();
+            SimTK_TEST_EQ(v, Vector(100, Real(i+1)));
+        }
+        SimTK_TEST_EQ(Value<Vector>::downcast(s.getDiscreteVariable(Sub0, dvx))
+                      .get(), Vector(100, Real(0)));
+    }
+}
+
 void testMisc() {
     State s;
     s.setNumSubsystems(1);
@@ -535,6 +644,8 @@ int main() {
     SimTK_START_TEST("StateTest");
         //SimTK_SUBTEST(testLowestModified);
         SimTK_SUBTEST(testCacheValidity);
+        SimTK_SUBTEST(testCopyOnWrite);
+        SimTK_SUBTEST(testCopiesWrittenConcurrently);
         SimTK_SUBTEST(testMisc);
         SimTK_SUBTEST(testConsistent);
     SimTK_END_TEST();
@@ -0,0 +1,122 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "SimTKcommon/Testing.h"
+
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+using namespace SimTK;
+using std::cout;
+using std::endl;
+
+void testViews() {
+    ScratchArena arena;
+    ScratchArena::Scope scope(arena);
+
+    Vector v = arena.allocateVector<Real>(5, Real(2));
+    SimTK_TEST(v.size() == 5);
+    SimTK_TEST(v.sum() == 10);
+    v[3] = 7;
+    SimTK_TEST(v[3] == 7);
+    v.resize(5); // same size is OK for a view
+    SimTK_TEST_MUST_THROW(v.resize(6));
+
+    Vector_<SpatialVec> sv = arena.allocateVector<SpatialVec>(3);
+    sv = SpatialVec(Vec3(1,2,3), Vec3(4,5,6));
+    SimTK_TEST(sv[2][1] == Vec3(4,5,6));
+    SimTK_TEST((std::uintptr_t)&sv[0] % alignof(SpatialVec) == 0);
+
+    Matrix m = arena.allocateMatrix<Real>(3,4);
+    m = 0;
+    m(2,3) = 1;
+    SimTK_TEST(m.nrow() == 3 && m.ncol() == 4);
+    SimTK_TEST(m.sum().sum() == 1);
+    SimTK_TEST(m(3)[2] == 1);
+
+    Array_<int> a = arena.allocateArray<int>(4);
+    for (int i=0; i < 4; ++i) a[i] = i;
+    SimTK_TEST(a.size() == 4 && a[3] == 3);
+    SimTK_TEST(!a.isOwner());
+}
+
+void testRewind() {
+    ScratchArena arena;
+    SimTK_TEST(arena.getNumHeapAllocations() == 0);
+    SimTK_TEST(arena.getCapacity() == 0);
+
+    {   ScratchArena::Scope scope(arena);
+        Real* p = arena.allocate<Real>(10);
+        ScratchArena::Mark mark = arena.getMark();
+        Real* q = arena.allocate<Real>(10);
+        SimTK_TEST(q >= p+10);
+        arena.rewind(mark);
+        SimTK_TEST(arena.allocate<Real>(10) == q);
+    }
+    SimTK_TEST(arena.getNumHeapAllocations() == 1);
+
+    // Outgrow the first chunk, then repeat the same sequence of requests; the
+    // second time no heap allocation should be needed.
+    const std::size_t chunk = arena.getCapacity();
+    auto work = [&]() {
+        ScratchArena::Scope scope(arena);
+        for (int i=0; i < 5; ++i)
+            arena.allocateBytes(chunk/2 + 8);
+        Vector v = arena.allocateVector<Real>(1000, Real(1));
+        SimTK_TEST(v.sum() == 1000);
+    };
+    work();
+    const long long nAllocs = arena.getNumHeapAllocations();
+    SimTK_TEST(nAllocs > 1);
+    for (int i=0; i < 10; ++i)
+        work();
+    SimTK_TEST(arena.getNumHeapAllocations() == nAllocs);
+
+    // A request larger than any chunk gets a chunk of its own.
+    {   ScratchArena::Scope scope(arena);
+        arena.allocateBytes(10*arena.getCapacity());
+    }
+    SimTK_TEST(arena.getNumHeapAllocations() == nAllocs+1);
+
+    arena.reset();
+    SimTK_TEST(arena.getMark().chunk == 0 && arena.getMark().offset == 0);
+}
+
+void testThreadArenas() {
+    ScratchArena* mine = &ScratchArena::getThreadArena();
+    SimTK_TEST(&ScratchArena::getThreadArena() == mine);
+    ScratchArena* other = nullptr;
+    std::thread t([&]() {other = &ScratchArena::getThreadArena();});
+    t.join();
+    SimTK_TEST(other != mine);
+}
+
+int main() {
+    SimTK_START_TEST("TestScratchArena");
+        SimTK_SUBTEST(testViews);
+        SimTK_SUBTEST(testRewind);
+        SimTK_SUBTEST(testThreadArenas);
+    SimTK_END_TEST();
+}
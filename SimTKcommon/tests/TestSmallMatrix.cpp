@@ -485,6 +485,89 @@ void testAppendRowCol() {
 
 }
 
+// The common 3x3, 3-vector and spatial operations may be done with
+// hand-vectorized kernels (see SmallMatrixSIMD.h); check them against
+// element-by-element calculations.
+// The hand-vectorized kernels in SmallMatrixSIMD.h promise to produce
+// bitwise the same results as the generic templates, so the references here
+// are computed with scalar code doing the same operations in the same order
+// and compared exactly. If the compiler is allowed to fuse multiplies and
+// adds, the scalar references may be rounded differently, so we can only
+// check them to within a tolerance.
+#if defined(__FMA__) || defined(__FMA4__)
+    #define SIMD_KERNEL_TEST_EQ(a,b) SimTK_TEST_EQ(a,b)
+#else
+    #define SIMD_KERNEL_TEST_EQ(a,b) SimTK_TEST((a)==(b))
+#endif
+
+// r = m*v, summing each row left to right.
+static Vec3 refMat33TimesVec3(const Mat33& m, const Vec3& v) {
+    Vec3 r;
+    for (int i=0; i < 3; ++i)
+        r[i] = m(i,0)*v[0] + m(i,1)*v[1] + m(i,2)*v[2];
+    return r;
+}
+
+// r = m*n, one reference matrix-vector product per column of n.
+static Mat33 refMat33TimesMat33(const Mat33& m, const Mat33& n) {
+    Mat33 r;
+    for (int j=0; j < 3; ++j)
+        r(j) = refMat33TimesVec3(m, n(j));
+    return r;
+}
+
+void testSIMDKernels() {
+    for (int trial=0; trial < 10; ++trial) {
+        const Mat33 m = Test::randMat33(), m2 = Test::randMat33();
+        const Vec3 v = Test::randVec3(), w = Test::randVec3();
+        const SymMat33 sym = Test::randSymMat<3>();
+        const Vec4 a4 = Test::randVec<4>(), b4 = Test::randVec<4>();
+
+        Mat33 symFull;
+        for (int i=0; i < 3; ++i)
+            for (int j=0; j < 3; ++j)
+                symFull(i,j) = i >= j ? sym(i,j) : sym(j,i);
+
+        SIMD_KERNEL_TEST_EQ(m*v, refMat33TimesVec3(m, v));
+        SIMD_KERNEL_TEST_EQ(sym*v, refMat33TimesVec3(symFull, v));
+        SIMD_KERNEL_TEST_EQ(m*m2, refMat33TimesMat33(m, m2));
+        SIMD_KERNEL_TEST_EQ(dot(v,w), v[0]*w[0] + v[1]*w[1] + v[2]*w[2]);
+        SIMD_KERNEL_TEST_EQ(dot(a4,b4), 
+                            a4[0]*b4[0] + a4[1]*b4[1] + a4[2]*b4[2] 
+                            + a4[3]*b4[3]);
+
+        // A spatial matrix times a spatial vector is formed block by block,
+        // M(i,0)*v[0] + M(i,1)*v[1].
+        const SpatialMat S = Test::randSpatialMat();
+        const SpatialVec sv = Test::randSpatialVec();
+        SpatialVec Ssv;
+        for (int i=0; i < 2; ++i)
+            Ssv[i] = refMat33TimesVec3(S(i,0), sv[0]) 
+                     + refMat33TimesVec3(S(i,1), sv[1]);
+        SIMD_KERNEL_TEST_EQ(S*sv, Ssv);
+
+        // Products of spatial matrices are built from the Mat33 products.
+        SpatialMat SS;
+        for (int i=0; i < 2; ++i)
+            for (int j=0; j < 2; ++j)
+                SS(i,j) = refMat33TimesMat33(S(i,0), S(0,j))
+                          + refMat33TimesMat33(S(i,1), S(1,j));
+        SIMD_KERNEL_TEST_EQ(S*S, SS);
+
+        // And the results must still be the mathematically correct ones.
+        Matrix Sbig(6,6);
+        for (int i=0; i < 6; ++i)
+            for (int j=0; j < 6; ++j)
+                Sbig(i,j) = S(i/3,j/3)(i%3,j%3);
+        Vector svbig(6);
+        for (int i=0; i < 6; ++i) svbig[i] = sv[i/3][i%3];
+        const Vector SsvBig = Sbig*svbig;
+        const SpatialVec result = S*sv;
+        for (int i=0; i < 6; ++i)
+            SimTK_TEST_EQ(result[i/3][i%3], SsvBig[i]);
+    }
+}
+
 int main() {
     SimTK_START_TEST("TestSmallMatrix");
         SimTK_SUBTEST(testSymMat);
@@ -498,5 +581,6 @@ int main() {
         SimTK_SUBTEST(testNumericallyEqual);
         SimTK_SUBTEST(testUnitVec);
         SimTK_SUBTEST(testAppendRowCol);
+        SimTK_SUBTEST(testSIMDKernels);
     SimTK_END_TEST();
 }
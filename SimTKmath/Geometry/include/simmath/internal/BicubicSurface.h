@@ -301,9 +301,38 @@ public:
     /** This is a slow-but-convenient version of calcDerivative() since it
     does not provide for a PatchHint. See the other signature for a much faster
     version. **/
-    Real calcDerivative(const Array_<int>& derivComponents, 
+    Real calcDerivative(const Array_<int>& derivComponents,
                         const Vec2& XY) const;
-    
+
+    /** Calculate the value of the surface at each of many XY coordinates in
+    a single call. This is much faster than calling calcValue() for each
+    point when there are a lot of them, as when a tracked vehicle is resting
+    on a terrain.
+    @param[in]      XY
+        The (X,Y) points at which F(X,Y) is to be evaluated. They may be in
+        any order and may lie on any patches.
+    @param[out]     f
+        The interpolated function values, resized to match \a XY so that
+        f[i] is F(XY[i]).
+
+    The points are first sorted by the patch they lie on so that the
+    coefficients of each patch are computed only once regardless of how many
+    points lie on it, and then all the points on a patch are evaluated
+    together, several at a time using SIMD instructions where available. The
+    results are exactly the same as calcValue() would return, unless the
+    compiler is permitted to contract multiplies and adds into FMA
+    instructions (for example when building with -mfma), in which case they
+    may differ in the last bit. Every point counts as one access in the
+    statistics. **/
+    void calcValues(const Array_<Vec2>& XY, Array_<Real>& f) const;
+
+    /** Same as the other signature but also calculates the gradient
+    (DF/DX, DF/DY) of the surface at each point. The normals can be obtained
+    from the gradients; at XY[i] the outward unit normal is
+    UnitVec3(-gradf[i][0], -gradf[i][1], 1). **/
+    void calcValues(const Array_<Vec2>& XY, Array_<Real>& f,
+                    Array_<Vec2>& gradf) const;
+
     /** The surface interpolation only works within the grid defined by the 
     vectors x and y used in the constructor. This function checks to see if an 
     XYval is within the defined bounds of this particular BicubicSurface.
@@ -337,13 +366,13 @@ public:
     //--------------------------------------------------------------------------
     /**@name                        Statistics
     This class keeps track of the number of surface accesses made (using
-    either calcValue() or calcDerivative(), and how many of those were
+    calcValue(), calcDerivative() or calcValues()), and how many of those were
     resolved successfully using some or all of the hint information. 
     Methods in this section allow access to those statistics. Note that
     these statistics include accesses from all users of this surface. **/
     /**@{**/
     /** This is the total number of calls made to either calcValue() or
-    calcDerivative(). **/
+    calcDerivative(), plus the number of points passed to calcValues(). **/
     int getNumAccesses() const;
     /** This is the number of accesses which specified a point whose 
     information was already available in the hint. Note that if different
@@ -355,7 +384,8 @@ public:
     same patch as was already present in the hint, or asked for new information
     about the same point. These accesses are resolved without having to search
     for the patch, and without having to compute patch information. However,
-    specific point information still must be calculated. **/
+    specific point information still must be calculated. In a calcValues()
+    call, every point after the first one on each patch counts here. **/
     int getNumAccessesSamePatch() const;
     /** This is the number of accesses which specified on a point that was
     not on the patch currently in the hint, but was close enough that we did
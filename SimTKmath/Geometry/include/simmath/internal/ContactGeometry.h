@@ -781,6 +781,63 @@ Vec2 calcSplitGeodErrorAnalytical(const Vec3& P, const Vec3& Q,
 /**@}**/
 
 
+/** @name                     Geodesic Caching
+If caching is enabled with setGeodesicCacheSize(), two-point geodesic 
+calculations made with calcGeodesic(), calcGeodesicUsingOrthogonalMethod() or
+continueGeodesic() remember their most recent results on this surface. Asking
+again for a geodesic between the same two points returns the remembered one
+without integrating anything.
+Asking for one whose end points are close to those of a remembered geodesic
+starting in about the same direction warm starts the solution from that
+geodesic, using its Jacobi field sensitivities to predict the new starting
+direction and length, so that usually only a geodesic or two must be shot.
+continueGeodesic() warm starts from the previous geodesic in the same way if
+nothing closer is remembered.
+
+Warm-started geodesics agree with cold-started ones to within the solution
+tolerance but are not bitwise identical, so results can depend on what was
+calculated earlier. That is why caching is off by default; turn it on when
+the same surface is asked for a slowly changing sequence of geodesics, as 
+for a cable wrapping over it. Copies of this surface get the same settings 
+but an empty cache. As with the rest of the geodesic methods, a single 
+surface object must not be used for geodesic calculations by several threads
+at once. **/
+/**@{**/
+
+/** Set the number of geodesics remembered by this surface; zero disables
+caching and warm starting. Any currently remembered geodesics are
+forgotten. The default is 0; a few (say 4) is enough for tracking a 
+moving geodesic. **/
+void setGeodesicCacheSize(int n);
+/** Return the number of geodesics this surface will remember. **/
+int getGeodesicCacheSize() const;
+/** Forget all remembered geodesics. Statistics are not affected. **/
+void clearGeodesicCache() const;
+
+/** Set the accuracy to which the geodesic equations are integrated. The
+integrator adapts its step size to this, so a looser accuracy means fewer
+steps per geodesic. Two-point geodesics are solved until the end point error
+is less than 1/1000 of this value. Any remembered geodesics are forgotten.
+The default is 1e-6. **/
+void setGeodesicAccuracy(Real accuracy);
+/** Return the accuracy to which the geodesic equations are integrated. **/
+Real getGeodesicAccuracy() const;
+
+/** Return the number of two-point geodesic calculations that were satisfied
+by a remembered geodesic with exactly the requested end points. **/
+int getNumGeodesicCacheHits() const;
+/** Return the number of two-point geodesic calculations that were warm
+started from a nearby geodesic. **/
+int getNumGeodesicCacheWarmStarts() const;
+/** Return the number of two-point geodesic calculations that had to start
+from the caller's hints because no suitable nearby geodesic was available. **/
+int getNumGeodesicCacheMisses() const;
+/** Reset the cache statistics to zero. Note that the statistics are mutable
+so you do not need write access to the surface. **/
+void resetGeodesicCacheStatistics() const;
+/**@}**/
+
+
 /** @name Geodesic-related Debugging **/
 /**@{**/
 
@@ -1079,6 +1136,19 @@ const BicubicSurface& getBicubicSurface() const;
 surface. **/
 const OBBTree& getOBBTree() const;
 
+/** Calculate the surface height z=f(x,y) at each of many (x,y) locations,
+measured in the surface frame, in a single call. This is much faster than
+querying the BicubicSurface one point at a time when there are a lot of
+points, as for the wheels or track links of a vehicle; see
+BicubicSurface::calcValues(). Every location must be within the bounds of
+the surface. **/
+void calcSurfaceHeights(const Array_<Vec2>& xy, Array_<Real>& height) const;
+
+/** Same as the other signature but also calculates the outward unit normal
+to the surface at each location, expressed in the surface frame. **/
+void calcSurfaceHeights(const Array_<Vec2>& xy, Array_<Real>& height,
+                        Array_<UnitVec3>& normal) const;
+
 /** Return true if the supplied ContactGeometry object is a SmoothHeightMap. **/
 static bool isInstance(const ContactGeometry& geo)
 {   return geo.getTypeId()==classTypeId(); }
@@ -1184,6 +1254,26 @@ triangulated.
                  If false, it will be treated as a faceted mesh with a constant
                  normal vector over each face. **/
 explicit TriangleMesh(const PolygonalMesh& mesh, bool smooth=false);
+/** Create a TriangleMesh whose Oriented Bounding Box Tree is read from data
+that was previously written by writeOBBTree() for a mesh with exactly the same
+vertices and faces, instead of being built. Building the tree is the most 
+expensive part of creating a large mesh, so saving it along with the mesh 
+makes subsequent loads much faster. An exception is thrown if the data is
+corrupt or was written for a different mesh.
+@param vertices     The positions of all vertices in the mesh.
+@param faceIndices  The indices of the vertices that make up each face, as for
+                    the constructor that builds the tree.
+@param obbTree      A stream, opened in binary mode, containing the tree.
+@param smooth       Whether the mesh is to be treated as a smooth surface. **/
+TriangleMesh(const ArrayViewConst_<Vec3>& vertices, 
+             const ArrayViewConst_<int>& faceIndices, 
+             std::istream& obbTree, bool smooth=false);
+/** Create a TriangleMesh based on a PolygonalMesh object, reading its 
+Oriented Bounding Box Tree from data previously written by writeOBBTree() for
+a TriangleMesh created from the same PolygonalMesh. See the corresponding 
+constructor taking a list of vertices and faces. **/
+TriangleMesh(const PolygonalMesh& mesh, std::istream& obbTree, 
+             bool smooth=false);
 /** Get the number of edges in the mesh. **/
 int getNumEdges() const;
 /** Get the number of faces in the mesh. **/
@@ -1308,6 +1398,11 @@ bool intersectsRay(const Vec3& origin, const UnitVec3& direction, Real& distance
 /** Get the OBBTreeNode which forms the root of this mesh's Oriented Bounding 
 Box Tree. **/
 OBBTreeNode getOBBTreeNode() const;
+/** Write this mesh's Oriented Bounding Box Tree to a stream, which should be
+opened in binary mode, so that it can be read by one of the constructors that
+take an std::istream instead of being built again. The data is in the native
+byte order and precision of this machine. **/
+void writeOBBTree(std::ostream& out) const;
 
 /** Generate a PolygonalMesh from this TriangleMesh; useful mostly for debugging
 because you can create a DecorativeMesh from this and then look at it. **/
@@ -137,6 +137,20 @@ Real BicubicSurface::calcDerivative
     return calcDerivative(components, XY, hint); 
 }
 
+void BicubicSurface::calcValues
+   (const Array_<Vec2>& XY, Array_<Real>& f) const {
+    SimTK_ERRCHK_ALWAYS(!isEmpty(), "BicubicSurface::calcValues()",
+        "This method can't be called on an empty handle.");
+    guts->calcValues(XY, f, 0);
+}
+
+void BicubicSurface::calcValues
+   (const Array_<Vec2>& XY, Array_<Real>& f, Array_<Vec2>& gradf) const {
+    SimTK_ERRCHK_ALWAYS(!isEmpty(), "BicubicSurface::calcValues()",
+        "This method can't be called on an empty handle.");
+    guts->calcValues(XY, f, &gradf);
+}
+
 UnitVec3 BicubicSurface::calcUnitNormal(const Vec2& XY, PatchHint& hint) const {
     const Array_<int> dx(1,0), dy(1,1);
     const Real fx = calcDerivative(dx,XY,hint);
@@ -660,27 +674,13 @@ getFdF(const Vec2& aXY, int wantLevel, PatchHint& hint) const {
     h.xy = aXY;
     h.level = -1; // we don't know anything about this point
 
-    // We're going to feed calcLowerBoundIndex() our best guess as to the
-    // patch this point is on. For regularly-spaced grid points we can find
-    // it exactly, except for some possible roundoff. Otherwise the best we
-    // can do is supply the current index from the hint.
-    int pXidx = h.x0, pYidx = h.y0;
-    if (_hasRegularSpacing) {
-        pXidx = clamp(0, (int)std::floor((h.xy[0]-_x[0])/_spacing[0]),
-                      _x.size()-2); // can't be last index
-        pYidx = clamp(0, (int)std::floor((h.xy[1]-_y[0])/_spacing[1]),
-                      _y.size()-2);
-    }
-
-    // Compute the indices that define the patch containing this value.
-    int howResolvedX, howResolvedY;
-    const int x0 = calcLowerBoundIndex(_x,aXY[0],pXidx,howResolvedX);
-    const int x1 = x0+1;
-    const int y0 = calcLowerBoundIndex(_y,aXY[1],pYidx,howResolvedY);
-    const int y1 = y0+1;
+    // Compute the indices that define the patch containing this value,
+    // starting the search from the patch in the hint.
+    int x0 = h.x0, y0 = h.y0;
+    const int howResolved = findPatch(aXY, x0, y0);
+    const int x1 = x0+1, y1 = y0+1;
 
     // 0->same patch, 1->nearby patch, 2->had to search
-    const int howResolved = std::max(howResolvedX, howResolvedY);
     if      (howResolved == 0) ++numAccessesSamePatch;
     else if (howResolved == 1) ++numAccessesNearbyPatch;
  
@@ -799,6 +799,214 @@ getFdF(const Vec2& aXY, int wantLevel, PatchHint& hint) const {
 }
 
 
+// Find the patch containing aXY, whose indices are returned in x0,y0. On
+// entry x0,y0 may hold a guess (such as the patch from a hint), or -1 if
+// there isn't one. For regularly-spaced grid points we replace the guess
+// with the patch we can calculate directly, which is exact except for some
+// possible roundoff. Returns 0 if the point was on the guessed patch, 1 if
+// it was on a nearby patch, and 2 if we had to search.
+int BicubicSurface::Guts::
+findPatch(const Vec2& aXY, int& x0, int& y0) const {
+    if (_hasRegularSpacing) {
+        x0 = clamp(0, (int)std::floor((aXY[0]-_x[0])/_spacing[0]),
+                   _x.size()-2); // can't be last index
+        y0 = clamp(0, (int)std::floor((aXY[1]-_y[0])/_spacing[1]),
+                   _y.size()-2);
+    }
+
+    int howResolvedX, howResolvedY;
+    x0 = calcLowerBoundIndex(_x,aXY[0],x0,howResolvedX);
+    y0 = calcLowerBoundIndex(_y,aXY[1],y0,howResolvedY);
+    return std::max(howResolvedX, howResolvedY);
+}
+
+
+
+//==============================================================================
+//                         BATCH SURFACE EVALUATION
+//==============================================================================
+// calcValues() evaluates the patch polynomial for a group of points that are
+// all on the same patch. The arithmetic is written once, as a template, and
+// instantiated both for scalars and for SIMD registers holding one point per
+// lane, so the vectorized results are identical to the scalar ones. Each
+// operation is the same one, in the same order, that getFdF() performs.
+
+namespace {
+
+inline Real splatReal(Real x)           {return x;}
+inline Real loadReal(const Real* p)     {return *p;}
+inline void storeReal(Real* p, Real x)  {*p = x;}
+inline Real add(Real a, Real b)         {return a+b;}
+inline Real mul(Real a, Real b)         {return a*b;}
+
+#if defined(SimTK_SMALLMATRIX_USE_SSE2) && SimTK_DEFAULT_PRECISION == 2
+#define SimTK_BICUBIC_USE_SIMD
+// The register is wrapped in a struct so that it can be used as a template
+// argument without losing its alignment attributes.
+#ifdef SimTK_SMALLMATRIX_USE_AVX
+struct Lanes {__m256d v;};
+const int NLanes = 4;
+inline Lanes lanes(__m256d v)              {Lanes r={v}; return r;}
+inline Lanes splatLanes(double x)          {return lanes(_mm256_set1_pd(x));}
+inline Lanes loadLanes(const double* p)    {return lanes(_mm256_loadu_pd(p));}
+inline void storeLanes(double* p, Lanes x) {_mm256_storeu_pd(p, x.v);}
+inline Lanes add(Lanes a, Lanes b) {return lanes(_mm256_add_pd(a.v, b.v));}
+inline Lanes mul(Lanes a, Lanes b) {return lanes(_mm256_mul_pd(a.v, b.v));}
+#else
+struct Lanes {__m128d v;};
+const int NLanes = 2;
+inline Lanes lanes(__m128d v)              {Lanes r={v}; return r;}
+inline Lanes splatLanes(double x)          {return lanes(_mm_set1_pd(x));}
+inline Lanes loadLanes(const double* p)    {return lanes(_mm_loadu_pd(p));}
+inline void storeLanes(double* p, Lanes x) {_mm_storeu_pd(p, x.v);}
+inline Lanes add(Lanes a, Lanes b) {return lanes(_mm_add_pd(a.v, b.v));}
+inline Lanes mul(Lanes a, Lanes b) {return lanes(_mm_mul_pd(a.v, b.v));}
+#endif
+#endif
+
+// The patch information in a form ready for evaluation: the coefficients
+// and scale factors are broadcast once per patch rather than once per point.
+template <class T>
+struct PatchCoefs {
+    template <class Splat>
+    PatchCoefs(const BicubicSurface::PatchHint::Guts& h, Splat splat) {
+        for (int k=0; k < 16; ++k) a[k] = splat(h.a[k]);
+        ooxS = splat(h.ooxS); ooyS = splat(h.ooyS);
+        two = splat(2); three = splat(3);
+    }
+    T a[16], ooxS, ooyS, two, three;
+};
+
+// Calculate f and, if wantGradient is set, fx and fy at the point whose
+// position within the patch (scaled to [0,1]) is (xpt,ypt).
+template <class T>
+void evalPatchPoint(const PatchCoefs<T>& c, T xpt, T ypt, bool wantGradient,
+                    T& f, T& fx, T& fy) {
+    const T* a = c.a;
+    const T xpt2 = mul(xpt,xpt), xpt3 = mul(xpt,xpt2);
+    const T ypt2 = mul(ypt,ypt), ypt3 = mul(ypt,ypt2);
+    T xsum[4];
+    for (int r=0; r < 4; ++r)
+        xsum[r] = add(add(add(a[4*r], mul(a[4*r+1],xpt)), mul(a[4*r+2],xpt2)),
+                      mul(a[4*r+3],xpt3));
+    f = add(add(add(xsum[0], mul(ypt,xsum[1])), mul(ypt2,xsum[2])),
+            mul(ypt3,xsum[3]));
+    if (!wantGradient)
+        return;
+
+    const T dypt2 = mul(mul(c.two,ypt),c.ooyS),
+            dypt3 = mul(mul(c.three,ypt2),c.ooyS);
+    fy = add(add(mul(c.ooyS,xsum[1]), mul(dypt2,xsum[2])), mul(dypt3,xsum[3]));
+
+    const T dxpt2 = mul(mul(c.two,xpt),c.ooxS),
+            dxpt3 = mul(mul(c.three,xpt2),c.ooxS);
+    T dxsum[4];
+    for (int r=0; r < 4; ++r)
+        dxsum[r] = add(add(mul(a[4*r+1],c.ooxS), mul(a[4*r+2],dxpt2)),
+                       mul(a[4*r+3],dxpt3));
+    fx = add(add(add(dxsum[0], mul(ypt,dxsum[1])), mul(ypt2,dxsum[2])),
+             mul(ypt3,dxsum[3]));
+}
+
+// Evaluate n points on the patch described by h, using SIMD for as many
+// points as fill whole registers and scalars for the rest. fx and fy are
+// calculated only if they are non-null.
+void evalPatchPoints(const BicubicSurface::PatchHint::Guts& h, int n,
+                     const Real* xpt, const Real* ypt,
+                     Real* f, Real* fx, Real* fy) {
+    const bool wantGradient = fx != 0;
+    int i = 0;
+#ifdef SimTK_BICUBIC_USE_SIMD
+    if (n >= NLanes) {
+        const PatchCoefs<Lanes> c(h, splatLanes);
+        Lanes lf, lfx, lfy;
+        for (; i+NLanes <= n; i += NLanes) {
+            evalPatchPoint(c, loadLanes(xpt+i), loadLanes(ypt+i),
+                           wantGradient, lf, lfx, lfy);
+            storeLanes(f+i, lf);
+            if (wantGradient) {storeLanes(fx+i, lfx); storeLanes(fy+i, lfy);}
+        }
+    }
+#endif
+    if (i == n)
+        return;
+    const PatchCoefs<Real> c(h, splatReal);
+    Real sf, sfx, sfy;
+    for (; i < n; ++i) {
+        evalPatchPoint(c, loadReal(xpt+i), loadReal(ypt+i),
+                       wantGradient, sf, sfx, sfy);
+        storeReal(f+i, sf);
+        if (wantGradient) {storeReal(fx+i, sfx); storeReal(fy+i, sfy);}
+    }
+}
+
+}
+
+void BicubicSurface::Guts::
+calcValues(const Array_<Vec2>& XY, Array_<Real>& f, Array_<Vec2>* gradf) const
+{
+    const int n = (int)XY.size();
+    f.resize(n);
+    if (gradf) gradf->resize(n);
+    if (n == 0)
+        return;
+    numAccesses += n;
+
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+
+    // Sort the points by patch. Each sort key has the patch number in its
+    // high half and the point's index in its low half. Nearby points are
+    // likely to be on the same or neighboring patches, so each search starts
+    // from the previous point's patch.
+    typedef unsigned long long Key;
+    const int nyPatches = _y.size()-1;
+    Key* keys = arena.allocate<Key>(n);
+    int x0 = -1, y0 = -1;
+    for (int i=0; i < n; ++i) {
+        SimTK_ERRCHK6_ALWAYS(isSurfaceDefined(XY[i]),
+            "BicubicSurface::calcValues()",
+            "BicubicSurface is not defined at requested location (%g,%g)."
+            " The surface is valid from x[%g %g], y[%g %g].", XY[i][0],
+            XY[i][1], _x[0], _x[_x.size()-1], _y[0], _y[_y.size()-1]);
+        findPatch(XY[i], x0, y0);
+        keys[i] = (Key(x0*nyPatches + y0) << 32) | Key(i);
+    }
+    std::sort(keys, keys+n);
+
+    // Gather each patch's points, in sorted order, as positions within the
+    // patch, then evaluate them all at once.
+    Real* xpt = arena.allocate<Real>(n);
+    Real* ypt = arena.allocate<Real>(n);
+    Real* fs  = arena.allocate<Real>(n);
+    Real* fxs = gradf ? arena.allocate<Real>(n) : 0;
+    Real* fys = gradf ? arena.allocate<Real>(n) : 0;
+    PatchHint::Guts h;
+    for (int begin=0, end; begin < n; begin = end) {
+        const Key patch = keys[begin] >> 32;
+        for (end=begin+1; end < n && (keys[end] >> 32) == patch; ++end) {}
+        const int px = int(patch / nyPatches), py = int(patch % nyPatches);
+        getPatchInfoIfNeeded(px, py, h);
+        numAccessesSamePatch += end-begin-1;
+
+        for (int k=begin; k < end; ++k) {
+            const Vec2& p = XY[int(keys[k] & 0xffffffff)];
+            xpt[k] = (p[0]-_x(px))*h.ooxS;
+            ypt[k] = (p[1]-_y(py))*h.ooyS;
+        }
+        evalPatchPoints(h, end-begin, xpt+begin, ypt+begin, fs+begin,
+                        fxs ? fxs+begin : 0, fys ? fys+begin : 0);
+    }
+
+    // Scatter the results back to the caller's order.
+    for (int k=0; k < n; ++k) {
+        const int i = int(keys[k] & 0xffffffff);
+        f[i] = fs[k];
+        if (gradf) (*gradf)[i] = Vec2(fxs[k], fys[k]);
+    }
+}
+
+
 /** Given a search value aVal and an n-vector aVec (n>=2) containing 
 monotonically increasing values (no duplicates), this method finds the unique
 pair of indices (i,i+1) such that either 
@@ -143,6 +143,11 @@ public:
     Real calcDerivative(const Array_<int>& derivComponents, 
                         const Vec2& XY, PatchHint& hint) const;
 
+    // Calculate the value of the surface, and its gradient if gradf is
+    // non-null, at each of many XY coordinates.
+    void calcValues(const Array_<Vec2>& XY, Array_<Real>& f,
+                    Array_<Vec2>* gradf) const;
+
     // Calculate a paraboloid and the max/min principal curvatures at a contact
     // point at XY.
     void calcParaboloid
@@ -275,6 +280,7 @@ private:
     int calcLowerBoundIndex(const Vector& vecV, Real value, int pIdx,
                             int& howResolved) const;
     void getCoefficients(const Vec<16>& f, Vec<16>& aV) const;
+    int findPatch(const Vec2& aXY, int& x0, int& y0) const;
     void getFdF(const Vec2& aXY, int wantLevel,
                 BicubicSurface::PatchHint& hint) const;
     void getPatchInfoIfNeeded(int x0, int y0, 
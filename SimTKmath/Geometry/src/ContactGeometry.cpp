@@ -83,6 +83,7 @@ ContactGeometry::ContactGeometry(const ContactGeometry& src) : impl(0) {
     if (src.impl) {
         impl = src.impl->clone();
         impl->setMyHandle(*this);
+        impl->copyGeodesicSettings(*src.impl);
     }
 }
 
@@ -94,6 +95,7 @@ ContactGeometry& ContactGeometry::operator=(const ContactGeometry& src) {
         if (src.impl) {
             impl = src.impl->clone();
             impl->setMyHandle(*this);
+            impl->copyGeodesicSettings(*src.impl);
         }
     }
     return *this;
@@ -869,6 +871,31 @@ void ContactGeometry::setPlane(const Plane& plane) const { getImpl().setPlane(pl
 const Geodesic& ContactGeometry::getGeodP() const { return getImpl().getGeodP(); }
 const Geodesic& ContactGeometry::getGeodQ() const { return getImpl().getGeodQ(); }
 const int ContactGeometry::getNumGeodesicsShot() const { return getImpl().getNumGeodesicsShot(); }
+
+void ContactGeometry::setGeodesicCacheSize(int n) {
+    SimTK_APIARGCHECK1_ALWAYS(n >= 0, "ContactGeometry", 
+        "setGeodesicCacheSize", "Illegal cache size %d.", n);
+    updImpl().setGeodesicCacheSize(n);
+}
+int ContactGeometry::getGeodesicCacheSize() const 
+{   return getImpl().getGeodesicCacheSize(); }
+void ContactGeometry::clearGeodesicCache() const 
+{   getImpl().clearGeodesicCache(); }
+void ContactGeometry::setGeodesicAccuracy(Real accuracy) {
+    SimTK_APIARGCHECK1_ALWAYS(accuracy > 0, "ContactGeometry", 
+        "setGeodesicAccuracy", "Illegal accuracy %g.", (double)accuracy);
+    updImpl().setGeodesicAccuracy(accuracy);
+}
+Real ContactGeometry::getGeodesicAccuracy() const 
+{   return getImpl().getGeodesicAccuracy(); }
+int ContactGeometry::getNumGeodesicCacheHits() const 
+{   return getImpl().getNumGeodesicCacheHits(); }
+int ContactGeometry::getNumGeodesicCacheWarmStarts() const 
+{   return getImpl().getNumGeodesicCacheWarmStarts(); }
+int ContactGeometry::getNumGeodesicCacheMisses() const 
+{   return getImpl().getNumGeodesicCacheMisses(); }
+void ContactGeometry::resetGeodesicCacheStatistics() const 
+{   getImpl().resetGeodesicCacheStatistics(); }
 void ContactGeometry::addVizReporter(ScheduledEventReporter* reporter) const {
     getImpl().addVizReporter(reporter);
 }
@@ -1212,8 +1239,6 @@ continueGeodesic(const Vec3& xP, const Vec3& xQ, const Geodesic& prevGeod,
     if (prevGeod.getNumPoints() 
         && prevGeod.getPointP()==P && prevGeod.getPointQ()==Q) {
             geod = prevGeod;
-            cout << "REUSING OLD GEODESIC of length=" 
-                << prevGeod.getLength() << "\n";
             return;
     }
    
@@ -1221,7 +1246,6 @@ continueGeodesic(const Vec3& xP, const Vec3& xQ, const Geodesic& prevGeod,
     const Real PQlength = PQ.norm();
     const UnitVec3 PQdir =
         PQlength == 0 ? UnitVec3(XAxis) : UnitVec3(PQ/PQlength, true);
-    cout << "  PQlen=" << PQlength << " PQdir=" << PQdir << "\n";
 
     // If the length is less than this fraction of the maximum radius of
     // curvature (1/kdP) then the geodesic is indistinguishable from a 
@@ -1231,7 +1255,6 @@ continueGeodesic(const Vec3& xP, const Vec3& xQ, const Geodesic& prevGeod,
     // that matter?
     const Real kdP = std::abs(calcSurfaceCurvatureInDirection(P,PQdir));
     if (PQlength*kdP <= StraightLineGeoFrac) {
-        cout << "STRAIGHT LINE GEO length=" << PQlength << "\n";
         makeStraightLineGeodesic(P, Q, PQdir, options, geod);
         return;
     }
@@ -1279,12 +1302,10 @@ continueGeodesic(const Vec3& xP, const Vec3& xQ, const Geodesic& prevGeod,
             tPhint = PQdir;
             tQhint = PQdir;
             sHint = PQlength;
-            cout << "GEODESIC FLIPPED. Prev len was " 
-                 << prevGeod.getLength() << endl;
         }
     }
 
-    calcGeodesicUsingOrthogonalMethod(P, Q, tPhint, sHint, geod);
+    calcGeodesicUsingOrthogonalMethod(P, Q, tPhint, sHint, &prevGeod, geod);
     //calcGeodesicAnalytical(P, Q, tPhint, tQhint, geod);
 }
 
@@ -1366,7 +1387,7 @@ makeStraightLineGeodesic(const Vec3& xP, const Vec3& xQ,
 // surface point P', calculate the outward unit normal n' at P', then
 // project tP to tP' by removing any component it has in the n' direction,
 // then renormalizing.
-static const Real IntegratorAccuracy = Real(1e-6); // TODO: how to choose?
+const Real ContactGeometryImpl::DefaultGeodesicAccuracy = Real(1e-6);
 static const Real IntegratorConstraintTol = Real(1e-10);
 void ContactGeometryImpl::
 shootGeodesicInDirection(const Vec3& P, const UnitVec3& tP,
@@ -1394,7 +1415,7 @@ shootGeodesicInDirection(const Vec3& P, const UnitVec3& tP,
     //RungeKutta3Integrator integ(*ptOnSurfSys);
     RungeKuttaMersonIntegrator integ(*ptOnSurfSys);
     //RungeKuttaFeldbergIntegrator integ(*ptOnSurfSys);
-    integ.setAccuracy(IntegratorAccuracy);
+    integ.setAccuracy(geodesicAccuracy);
     integ.setConstraintTolerance(IntegratorConstraintTol);
     integ.setFinalTime(finalTime);
     integ.setReturnEveryInternalStep(true); // save geodesic knot points
@@ -1467,7 +1488,7 @@ shootGeodesicInDirection(const Vec3& P, const UnitVec3& tP,
     geod.setTorsionAtP(tauP); geod.setTorsionAtQ(tauQ);
 
     geod.setIsShortest(false); // TODO
-    geod.setAchievedAccuracy(IntegratorAccuracy); // TODO: accuracy of length?
+    geod.setAchievedAccuracy(geodesicAccuracy); // TODO: accuracy of length?
     // TODO: better to use something like the second-to-last step, or average
     // excluding initial and last steps, so that we don't have to start small.
     geod.setInitialStepSizeHint(integ.getActualInitialStepSizeTaken());
@@ -1483,12 +1504,14 @@ shootGeodesicInDirection2(const Vec3& P, const UnitVec3& tP,
 
     GeodesicOnImplicitSurface eqns(*this);
     GeodesicIntegrator<GeodesicOnImplicitSurface> 
-        integ(eqns,IntegratorAccuracy,IntegratorConstraintTol);
+        integ(eqns,geodesicAccuracy,IntegratorConstraintTol);
     static const int N = GeodesicOnImplicitSurface::N;
 
     ++numGeodesicsShot;
 
     integ.initialize(startArcLength, eqns.getInitialState(P,tP));
+    if (!isNaN(stepSizeHint))
+        integ.setNextStepSizeToTry(stepSizeHint);
     // Aliases for the integrators internal time and state variables.
     const Vec<N>& y = integ.getY();
     const Real&   s = integ.getTime();  // arc length
@@ -1547,7 +1570,7 @@ shootGeodesicInDirection2(const Vec3& P, const UnitVec3& tP,
     geod.setTorsionAtP(tauP); geod.setTorsionAtQ(tauQ);
 
     geod.setIsShortest(false); // TODO
-    geod.setAchievedAccuracy(IntegratorAccuracy); // TODO: accuracy of length?
+    geod.setAchievedAccuracy(geodesicAccuracy); // TODO: accuracy of length?
     // TODO: better to use something like the second-to-last step, or average
     // excluding initial and last steps, so that we don't have to start small.
     geod.setInitialStepSizeHint(integ.getActualInitialStepSizeTaken());
@@ -1569,7 +1592,7 @@ calcGeodesicReverseSensitivity(Geodesic& geod, const Vec2& initJacobi) const {
 
     //RungeKutta3Integrator integ(ptOnSurfSys);
     RungeKuttaMersonIntegrator integ(*ptOnSurfSys);
-    integ.setAccuracy(IntegratorAccuracy);
+    integ.setAccuracy(geodesicAccuracy);
     integ.setConstraintTolerance(IntegratorConstraintTol);
     State sysState = ptOnSurfSys->getDefaultState();
     Vector& q = sysState.updQ();
@@ -1629,7 +1652,7 @@ calcGeodesicReverseSensitivity2
 
     GeodesicOnImplicitSurface eqns(*this);
     GeodesicIntegrator<GeodesicOnImplicitSurface> 
-        integ(eqns,IntegratorAccuracy,IntegratorConstraintTol);
+        integ(eqns,geodesicAccuracy,IntegratorConstraintTol);
     static const int N = GeodesicOnImplicitSurface::N;
 
     integ.initialize(0, 
@@ -1738,6 +1761,128 @@ static Real maxabsdiff(Vec2 x, Vec2 xold) {
 
 
 
+//------------------------------------------------------------------------------
+//                              GEODESIC CACHE
+//------------------------------------------------------------------------------
+// A remembered geodesic is near enough to warm start from if neither of its
+// end points is further from P or Q than this fraction of its length, and its
+// starting direction is within about 25 degrees of the caller's hint. The
+// direction test keeps us from jumping to a different geodesic than the
+// caller wanted, for example the one going the other way around.
+static const Real WarmStartDistanceFraction = Real(0.25);
+static const Real CosMaxWarmStartAngle = Real(0.9);
+
+// If a geodesic that was calculated for end points P0 and Q0 is near enough
+// to P and Q to warm start from, return true and the larger of the distances
+// between corresponding end points.
+static bool isNearbyGeodesic(const Geodesic& geod, 
+                             const Vec3& P0, const Vec3& Q0,
+                             const Vec3& P, const Vec3& Q, 
+                             const Vec3& tPhint, Real& dist) {
+    if (geod.getNumPoints() < 2)
+        return false;
+    dist = std::max((P0-P).norm(), (Q0-Q).norm());
+    if (dist > WarmStartDistanceFraction*geod.getLength())
+        return false;
+    const Real tPhintLen = tPhint.norm();
+    return ~geod.getTangentP()*tPhint >= CosMaxWarmStartAngle*tPhintLen;
+}
+
+// This is the Jacobian of the orthogonal error conditions with respect to
+// (thetaP, length), given a geodesic shot with those unknowns and the vector
+// r_QQhat from the target Q to that geodesic's actual end point Qhat.
+static Mat22 calcOrthogonalGeodErrorJacobian(const Geodesic& geod, 
+                                             const Vec3& r_QQhat) {
+    const Real eh = ~r_QQhat*geod.getNormalQ();
+    const Real es = ~r_QQhat*geod.getTangentQ();
+    const Real eb = ~r_QQhat*geod.getBinormalQ();
+    const Real j = geod.getJacobiQ();
+    const Real jd = geod.getJacobiQDot();
+    const Real tau = geod.getTorsionQ();
+    const Real kappa = geod.getCurvatureQ();
+    const Real mu = geod.getBinormalCurvatureQ();
+
+   // printf("eh=%g es=%g, eb=%g, j=%g, tau=%g, kappa=%g, mu=%g\n",
+    //  eh,es,eb,j,tau,kappa,mu);
+
+    return Mat22( -(jd*es+j*(mu*eh-1)),      -tau*eh,
+                   -(j*tau*eh-jd*eb),      1-kappa*eh );
+}
+
+int ContactGeometryImpl::
+findCachedGeodesic(const Vec3& P, const Vec3& Q, const Vec3& tPhint,
+                   bool& isExact) const {
+    int best = -1;
+    Real bestDist = Infinity;
+    for (int i=0; i < (int)geodCache.size(); ++i) {
+        const CachedGeodesic& entry = geodCache[i];
+        Real dist;
+        if (isNearbyGeodesic(entry.geod, entry.P, entry.Q, P, Q, tPhint, dist)
+            && dist < bestDist)
+        {   best = i; bestDist = dist; }
+    }
+    isExact = best >= 0 && geodCache[best].P == P && geodCache[best].Q == Q;
+    return best;
+}
+
+void ContactGeometryImpl::
+rememberGeodesic(const Vec3& P, const Vec3& Q, const Geodesic& geod) const {
+    if (geodCacheSize == 0)
+        return;
+    int slot = geodCache.size();
+    if (slot < geodCacheSize)
+        geodCache.push_back();
+    else {
+        slot = 0; // replace the least recently used
+        for (int i=1; i < (int)geodCache.size(); ++i)
+            if (geodCache[i].lastUsed < geodCache[slot].lastUsed)
+                slot = i;
+    }
+    CachedGeodesic& entry = geodCache[slot];
+    entry.P = P; entry.Q = Q;
+    entry.geod = geod;
+    entry.lastUsed = ++geodCacheClock;
+}
+
+// The neighbor geodesic G0 runs from P0 to Q0 with length s0. If we shot a 
+// geodesic of length s0 from P instead, in the direction we get by carrying
+// G0's starting tangent over to P, it would end near
+//      Qhat = Q0 + jt (bP0 . dP) bQ0 + (tP0 . dP) tQ0,       dP = P - P0
+// where jt is G0's positional Jacobi field at Q0. That is, sideways motion of
+// P is propagated by the Jacobi field and motion along the geodesic just
+// slides it. That gives us the orthogonal errors for thetaP=Pi/2 (the
+// carried-over tangent) and length s0 without shooting anything, and one
+// Newton step from there using G0's sensitivities is our prediction.
+bool ContactGeometryImpl::
+predictOrthogonalUnknowns(const Geodesic& neighbor, const Vec3& P, 
+                          const Vec3& Q, Vec2& x) const {
+    const Vec3 dP = P - neighbor.getPointP();
+    const Vec3 Qhat = neighbor.getPointQ() 
+        + (neighbor.getJacobiTransQ()*(~neighbor.getBinormalP()*dP))
+            * neighbor.getBinormalQ()
+        + (~neighbor.getTangentP()*dP) * neighbor.getTangentQ();
+    const Vec3 r_QQhat = Qhat - Q;
+    const Vec2 Fx(~r_QQhat*neighbor.getBinormalQ(),
+                  ~r_QQhat*neighbor.getTangentQ());
+    const Mat22 J = calcOrthogonalGeodErrorJacobian(neighbor, r_QQhat);
+    const Real det = J(0,0)*J(1,1) - J(0,1)*J(1,0);
+    if (!SimTK::isFinite(det) || std::abs(det) <= SignificantReal 
+        || !Fx.isFinite())
+        return false; // e.g., the neighbor has no positional sensitivities
+
+    const Vec2 dx = J.invert()*Fx;
+    // Same limit on the angle change as the Newton iteration uses; a bigger
+    // change means the neighbor isn't a good predictor.
+    if (std::abs(dx[0]) > Pi/8 || neighbor.getLength() - dx[1] <= 0)
+        return false;
+
+    R_SP = calcTangentBasis(P, neighbor.getTangentP());
+    x = Vec2(Pi/2, neighbor.getLength()) - dx;
+    return true;
+}
+
+
+
 //------------------------------------------------------------------------------
 //                              CALC GEODESIC
 //------------------------------------------------------------------------------
@@ -1748,7 +1893,7 @@ void ContactGeometryImpl::calcGeodesic(const Vec3& xP, const Vec3& xQ,
         const Vec3& tPhint, const Vec3& tQhint, Geodesic& geod) const {
 
     // Newton solver settings. TODO: single precision?
-    const Real ftol = Real(1e-9);
+    const Real ftol = geodesicAccuracy/1000; // 1e-9 at default accuracy
     const Real xtol = Real(1e-9);
     const Real minlam = Real(1e-9);
     const int maxNewtonIterations = 25;
@@ -1756,9 +1901,27 @@ void ContactGeometryImpl::calcGeodesic(const Vec3& xP, const Vec3& xQ,
     // reset counter
     numGeodesicsShot = 0;
 
+    // If we remember a geodesic that is near enough, start in its directions
+    // rather than the hints'.
+    bool isExact;
+    const int cached = findCachedGeodesic(xP, xQ, tPhint, isExact);
+    Vec3 tPstart = tPhint, tQstart = tQhint;
+    if (cached >= 0) {
+        const Geodesic& near = useCachedGeodesic(cached);
+        if (isExact) {
+            geod = near;
+            ++numGeodCacheHits;
+            return;
+        }
+        tPstart = near.getTangentP().asVec3();
+        tQstart = near.getTangentQ().asVec3();
+        ++numGeodCacheWarmStarts;
+    } else
+        ++numGeodCacheMisses;
+
     // define basis
-    R_SP = calcTangentBasis(xP, tPhint);
-    R_SQ = calcTangentBasis(xQ, tQhint);
+    R_SP = calcTangentBasis(xP, tPstart);
+    R_SQ = calcTangentBasis(xQ, tQstart);
 
     // calculate plane bisecting P and Q, and use as termination condition for integrator
     UnitVec3 normal(xQ - xP);
@@ -1834,6 +1997,9 @@ void ContactGeometryImpl::calcGeodesic(const Vec3& xP, const Vec3& xQ,
         geodP.getDirectionalSensitivityPtoQ().back());
 
     mergeGeodesics(geodP, geodQ, geod);
+
+    if (maxabs(Fx) < ftol)
+        rememberGeodesic(xP, xQ, geod);
 }
 
 
@@ -1843,13 +2009,14 @@ void ContactGeometryImpl::calcGeodesic(const Vec3& xP, const Vec3& xQ,
 //------------------------------------------------------------------------------
 void ContactGeometryImpl::calcGeodesicUsingOrthogonalMethod
    (const Vec3& xP, const Vec3& xQ,
-    const Vec3& tPhint, Real lengthHint, Geodesic& geod) const 
+    const Vec3& tPhint, Real lengthHint, const Geodesic* neighbor,
+    Geodesic& geod) const 
 {
     const Vec3 P = projectDownhillToNearestPoint(xP);
     const Vec3 Q = projectDownhillToNearestPoint(xQ);
 
     // Newton solver settings. TODO: single precision values?
-    const Real ftol = Real(1e-9);
+    const Real ftol = geodesicAccuracy/1000; // 1e-9 at default accuracy
     const Real xtol = Real(1e-12);
     const Real minlam = Real(1e-3);
     const int MaxIterations = 25;
@@ -1859,18 +2026,47 @@ void ContactGeometryImpl::calcGeodesicUsingOrthogonalMethod
     // reset counter
     numGeodesicsShot = 0;
 
-    // Define basis. This will not change during the solution.
-    R_SP = calcTangentBasis(P, tPhint);
-
     Mat22 J;
     Vec2 x, xold, dx, Fx;
     Matrix JMat;
-    // initial conditions
-    x[0] = Pi/2; // thetaP
-    x[1] = lengthHint;
+
+    // Look for a geodesic to start from, first among those we remember and
+    // then the caller's. If we find one we'll use it to predict the initial
+    // conditions and basis; otherwise we use the hints. With caching disabled
+    // we always use the hints so that results don't depend on history.
+    bool isExact;
+    const int cached = findCachedGeodesic(P, Q, tPhint, isExact);
+    if (cached >= 0 && isExact) {
+        geod = useCachedGeodesic(cached);
+        ++numGeodCacheHits;
+        return;
+    }
+
+    const Geodesic* start = cached >= 0 ? &useCachedGeodesic(cached) : 0;
+    Real startDist;
+    if (!start && neighbor && geodCacheSize > 0
+        && isNearbyGeodesic(*neighbor, neighbor->getPointP(), 
+                            neighbor->getPointQ(), P, Q, tPhint, startDist))
+        start = neighbor;
+
+    stepSizeHint = NaN;
+    if (start && predictOrthogonalUnknowns(*start, P, Q, x)) {
+        stepSizeHint = start->getInitialStepSizeHint();
+        ++numGeodCacheWarmStarts;
+    } else {
+        // Define basis. This will not change during the solution.
+        R_SP = calcTangentBasis(P, tPhint);
+        x[0] = Pi/2; // thetaP
+        x[1] = lengthHint;
+        ++numGeodCacheMisses;
+    }
     Real f, fold, dist, lam = 1;
 
     Fx = calcOrthogonalGeodError(P, Q, x[0], x[1], geod);
+    // The rest of the iterations shoot similar geodesics so should be able
+    // to start with the same step size.
+    if (isNaN(stepSizeHint))
+        stepSizeHint = geod.getInitialStepSizeHint();
     if (vizReporter != NULL) {
         vizReporter->handleEvent(ptOnSurfSys->getDefaultState());
         sleepInSec(pauseBetweenGeodIterations);
@@ -1938,23 +2134,7 @@ void ContactGeometryImpl::calcGeodesicUsingOrthogonalMethod
             //printf("Jacobi dot Q num=%g, analytic=%g\n",
             //    num_jtd, geod0.getJacobiTransQDot());
 
-            const Real jt = geod.getJacobiTransQ();
-            const Real jtd = geod.getJacobiTransQDot();
-
-            const Real eh = ~r_QQhat*geod.getNormalQ();
-            const Real es = ~r_QQhat*geod.getTangentQ();
-            const Real eb = ~r_QQhat*geod.getBinormalQ();
-            const Real j = geod.getJacobiQ();
-            const Real jd = geod.getJacobiQDot();
-            const Real tau = geod.getTorsionQ();
-            const Real kappa = geod.getCurvatureQ();
-            const Real mu = geod.getBinormalCurvatureQ();
-
-           // printf("eh=%g es=%g, eb=%g, j=%g, tau=%g, kappa=%g, mu=%g\n",
-            //  eh,es,eb,j,tau,kappa,mu);
-
-            Mat22 newJ( -(jd*es+j*(mu*eh-1)),      -tau*eh,
-                         -(j*tau*eh-jd*eb),      1-kappa*eh );
+            const Mat22 newJ = calcOrthogonalGeodErrorJacobian(geod, r_QQhat);
 
             //cout << "   J=" << J;
             //cout << "newJ=" << newJ;
@@ -2023,6 +2203,7 @@ void ContactGeometryImpl::calcGeodesicUsingOrthogonalMethod
     if (f > ftol)
         std::cout << "### ORTHO geodesic DIVERGED in " 
                     << MaxIterations << " iterations with err=" << f << std::endl;
+    stepSizeHint = NaN;
 
     // Finish each geodesic with reverse Jacobi field.
 #ifdef USE_NEW_INTEGRATOR
@@ -2031,6 +2212,8 @@ void ContactGeometryImpl::calcGeodesicUsingOrthogonalMethod
     calcGeodesicReverseSensitivity(geod, Vec2(0,1));
 #endif
 
+    if (f <= ftol)
+        rememberGeodesic(P, Q, geod);
 }
 
 
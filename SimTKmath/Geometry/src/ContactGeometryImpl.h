@@ -47,14 +47,19 @@ class SimTK_SIMMATH_EXPORT ContactGeometryImpl {
 public:
     ContactGeometryImpl() 
     :   myHandle(0), ptOnSurfSys(0), geodHitPlaneEvent(0), vizReporter(0),
-        splitGeodErr(0), numGeodesicsShot(0)
+        splitGeodErr(0), numGeodesicsShot(0), stepSizeHint(NaN),
+        geodesicAccuracy(DefaultGeodesicAccuracy), 
+        geodCacheSize(DefaultGeodesicCacheSize), geodCacheClock(0)
     {
         createParticleOnSurfaceSystem();
+        resetGeodesicCacheStatistics();
     }
     ContactGeometryImpl(const ContactGeometryImpl& source)
     :   myHandle(0), ptOnSurfSys(0), geodHitPlaneEvent(0), vizReporter(0),
-        splitGeodErr(0), numGeodesicsShot(0) 
-    {}
+        splitGeodErr(0), numGeodesicsShot(0), stepSizeHint(NaN),
+        geodesicAccuracy(source.geodesicAccuracy),
+        geodCacheSize(source.geodCacheSize), geodCacheClock(0)
+    {   resetGeodesicCacheStatistics(); }
 
     virtual ~ContactGeometryImpl() {
         clearMyHandle();
@@ -171,7 +176,15 @@ public:
     // and binormal directions.
     void calcGeodesicUsingOrthogonalMethod
        (const Vec3& xP, const Vec3& xQ,
-        const Vec3& tPhint, Real lengthHint, Geodesic& geod) const; 
+        const Vec3& tPhint, Real lengthHint, Geodesic& geod) const
+    {   calcGeodesicUsingOrthogonalMethod(xP, xQ, tPhint, lengthHint, 0, geod); }
+
+    // Same, but if no remembered geodesic is near P and Q we'll try to warm
+    // start from the given one instead (if not null).
+    void calcGeodesicUsingOrthogonalMethod
+       (const Vec3& xP, const Vec3& xQ,
+        const Vec3& tPhint, Real lengthHint, const Geodesic* neighbor,
+        Geodesic& geod) const; 
 
     // Utility method to calculate the "geodesic error" between one geodesic
     // shot from P in the direction tP and another geodesic shot from Q in the
@@ -391,6 +404,62 @@ public:
         return numGeodesicsShot;
     }
 
+    // Geodesic caching; see ContactGeometry for the public interface. It is
+    // off by default since warm-started results depend on earlier calls.
+    static const int DefaultGeodesicCacheSize = 0;
+
+    void setGeodesicCacheSize(int n) {
+        geodCacheSize = n;
+        clearGeodesicCache();
+    }
+    int getGeodesicCacheSize() const {return geodCacheSize;}
+    void clearGeodesicCache() const {geodCache.clear();}
+
+    void setGeodesicAccuracy(Real accuracy) {
+        geodesicAccuracy = accuracy;
+        clearGeodesicCache(); // remembered geodesics are for the old accuracy
+    }
+    Real getGeodesicAccuracy() const {return geodesicAccuracy;}
+
+    // Copies of a surface get their own (empty) cache but keep the settings.
+    void copyGeodesicSettings(const ContactGeometryImpl& src) {
+        geodesicAccuracy = src.geodesicAccuracy;
+        geodCacheSize    = src.geodCacheSize;
+    }
+
+    int getNumGeodesicCacheHits() const {return numGeodCacheHits;}
+    int getNumGeodesicCacheWarmStarts() const {return numGeodCacheWarmStarts;}
+    int getNumGeodesicCacheMisses() const {return numGeodCacheMisses;}
+    void resetGeodesicCacheStatistics() const {
+        numGeodCacheHits = numGeodCacheWarmStarts = numGeodCacheMisses = 0;
+    }
+
+    // Return the index of the remembered geodesic whose end points are 
+    // nearest P and Q, considering only those near enough to warm start from
+    // and whose starting direction agrees with tPhint. Returns -1 if there is
+    // none. On return isExact says whether the end points match exactly.
+    int findCachedGeodesic(const Vec3& P, const Vec3& Q, const Vec3& tPhint,
+                           bool& isExact) const;
+
+    // Return a remembered geodesic, noting that it has just been used.
+    const Geodesic& useCachedGeodesic(int which) const {
+        geodCache[which].lastUsed = ++geodCacheClock;
+        return geodCache[which].geod;
+    }
+
+    // Remember a newly calculated geodesic that was requested for end points
+    // P and Q, replacing the least recently used one if the cache is full.
+    void rememberGeodesic(const Vec3& P, const Vec3& Q, 
+                          const Geodesic& geod) const;
+
+    // Use a nearby geodesic and its sensitivities to predict the unknowns
+    // (thetaP, length) for the orthogonal method for a geodesic from P to Q,
+    // setting the member basis R_SP to go with them. Returns false if the
+    // neighbor is too far away for the prediction to be trusted.
+    bool predictOrthogonalUnknowns(const Geodesic& neighbor, 
+                                   const Vec3& P, const Vec3& Q, 
+                                   Vec2& x) const;
+
     void addVizReporter(ScheduledEventReporter* reporter) const {
         vizReporter = reporter;
         ptOnSurfSys->addEventReporter(vizReporter); // takes ownership
@@ -433,7 +502,24 @@ protected:
     mutable Rotation R_SP;
     mutable Rotation R_SQ;
     mutable int numGeodesicsShot;
-
+    mutable Real stepSizeHint; // NaN if none; used by shootGeodesicInDirection2
+
+    // The accuracy to which geodesic equations are integrated.
+    static const Real DefaultGeodesicAccuracy;
+    Real geodesicAccuracy;
+
+    // Recently calculated two-point geodesics, in no particular order. The
+    // geodesic's own end points match the requested ones P and Q only to
+    // within the solution tolerance, so we keep the requested ones as keys.
+    struct CachedGeodesic {
+        Vec3        P, Q;
+        Geodesic    geod;
+        long long   lastUsed; // geodCacheClock value at last use
+    };
+    int                             geodCacheSize;
+    mutable Array_<CachedGeodesic>  geodCache;
+    mutable long long               geodCacheClock;
+    mutable int numGeodCacheHits, numGeodCacheWarmStarts, numGeodCacheMisses;
 };
 
 
@@ -991,12 +1077,51 @@ public:
     OBBTreeNodeImpl* child2;
     Array_<int> triangles;
     int numTriangles;
+};
+
+
+
+//==============================================================================
+//                              FLAT OBB TREE
+//==============================================================================
+// A copy of a mesh's OBBTreeNodeImpl hierarchy packed into contiguous arrays
+// for fast point and ray queries. Internal nodes are stored breadth first and
+// each one holds the boxes of both of its children side by side ("lane" 0 is
+// the first child, lane 1 the second) so that both can be tested at once with
+// SSE2 where it is available. Leaf triangles are concatenated into a single
+// array. Traversal uses an explicit stack taken from the thread's
+// ScratchArena rather than recursion.
+class FlatOBBTree {
+public:
+    FlatOBBTree() : maxDepth(0) {}
+    void build(const OBBTreeNodeImpl& root);
     Vec3 findNearestPoint(const ContactGeometry::TriangleMesh::Impl& mesh, 
-                          const Vec3& position, Real cutoff2, Real& distance2, 
+                          const Vec3& position, Real& distance2, 
                           int& face, Vec2& uv) const;
     bool intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh, 
                        const Vec3& origin, const UnitVec3& direction, 
                        Real& distance, int& face, Vec2& uv) const;
+private:
+    // The box of child c is, in lane c of each field, the set of points p
+    // with 0 <= ~axis[i]*(p-origin) <= size[i] for each axis i.
+    struct Node {
+        Real axis[3][3][2];     // [box axis][Ground component][lane]
+        Real origin[3][2];
+        Real size[3][2];
+        int  child[2];          // >= 0: index of a Node; < 0: ~leaf index
+    };
+    // Test a query against both child boxes of a Node: the squared distance
+    // from a point to each box, or whether and where a ray enters each box.
+    void calcBoxDistance2(const Node& node, const Vec3& position, 
+                          Real dist2[2]) const;
+    void intersectBoxes(const Node& node, const Vec3& origin, 
+                        const Vec3& direction, bool hit[2], 
+                        Real dist[2]) const;
+
+    Array_<Node> nodes;
+    Array_<int>  leafStart;     // leaf i is triangles[leafStart[i]..[i+1])
+    Array_<int>  triangles;
+    int          maxDepth;      // number of internal levels
 };
 
 
@@ -1010,9 +1135,11 @@ public:
     class Face;
     class Vertex;
 
+    // If obbTree is given, the OBB tree is read from it rather than built.
     Impl(const ArrayViewConst_<Vec3>& vertexPositions, 
-         const ArrayViewConst_<int>& faceIndices, bool smooth);
-    Impl(const PolygonalMesh& mesh, bool smooth);
+         const ArrayViewConst_<int>& faceIndices, bool smooth,
+         std::istream* obbTree = NULL);
+    Impl(const PolygonalMesh& mesh, bool smooth, std::istream* obbTree = NULL);
     ContactGeometryImpl* clone() const override {
         return new Impl(*this);
     }
@@ -1035,6 +1162,7 @@ public:
     bool intersectsRay(const Vec3& origin, const UnitVec3& direction, 
                        Real& distance, int& face, Vec2& uv) const;
     void getBoundingSphere(Vec3& center, Real& radius) const override;
+    void writeObbTree(std::ostream& out) const;
 
     bool isSmooth() const override {return false;}
     bool isConvex() const override {return false;}
@@ -1047,15 +1175,22 @@ public:
         return id;
     }
 private:
-    void init(const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices);
-    void createObbTree(OBBTreeNodeImpl& node, const Array_<int>& faceIndices);
-    void splitObbAxis(const Array_<int>& parentIndices, 
-                      Array_<int>& child1Indices, 
-                      Array_<int>& child2Indices, int axis);
+    class CreateObbTreeTask;
+
+    void init(const Array_<Vec3>& vertexPositions, 
+              const Array_<int>& faceIndices, std::istream* obbTree);
+    void createObbTree(OBBTreeNodeImpl& node, const Array_<int>& faceIndices,
+                       ParallelWorkQueue* queue);
+    bool splitObbSAH(const OrientedBoundingBox& bounds, 
+                     const Array_<int>& parentIndices, 
+                     Array_<int>& child1Indices, 
+                     Array_<int>& child2Indices) const;
+    void readObbTree(std::istream& in);
+    unsigned long long calcMeshSignature() const;
     void findBoundingSphere(Vec3* point[], int p, int b, 
                             Vec3& center, Real& radius);
     friend class ContactGeometry::TriangleMesh;
-    friend class OBBTreeNodeImpl;
+    friend class FlatOBBTree;
 
     Array_<Edge>    edges;
     Array_<Face>    faces;
@@ -1063,6 +1198,7 @@ private:
     Vec3            boundingSphereCenter;
     Real            boundingSphereRadius;
     OBBTreeNodeImpl obb;
+    FlatOBBTree     flatObb;
     bool            smooth;
 };
 
@@ -63,6 +63,22 @@ getBicubicSurface() const {return getImpl().getBicubicSurface();}
 const OBBTree& ContactGeometry::SmoothHeightMap::
 getOBBTree() const {return getImpl().getOBBTree();}
 
+void ContactGeometry::SmoothHeightMap::
+calcSurfaceHeights(const Array_<Vec2>& xy, Array_<Real>& height) const
+{   getBicubicSurface().calcValues(xy, height); }
+
+void ContactGeometry::SmoothHeightMap::
+calcSurfaceHeights(const Array_<Vec2>& xy, Array_<Real>& height,
+                   Array_<UnitVec3>& normal) const {
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Array_<Vec2> gradient = arena.allocateArray<Vec2>((int)xy.size());
+    getBicubicSurface().calcValues(xy, height, gradient);
+    normal.resize(xy.size());
+    for (unsigned i=0; i < xy.size(); ++i)
+        normal[i] = UnitVec3(-gradient[i][0], -gradient[i][1], 1);
+}
+
 const ContactGeometry::SmoothHeightMap::Impl& ContactGeometry::SmoothHeightMap::
 getImpl() const {
     assert(impl);
@@ -30,6 +30,7 @@
 
 #include "ContactGeometryImpl.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <map>
@@ -42,6 +43,22 @@ using std::set;
 using std::string;
 using std::cout; using std::endl;
 
+namespace {
+// OBB tree construction parameters. Subtrees with at least MinFacesForObbTask
+// faces are built as separate tasks when multiple processors are available.
+// Split planes are chosen among NumObbBins evenly spaced candidates along
+// each axis, and a node with no more than MaxObbLeafFaces faces is left
+// unsplit if the surface area heuristic says splitting wouldn't pay.
+const int MinFacesForObbTask = 2048;
+const int NumObbBins = 16;
+const int MaxObbLeafFaces = 8;
+
+// Surface area of a box with the given edge lengths.
+Real calcBoxArea(const Vec3& size) {
+    return 2*(size[0]*size[1] + size[1]*size[2] + size[2]*size[0]);
+}
+}
+
 //==============================================================================
 //                  CONTACT GEOMETRY :: TRIANGLE MESH
 //==============================================================================
@@ -55,6 +72,17 @@ ContactGeometry::TriangleMesh::TriangleMesh
    (const PolygonalMesh& mesh, bool smooth) 
 :   ContactGeometry(new TriangleMesh::Impl(mesh, smooth)) {}
 
+ContactGeometry::TriangleMesh::TriangleMesh
+   (const ArrayViewConst_<Vec3>& vertices, 
+    const ArrayViewConst_<int>& faceIndices, std::istream& obbTree, 
+    bool smooth) 
+:   ContactGeometry(new TriangleMesh::Impl(vertices, faceIndices, smooth, 
+                                           &obbTree)) {}
+
+ContactGeometry::TriangleMesh::TriangleMesh
+   (const PolygonalMesh& mesh, std::istream& obbTree, bool smooth) 
+:   ContactGeometry(new TriangleMesh::Impl(mesh, smooth, &obbTree)) {}
+
 /*static*/ ContactGeometryTypeId ContactGeometry::TriangleMesh::classTypeId() 
 {   return ContactGeometry::TriangleMesh::Impl::classTypeId(); }
 
@@ -183,6 +211,10 @@ bool ContactGeometry::TriangleMesh::intersectsRay
     return getImpl().intersectsRay(origin, direction, distance, face, uv);
 }
 
+void ContactGeometry::TriangleMesh::writeOBBTree(std::ostream& out) const {
+    getImpl().writeObbTree(out);
+}
+
 ContactGeometry::TriangleMesh::OBBTreeNode 
 ContactGeometry::TriangleMesh::getOBBTreeNode() const {
     return OBBTreeNode(getImpl().obb);
@@ -257,7 +289,8 @@ Vec3 ContactGeometry::TriangleMesh::Impl::
 findNearestPoint(const Vec3& position, bool& inside, int& face, Vec2& uv) const 
 {
     Real distance2;
-    Vec3 nearestPoint = obb.findNearestPoint(*this, position, MostPositiveReal, distance2, face, uv);
+    Vec3 nearestPoint = flatObb.findNearestPoint(*this, position, distance2, 
+                                                 face, uv);
     Vec3 delta = position-nearestPoint;
     inside = (~delta*faces[face].normal < 0);
     return nearestPoint;
@@ -280,7 +313,7 @@ intersectsRay(const Vec3& origin, const UnitVec3& direction, Real& distance,
     Real boundsDistance;
     if (!obb.bounds.intersectsRay(origin, direction, boundsDistance))
         return false;
-    return obb.intersectsRay(*this, origin, direction, distance, face, uv);
+    return flatObb.intersectsRay(*this, origin, direction, distance, face, uv);
 }
 
 void ContactGeometry::TriangleMesh::Impl::
@@ -302,13 +335,14 @@ createPolygonalMesh(PolygonalMesh& mesh) const {
 
 ContactGeometry::TriangleMesh::Impl::Impl
    (const ArrayViewConst_<Vec3>& vertexPositions, 
-    const ArrayViewConst_<int>& faceIndices, bool smooth) 
+    const ArrayViewConst_<int>& faceIndices, bool smooth, 
+    std::istream* obbTree) 
 :   ContactGeometryImpl(), smooth(smooth) {
-    init(vertexPositions, faceIndices);
+    init(vertexPositions, faceIndices, obbTree);
 }
 
 ContactGeometry::TriangleMesh::Impl::Impl
-   (const PolygonalMesh& mesh, bool smooth) 
+   (const PolygonalMesh& mesh, bool smooth, std::istream* obbTree) 
 :   ContactGeometryImpl(), smooth(smooth) 
 {   // Create the mesh, triangulating faces as necessary.
     Array_<Vec3>    vertexPositions;
@@ -354,7 +388,7 @@ ContactGeometry::TriangleMesh::Impl::Impl
             faceIndices.push_back(newIndex);
         }
     }
-    init(vertexPositions, faceIndices);
+    init(vertexPositions, faceIndices, obbTree);
     
     // Make sure the mesh normals are oriented correctly.
     
@@ -400,7 +434,8 @@ ContactGeometry::TriangleMesh::Impl::Impl
 }
 
 void ContactGeometry::TriangleMesh::Impl::init
-   (const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices) 
+   (const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices,
+    std::istream* obbTree) 
 {   SimTK_APIARGCHECK_ALWAYS(faceIndices.size()%3 == 0, 
         "ContactGeometry::TriangleMesh::Impl", "TriangleMesh::Impl", 
         "The number of indices must be a multiple of 3.");
@@ -529,12 +564,25 @@ void ContactGeometry::TriangleMesh::Impl::init
     for (int i = 0; i < (int) vertices.size(); i++)
         vertices[i].normal = UnitVec3(vertNorm[i]);
     
-    // Create the OBBTree.
+    // Create the OBBTree, or read it if it was saved previously. Large
+    // subtrees are built in parallel.
     
-    Array_<int> allFaces(faces.size());
-    for (int i = 0; i < (int) allFaces.size(); i++)
-        allFaces[i] = i;
-    createObbTree(obb, allFaces);
+    if (obbTree != NULL)
+        readObbTree(*obbTree);
+    else {
+        Array_<int> allFaces(faces.size());
+        for (int i = 0; i < (int) allFaces.size(); i++)
+            allFaces[i] = i;
+        const int numThreads = ParallelExecutor::getNumProcessors();
+        if (numThreads > 1 && (int) faces.size() >= 2*MinFacesForObbTask) {
+            ParallelWorkQueue queue(faces.size(), numThreads);
+            createObbTree(obb, allFaces, &queue);
+            queue.flush();
+        }
+        else
+            createObbTree(obb, allFaces, NULL);
+    }
+    flatObb.build(obb);
     
     // Find the bounding sphere.
     Array_<const Vec3*> points(vertices.size());
@@ -545,76 +593,61 @@ void ContactGeometry::TriangleMesh::Impl::init
     boundingSphereRadius = bnd.getRadius();
 }
 
+// Builds the subtree below one node on a ParallelWorkQueue thread.
+class ContactGeometry::TriangleMesh::Impl::CreateObbTreeTask 
+:   public ParallelWorkQueue::Task {
+public:
+    CreateObbTreeTask(Impl& mesh, OBBTreeNodeImpl& node, 
+                      Array_<int>& faceIndices, ParallelWorkQueue& queue) 
+    :   mesh(mesh), node(node), queue(queue) {
+        this->faceIndices.swap(faceIndices);
+    }
+    void execute() override {
+        mesh.createObbTree(node, faceIndices, &queue);
+    }
+private:
+    Impl&               mesh;
+    OBBTreeNodeImpl&    node;
+    Array_<int>         faceIndices;
+    ParallelWorkQueue&  queue;
+};
+
 void ContactGeometry::TriangleMesh::Impl::createObbTree
-   (OBBTreeNodeImpl& node, const Array_<int>& faceIndices) 
+   (OBBTreeNodeImpl& node, const Array_<int>& faceIndices, 
+    ParallelWorkQueue* queue) 
 {   // Find all vertices in the node and build the OrientedBoundingBox.
     node.numTriangles = faceIndices.size();
-    set<int> vertexIndices;
+    Array_<int> vertexIndices;
+    vertexIndices.reserve(3*faceIndices.size());
     for (int i = 0; i < (int) faceIndices.size(); i++) 
         for (int j = 0; j < 3; j++)
-            vertexIndices.insert(faces[faceIndices[i]].vertices[j]);
+            vertexIndices.push_back(faces[faceIndices[i]].vertices[j]);
+    std::sort(vertexIndices.begin(), vertexIndices.end());
+    vertexIndices.resize(std::unique(vertexIndices.begin(), 
+                                     vertexIndices.end()) 
+                         - vertexIndices.begin());
     Vector_<Vec3> points((int)vertexIndices.size());
-    int index = 0;
-    for (set<int>::iterator iter = vertexIndices.begin(); 
-                            iter != vertexIndices.end(); ++iter)
-        points[index++] = vertices[*iter].pos;
+    for (int i = 0; i < (int) vertexIndices.size(); i++)
+        points[i] = vertices[vertexIndices[i]].pos;
     node.bounds = OrientedBoundingBox(points);
     if (faceIndices.size() > 3) {
-
-        // Order the axes by size.
-
-        int axisOrder[3];
-        const Vec3& size = node.bounds.getSize();
-        if (size[0] > size[1]) {
-            if (size[0] > size[2]) {
-                axisOrder[0] = 0;
-                if (size[1] > size[2]) {
-                    axisOrder[1] = 1;
-                    axisOrder[2] = 2;
-                }
-                else {
-                    axisOrder[1] = 2;
-                    axisOrder[2] = 1;
-                }
-            }
-            else {
-                axisOrder[0] = 2;
-                axisOrder[1] = 0;
-                axisOrder[2] = 1;
-            }
-        }
-        else if (size[0] > size[2]) {
-            axisOrder[0] = 1;
-            axisOrder[1] = 0;
-            axisOrder[2] = 2;
-        }
-        else {
-            if (size[1] > size[2]) {
-                axisOrder[0] = 1;
-                axisOrder[1] = 2;
-            }
-            else {
-                axisOrder[0] = 2;
-                axisOrder[1] = 1;
-            }
-            axisOrder[2] = 0;
-        }
-
-        // Try splitting along each axis.
-
-        for (int i = 0; i < 3; i++) {
-            Array_<int> child1Indices, child2Indices;
-            splitObbAxis(faceIndices, child1Indices, child2Indices, 
-                         axisOrder[i]);
-            if (child1Indices.size() > 0 && child2Indices.size() > 0) {
-                // It was successfully split, so create the child nodes.
-
-                node.child1 = new OBBTreeNodeImpl();
-                node.child2 = new OBBTreeNodeImpl();
-                createObbTree(*node.child1, child1Indices);
-                createObbTree(*node.child2, child2Indices);
-                return;
-            }
+        Array_<int> child1Indices, child2Indices;
+        if (splitObbSAH(node.bounds, faceIndices, child1Indices, 
+                        child2Indices)) {
+            // It was successfully split, so create the child nodes. A large
+            // first child is handed to the work queue if there is one, while
+            // this thread goes on with the second.
+
+            node.child1 = new OBBTreeNodeImpl();
+            node.child2 = new OBBTreeNodeImpl();
+            if (queue != NULL && 
+                (int) child1Indices.size() >= MinFacesForObbTask)
+                queue->addTask(new CreateObbTreeTask(*this, *node.child1, 
+                                                     child1Indices, *queue));
+            else
+                createObbTree(*node.child1, child1Indices, queue);
+            createObbTree(*node.child2, child2Indices, queue);
+            return;
         }
     }
     
@@ -624,39 +657,266 @@ void ContactGeometry::TriangleMesh::Impl::createObbTree
                           faceIndices.end());
 }
 
-void ContactGeometry::TriangleMesh::Impl::splitObbAxis
-   (const Array_<int>& parentIndices, Array_<int>& child1Indices, 
-    Array_<int>& child2Indices, int axis) 
-{   // For each face, find its minimum and maximum extent along the axis.
-    Vector minExtent(parentIndices.size());
-    Vector maxExtent(parentIndices.size());
-    for (int i = 0; i < (int) parentIndices.size(); i++) {
-        int* vertexIndices = faces[parentIndices[i]].vertices;
-        Real minVal = vertices[vertexIndices[0]].pos[axis];
-        Real maxVal = vertices[vertexIndices[0]].pos[axis];
-        minVal = std::min(minVal, vertices[vertexIndices[1]].pos[axis]);
-        maxVal = std::max(maxVal, vertices[vertexIndices[1]].pos[axis]);
-        minExtent[i] = std::min(minVal, vertices[vertexIndices[2]].pos[axis]);
-        maxExtent[i] = std::max(maxVal, vertices[vertexIndices[2]].pos[axis]);
+bool ContactGeometry::TriangleMesh::Impl::splitObbSAH
+   (const OrientedBoundingBox& bounds, const Array_<int>& parentIndices, 
+    Array_<int>& child1Indices, Array_<int>& child2Indices) const
+{   // Express the extent and centroid of each face in the frame of the 
+    // parent's box.
+    const int n = parentIndices.size();
+    const Rotation& R = bounds.getTransform().R();
+    Array_<Vec3> faceMin(n), faceMax(n), centroid(n);
+    for (int i = 0; i < n; i++) {
+        const Face& f = faces[parentIndices[i]];
+        const Vec3 p0 = ~R*vertices[f.vertices[0]].pos;
+        const Vec3 p1 = ~R*vertices[f.vertices[1]].pos;
+        const Vec3 p2 = ~R*vertices[f.vertices[2]].pos;
+        for (int j = 0; j < 3; j++) {
+            faceMin[i][j] = std::min(p0[j], std::min(p1[j], p2[j]));
+            faceMax[i][j] = std::max(p0[j], std::max(p1[j], p2[j]));
+        }
+        centroid[i] = (p0+p1+p2)/3;
     }
     
-    // Select a split point that tries to put as many faces as possible 
-    // entirely on one side or the other.
+    // Along each axis of the box, sort the faces into bins by centroid and
+    // evaluate the surface area heuristic at each boundary between bins: the
+    // cost of a split is the number of faces on each side weighted by the 
+    // surface area of a box enclosing them, which is proportional to the 
+    // chance that a query needs to look inside it.
+    
+    Real bestCost = MostPositiveReal;
+    int bestAxis = -1, bestBin = 0;
+    Real bestMin = 0, bestScale = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        Real minCentroid = MostPositiveReal, maxCentroid = MostNegativeReal;
+        for (int i = 0; i < n; i++) {
+            minCentroid = std::min(minCentroid, centroid[i][axis]);
+            maxCentroid = std::max(maxCentroid, centroid[i][axis]);
+        }
+        if (!(maxCentroid > minCentroid))
+            continue; // All centroids are in the same plane.
+        const Real scale = NumObbBins/(maxCentroid-minCentroid);
+        int count[NumObbBins] = {0};
+        Vec3 binMin[NumObbBins], binMax[NumObbBins];
+        for (int b = 0; b < NumObbBins; b++) {
+            binMin[b] = Vec3(MostPositiveReal);
+            binMax[b] = Vec3(MostNegativeReal);
+        }
+        for (int i = 0; i < n; i++) {
+            const int b = std::min(NumObbBins-1, 
+                (int) ((centroid[i][axis]-minCentroid)*scale));
+            count[b]++;
+            for (int j = 0; j < 3; j++) {
+                binMin[b][j] = std::min(binMin[b][j], faceMin[i][j]);
+                binMax[b][j] = std::max(binMax[b][j], faceMax[i][j]);
+            }
+        }
+        
+        // Sweep down from the top to find the cost of everything above each
+        // boundary, then up from the bottom to evaluate the splits.
+        
+        Real aboveCost[NumObbBins];
+        Vec3 lo(MostPositiveReal), hi(MostNegativeReal);
+        int num = 0;
+        for (int b = NumObbBins-1; b > 0; b--) {
+            num += count[b];
+            for (int j = 0; j < 3; j++) {
+                lo[j] = std::min(lo[j], binMin[b][j]);
+                hi[j] = std::max(hi[j], binMax[b][j]);
+            }
+            aboveCost[b] = (num == 0 ? 0 : num*calcBoxArea(hi-lo));
+        }
+        lo = Vec3(MostPositiveReal);
+        hi = Vec3(MostNegativeReal);
+        num = 0;
+        for (int b = 0; b < NumObbBins-1; b++) {
+            num += count[b];
+            for (int j = 0; j < 3; j++) {
+                lo[j] = std::min(lo[j], binMin[b][j]);
+                hi[j] = std::max(hi[j], binMax[b][j]);
+            }
+            if (num == 0 || num == n)
+                continue;
+            const Real cost = num*calcBoxArea(hi-lo) + aboveCost[b+1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b+1;
+                bestMin = minCentroid;
+                bestScale = scale;
+            }
+        }
+    }
+    if (bestAxis < 0)
+        return false; // All the centroids coincide.
     
-    Real split = (median(minExtent)+median(maxExtent)) / 2;
+    // A small node isn't worth splitting unless the cost of testing the 
+    // extra box is made up by not having to test all its faces.
     
-    // Choose a side for each face.
+    if (n <= MaxObbLeafFaces && 
+        bestCost >= (n-1)*calcBoxArea(bounds.getSize()))
+        return false;
     
-    for (int i = 0; i < (int) parentIndices.size(); i++) {
-        if (maxExtent[i] <= split)
-            child1Indices.push_back(parentIndices[i]);
-        else if (minExtent[i] >= split)
-            child2Indices.push_back(parentIndices[i]);
-        else if (0.5*(minExtent[i]+maxExtent[i]) <= split)
+    for (int i = 0; i < n; i++) {
+        const int b = std::min(NumObbBins-1, 
+            (int) ((centroid[i][bestAxis]-bestMin)*bestScale));
+        if (b < bestBin)
             child1Indices.push_back(parentIndices[i]);
         else
             child2Indices.push_back(parentIndices[i]);
     }
+    return true;
+}
+
+unsigned long long ContactGeometry::TriangleMesh::Impl::
+calcMeshSignature() const {
+    // A 64 bit FNV-1a hash of the vertex positions and the set of vertices
+    // in each face. The order of vertices within a face is ignored since it
+    // may be reversed after the tree is built to orient the normals.
+    unsigned long long hash = 14695981039346656037ULL;
+    const auto add = [&hash](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    for (int i = 0; i < (int) vertices.size(); i++)
+        add(&vertices[i].pos[0], 3*sizeof(Real));
+    for (int i = 0; i < (int) faces.size(); i++) {
+        int v[3] = {faces[i].vertices[0], faces[i].vertices[1], 
+                    faces[i].vertices[2]};
+        std::sort(v, v+3);
+        add(v, sizeof(v));
+    }
+    return hash;
+}
+
+namespace {
+const char ObbTreeMagic[8] = {'S', 'i', 'm', 'T', 'K', 'O', 'B', 'B'};
+const int ObbTreeFormatVersion = 1;
+
+template <class T>
+void writeObbValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+T readObbValue(std::istream& in) {
+    T value = T();
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+// Nodes are written depth first: the number of triangles, whether it is a
+// leaf, the box's rotation (by rows), origin and size, and then for a leaf
+// its triangles or otherwise its two children.
+void writeObbNode(std::ostream& out, const OBBTreeNodeImpl& node) {
+    writeObbValue<int>(out, node.numTriangles);
+    writeObbValue<char>(out, node.child1 == NULL);
+    const Transform& X = node.bounds.getTransform();
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            writeObbValue<Real>(out, X.R()[i][j]);
+    for (int i = 0; i < 3; i++)
+        writeObbValue<Real>(out, X.p()[i]);
+    for (int i = 0; i < 3; i++)
+        writeObbValue<Real>(out, node.bounds.getSize()[i]);
+    if (node.child1 == NULL)
+        out.write(reinterpret_cast<const char*>(node.triangles.begin()), 
+                  node.triangles.size()*sizeof(int));
+    else {
+        writeObbNode(out, *node.child1);
+        writeObbNode(out, *node.child2);
+    }
+}
+
+// Read a node written by writeObbNode(), which must contain at most 
+// maxTriangles triangles. Each triangle read is counted in faceCount.
+void readObbNode(std::istream& in, OBBTreeNodeImpl& node, int maxTriangles, 
+                 Array_<int>& faceCount) {
+    node.numTriangles = readObbValue<int>(in);
+    const bool isLeaf = readObbValue<char>(in) != 0;
+    Mat33 R;
+    Vec3 p, size;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            R(i, j) = readObbValue<Real>(in);
+    for (int i = 0; i < 3; i++)
+        p[i] = readObbValue<Real>(in);
+    for (int i = 0; i < 3; i++)
+        size[i] = readObbValue<Real>(in);
+    SimTK_ERRCHK_ALWAYS(in.good() && node.numTriangles > 0 
+                        && node.numTriangles <= maxTriangles
+                        && (isLeaf || node.numTriangles > 1), 
+        "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+        "The OBB tree data is truncated or corrupt.");
+    node.bounds = OrientedBoundingBox(Transform(Rotation(R, true), p), size);
+    if (isLeaf) {
+        node.triangles.resize(node.numTriangles);
+        in.read(reinterpret_cast<char*>(node.triangles.begin()), 
+                node.numTriangles*sizeof(int));
+        SimTK_ERRCHK_ALWAYS(in.good(),
+            "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+            "The OBB tree data is truncated or corrupt.");
+        for (int i = 0; i < node.numTriangles; i++) {
+            const int face = node.triangles[i];
+            SimTK_ERRCHK_ALWAYS(face >= 0 && face < (int) faceCount.size()
+                                && ++faceCount[face] == 1,
+                "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+                "The OBB tree data is truncated or corrupt.");
+        }
+        return;
+    }
+    node.child1 = new OBBTreeNodeImpl();
+    node.child2 = new OBBTreeNodeImpl();
+    readObbNode(in, *node.child1, node.numTriangles-1, faceCount);
+    readObbNode(in, *node.child2, node.numTriangles-node.child1->numTriangles,
+                faceCount);
+    SimTK_ERRCHK_ALWAYS(node.child1->numTriangles + node.child2->numTriangles
+                        == node.numTriangles,
+        "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+        "The OBB tree data is truncated or corrupt.");
+}
+}
+
+void ContactGeometry::TriangleMesh::Impl::
+writeObbTree(std::ostream& out) const {
+    out.write(ObbTreeMagic, sizeof(ObbTreeMagic));
+    writeObbValue<int>(out, ObbTreeFormatVersion);
+    writeObbValue<int>(out, (int) sizeof(Real));
+    writeObbValue<int>(out, (int) vertices.size());
+    writeObbValue<int>(out, (int) faces.size());
+    writeObbValue<unsigned long long>(out, calcMeshSignature());
+    writeObbNode(out, obb);
+    SimTK_ERRCHK_ALWAYS(out.good(), 
+        "ContactGeometry::TriangleMesh::writeOBBTree()",
+        "An error occurred while writing the OBB tree.");
+}
+
+void ContactGeometry::TriangleMesh::Impl::readObbTree(std::istream& in) {
+    char magic[sizeof(ObbTreeMagic)];
+    in.read(magic, sizeof(magic));
+    const int version = readObbValue<int>(in);
+    const int realSize = readObbValue<int>(in);
+    SimTK_ERRCHK_ALWAYS(in.good() 
+                        && std::equal(magic, magic+sizeof(magic), ObbTreeMagic)
+                        && version == ObbTreeFormatVersion 
+                        && realSize == (int) sizeof(Real),
+        "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+        "The data is not an OBB tree written by this version of SimTK.");
+    const int numVertices = readObbValue<int>(in);
+    const int numFaces = readObbValue<int>(in);
+    const unsigned long long signature = readObbValue<unsigned long long>(in);
+    SimTK_ERRCHK_ALWAYS(in.good() && numVertices == (int) vertices.size() 
+                        && numFaces == (int) faces.size()
+                        && signature == calcMeshSignature(),
+        "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+        "The OBB tree was saved from a different mesh.");
+    Array_<int> faceCount(faces.size(), 0);
+    readObbNode(in, obb, faces.size(), faceCount);
+    SimTK_ERRCHK_ALWAYS(obb.numTriangles == (int) faces.size(),
+        "ContactGeometry::TriangleMesh::Impl::readObbTree()",
+        "The OBB tree data is truncated or corrupt.");
 }
 
 Vec3 ContactGeometry::TriangleMesh::Impl::findNearestPointToFace
@@ -791,197 +1051,354 @@ OBBTreeNodeImpl::~OBBTreeNodeImpl() {
         delete child2;
 }
 
-Vec3 OBBTreeNodeImpl::findNearestPoint
-   (const ContactGeometry::TriangleMesh::Impl& mesh, 
-    const Vec3& position, Real cutoff2, 
-    Real& distance2, int& face, Vec2& uv) const 
-{
-    Real tol = 100*Eps;
-    if (child1 != NULL) {
-        // Recursively check the child nodes.
-        
-        Real child1distance2 = MostPositiveReal, 
-             child2distance2 = MostPositiveReal;
-        int child1face, child2face;
-        Vec2 child1uv, child2uv;
-        Vec3 child1point, child2point;
-        Real child1BoundsDist2 = 
-            (child1->bounds.findNearestPoint(position)-position).normSqr();
-        Real child2BoundsDist2 = 
-            (child2->bounds.findNearestPoint(position)-position).normSqr();
-        if (child1BoundsDist2 < child2BoundsDist2) {
-            if (child1BoundsDist2 < cutoff2) {
-                child1point = child1->findNearestPoint(mesh, position, cutoff2, child1distance2, child1face, child1uv);
-                if (child2BoundsDist2 < child1distance2 && child2BoundsDist2 < cutoff2)
-                    child2point = child2->findNearestPoint(mesh, position, cutoff2, child2distance2, child2face, child2uv);
+
+
+//==============================================================================
+//                              FLAT OBB TREE
+//==============================================================================
+
+namespace {
+// An entry on a FlatOBBTree traversal stack: a Node index (or ~leaf index)
+// and the distance from the query to its box.
+struct FlatOBBStackEntry {
+    int  code;
+    Real dist;
+};
+}
+
+void FlatOBBTree::build(const OBBTreeNodeImpl& root) {
+    nodes.clear();
+    leafStart.clear();
+    triangles.clear();
+    maxDepth = 0;
+    leafStart.push_back(0);
+    if (root.child1 == NULL) {
+        // The whole mesh is a single leaf; there are no internal nodes.
+        triangles = root.triangles;
+        leafStart.push_back(triangles.size());
+        return;
+    }
+
+    // Visit the internal nodes breadth first; each one's slot is reserved
+    // when it is queued, so children always follow their parents.
+    Array_<const OBBTreeNodeImpl*> queue(1, &root);
+    Array_<int> depth(1, 1);
+    nodes.resize(1);
+    for (int n = 0; n < (int) queue.size(); n++) {
+        const OBBTreeNodeImpl* children[2] = {queue[n]->child1, 
+                                              queue[n]->child2};
+        maxDepth = std::max(maxDepth, depth[n]);
+        for (int lane = 0; lane < 2; lane++) {
+            const OBBTreeNodeImpl& child = *children[lane];
+            const Transform& X = child.bounds.getTransform();
+            const Mat33& R = X.R().asMat33();
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++)
+                    nodes[n].axis[i][j][lane] = R(j, i);
+                nodes[n].origin[i][lane] = X.p()[i];
+                nodes[n].size[i][lane] = child.bounds.getSize()[i];
             }
-        }
-        else {
-            if (child2BoundsDist2 < cutoff2) {
-                child2point = child2->findNearestPoint(mesh, position, cutoff2, child2distance2, child2face, child2uv);
-                if (child1BoundsDist2 < child2distance2 && child1BoundsDist2 < cutoff2)
-                    child1point = child1->findNearestPoint(mesh, position, cutoff2, child1distance2, child1face, child1uv);
+            if (child.child1 == NULL) {
+                nodes[n].child[lane] = ~(int) (leafStart.size()-1);
+                for (int i = 0; i < (int) child.triangles.size(); i++)
+                    triangles.push_back(child.triangles[i]);
+                leafStart.push_back(triangles.size());
+            }
+            else {
+                nodes[n].child[lane] = queue.size();
+                queue.push_back(&child);
+                depth.push_back(depth[n]+1);
+                nodes.push_back(Node());
             }
         }
-        if (   child1distance2 <= child2distance2*(1+tol) 
-            && child2distance2 <= child1distance2*(1+tol)) {
-            // Decide based on angle which one to use.
-            
-            if (  std::abs(~(child1point-position)*mesh.faces[child1face].normal) 
-                > std::abs(~(child2point-position)*mesh.faces[child2face].normal))
-                child2distance2 = MostPositiveReal;
-            else
-                child1distance2 = MostPositiveReal;
-        }
-        if (child1distance2 < child2distance2) {
-            distance2 = child1distance2;
-            face = child1face;
-            uv = child1uv;
-            return child1point;
-        }
-        else {
-            distance2 = child2distance2;
-            face = child2face;
-            uv = child2uv;
-            return child2point;
-        }
-    }    
-    // This is a leaf node, so check each triangle for its distance to the point.
-    
-    distance2 = MostPositiveReal;
-    Vec3 nearestPoint;
-    for (int i = 0; i < (int) triangles.size(); i++) {
-        Vec2 triangleUV;
-        Vec3 p = mesh.findNearestPointToFace(position, triangles[i], triangleUV);
-        Vec3 offset = p-position;
-        // TODO: volatile to work around compiler bug
-        volatile Real d2 = offset.normSqr(); 
-        if (d2 < distance2 || (d2 < distance2*(1+tol) && std::abs(~offset*mesh.faces[triangles[i]].normal) > std::abs(~offset*mesh.faces[face].normal))) {
-            nearestPoint = p;
-            distance2 = d2;
-            face = triangles[i];
-            uv = triangleUV;
+    }
+}
+
+void FlatOBBTree::calcBoxDistance2
+   (const Node& node, const Vec3& position, Real dist2[2]) const {
+    // Transform the point to each box's frame, clamp it to the box, and
+    // accumulate the squared distance it had to move.
+#if defined(SimTK_SMALLMATRIX_USE_SSE2) && SimTK_DEFAULT_PRECISION == 2
+    __m128d d[3];
+    for (int j = 0; j < 3; j++)
+        d[j] = _mm_sub_pd(_mm_set1_pd(position[j]), 
+                          _mm_loadu_pd(node.origin[j]));
+    __m128d sum = _mm_setzero_pd();
+    for (int i = 0; i < 3; i++) {
+        __m128d p = _mm_mul_pd(_mm_loadu_pd(node.axis[i][0]), d[0]);
+        p = _mm_add_pd(p, _mm_mul_pd(_mm_loadu_pd(node.axis[i][1]), d[1]));
+        p = _mm_add_pd(p, _mm_mul_pd(_mm_loadu_pd(node.axis[i][2]), d[2]));
+        const __m128d clamped = _mm_min_pd(_mm_max_pd(p, _mm_setzero_pd()), 
+                                           _mm_loadu_pd(node.size[i]));
+        const __m128d delta = _mm_sub_pd(p, clamped);
+        sum = _mm_add_pd(sum, _mm_mul_pd(delta, delta));
+    }
+    _mm_storeu_pd(dist2, sum);
+#else
+    for (int lane = 0; lane < 2; lane++) {
+        Real d[3], sum = 0;
+        for (int j = 0; j < 3; j++)
+            d[j] = position[j]-node.origin[j][lane];
+        for (int i = 0; i < 3; i++) {
+            const Real p = node.axis[i][0][lane]*d[0] 
+                         + node.axis[i][1][lane]*d[1] 
+                         + node.axis[i][2][lane]*d[2];
+            const Real clamped = std::min(std::max(p, Real(0)), 
+                                          node.size[i][lane]);
+            sum += (p-clamped)*(p-clamped);
         }
+        dist2[lane] = sum;
     }
-    return nearestPoint;
+#endif
 }
 
-bool OBBTreeNodeImpl::
-intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh,
-              const Vec3& origin, const UnitVec3& direction, Real& distance, 
-              int& face, Vec2& uv) const {
-    if (child1 != NULL) {
-        // Recursively check the child nodes.
-        
-        Real child1distance, child2distance;
-        int child1face, child2face;
-        Vec2 child1uv, child2uv;
-        bool child1intersects = child1->bounds.intersectsRay(origin, direction, child1distance);
-        bool child2intersects = child2->bounds.intersectsRay(origin, direction, child2distance);
-        if (child1intersects) {
-            if (child2intersects) {
-                // The ray intersects both child nodes.  First check the closer one.
-                
-                if (child1distance < child2distance) {
-                    child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
-                    if (!child1intersects || child2distance < child1distance)
-                        child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
-                }
-                else {
-                    child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
-                    if (!child2intersects || child1distance < child2distance)
-                        child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
-                }
+void FlatOBBTree::intersectBoxes
+   (const Node& node, const Vec3& origin, const Vec3& direction, 
+    bool hit[2], Real dist[2]) const {
+    // This is the slab test of OrientedBoundingBox::intersectsRay() applied
+    // to both boxes. An axis the ray is parallel to doesn't limit the
+    // distance along the ray but rejects the box if the ray lies outside it.
+#if defined(SimTK_SMALLMATRIX_USE_SSE2) && SimTK_DEFAULT_PRECISION == 2
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d huge = _mm_set1_pd(MostPositiveReal);
+    __m128d d[3];
+    for (int j = 0; j < 3; j++)
+        d[j] = _mm_sub_pd(_mm_set1_pd(origin[j]), 
+                          _mm_loadu_pd(node.origin[j]));
+    __m128d minDist = _mm_set1_pd(MostNegativeReal);
+    __m128d maxDist = huge;
+    __m128d outside = _mm_setzero_pd();
+    for (int i = 0; i < 3; i++) {
+        const __m128d a0 = _mm_loadu_pd(node.axis[i][0]);
+        const __m128d a1 = _mm_loadu_pd(node.axis[i][1]);
+        const __m128d a2 = _mm_loadu_pd(node.axis[i][2]);
+        __m128d orig = _mm_mul_pd(a0, d[0]);
+        orig = _mm_add_pd(orig, _mm_mul_pd(a1, d[1]));
+        orig = _mm_add_pd(orig, _mm_mul_pd(a2, d[2]));
+        __m128d dir = _mm_mul_pd(a0, _mm_set1_pd(direction[0]));
+        dir = _mm_add_pd(dir, _mm_mul_pd(a1, _mm_set1_pd(direction[1])));
+        dir = _mm_add_pd(dir, _mm_mul_pd(a2, _mm_set1_pd(direction[2])));
+        const __m128d size = _mm_loadu_pd(node.size[i]);
+        const __m128d parallel = _mm_cmpeq_pd(dir, zero);
+        outside = _mm_or_pd(outside, _mm_and_pd(parallel, 
+            _mm_or_pd(_mm_cmplt_pd(orig, zero), _mm_cmpgt_pd(orig, size))));
+        // Substitute 1 for a zero direction to keep the division finite;
+        // those lanes are masked out below.
+        const __m128d safeDir = _mm_or_pd(_mm_andnot_pd(parallel, dir), 
+                                          _mm_and_pd(parallel, _mm_set1_pd(1)));
+        const __m128d dist1 = _mm_div_pd(_mm_sub_pd(zero, orig), safeDir);
+        const __m128d dist2 = _mm_div_pd(_mm_sub_pd(size, orig), safeDir);
+        const __m128d lo = _mm_min_pd(dist1, dist2);
+        const __m128d hi = _mm_max_pd(dist1, dist2);
+        minDist = _mm_or_pd(_mm_and_pd(parallel, minDist), 
+                            _mm_andnot_pd(parallel, _mm_max_pd(minDist, lo)));
+        maxDist = _mm_or_pd(_mm_and_pd(parallel, maxDist), 
+                            _mm_andnot_pd(parallel, _mm_min_pd(maxDist, hi)));
+    }
+    const __m128d miss = _mm_or_pd(outside, _mm_or_pd(
+        _mm_cmpgt_pd(minDist, maxDist), _mm_cmplt_pd(maxDist, zero)));
+    const int missMask = _mm_movemask_pd(miss);
+    _mm_storeu_pd(dist, _mm_max_pd(minDist, zero));
+    hit[0] = (missMask & 1) == 0;
+    hit[1] = (missMask & 2) == 0;
+#else
+    for (int lane = 0; lane < 2; lane++) {
+        Real d[3];
+        for (int j = 0; j < 3; j++)
+            d[j] = origin[j]-node.origin[j][lane];
+        Real minDist = MostNegativeReal;
+        Real maxDist = MostPositiveReal;
+        hit[lane] = true;
+        for (int i = 0; i < 3 && hit[lane]; i++) {
+            const Real orig = node.axis[i][0][lane]*d[0] 
+                            + node.axis[i][1][lane]*d[1] 
+                            + node.axis[i][2][lane]*d[2];
+            const Real dir = node.axis[i][0][lane]*direction[0] 
+                           + node.axis[i][1][lane]*direction[1] 
+                           + node.axis[i][2][lane]*direction[2];
+            const Real size = node.size[i][lane];
+            if (dir == 0.0) {
+                if (orig < 0 || orig > size)
+                    hit[lane] = false;
+                continue;
             }
-            else
-                child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
+            const Real dist1 = -orig/dir;
+            const Real dist2 = (size-orig)/dir;
+            minDist = std::max(minDist, std::min(dist1, dist2));
+            maxDist = std::min(maxDist, std::max(dist1, dist2));
+            if (minDist > maxDist || maxDist < 0.0)
+                hit[lane] = false;
         }
-        else if (child2intersects)
-            child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
-        
-        // If either one had an intersection, return the closer one.
-        
-        if (child1intersects && (!child2intersects || child1distance < child2distance)) {
-            distance = child1distance;
-            face = child1face;
-            uv = child1uv;
-            return true;
+        dist[lane] = std::max(minDist, Real(0));
+    }
+#endif
+}
+
+Vec3 FlatOBBTree::findNearestPoint
+   (const ContactGeometry::TriangleMesh::Impl& mesh, const Vec3& position, 
+    Real& distance2, int& face, Vec2& uv) const 
+{
+    // Two candidates whose squared distances agree to within this relative
+    // tolerance are considered tied, and the one whose face the point is more
+    // nearly perpendicular to is preferred.
+    const Real tol = 100*Eps;
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scope(arena);
+    FlatOBBStackEntry* stack = arena.allocate<FlatOBBStackEntry>(maxDepth+2);
+    int top = 0;
+    stack[top++] = {nodes.empty() ? ~0 : 0, 0};
+
+    distance2 = MostPositiveReal;
+    face = -1;
+    Vec3 nearestPoint, nearestOffset;
+    while (top > 0) {
+        const FlatOBBStackEntry entry = stack[--top];
+        if (entry.dist > distance2*(1+tol))
+            continue; // The box can't hold anything at least as close.
+        if (entry.code >= 0) {
+            // Queue whichever children might hold a closer point, the 
+            // nearer one last so that it is examined first.
+            const Node& node = nodes[entry.code];
+            Real dist2[2];
+            calcBoxDistance2(node, position, dist2);
+            const int nearer = (dist2[1] < dist2[0] ? 1 : 0);
+            const int farther = 1-nearer;
+            if (dist2[farther] <= distance2*(1+tol))
+                stack[top++] = {node.child[farther], dist2[farther]};
+            if (dist2[nearer] <= distance2*(1+tol))
+                stack[top++] = {node.child[nearer], dist2[nearer]};
+            continue;
         }
-        if (child2intersects) {
-            distance = child2distance;
-            face = child2face;
-            uv = child2uv;
-            return true;
+
+        // This is a leaf, so check each triangle for its distance to the 
+        // point.
+        const int leaf = ~entry.code;
+        for (int i = leafStart[leaf]; i < leafStart[leaf+1]; i++) {
+            const int tri = triangles[i];
+            Vec2 triangleUV;
+            Vec3 p = mesh.findNearestPointToFace(position, tri, triangleUV);
+            Vec3 offset = p-position;
+            // TODO: volatile to work around compiler bug
+            volatile Real d2 = offset.normSqr();
+            bool better;
+            if (face < 0)
+                better = true;
+            else if (d2 <= distance2*(1+tol) && distance2 <= d2*(1+tol))
+                better = (  std::abs(~offset*mesh.faces[tri].normal) 
+                          > std::abs(~nearestOffset*mesh.faces[face].normal));
+            else
+                better = (d2 < distance2);
+            if (better) {
+                nearestPoint = p;
+                nearestOffset = offset;
+                distance2 = d2;
+                face = tri;
+                uv = triangleUV;
+            }
         }
-        return false;
     }
-    
-    // This is a leaf node, so check each triangle for an intersection with the 
-    // ray.
-    
+    return nearestPoint;
+}
+
+bool FlatOBBTree::intersectsRay
+   (const ContactGeometry::TriangleMesh::Impl& mesh, const Vec3& origin, 
+    const UnitVec3& direction, Real& distance, int& face, Vec2& uv) const 
+{
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scope(arena);
+    FlatOBBStackEntry* stack = arena.allocate<FlatOBBStackEntry>(maxDepth+2);
+    int top = 0;
+    stack[top++] = {nodes.empty() ? ~0 : 0, 0};
+
     bool foundIntersection = false;
-    for (int i = 0; i < (int) triangles.size(); i++) {
-        const UnitVec3& faceNormal = mesh.faces[triangles[i]].normal;
-        Real vd = ~faceNormal*direction;
-        if (vd == 0.0)
-            continue; // The ray is parallel to the plane.
-        const Vec3& vert1 = mesh.vertices[mesh.faces[triangles[i]].vertices[0]].pos;
-        Real v0 = ~faceNormal*(vert1-origin);
-        Real t = v0/vd;
-        if (t < 0)
-            continue; // Ray points away from plane of triangle.
-        if (foundIntersection && t >= distance)
-            continue; // We already have a closer intersection.
-
-        // Determine whether the intersection point is inside the triangle by projecting onto
-        // a plane and computing the barycentric coordinates.
-
-        Vec3 ri = origin+direction*t;
-        const Vec3& vert2 = mesh.vertices[mesh.faces[triangles[i]].vertices[1]].pos;
-        const Vec3& vert3 = mesh.vertices[mesh.faces[triangles[i]].vertices[2]].pos;
-        int axis1, axis2;
-        if (std::abs(faceNormal[1]) > std::abs(faceNormal[0])) {
-            if (std::abs(faceNormal[2]) > std::abs(faceNormal[1])) {
-                axis1 = 0;
-                axis2 = 1;
-            }
-            else {
-                axis1 = 0;
-                axis2 = 2;
-            }
+    while (top > 0) {
+        const FlatOBBStackEntry entry = stack[--top];
+        if (foundIntersection && entry.dist >= distance)
+            continue; // The ray enters the box beyond the closest hit.
+        if (entry.code >= 0) {
+            // Queue the children the ray passes through, the nearer one
+            // last so that it is examined first.
+            const Node& node = nodes[entry.code];
+            bool hit[2];
+            Real dist[2];
+            intersectBoxes(node, origin, direction.asVec3(), hit, dist);
+            const int nearer = (dist[1] < dist[0] ? 1 : 0);
+            const int farther = 1-nearer;
+            if (hit[farther])
+                stack[top++] = {node.child[farther], dist[farther]};
+            if (hit[nearer])
+                stack[top++] = {node.child[nearer], dist[nearer]};
+            continue;
         }
-        else {
-            if (std::abs(faceNormal[2]) > std::abs(faceNormal[0])) {
-                axis1 = 0;
-                axis2 = 1;
+
+        // This is a leaf node, so check each triangle for an intersection 
+        // with the ray.
+        const int leaf = ~entry.code;
+        for (int i = leafStart[leaf]; i < leafStart[leaf+1]; i++) {
+            const int tri = triangles[i];
+            const UnitVec3& faceNormal = mesh.faces[tri].normal;
+            Real vd = ~faceNormal*direction;
+            if (vd == 0.0)
+                continue; // The ray is parallel to the plane.
+            const Vec3& vert1 = mesh.vertices[mesh.faces[tri].vertices[0]].pos;
+            Real v0 = ~faceNormal*(vert1-origin);
+            Real t = v0/vd;
+            if (t < 0)
+                continue; // Ray points away from plane of triangle.
+            if (foundIntersection && t >= distance)
+                continue; // We already have a closer intersection.
+
+            // Determine whether the intersection point is inside the 
+            // triangle by projecting onto a plane and computing the 
+            // barycentric coordinates.
+
+            Vec3 ri = origin+direction*t;
+            const Vec3& vert2 = mesh.vertices[mesh.faces[tri].vertices[1]].pos;
+            const Vec3& vert3 = mesh.vertices[mesh.faces[tri].vertices[2]].pos;
+            int axis1, axis2;
+            if (std::abs(faceNormal[1]) > std::abs(faceNormal[0])) {
+                if (std::abs(faceNormal[2]) > std::abs(faceNormal[1])) {
+                    axis1 = 0;
+                    axis2 = 1;
+                }
+                else {
+                    axis1 = 0;
+                    axis2 = 2;
+                }
             }
             else {
-                axis1 = 1;
-                axis2 = 2;
+                if (std::abs(faceNormal[2]) > std::abs(faceNormal[0])) {
+                    axis1 = 0;
+                    axis2 = 1;
+                }
+                else {
+                    axis1 = 1;
+                    axis2 = 2;
+                }
             }
+            Vec2 pos(ri[axis1]-vert1[axis1], ri[axis2]-vert1[axis2]);
+            Vec2 edge1(vert1[axis1]-vert2[axis1], vert1[axis2]-vert2[axis2]);
+            Vec2 edge2(vert1[axis1]-vert3[axis1], vert1[axis2]-vert3[axis2]);
+            Real denom = Real(1)/(edge1%edge2);
+            edge2 *= denom;
+            Real v = edge2%pos;
+            if (v < 0 || v > 1)
+                continue;
+            edge1 *= denom;
+            Real w = pos%edge1;
+            if (w < 0 || w > 1)
+                continue;
+            Real u = 1-v-w;
+            if (u < 0 || u > 1)
+                continue;
+
+            // It intersects.
+
+            distance = t;
+            face = tri;
+            uv = Vec2(u, v);
+            foundIntersection = true;
         }
-        Vec2 pos(ri[axis1]-vert1[axis1], ri[axis2]-vert1[axis2]);
-        Vec2 edge1(vert1[axis1]-vert2[axis1], vert1[axis2]-vert2[axis2]);
-        Vec2 edge2(vert1[axis1]-vert3[axis1], vert1[axis2]-vert3[axis2]);
-        Real denom = Real(1)/(edge1%edge2);
-        edge2 *= denom;
-        Real v = edge2%pos;
-        if (v < 0 || v > 1)
-            continue;
-        edge1 *= denom;
-        Real w = pos%edge1;
-        if (w < 0 || w > 1)
-            continue;
-        Real u = 1-v-w;
-        if (u < 0 || u > 1)
-            continue;
-        
-        // It intersects.
-        
-        distance = t;
-        face = triangles[i];
-        uv = Vec2(u, v);
-        foundIntersection = true;
     }
     return foundIntersection;
 }
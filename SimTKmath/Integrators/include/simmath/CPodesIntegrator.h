@@ -67,6 +67,29 @@ public:
      * will produce an exception.
      */
     void setUseCPodesProjection();
+    /**
+     * By default CPODES solves the linear systems arising in its Newton iterations by forming a dense
+     * Jacobian with finite differences and factoring it, which costs O(n^2) ODE evaluations and O(n^3)
+     * work per Jacobian for n state variables. Invoking this method with \a useKrylov true selects
+     * a matrix-free GMRES solver instead, in which each Jacobian-vector product costs a single
+     * evaluation of the system's state derivatives; that is much cheaper for large models.
+     *
+     * By default GMRES is not preconditioned. If \a precondHalfBandwidth is zero or more, it is
+     * preconditioned with a band matrix of that half-bandwidth formed by difference quotients. The
+     * difference quotients assume the Jacobian really is banded, so the bandwidth should cover the
+     * coupling between each q and its u's (at least nq for a multibody system); too narrow a band
+     * gives a misleading preconditioner that does more harm than good.
+     *
+     * This method must be invoked before the integrator is initialized.  Invoking it after initialization
+     * will produce an exception.
+     */
+    void setUseKrylovLinearSolver(bool useKrylov=true, int precondHalfBandwidth=-1);
+    /**
+     * Get the total number of GMRES iterations the Krylov linear solver has performed since the last call
+     * to resetAllStatistics(). This is always zero unless setUseKrylovLinearSolver() was used.
+     * Invoking it before the integrator is initialized will produce an exception.
+     */
+    int getNumKrylovLinearIterations() const;
     /**
      * Restrict the integrator to lower orders than it is otherwise capable of (up to 12 for Adams, 5 for BDF).  This method
      * may only be used to decrease the maximum order permitted, never to increase it.  Once you specify an order limit, calling it
@@ -0,0 +1,75 @@
+#ifndef SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_H_
+#define SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+#include "simmath/Integrator.h"
+
+namespace SimTK {
+
+class RosenbrockIntegratorRep;
+
+/** This is an error controlled, second order, linearly implicit integrator
+intended for stiff systems, such as multibody systems with stiff compliant 
+contact, where the explicit integrators are forced to take tiny steps.
+
+It implements the two-stage Rosenbrock-W method ROS2 of Verwer et al. (J.G.
+Verwer, E.J. Spee, J.G. Blom and W. Hundsdorfer, "A second order Rosenbrock 
+method applied to photochemical dispersion problems", SIAM J. Sci. Comput. 
+20(4), 1999). Each step solves two linear systems with the matrix 
+W = I - gamma*h*J, where J approximates the Jacobian d(ydot)/dy and 
+gamma = 1+1/sqrt(2): <pre>
+    W k1 = f(t0, y0)
+    W k2 = f(t0+h, y0 + h k1) - 2 k1
+    y1   = y0 + (3/2) h k1 + (1/2) h k2
+</pre> The method is L-stable, so stiff components are damped rather than 
+limiting the step size, and, being a W-method, it remains second order for any
+J. That allows J to be reused for several steps and only recomputed (by 
+difference quotients, one realization per state variable) when it gets old,
+after a rejected step, or after an event changes the state. The embedded
+first order solution y0 + h k1 provides the error estimate.
+
+Unlike CPodesIntegrator this is a one-step method, so it restarts cheaply 
+after events. It uses the same event localization, constraint projection and
+interpolation as the explicit Runge-Kutta integrators.
+**/
+class SimTK_SIMMATH_EXPORT RosenbrockIntegrator : public Integrator {
+public:
+    /** Create a RosenbrockIntegrator for integrating a System. **/
+    explicit RosenbrockIntegrator(const System& sys);
+
+    /** Set the number of successful steps for which a Jacobian may be reused
+    before a new one is calculated. The default is 10; use 1 to recalculate
+    the Jacobian at the start of every step. **/
+    void setMaxJacobianAge(int numSteps);
+    /** Return the number of times the Jacobian has been calculated since the
+    statistics were last reset. **/
+    int getNumJacobianEvaluations() const;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_H_
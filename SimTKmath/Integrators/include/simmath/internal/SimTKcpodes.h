@@ -177,6 +177,14 @@ public:
         OneStepTstop
     };
 
+    enum PreconditionType {
+        UnspecifiedPreconditionType=0,
+        NoPreconditioning,
+        LeftPreconditioning,
+        RightPreconditioning,
+        BothPreconditioning
+    };
+
     explicit CPodes
        (ODEType                      ode=UnspecifiedODEType, 
         LinearMultistepMethod        lmm=UnspecifiedLinearMultistepMethod, 
@@ -342,6 +350,27 @@ public:
     int lapackBand(int N, int mupper, int mlower);
     int lapackDenseProj(int Nc, int Ny, ProjectionFactorizationType);
 
+    // These select the matrix-free scaled, preconditioned GMRES linear
+    // solver for the Newton iteration in place of a direct (dense or band)
+    // solver. No iteration matrix is ever formed; only products of the
+    // Jacobian with a vector are needed, which CPODES forms by a difference
+    // quotient costing one ODE function evaluation each. maxl is the
+    // maximum Krylov subspace dimension; 0 means use the CPODES default (5).
+    // bandPrecSpgmr() adds a banded preconditioner with the given half 
+    // bandwidths, formed by difference quotients; with small bandwidths
+    // it captures the (block-)diagonal coupling among neighboring state
+    // variables. The preconditioner's memory is owned by this CPodes object.
+    int spgmr(PreconditionType, int maxl);
+    int bandPrecSpgmr(int N, int mupper, int mlower, 
+                      PreconditionType, int maxl);
+
+    int spilsGetNumLinIters(int* nliters);
+    int spilsGetNumConvFails(int* nlcfails);
+    int spilsGetNumJtimesEvals(int* njvevals);
+    int spilsGetNumPrecEvals(int* npevals);
+    int spilsGetNumPrecSolves(int* npsolves);
+    int spilsGetNumFctEvals(int* nfevalsLS);
+
 private:
     // This is how we get the client-side virtual functions to
     // be callable from library-side code while maintaining binary
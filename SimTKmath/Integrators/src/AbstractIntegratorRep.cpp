@@ -66,13 +66,7 @@ void AbstractIntegratorRep::createInterpolatedState(Real t) {
     State&        interp   = updInterpolatedState();
     interp = advanced; // pick up discrete stuff.
 
-    // Hermite interpolation requires state derivatives so we must realize
-    // end-of-step derivatives if they haven't already been realized.
-    realizeStateDerivatives(advanced);
-
-    interpolateOrder3(getPreviousTime(),  getPreviousY(),  getPreviousYDot(),
-                      advanced.getTime(), advanced.getY(), advanced.getYDot(),
-                      t, interp.updY());
+    interpolateY(t, interp.updY());
     interp.updTime() = t;
 
     if (userProjectInterpolatedStates == 0) {
@@ -90,6 +84,40 @@ void AbstractIntegratorRep::createInterpolatedState(Real t) {
 }
 
 
+//==============================================================================
+//                              INTERPOLATE Y
+//==============================================================================
+// Calculate y at time t between the previous and advanced times. If the
+// method has a continuous extension of its last step we use that, since it
+// costs only a linear combination of stage derivatives. It doesn't know about
+// the projection done at the end of the step (or about the advanced state
+// having been backed up), so we blend in the difference between it and the
+// advanced state linearly over the interval. That makes the result match both
+// ends of the interval exactly, as the Hermite interpolant does. Otherwise
+// we use Hermite interpolation, which requires end-of-step derivatives.
+void AbstractIntegratorRep::interpolateY(Real t, Vector& yt) {
+    const State& advanced = getAdvancedState();
+    const Real t0 = getPreviousTime(), t1 = advanced.getTime();
+
+    if (interpolateLastStep(t, yt)) {
+        if (t1 > t0 && interpolateLastStep(t1, yEndOfInterval)) {
+            const Vector& y1 = advanced.getY();
+            const Real w = (t-t0)/(t1-t0);
+            for (int i=0; i < yt.size(); ++i)
+                yt[i] += w*(y1[i]-yEndOfInterval[i]);
+            return;
+        }
+        // Shouldn't happen, but Hermite will do.
+    }
+
+    realizeStateDerivatives(advanced);
+    interpolateOrder3(getPreviousTime(),  getPreviousY(),  getPreviousYDot(),
+                      advanced.getTime(), advanced.getY(), advanced.getYDot(),
+                      t, yt);
+}
+
+
+
 //==============================================================================
 //                  BACK UP ADVANCED STATE BY INTERPOLATION
 //==============================================================================
@@ -100,16 +128,11 @@ void AbstractIntegratorRep::createInterpolatedState(Real t) {
 void AbstractIntegratorRep::backUpAdvancedStateByInterpolation(Real t) {
     const System& system   = getSystem();
     State& advanced = updAdvancedState();
-    Vector yinterp, dummy;
+    Vector yinterp;
 
     assert(getPreviousTime() <= t && t <= advanced.getTime());
 
-    // Hermite interpolation requires state derivatives so we must realize
-    // end-of-step derivatives if they haven't already been realized.
-    realizeStateDerivatives(advanced);
-    interpolateOrder3(getPreviousTime(),  getPreviousY(),  getPreviousYDot(),
-                      advanced.getTime(), advanced.getY(), advanced.getYDot(),
-                      t, yinterp);
+    interpolateY(t, yinterp);
     advanced.updY() = yinterp;
     advanced.updTime() = t;
 
@@ -608,8 +631,12 @@ bool AbstractIntegratorRep::takeOneStep(Real tMax, Real tReport)
         return false;
     }
 
-    // TODO: this is indiscriminately evaluating expensive accelerations
-    // that are only needed if there are acceleration-level witness functions.
+    // TODO: this evaluates accelerations at the advanced state even if there
+    // are no acceleration-level witness functions. That is usually not
+    // wasted, since the next step starts by realizing this same state's
+    // derivatives, which will then already be available. But the work is 
+    // thrown away if an event is found below and the advanced state is backed
+    // up by interpolation.
     realizeStateDerivatives(getAdvancedState());
     const Vector& e1 = getAdvancedState().getEventTriggers();
     assert(e0.size() == e1.size() && 
@@ -654,9 +681,15 @@ bool AbstractIntegratorRep::takeOneStep(Real tMax, Real tReport)
     // From above we have earliestTimeEst which is the time at which we
     // think the first event is triggering.
 
-    Vector eLow = e0, eHigh = e1;
+    Vector eLow = e0, eHigh = e1, eMid;
     Real bias = 1; // neutral
 
+    // Localization only needs the trigger values at the interpolated states,
+    // so those are realized only through the highest stage that has any
+    // triggers. Most witness functions depend only on positions or
+    // velocities, in which case no accelerations are calculated at all.
+    const Stage triggerStage = findHighestEventTriggerStage(getAdvancedState());
+
     // There is an event in (tLow,tHigh], with the eariest occurrence
     // estimated at tMid=earliestTimeEst, tLow<tMid<tHigh. 
     // Decide whether the earliest occurrence is actually in the
@@ -681,10 +714,15 @@ bool AbstractIntegratorRep::takeOneStep(Real tMax, Real tReport)
 
         // Failure to evaluate at the interpolated state is a disaster of some
         // kind, not something we expect to be able to recover from, so this 
-        // will throw an exception if it fails.
-        realizeStateDerivatives(getInterpolatedState());
-
-        const Vector& eMid = getInterpolatedState().getEventTriggers();
+        // will throw an exception if it fails. The interpolated state has
+        // already been realized through Velocity stage.
+        if (triggerStage == Stage::Acceleration)
+            realizeStateDerivatives(getInterpolatedState());
+        else if (triggerStage > Stage::Velocity)
+            getSystem().realize(getInterpolatedState(), triggerStage);
+
+        getEventTriggersThroughStage(getInterpolatedState(), triggerStage, 
+                                     eMid);
 
         // TODO: should search in the wider interval first
 
@@ -141,18 +141,28 @@ protected:
                                 bool hWasArtificiallyLimited);
     /**
      * Create an interpolated state at time t, which is between the previous 
-     * and advanced times. The default implementation uses third order 
-     * Hermite spline interpolation.
+     * and advanced times. The default implementation uses the method's 
+     * continuous extension if it has one (see interpolateLastStep()) and
+     * otherwise third order Hermite spline interpolation.
      */
     virtual void createInterpolatedState(Real t);
     /**
      * Interpolate the advanced state back to an earlier part of the interval,
      * forgetting about the rest of the interval. This is necessary, for 
      * example, after we have localized an event trigger to an interval 
-     * tLow:tHigh where tHigh < tAdvanced.  The default implementation uses 
-     * third order Hermite spline interpolation.
+     * tLow:tHigh where tHigh < tAdvanced.  The default implementation 
+     * interpolates the same way as createInterpolatedState().
      */
     virtual void backUpAdvancedStateByInterpolation(Real t);
+    /**
+     * A method that has a continuous extension of its steps ("dense output")
+     * built from stage derivatives it has already calculated can override 
+     * this to evaluate y at time t within the step most recently taken by
+     * attemptODEStep(), returning true. Interpolation then needs no 
+     * realizations. The default returns false, meaning that the default
+     * implementations above should use Hermite interpolation.
+     */
+    virtual bool interpolateLastStep(Real t, Vector& yt) const {return false;}
     int statsStepsTaken, statsStepsAttempted, statsErrorTestFailures, statsConvergenceTestFailures;
 
     // Iterative methods should count iterations and then classify them as 
@@ -160,10 +170,12 @@ protected:
     int statsConvergentIterations, statsDivergentIterations;
 private:
     bool takeOneStep(Real tMax, Real tReport);
+    void interpolateY(Real t, Vector& yt);
     bool initialized, hasErrorControl;
     Real currentStepSize, lastStepSize, actualInitialStepSizeTaken;
     int minOrder, maxOrder;
     std::string methodName;
+    Vector yEndOfInterval; // temp for interpolateY()
 };
 
 } // namespace SimTK
@@ -31,6 +31,8 @@
 #include "cpodes/cpodes.h"
 #include "cpodes/cpodes_dense.h"
 #include "cpodes/cpodes_lapack_exports.h"
+#include "cpodes/cpodes_spgmr.h"
+#include "cpodes/cpodes_bandpre.h"
 
 #include <limits>
 
@@ -39,18 +41,21 @@ namespace SimTK {
 class CPodesRep {
 public:
     CPodesRep()
-      : useImplicitODEFunction(false), cpode_mem(0), sysp(0), myHandle(0) 
+      : useImplicitODEFunction(false), cpode_mem(0), bandPrec_mem(0),
+        sysp(0), myHandle(0) 
     { 
         zeroFunctionPointers();
     }
 
     CPodesRep(int ode_type, int lmm_type, int nls_type)
-      : useImplicitODEFunction(ode_type == CP_IMPL), cpode_mem(0), sysp(0), myHandle(0)
+      : useImplicitODEFunction(ode_type == CP_IMPL), cpode_mem(0), 
+        bandPrec_mem(0), sysp(0), myHandle(0)
     {
         cpode_mem = CPodeCreate(ode_type, lmm_type, nls_type);
     }
 
     ~CPodesRep() {
+        freeBandPrec();
         if (cpode_mem)
             CPodeFree(&cpode_mem);
     }
@@ -84,6 +89,13 @@ public:
 private:
     bool  useImplicitODEFunction;
     void* cpode_mem;
+    void* bandPrec_mem; // band preconditioner data, if any
+
+    void freeBandPrec() {
+        if (bandPrec_mem)
+            CPBandPrecFree(&bandPrec_mem);
+        bandPrec_mem = 0;
+    }
     const CPodesSystem* sysp;
 
     friend class CPodes;
@@ -248,6 +260,16 @@ static int mapProjectionFactorizationType(CPodes::ProjectionFactorizationType ft
     }
 }
 
+static int mapPreconditionType(CPodes::PreconditionType pretype) {
+    switch(pretype) {
+    case CPodes::NoPreconditioning:     return PREC_NONE;
+    case CPodes::LeftPreconditioning:   return PREC_LEFT;
+    case CPodes::RightPreconditioning:  return PREC_RIGHT;
+    case CPodes::BothPreconditioning:   return PREC_BOTH;
+    default: return std::numeric_limits<int>::min();
+    }
+}
+
 static int mapStepMode(CPodes::StepMode mode) {
     switch(mode) {
     case CPodes::Normal:       return CP_NORMAL;
@@ -681,6 +703,59 @@ int CPodes::lapackDenseProj(int Nc, int Ny, ProjectionFactorizationType fact_typ
         mapProjectionFactorizationType(fact_type));
 }
 
+int CPodes::spgmr(PreconditionType pretype, int maxl) {
+    return CPSpgmr(updRep().cpode_mem, mapPreconditionType(pretype), maxl);
+}
+int CPodes::bandPrecSpgmr(int N, int mupper, int mlower, 
+                          PreconditionType pretype, int maxl) 
+{
+    CPodesRep& cprep = updRep();
+    // Any previous preconditioner is replaced; CPBPSpgmr() below will
+    // release the old linear solver that referenced it.
+    cprep.freeBandPrec();
+    cprep.bandPrec_mem = CPBandPrecAlloc(cprep.cpode_mem, N, mupper, mlower);
+    if (!cprep.bandPrec_mem)
+        return CPSPILS_MEM_FAIL;
+    return CPBPSpgmr(cprep.cpode_mem, mapPreconditionType(pretype), maxl,
+                     cprep.bandPrec_mem);
+}
+int CPodes::spilsGetNumLinIters(int* nliters) {
+    long lnliters;
+    int stat = CPSpilsGetNumLinIters(updRep().cpode_mem,&lnliters);
+    *nliters = (int)lnliters;
+    return stat;
+}
+int CPodes::spilsGetNumConvFails(int* nlcfails) {
+    long lnlcfails;
+    int stat = CPSpilsGetNumConvFails(updRep().cpode_mem,&lnlcfails);
+    *nlcfails = (int)lnlcfails;
+    return stat;
+}
+int CPodes::spilsGetNumJtimesEvals(int* njvevals) {
+    long lnjvevals;
+    int stat = CPSpilsGetNumJtimesEvals(updRep().cpode_mem,&lnjvevals);
+    *njvevals = (int)lnjvevals;
+    return stat;
+}
+int CPodes::spilsGetNumPrecEvals(int* npevals) {
+    long lnpevals;
+    int stat = CPSpilsGetNumPrecEvals(updRep().cpode_mem,&lnpevals);
+    *npevals = (int)lnpevals;
+    return stat;
+}
+int CPodes::spilsGetNumPrecSolves(int* npsolves) {
+    long lnpsolves;
+    int stat = CPSpilsGetNumPrecSolves(updRep().cpode_mem,&lnpsolves);
+    *npsolves = (int)lnpsolves;
+    return stat;
+}
+int CPodes::spilsGetNumFctEvals(int* nfevalsLS) {
+    long lnfevalsLS;
+    int stat = CPSpilsGetNumFctEvals(updRep().cpode_mem,&lnfevalsLS);
+    *nfevalsLS = (int)lnfevalsLS;
+    return stat;
+}
+
 
 
 // Client-side function registration
@@ -46,6 +46,18 @@ void CPodesIntegrator::setUseCPodesProjection() {
     cprep.setUseCPodesProjection();
 }
 
+void CPodesIntegrator::setUseKrylovLinearSolver(bool useKrylov,
+                                                int precondHalfBandwidth) {
+    CPodesIntegratorRep& cprep = dynamic_cast<CPodesIntegratorRep&>(*rep);
+    cprep.setUseKrylovLinearSolver(useKrylov, precondHalfBandwidth);
+}
+
+int CPodesIntegrator::getNumKrylovLinearIterations() const {
+    const CPodesIntegratorRep& cprep = 
+        dynamic_cast<const CPodesIntegratorRep&>(*rep);
+    return cprep.getNumKrylovLinearIterations();
+}
+
 void CPodesIntegrator::setOrderLimit(int order) {
     CPodesIntegratorRep& cprep = dynamic_cast<CPodesIntegratorRep&>(*rep);
     cprep.setOrderLimit(order);
@@ -137,6 +149,8 @@ void CPodesIntegratorRep::init
     cps = new CPodesSystemImpl(*this, getSystem());
     initialized = false;
     useCpodesProjection = false;
+    useKrylov = false;
+    krylovPrecHalfBandwidth = -1;
 }
 
 CPodesIntegratorRep::CPodesIntegratorRep
@@ -189,7 +203,21 @@ void CPodesIntegratorRep::methodInitialize(const State& state) {
         printf("init() returned %d\n", retval);
         SimTK_THROW1(Integrator::InitializationFailed, "init() failed");
     }
-    cpodes->lapackDense(ny);
+    if (useKrylov) {
+        // Matrix-free GMRES: each Jacobian-vector product costs one
+        // realization through Acceleration stage, which is O(n) for a
+        // multibody system, so no ny X ny matrix is ever formed or factored.
+        if (krylovPrecHalfBandwidth < 0)
+            cpodes->spgmr(CPodes::NoPreconditioning, 0);
+        else {
+            const int hbw = std::max(0, 
+                std::min(krylovPrecHalfBandwidth, ny-1));
+            cpodes->bandPrecSpgmr(ny, hbw, hbw, 
+                                  CPodes::LeftPreconditioning, 0);
+        }
+    }
+    else
+        cpodes->lapackDense(ny);
     cpodes->setNonlinConvCoef(Real(0.01)); // TODO (default is 0.1)
     if (useCpodesProjection) {
         const int nqerr = state.getNQErr(), nuerr = state.getNUErr();
@@ -388,6 +416,12 @@ stepTo(Real reportTime, Real scheduledEventTime) {
             cpodes->getNumErrTestFails(&oldTestFailures);
             cpodes->getNumNonlinSolvIters(&oldNonlinIterations);
             cpodes->getNumNonlinSolvConvFails(&oldNonlinConvFailures);
+            // The linear solver's counters are reset at the start of the 
+            // first step after (re)initialization, i.e., when no steps have
+            // been taken yet.
+            int oldLinIterations=0;
+            if (useKrylov && oldSteps > 0)
+                cpodes->spilsGetNumLinIters(&oldLinIterations);
 
             //---------------------step------------------------
             res = cpodes->step(tMax, &tret, yout, ypout, mode);
@@ -413,10 +447,14 @@ stepTo(Real reportTime, Real scheduledEventTime) {
             cpodes->getNumErrTestFails(&newTestFailures);
             cpodes->getNumNonlinSolvIters(&newNonlinIterations);
             cpodes->getNumNonlinSolvConvFails(&newNonlinConvFailures);
+            int newLinIterations=0;
+            if (useKrylov)
+                cpodes->spilsGetNumLinIters(&newLinIterations);
             statsStepsTaken += newSteps-oldSteps;
             statsErrorTestFailures += newTestFailures-oldTestFailures;
             // Project stats were already updated in project() above.
             statsIterations += newNonlinIterations-oldNonlinIterations;
+            statsLinearIterations += newLinIterations-oldLinIterations;
             statsConvergenceTestFailures += newNonlinConvFailures-oldNonlinConvFailures;
  
             // This takes care of prescribed motion.
@@ -614,6 +652,7 @@ void CPodesIntegratorRep::resetMethodStatistics() {
     statsErrorTestFailures = 0;
     statsConvergenceTestFailures = 0;
     statsIterations = 0;
+    statsLinearIterations = 0;
 }
 
 const char* CPodesIntegratorRep::getMethodName() const {
@@ -639,6 +678,22 @@ void CPodesIntegratorRep::setUseCPodesProjection() {
     useCpodesProjection = true;
 }
 
+void CPodesIntegratorRep::setUseKrylovLinearSolver
+   (bool useKrylovSolver, int precondHalfBandwidth) {
+    SimTK_APIARGCHECK_ALWAYS(!initialized, "CPodesIntegrator", 
+        "setUseKrylovLinearSolver",
+        "This method may not be invoked after the integrator has been initialized.");
+    useKrylov = useKrylovSolver;
+    krylovPrecHalfBandwidth = precondHalfBandwidth;
+}
+
+int CPodesIntegratorRep::getNumKrylovLinearIterations() const {
+    SimTK_APIARGCHECK_ALWAYS(initialized, "CPodesIntegrator", 
+        "getNumKrylovLinearIterations",
+        "This method may not be invoked before the integrator has been initialized.");
+    return statsLinearIterations;
+}
+
 void CPodesIntegratorRep::setOrderLimit(int order) {
     cpodes->setMaxOrd(order);
 }
@@ -63,6 +63,8 @@ public:
     int getMethodMaxOrder() const override;
     bool methodHasErrorControl() const override;
     void setUseCPodesProjection();
+    void setUseKrylovLinearSolver(bool useKrylov, int precondHalfBandwidth);
+    int getNumKrylovLinearIterations() const;
     void setOrderLimit(int order);
     class CPodesSystemImpl;
     friend class CPodesSystemImpl;
@@ -70,8 +72,10 @@ private:
     CPodes* cpodes;
     CPodesSystemImpl* cps;
     bool initialized, useCpodesProjection;
+    bool useKrylov;
+    int krylovPrecHalfBandwidth; // < 0 means no preconditioner
     int statsStepsTaken, statsErrorTestFailures, statsConvergenceTestFailures;
-    int statsIterations;
+    int statsIterations, statsLinearIterations;
     int pendingReturnCode;
     Real previousStartTime, previousTimeReturned;
     Vector savedY;
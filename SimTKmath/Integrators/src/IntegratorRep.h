@@ -413,9 +413,8 @@ public:
         timeEstimates.clear();
         transitions.clear();
         earliestTimeEst = narrowestWindow = Infinity;
-        for (int i=0; i<nCandidates; ++i) {
-            const SystemEventTriggerIndex e = viableCandidates ? (*viableCandidates)[i] 
-                                                                 : SystemEventTriggerIndex(i);
+
+        auto considerTrigger = [&](SystemEventTriggerIndex e) {
             Event::Trigger transitionSeen =
                 Event::maskTransition(
                     Event::classifyTransition(sign(eLow[e]), sign(eHigh[e])),
@@ -439,9 +438,66 @@ public:
                 transitions.push_back(transitionSeen);
                 earliestTimeEst = std::min(earliestTimeEst, timeEstimates.back());
             }
+        };
+
+        if (viableCandidates) {
+            for (int i=0; i<nCandidates; ++i)
+                considerTrigger((*viableCandidates)[i]);
+            return;
         }
+
+        // With no list to narrow we have to look at every trigger, and there
+        // may be thousands of them. Screen them all with a branch-free pass
+        // that the compiler can vectorize: a trigger can only have 
+        // transitioned if it didn't start at zero and its product with the
+        // end value is not positive. Underflow of the product can let a 
+        // few extra triggers through, but can't hide a real sign change.
+        ScratchArena& arena = ScratchArena::getThreadArena();
+        ScratchArena::Scope scratch(arena);
+        unsigned char* mayHaveTransitioned = 
+            arena.allocate<unsigned char>(nCandidates);
+        if (eLow.hasContiguousData() && eHigh.hasContiguousData()) {
+            const Real* lo = eLow.getContiguousScalarData();
+            const Real* hi = eHigh.getContiguousScalarData();
+            for (int i=0; i<nCandidates; ++i)
+                mayHaveTransitioned[i] = 
+                    (unsigned char)((lo[i] != 0) & (lo[i]*hi[i] <= 0));
+        } else {
+            for (int i=0; i<nCandidates; ++i)
+                mayHaveTransitioned[i] = 
+                    (unsigned char)((eLow[i] != 0) & (eLow[i]*eHigh[i] <= 0));
+        }
+
+        for (int i=0; i<nCandidates; ++i)
+            if (mayHaveTransitioned[i])
+                considerTrigger(SystemEventTriggerIndex(i));
     }
-    
+
+    // Return the highest stage at which the System has any event triggers;
+    // realizing a State through that stage is enough to evaluate all of them.
+    // Triggers can't depend on anything later than Acceleration stage.
+    static Stage findHighestEventTriggerStage(const State& s) {
+        for (Stage g = Stage::Acceleration; g >= Stage::Topology; g = g.prev())
+            if (s.getNEventTriggersByStage(g) > 0)
+                return g;
+        return Stage::Empty;
+    }
+
+    // Copy all the event trigger values out of a State that has been realized
+    // through the given stage, which must be at least the highest stage that
+    // has any triggers. Unlike State::getEventTriggers() this doesn't require
+    // that the State be realized through Acceleration stage.
+    static void getEventTriggersThroughStage(const State& s, Stage g, 
+                                             Vector& triggers) {
+        triggers.resize(s.getNEventTriggers());
+        for (Stage j = Stage::Topology; j <= g; j = j.next()) {
+            const int n = s.getNEventTriggersByStage(j);
+            if (n > 0)
+                triggers(s.getEventTriggerStartByStage(j), n) = 
+                    s.getEventTriggersByStage(j);
+        }
+    }
+
     /// Given a list of events, specified by their indices in the list of trigger functions,
     /// convert them to the corresponding event IDs.
     void findEventIds(const Array_<SystemEventTriggerIndex>& indices, Array_<EventId>& ids) {
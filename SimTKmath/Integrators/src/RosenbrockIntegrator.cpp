@@ -0,0 +1,175 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/** @file
+ * This is the private (library side) implementation of the 
+ * RosenbrockIntegrator and RosenbrockIntegratorRep classes.
+ */
+
+#include "SimTKcommon.h"
+#include "simmath/Integrator.h"
+#include "simmath/RosenbrockIntegrator.h"
+
+#include "IntegratorRep.h"
+#include "RosenbrockIntegratorRep.h"
+
+#include <cmath>
+
+using namespace SimTK;
+
+//------------------------------------------------------------------------------
+//                          ROSENBROCK INTEGRATOR
+//------------------------------------------------------------------------------
+
+RosenbrockIntegrator::RosenbrockIntegrator(const System& sys) 
+{
+    rep = new RosenbrockIntegratorRep(this, sys);
+}
+
+void RosenbrockIntegrator::setMaxJacobianAge(int numSteps) {
+    dynamic_cast<RosenbrockIntegratorRep&>(*rep).setMaxJacobianAge(numSteps);
+}
+
+int RosenbrockIntegrator::getNumJacobianEvaluations() const {
+    return dynamic_cast<const RosenbrockIntegratorRep&>(*rep)
+                .getNumJacobianEvaluations();
+}
+
+//------------------------------------------------------------------------------
+//                        ROSENBROCK INTEGRATOR REP
+//------------------------------------------------------------------------------
+
+RosenbrockIntegratorRep::RosenbrockIntegratorRep
+   (Integrator* handle, const System& sys) 
+:   AbstractIntegratorRep(handle, sys, 2, 2, "Rosenbrock",  true),
+    jacobianIsValid(false), jacobianTime(NaN), lastStepStart(NaN),
+    jacobianAge(0), maxJacobianAge(10), statsJacobianEvaluations(0) {
+}
+
+void RosenbrockIntegratorRep::methodInitialize(const State& state) {
+    AbstractIntegratorRep::methodInitialize(state);
+    jacobianIsValid = false;
+    lastStepStart = NaN;
+}
+
+// An event handler may have changed the state discontinuously, so the old
+// Jacobian can't be trusted any more.
+void RosenbrockIntegratorRep::methodReinitialize
+   (Stage stage, bool shouldTerminate) {
+    if (stage < Stage::Report)
+        jacobianIsValid = false;
+}
+
+void RosenbrockIntegratorRep::resetMethodStatistics() {
+    AbstractIntegratorRep::resetMethodStatistics();
+    statsJacobianEvaluations = 0;
+}
+
+void RosenbrockIntegratorRep::setMaxJacobianAge(int numSteps) {
+    SimTK_APIARGCHECK1_ALWAYS(numSteps >= 1, "RosenbrockIntegrator",
+        "setMaxJacobianAge", 
+        "The maximum Jacobian age must be at least 1 but was %d.", numSteps);
+    maxJacobianAge = numSteps;
+}
+
+// Approximate J=d(ydot)/dy by forward differences about (t0,y0), where the
+// derivative f0 is already known. A W-method doesn't need J to be accurate
+// so one-sided differences are good enough.
+void RosenbrockIntegratorRep::calcJacobian
+   (Real t0, const Vector& y0, const Vector& f0) 
+{
+    const int ny = y0.size();
+    jacobian.resize(ny, ny);
+    Vector& y = ytmp[2];
+    y = y0;
+    for (int j=0; j < ny; ++j) {
+        const Real h = SqrtEps*std::max(std::abs(y0[j]), Real(1));
+        y[j] = y0[j] + h;
+        setAdvancedStateAndRealizeDerivatives(t0, y);
+        jacobian(j) = (getAdvancedState().getYDot() - f0) / h;
+        y[j] = y0[j]; // restore
+    }
+    jacobianIsValid = true;
+    jacobianTime = t0;
+    jacobianAge = 0;
+    ++statsJacobianEvaluations;
+}
+
+// This is the two-stage ROS2 method described in the RosenbrockIntegrator
+// header, with gamma = 1+1/sqrt(2) for L-stability. We call the initial state
+// (t0,y0) and want (t0+h,y1). The initial derivative f0=f(t0,y0) is given.
+bool RosenbrockIntegratorRep::attemptODEStep
+   (Real t1, Vector& y1err, int& errOrder, int& numIterations)
+{
+    static const Real Gamma = 1 + 1/std::sqrt(Real(2));
+
+    const Real t0 = getPreviousTime();
+    assert(t1 > t0);
+
+    statsStepsAttempted++;
+    errOrder = 2;
+    const Vector& y0 = getPreviousY();
+    const Vector& f0 = getPreviousYDot();
+    const int ny = y0.size();
+    if (ytmp[0].size() != ny)
+        for (int i=0; i<NTemps; ++i)
+            ytmp[i].resize(ny);
+    Vector& k1 = ytmp[0]; // rename temps
+    Vector& k2 = ytmp[1];
+
+    // A retry from the same starting point means the last attempt failed; 
+    // get a fresh Jacobian unless we already have one from here. Otherwise
+    // each step from a new starting point ages the Jacobian by one.
+    const bool isRetry = (t0 == lastStepStart);
+    if (!isRetry && jacobianIsValid) ++jacobianAge;
+    lastStepStart = t0;
+    if (!jacobianIsValid || jacobian.nrow() != ny 
+        || jacobianAge >= maxJacobianAge
+        || (isRetry && jacobianTime != t0))
+        calcJacobian(t0, y0, f0);
+
+    const Real h = t1-t0;
+    Matrix W = (-Gamma*h)*jacobian;
+    W.diag() += 1;
+    iterationMatrix.factor(W);
+    if (iterationMatrix.isSingular())
+        return false; // try a smaller step
+
+    iterationMatrix.solve(f0, k1);
+
+    setAdvancedStateAndRealizeDerivatives(t1, y0 + h*k1);
+    iterationMatrix.solve(getAdvancedState().getYDot() - 2*k1, k2);
+
+    // Evaluate through kinematics only; it is a waste of a stage to 
+    // evaluate derivatives here since the caller will muck with this before
+    // the end of the step.
+    setAdvancedStateAndRealizeKinematics(t1, y0 + (1.5*h)*k1 + (0.5*h)*k2);
+
+    // The embedded first order solution is y0 + h*k1, so the difference
+    // between the two is (h/2)(k1+k2).
+    for (int i=0; i<ny; ++i)
+        y1err[i] = std::abs((h/2)*(k1[i]+k2[i]));
+
+    numIterations = 1;
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_REP_H_
+#define SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_REP_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "simmath/LinearAlgebra.h"
+
+#include "AbstractIntegratorRep.h"
+
+namespace SimTK {
+
+/**
+ * This is the private (library side) implementation of the 
+ * RosenbrockIntegratorRep class which is a concrete class
+ * implementing the abstract IntegratorRep.
+ */
+
+class RosenbrockIntegratorRep : public AbstractIntegratorRep {
+public:
+    RosenbrockIntegratorRep(Integrator* handle, const System& sys);
+    void methodInitialize(const State&) override;
+    void methodReinitialize(Stage stage, bool shouldTerminate) override;
+    void resetMethodStatistics() override;
+
+    void setMaxJacobianAge(int numSteps);
+    int getNumJacobianEvaluations() const {return statsJacobianEvaluations;}
+protected:
+    bool attemptODEStep
+       (Real t1, Vector& yErrEst, int& errOrder, int& numIterations) override;
+private:
+    void calcJacobian(Real t0, const Vector& y0, const Vector& f0);
+
+    Matrix      jacobian;       // approximate d(ydot)/dy
+    bool        jacobianIsValid;
+    Real        jacobianTime;   // t0 of the step that computed it
+    Real        lastStepStart;  // t0 of the most recent attempt
+    int         jacobianAge;    // number of steps since it was computed
+    int         maxJacobianAge;
+    int         statsJacobianEvaluations;
+
+    FactorLU    iterationMatrix; // factored W = I - gamma*h*J
+    static const int NTemps = 3;
+    Vector ytmp[NTemps];
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_ROSENBROCK_INTEGRATOR_REP_H_
@@ -54,7 +54,8 @@ RungeKuttaFeldbergIntegrator::RungeKuttaFeldbergIntegrator(const System& sys)
 
 RungeKuttaFeldbergIntegratorRep::RungeKuttaFeldbergIntegratorRep
    (Integrator* handle, const System& sys) 
-:   AbstractIntegratorRep(handle, sys, 5, 5, "RungeKuttaFeldberg",  true) {}
+:   AbstractIntegratorRep(handle, sys, 5, 5, "RungeKuttaFeldberg",  true),
+    tLastStepStart(NaN), tLastStepEnd(NaN) {}
 
 bool RungeKuttaFeldbergIntegratorRep::attemptODEStep
    (Real t1, Vector& y1err, int& errOrder, int& numIterations)
@@ -113,6 +114,7 @@ bool RungeKuttaFeldbergIntegratorRep::attemptODEStep
     Vector& ysave = ytmp[0]; // rename temps
     Vector& fa    = ytmp[1];
     Vector& fb    = ytmp[2];
+    tLastStepStart = NaN; // about to overwrite the stage derivatives
 
     const Real h = t1-t0;
 
@@ -150,6 +152,41 @@ bool RungeKuttaFeldbergIntegratorRep::attemptODEStep
     y1err = h*CE1*f0 + h*CE2*ytmp[1] + h*CE3*ytmp[2] + h*CE4*ytmp[3] 
                      + h*CE5*ytmp[4];
 
+    tLastStepStart = t0; tLastStepEnd = t1;
+    return true;
+}
+
+// This is a third order continuous extension of the step above, so that 
+// interpolation within the step needs no further derivative evaluations (see
+// Hairer, Norsett & Wanner, section II.6 on dense output). The weights 
+// b_i(theta), theta=(t-t0)/h, satisfy the order conditions through third
+// order for every theta using the stages f0, f2, f3 and f4 (ytmp[1..3]); 
+// the system they have to satisfy has a unique solution
+//
+//      b0 =   (37/36) theta -  (15/8) theta^2 +  (26/27) theta^3
+//      b2 = (-64/855) theta + (128/57) theta^2 - (832/513) theta^3
+//      b3 =  (169/684) theta - (169/456) theta^2 + (338/513) theta^3
+//      b4 =    -(1/5) theta
+//
+// which at theta=1 gives the weights of the propagated solution.
+bool RungeKuttaFeldbergIntegratorRep::interpolateLastStep
+   (Real t, Vector& yt) const
+{
+    if (!(tLastStepStart == getPreviousTime() 
+          && tLastStepStart <= t && t <= tLastStepEnd))
+        return false;
+
+    const Real h = tLastStepEnd-tLastStepStart;
+    const Real th = (t-tLastStepStart)/h, th2 = th*th, th3 = th*th2;
+    const Real b0 = Real(37./36.)*th   - Real(15./8.)*th2  
+                  + Real(26./27.)*th3;
+    const Real b2 = Real(-64./855.)*th + Real(128./57.)*th2 
+                  - Real(832./513.)*th3;
+    const Real b3 = Real(169./684.)*th  - Real(169./456.)*th2 
+                  + Real(338./513.)*th3;
+    const Real b4 = Real(-1./5.)*th;
+    yt = getPreviousY() + h*(b0*getPreviousYDot() + b2*ytmp[1] + b3*ytmp[2]
+                             + b4*ytmp[3]);
     return true;
 }
 
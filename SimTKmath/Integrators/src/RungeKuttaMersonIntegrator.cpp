@@ -55,7 +55,8 @@ RungeKuttaMersonIntegrator::RungeKuttaMersonIntegrator(const System& sys)
 
 RungeKuttaMersonIntegratorRep::RungeKuttaMersonIntegratorRep
    (Integrator* handle, const System& sys) 
-:   AbstractIntegratorRep(handle, sys, 4, 4, "RungeKuttaMerson",  true) {
+:   AbstractIntegratorRep(handle, sys, 4, 4, "RungeKuttaMerson",  true),
+    tLastStepStart(NaN), tLastStepEnd(NaN) {
 }
 
 // For a discussion of the Runge-Kutta-Merson method, see Hairer,
@@ -99,6 +100,7 @@ bool RungeKuttaMersonIntegratorRep::attemptODEStep
     Vector& ysave = ytmp[0]; // rename temps
     Vector& fa    = ytmp[1];
     Vector& fb    = ytmp[2];
+    tLastStepStart = NaN; // about to overwrite the stage derivatives
 
     const Real h = t1-t0;
 
@@ -136,6 +138,36 @@ bool RungeKuttaMersonIntegratorRep::attemptODEStep
     for (int i=0; i<y1.size(); ++i)
         y1err[i] = Real(.2)*std::abs(y1[i]-ysave[i]);
 
+    tLastStepStart = t0; tLastStepEnd = t1;
+    return true;
+}
+
+// This is a third order continuous extension of the step above, so that 
+// interpolation within the step needs no further derivative evaluations (see
+// Hairer, Norsett & Wanner, section II.6 on dense output). The weights 
+// b_i(theta), theta=(t-t0)/h, satisfy the order conditions through third
+// order for every theta using only the stages we kept, f0, f3 and f4:
+//
+//      b0 = theta - (3/2) theta^2 + (2/3) theta^3
+//      b3 =             2 theta^2 - (4/3) theta^3
+//      b4 =       - (1/2) theta^2 + (2/3) theta^3
+//
+// At theta=1 these are the weights 1/6, 2/3, 1/6 of the propagated solution.
+bool RungeKuttaMersonIntegratorRep::interpolateLastStep
+   (Real t, Vector& yt) const
+{
+    if (!(tLastStepStart == getPreviousTime() 
+          && tLastStepStart <= t && t <= tLastStepEnd))
+        return false;
+
+    const Real h = tLastStepEnd-tLastStepStart;
+    const Real th = (t-tLastStepStart)/h, th2 = th*th, th3 = th*th2;
+    const Real b0 = th - Real(1.5)*th2 + Real(2./3.)*th3;
+    const Real b3 = 2*th2 - Real(4./3.)*th3;
+    const Real b4 = Real(-0.5)*th2 + Real(2./3.)*th3;
+    const Vector& f3 = ytmp[2];
+    const Vector& f4 = ytmp[1];
+    yt = getPreviousY() + h*(b0*getPreviousYDot() + b3*f3 + b4*f4);
     return true;
 }
 
@@ -40,9 +40,13 @@ public:
 protected:
     bool attemptODEStep
        (Real t1, Vector& yErrEst, int& errOrder, int& numIterations) override;
+    bool interpolateLastStep(Real t, Vector& yt) const override;
 private:    
     static const int NTemps = 3;
     Vector ytmp[NTemps];
+    // The interval of the last successful attemptODEStep(), whose stage 
+    // derivatives are still in ytmp; tLastStepStart is NaN if there isn't one.
+    Real tLastStepStart, tLastStepEnd;
 };
 
 } // namespace SimTK
@@ -123,6 +123,34 @@ public:
     Vector calcGradient  (const Vector& y0, Method=UnspecifiedMethod) const;
     Matrix calcJacobian  (const Vector& y0, Method=UnspecifiedMethod) const;
 
+    // Sparse Jacobians. If you know which elements of df/dy may be nonzero,
+    // supply that pattern here in compressed column form: the rows that
+    // column j (parameter j) may affect are rowIndex[colStart[j]] through 
+    // rowIndex[colStart[j+1]-1]. The columns are then partitioned into
+    // groups ("colors") whose members affect no common row, and all the 
+    // parameters in a group are perturbed together, so calcJacobian() needs
+    // only one (forward) or two (central) function evaluations per color
+    // rather than per parameter. Elements outside the pattern are returned
+    // as zero. This applies only to a JacobianFunction.
+    Differentiator& setJacobianSparsity(const Array_<int>& colStart,
+                                        const Array_<int>& rowIndex);
+    Differentiator& clearJacobianSparsity();
+    bool hasJacobianSparsity() const;
+    // This is the number of groups of columns that are perturbed together;
+    // it is the number of parameters if there is no sparsity pattern.
+    int  getNumJacobianColors() const;
+
+    // Parallel Jacobians. Supply additional JacobianFunction objects that 
+    // compute the same function as the one being differentiated but can be 
+    // called concurrently with it and with each other (typically copies 
+    // with their own workspace). calcJacobian() then evaluates the perturbed
+    // columns (or colors) on 1+clones.size() threads, each using its own
+    // function object. The clones must remain alive while in use here; pass
+    // an empty array to go back to serial evaluation.
+    Differentiator& setFunctionClones
+       (const Array_<const JacobianFunction*>& clones);
+    int getNumFunctionClones() const;
+
     // Statistics (mutable)
     void resetAllStatistics();                 // reset all stats to zero
     int getNumDifferentiations() const;        // total # calls of calcWhatever
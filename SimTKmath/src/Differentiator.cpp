@@ -30,6 +30,7 @@
 #include "simmath/Differentiator.h"
 
 #include <exception>
+#include <memory>
 
 namespace SimTK {
 
@@ -133,6 +134,16 @@ public:
     void calcJacobian(const JacobianFunctionRep&, Differentiator::Method, 
                       const Vector& y0, const Vector& fy0, Matrix& dfdy) const;
 
+    void setJacobianSparsity(const Array_<int>& colStart, 
+                             const Array_<int>& rowIndex);
+    void clearJacobianSparsity();
+    bool hasJacobianSparsity() const {return !patternColStart.empty();}
+    int  getNumJacobianColors() const {
+        return hasJacobianSparsity() ? (int)colorColumns.size() : NParameters;
+    }
+    void setFunctionClones(const Array_<const JacobianFunctionRep*>& fclones);
+    int  getNumFunctionClones() const {return (int)clones.size();}
+
     const Real& getAccFac(int order) const {
         if (order==1) return AccFac1;
         if (order==2) return AccFac2;
@@ -173,6 +184,21 @@ private:
     mutable Vector ytmp;           // [NParameters]
     mutable Vector fyptmp, fymtmp; // [NFunctions]
 
+    // Optional sparsity pattern of df/dy in compressed column form, and the
+    // partition of the columns into colors that share no row. These are 
+    // empty if no pattern has been supplied.
+    Array_<int>             patternColStart, patternRowIndex;
+    Array_<Array_<int> >    colorColumns;
+
+    // Optional extra function objects for parallel Jacobian evaluation, and
+    // the executor whose threads use them.
+    Array_<const JacobianFunctionRep*>  clones;
+    std::unique_ptr<ParallelExecutor>   executor;
+
+    void calcJacobianByColors(const JacobianFunctionRep&, int order,
+                              const Vector& y0, const Vector& fy0, 
+                              Matrix& dfdy) const;
+
     // suppress
     DifferentiatorRep(const DifferentiatorRep&);
     DifferentiatorRep& operator=(const DifferentiatorRep&);
@@ -561,6 +587,42 @@ int Differentiator::getNumCallsToUserFunction() const {
     return rep->nCallsToUserFunction;
 }
 
+Differentiator& Differentiator::setJacobianSparsity
+   (const Array_<int>& colStart, const Array_<int>& rowIndex) {
+    rep->setJacobianSparsity(colStart, rowIndex);
+    return *this;
+}
+
+Differentiator& Differentiator::clearJacobianSparsity() {
+    rep->clearJacobianSparsity();
+    return *this;
+}
+
+bool Differentiator::hasJacobianSparsity() const {
+    return rep->hasJacobianSparsity();
+}
+
+int Differentiator::getNumJacobianColors() const {
+    return rep->getNumJacobianColors();
+}
+
+Differentiator& Differentiator::setFunctionClones
+   (const Array_<const JacobianFunction*>& fclones) {
+    Array_<const JacobianFunctionRep*> reps;
+    for (unsigned i=0; i < fclones.size(); ++i) {
+        SimTK_APIARGCHECK1_ALWAYS(fclones[i] != 0, "Differentiator", 
+            "setFunctionClones", "Clone %d was null.", (int)i);
+        reps.push_back(
+            dynamic_cast<const JacobianFunctionRep*>(fclones[i]->rep));
+    }
+    rep->setFunctionClones(reps);
+    return *this;
+}
+
+int Differentiator::getNumFunctionClones() const {
+    return rep->getNumFunctionClones();
+}
+
 
 /*static*/ bool 
 Differentiator::isValidMethod(Differentiator::Method m) {
@@ -772,6 +834,11 @@ void Differentiator::DifferentiatorRep::calcJacobian
 
     const int order = Differentiator::getMethodOrder(method);
 
+    if (hasJacobianSparsity() || !clones.empty()) {
+        calcJacobianByColors(f, order, y0, fy0, dfdy);
+        return;
+    }
+
     ytmp = y0;
     for (int i=0; i < NParameters; ++i) {
         const Real hEst = getAccFac(order)*std::max(std::abs(y0[i]), YMin);
@@ -789,6 +856,172 @@ void Differentiator::DifferentiatorRep::calcJacobian
     }
 }
 
-} // namespace SimTK
+void Differentiator::DifferentiatorRep::setJacobianSparsity
+   (const Array_<int>& colStart, const Array_<int>& rowIndex) 
+{
+    SimTK_APIARGCHECK2_ALWAYS((int)colStart.size()==NParameters+1, 
+        "Differentiator", "setJacobianSparsity",
+        "Expecting %d column starts (one per parameter plus one) but got %d",
+        NParameters+1, (int)colStart.size());
+    SimTK_APIARGCHECK2_ALWAYS(colStart[0]==0 
+                              && colStart[NParameters]==(int)rowIndex.size(),
+        "Differentiator", "setJacobianSparsity",
+        "Column starts must run from 0 to the number of row indices %d "
+        "but ended at %d", (int)rowIndex.size(), colStart[NParameters]);
+    for (int j=0; j < NParameters; ++j) {
+        SimTK_APIARGCHECK1_ALWAYS(colStart[j] <= colStart[j+1],
+            "Differentiator", "setJacobianSparsity",
+            "Column starts must be nondecreasing but column %d wasn't", j);
+        for (int e=colStart[j]; e < colStart[j+1]; ++e)
+            SimTK_APIARGCHECK3_ALWAYS(0 <= rowIndex[e] 
+                                      && rowIndex[e] < NFunctions,
+                "Differentiator", "setJacobianSparsity",
+                "Row index %d in column %d is out of range 0..%d", 
+                rowIndex[e], j, NFunctions-1);
+    }
+    patternColStart = colStart;
+    patternRowIndex = rowIndex;
+
+    // Greedy coloring, visiting the densest columns first. A column gets the
+    // lowest color not already taken by any column that shares a row with 
+    // it. lastUser[c] records the last column that found color c taken.
+    Array_<Array_<int> > colsOfRow(NFunctions);
+    for (int j=0; j < NParameters; ++j)
+        for (int e=colStart[j]; e < colStart[j+1]; ++e)
+            colsOfRow[rowIndex[e]].push_back(j);
+
+    Array_<int> order(NParameters);
+    for (int j=0; j < NParameters; ++j) order[j] = j;
+    std::stable_sort(order.begin(), order.end(), [&colStart](int a, int b) 
+    {   return colStart[a+1]-colStart[a] > colStart[b+1]-colStart[b]; });
+
+    Array_<int> color(NParameters, -1), lastUser;
+    colorColumns.clear();
+    for (int j : order) {
+        for (int e=colStart[j]; e < colStart[j+1]; ++e)
+            for (int k : colsOfRow[rowIndex[e]])
+                if (color[k] >= 0) lastUser[color[k]] = j;
+        int c = 0;
+        while (c < (int)lastUser.size() && lastUser[c] == j) ++c;
+        if (c == (int)lastUser.size()) {
+            lastUser.push_back(-1);
+            colorColumns.push_back(Array_<int>());
+        }
+        color[j] = c;
+        colorColumns[c].push_back(j);
+    }
+    for (auto& cols : colorColumns)
+        std::sort(cols.begin(), cols.end());
+}
+
+void Differentiator::DifferentiatorRep::clearJacobianSparsity() {
+    patternColStart.clear();
+    patternRowIndex.clear();
+    colorColumns.clear();
+}
+
+void Differentiator::DifferentiatorRep::setFunctionClones
+   (const Array_<const JacobianFunctionRep*>& fclones) 
+{
+    for (unsigned i=0; i < fclones.size(); ++i) {
+        SimTK_APIARGCHECK1_ALWAYS(fclones[i] != 0, "Differentiator", 
+            "setFunctionClones", "Clone %d is not a JacobianFunction.",
+            (int)i);
+        SimTK_APIARGCHECK1_ALWAYS(
+            fclones[i]->getNumFunctions()==NFunctions 
+            && fclones[i]->getNumParameters()==NParameters,
+            "Differentiator", "setFunctionClones",
+            "Clone %d doesn't have the same dimensions as the function "
+            "being differentiated.", (int)i);
+    }
+    clones = fclones;
+    executor.reset(clones.empty() ? 0 
+                   : new ParallelExecutor((int)clones.size()+1));
+}
 
+namespace {
+// Runs body(t, nCalls) for task t, saving any exception so it can be
+// rethrown on the calling thread after all the tasks are done.
+template <class Body>
+class ColorTask : public ParallelExecutor::Task {
+public:
+    ColorTask(int nTasks, Body& body) 
+    :   body(body), nCalls(nTasks, 0), errors(nTasks) {}
+    void execute(int t) override {
+        try {body(t, nCalls[t]);}
+        catch (...) {errors[t] = std::current_exception();}
+    }
+    Body&                       body;
+    Array_<int>                 nCalls;
+    Array_<std::exception_ptr>  errors;
+};
+}
 
+// Evaluate the Jacobian one color (group of columns) at a time. Without a 
+// sparsity pattern each column is a color by itself and affects every row.
+// Colors are dealt out round robin to one task per function object, so
+// each function object is used by only one thread at a time. Different
+// colors write to different columns of dfdy.
+void Differentiator::DifferentiatorRep::calcJacobianByColors
+   (const JacobianFunctionRep& f, int order, 
+    const Vector& y0, const Vector& fy0, Matrix& dfdy) const 
+{
+    const bool hasPattern = hasJacobianSparsity();
+    const int  nColors    = getNumJacobianColors();
+    const int  nTasks     = std::max(1, 
+                                std::min((int)clones.size()+1, nColors));
+    if (hasPattern) 
+        dfdy.setToZero();
+
+    auto evalColors = [&](int t, int& nCalls) {
+        const JacobianFunctionRep& ft = (t == 0 ? f : *clones[t-1]);
+        Vector y(y0), fyp(NFunctions), fym(NFunctions);
+        Array_<int> single(1);
+        Array_<Real> h;
+        for (int c=t; c < nColors; c += nTasks) {
+            if (!hasPattern) single[0] = c;
+            const Array_<int>& cols = hasPattern ? colorColumns[c] : single;
+            h.resize(cols.size());
+            for (unsigned k=0; k < cols.size(); ++k) {
+                const int j = cols[k];
+                const Real hEst = getAccFac(order)
+                                  * std::max(std::abs(y0[j]), YMin);
+                h[k] = cleanUpH(hEst, y0[j]);
+                y[j] = y0[j]+h[k];
+            }
+            ++nCalls; ft.call(y, fyp);
+            if (order==2) {
+                for (unsigned k=0; k < cols.size(); ++k)
+                    y[cols[k]] = y0[cols[k]]-h[k];
+                ++nCalls; ft.call(y, fym);
+            }
+            for (unsigned k=0; k < cols.size(); ++k) {
+                const int j = cols[k];
+                y[j] = y0[j]; // restore
+                if (!hasPattern) {
+                    if (order==1) dfdy(j) = (fyp-fy0)/h[k];
+                    else          dfdy(j) = (fyp-fym)/(2*h[k]);
+                    continue;
+                }
+                for (int e=patternColStart[j]; e < patternColStart[j+1]; ++e) {
+                    const int r = patternRowIndex[e];
+                    dfdy(r,j) = order==1 ? (fyp[r]-fy0[r])/h[k]
+                                         : (fyp[r]-fym[r])/(2*h[k]);
+                }
+            }
+        }
+    };
+
+    ColorTask<decltype(evalColors)> task(nTasks, evalColors);
+    if (nTasks > 1 && !ParallelExecutor::isWorkerThread())
+        executor->execute(task, nTasks);
+    else
+        for (int t=0; t < nTasks; ++t) task.execute(t);
+
+    for (int t=0; t < nTasks; ++t)
+        nCallsToUserFunction += task.nCalls[t];
+    for (int t=0; t < nTasks; ++t)
+        if (task.errors[t]) std::rethrow_exception(task.errors[t]);
+}
+
+} // namespace SimTK
@@ -71,6 +71,37 @@ int main () {
         CPodesIntegrator projInteg(sys, CPodes::BDF);
         projInteg.setUseCPodesProjection();
         testIntegrator(projInteg, sys);
+
+        // Use the matrix-free Krylov linear solver, with and without a band
+        // preconditioner just wide enough to couple each q with its u (the
+        // pendulum has nq=2). The GMRES solver must actually have been used.
+        // Changing the linear solver after initialization should produce an
+        // exception.
+
+        CPodesIntegrator krylovInteg(sys, CPodes::BDF);
+        krylovInteg.setUseKrylovLinearSolver();
+        testIntegrator(krylovInteg, sys);
+        ASSERT(krylovInteg.getNumKrylovLinearIterations() > 0);
+        try {
+            krylovInteg.setUseKrylovLinearSolver(false);
+            assert(false);
+        }
+        catch (...) {
+        }
+
+        CPodesIntegrator precInteg(sys, CPodes::BDF);
+        precInteg.setUseKrylovLinearSolver(true, 2);
+        bool threw = false; // there is no count before initialization
+        try {
+            precInteg.getNumKrylovLinearIterations();
+        }
+        catch (const std::exception&) {
+            threw = true;
+        }
+        ASSERT(threw);
+        testIntegrator(precInteg, sys);
+        ASSERT(precInteg.getNumKrylovLinearIterations() > 0);
+        ASSERT(bdfInteg.getNumKrylovLinearIterations() == 0);
     }
     cout << "Done" << endl;
     return 0;
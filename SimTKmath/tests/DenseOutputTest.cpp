@@ -0,0 +1,159 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check the states the integrators produce by interpolating within a step
+// (dense output) against a known solution, and check that the interpolated
+// trajectory is continuous across step boundaries. Merson and Feldberg use
+// their own continuous extensions here; RungeKutta3 uses Hermite 
+// interpolation and is included for comparison.
+//
+// With gravity turned off and a unit tangential initial velocity, the unit
+// length pendulum moves uniformly around the circle: x=cos(t), y=sin(t). 
+// The rod is a constraint, so the end of every step is projected and dense
+// output must account for that too.
+
+#include "SimTKmath.h"
+
+#include "PendulumSystem.h"
+
+#include <cstdio>
+
+using namespace SimTK;
+
+namespace {
+
+const Real Accuracy = 1e-6;
+const Real FinalTime = 5;
+
+Vec2 getXY(const State& state, const PendulumSystem& sys) {
+    const Vector& q = state.getQ(sys.getGuts().getSubsysIndex());
+    return Vec2(q[0], q[1]);
+}
+
+Real calcError(const State& state, const PendulumSystem& sys) {
+    const Real t = state.getTime();
+    return (getXY(state, sys) - Vec2(std::cos(t), std::sin(t))).norm();
+}
+
+void initialize(PendulumSystem& sys, Integrator& integ) {
+    sys.realizeTopology();
+    const Real qi[] = {1,0}; // (x,y)=(1,0)
+    const Real ui[] = {0,1}; // v=1, perpendicular to the rod
+    sys.setDefaultGravity(0);
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+    integ.setAccuracy(Accuracy);
+    integ.setConstraintTolerance(1e-8);
+    integ.initialize(sys.getDefaultState());
+}
+
+// stepTo() also returns at the start of the continuous interval, so keep 
+// going until the integrator gets to t.
+void advanceTo(Integrator& integ, Real t) {
+    while (integ.getTime() < t)
+        integ.stepTo(t);
+}
+
+// Report at many times that don't coincide with the ends of steps and compare
+// against the exact solution. The interpolated states should be about as 
+// accurate as the states at the ends of the steps.
+template <class IntegratorType>
+void testMatchesKnownSolution() {
+    PendulumSystem sys;
+    IntegratorType integ(sys);
+    initialize(sys, integ);
+
+    int numInterpolated = 0;
+    Real maxInterpError = 0, maxStepError = 0;
+    for (Real t = Real(0.0123); t < FinalTime; t += Real(0.0123)) {
+        advanceTo(integ, t);
+        SimTK_TEST(integ.getState().getTime() == t);
+        if (integ.isStateInterpolated()) {
+            ++numInterpolated;
+            maxInterpError = std::max(maxInterpError, 
+                                      calcError(integ.getState(), sys));
+        }
+        maxStepError = std::max(maxStepError, 
+                                calcError(integ.getAdvancedState(), sys));
+    }
+    printf("%s: %d interpolated states, max error %g (%g at step ends)\n", 
+           integ.getMethodName(), numInterpolated, maxInterpError, 
+           maxStepError);
+    // The steps must be much longer than the reporting interval for this
+    // test to mean anything.
+    SimTK_TEST(numInterpolated > 100);
+    SimTK_TEST(maxInterpError <= 2*maxStepError + 10*Accuracy);
+    SimTK_TEST(maxInterpError <= 100*Accuracy);
+}
+
+// Ask for interpolated states just before and just after the end of each of
+// a series of steps. The two should differ by only the tiny motion between
+// them, so there is no jump where one step's interpolant hands off to the 
+// next.
+template <class IntegratorType>
+void testContinuousAtStepBoundaries() {
+    PendulumSystem sys;
+    IntegratorType integ(sys);
+    initialize(sys, integ);
+
+    const Real Eps = 1e-9; // speed is 1, so that's how far the mass moves
+    Real maxJump = 0;
+    int numBoundaries = 0;
+    Real t = Real(0.0123);
+    while (t < FinalTime && numBoundaries < 50) {
+        advanceTo(integ, t);
+        if (!integ.isStateInterpolated()) {t += Real(0.0123); continue;}
+
+        // The current step ends at tEnd, beyond t. 
+        const Real tEnd = integ.getAdvancedState().getTime();
+        if (tEnd - Eps <= t) {t += Real(0.0123); continue;}
+        advanceTo(integ, tEnd - Eps);
+        SimTK_TEST(integ.isStateInterpolated());
+        const Vec2 before = getXY(integ.getState(), sys);
+
+        // Take the next step and look just after its start.
+        advanceTo(integ, tEnd + Eps);
+        SimTK_TEST(integ.getAdvancedState().getTime() > tEnd);
+        const Vec2 after = getXY(integ.getState(), sys);
+
+        maxJump = std::max(maxJump, (after-before).norm());
+        ++numBoundaries;
+        t = tEnd + Real(0.0123);
+    }
+    printf("%s: max jump across %d step boundaries %g\n", 
+           integ.getMethodName(), numBoundaries, maxJump);
+    SimTK_TEST(numBoundaries >= 20);
+    SimTK_TEST(maxJump <= 10*Eps);
+}
+
+}
+
+int main() {
+    SimTK_START_TEST("DenseOutputTest");
+        SimTK_SUBTEST(testMatchesKnownSolution<RungeKuttaMersonIntegrator>);
+        SimTK_SUBTEST(testMatchesKnownSolution<RungeKuttaFeldbergIntegrator>);
+        SimTK_SUBTEST(testMatchesKnownSolution<RungeKutta3Integrator>);
+        SimTK_SUBTEST(testContinuousAtStepBoundaries<RungeKuttaMersonIntegrator>);
+        SimTK_SUBTEST(testContinuousAtStepBoundaries<RungeKuttaFeldbergIntegrator>);
+        SimTK_SUBTEST(testContinuousAtStepBoundaries<RungeKutta3Integrator>);
+    SimTK_END_TEST();
+}
@@ -27,6 +27,7 @@
  */
 
 #include "SimTKmath.h"
+#include "SimTKcommon/Testing.h"
 
 // Just so we can get the version number:
 #include "SimTKlapack.h"
@@ -37,6 +38,7 @@
 using SimTK::Real;
 using SimTK::Vector;
 using SimTK::Matrix;
+using SimTK::Array_;
 using SimTK::Differentiator;
 using std::printf;
 using std::cout;
@@ -191,6 +193,77 @@ static void doSinOmegaExample() {
 };
 
 
+// A banded vector function of n parameters: f_i depends on y_(i-1), y_i
+// and y_(i+1), so its Jacobian is tridiagonal and needs only 3 colors.
+class BandedFunc : public Differentiator::JacobianFunction {
+public:
+    explicit BandedFunc(int n) : Differentiator::JacobianFunction(n,n) {}
+    int f(const Vector& y, Vector& fy) const override {
+        const int n = y.size();
+        for (int i=0; i < n; ++i) {
+            fy[i] = y[i]*y[i];
+            if (i > 0)   fy[i] += y[i-1]*y[i];
+            if (i < n-1) fy[i] += std::sin(y[i+1]);
+        }
+        return 0;
+    }
+};
+
+static void testSparseAndParallelJacobian() {
+    const int n = 20;
+    BandedFunc func(n), clone1(n), clone2(n);
+    Vector y0(n), fy0(n);
+    for (int i=0; i < n; ++i) y0[i] = 0.1*i - 0.5;
+    func.f(y0, fy0);
+
+    Differentiator dense(func);
+    const Matrix Jdense = dense.calcJacobian(y0);
+
+    Array_<int> colStart(1, 0), rowIndex;
+    for (int j=0; j < n; ++j) {
+        for (int i=std::max(j-1,0); i <= std::min(j+1,n-1); ++i)
+            rowIndex.push_back(i);
+        colStart.push_back((int)rowIndex.size());
+    }
+
+    Differentiator sparse(func);
+    sparse.setJacobianSparsity(colStart, rowIndex);
+    SimTK_TEST(sparse.hasJacobianSparsity());
+    SimTK_TEST(sparse.getNumJacobianColors() == 3);
+
+    Matrix J;
+    sparse.calcJacobian(y0, fy0, J);
+    SimTK_TEST(sparse.getNumCallsToUserFunction() == 3);
+    SimTK_TEST_EQ_TOL(J, Jdense, 1e-12);
+    SimTK_TEST(J(0,5) == 0);
+
+    sparse.calcJacobian(y0, fy0, J, Differentiator::CentralDifference);
+    SimTK_TEST(sparse.getNumCallsToUserFunction() == 3+6);
+
+    // Parallel evaluation gives the same answers, with or without a pattern.
+    Array_<const Differentiator::JacobianFunction*> clones;
+    clones.push_back(&clone1); clones.push_back(&clone2);
+    Matrix Jpar;
+    sparse.setFunctionClones(clones);
+    SimTK_TEST(sparse.getNumFunctionClones() == 2);
+    sparse.calcJacobian(y0, fy0, J);
+    dense.setFunctionClones(clones);
+    dense.calcJacobian(y0, fy0, Jpar);
+    SimTK_TEST_EQ(Jpar, Jdense);
+    SimTK_TEST(dense.getNumCallsToUserFunction() == 1+n+n);
+    SimTK_TEST(clone1.getNumCalls() > 0 && clone2.getNumCalls() > 0);
+
+    sparse.clearJacobianSparsity();
+    SimTK_TEST(!sparse.hasJacobianSparsity());
+    SimTK_TEST(sparse.getNumJacobianColors() == n);
+
+    // Bad patterns are caught.
+    Array_<int> shortStart(colStart.begin(), colStart.end()-1);
+    SimTK_TEST_MUST_THROW(sparse.setJacobianSparsity(shortStart, rowIndex));
+    Array_<int> badRows(rowIndex); badRows[3] = n;
+    SimTK_TEST_MUST_THROW(sparse.setJacobianSparsity(colStart, badRows));
+}
+
 static Real mysin(Real x) {
     return std::sin(x);
 }
@@ -284,6 +357,8 @@ int main() {
     cout << std::setprecision(16);
     cout << "1 err=" << (yp2-(yp+dfdy*2*delta_y)).norm() << endl;
     cout << "2 err=" << (yp2-(yp+dfdy2*2*delta_y)).norm() << endl;
+
+    testSparseAndParallelJacobian();
   }
   catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
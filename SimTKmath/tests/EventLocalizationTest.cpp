@@ -0,0 +1,206 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that the integrators still localize event triggers correctly now that
+// the triggers are screened in bulk and localization realizes interpolated
+// states only through the highest stage at which there are triggers. Time
+// stage triggers have known crossing times; position stage ones must be 
+// nearly zero when reported. Adding an acceleration stage trigger forces 
+// localization to realize accelerations, which must not change the other 
+// events.
+
+#include "SimTKmath.h"
+#include "simmath/TimeStepper.h"
+
+#include "PendulumSystem.h"
+
+#include <cstdio>
+
+using namespace SimTK;
+
+namespace {
+
+const Real Accuracy = 1e-4;
+const Real FinalTime = 10;
+
+// Record the times at which a witness function crossed zero, and the value
+// of a quantity of interest at those times.
+struct Crossings {
+    Array_<Real> times, values;
+};
+
+// Crosses zero once, at time tCross.
+class TimeCrossing : public TriggeredEventReporter {
+public:
+    TimeCrossing(Real tCross, Crossings& log) 
+    :   TriggeredEventReporter(Stage::Time), tCross(tCross), log(log) {}
+    Real getValue(const State& state) const override 
+    {   return state.getTime() - tCross; }
+    void handleEvent(const State& state) const override 
+    {   log.times.push_back(state.getTime()); }
+private:
+    Real        tCross;
+    Crossings&  log;
+};
+
+// Crosses zero whenever the pendulum passes x == c.
+class PositionCrossing : public TriggeredEventReporter {
+public:
+    PositionCrossing(const PendulumSystem& pendulum, Real c, Crossings& log) 
+    :   TriggeredEventReporter(Stage::Position), pendulum(pendulum), c(c), 
+        log(log) {}
+    Real getValue(const State& state) const override 
+    {   return getX(state) - c; }
+    void handleEvent(const State& state) const override {
+        log.times.push_back(state.getTime());
+        log.values.push_back(getX(state) - c);
+    }
+private:
+    Real getX(const State& state) const
+    {   return state.getQ(pendulum.getGuts().getSubsysIndex())[0]; }
+    const PendulumSystem&   pendulum;
+    Real                    c;
+    Crossings&              log;
+};
+
+// The horizontal acceleration comes only from the rod tension, so this 
+// crosses zero exactly when x does.
+class AccelerationCrossing : public TriggeredEventReporter {
+public:
+    AccelerationCrossing(const PendulumSystem& pendulum, Crossings& log) 
+    :   TriggeredEventReporter(Stage::Acceleration), pendulum(pendulum), 
+        log(log) {}
+    Real getValue(const State& state) const override 
+    {   return state.getUDot(pendulum.getGuts().getSubsysIndex())[0]; }
+    void handleEvent(const State& state) const override 
+    {   log.times.push_back(state.getTime()); }
+private:
+    const PendulumSystem&   pendulum;
+    Crossings&              log;
+};
+
+const int NumTimeCrossings = 25;
+Real getCrossingTime(int k) {return Real(0.13) + Real(0.37)*k;}
+const Real PositionCrossingLocations[] = {-.9, -.5, 0, .5, .9};
+const int NumPositionCrossings = 5;
+const int ZeroCrossing = 2; // index of x == 0 above
+
+struct Results {
+    Array_<Crossings> timeCrossings, positionCrossings;
+    Crossings accelerationCrossings;
+};
+
+// Simulate a pendulum with the crossing reporters using the given integrator.
+template <class IntegratorType>
+void simulate(bool includeAccelerationTrigger, Results& results) {
+    results.timeCrossings.resize(NumTimeCrossings);
+    results.positionCrossings.resize(NumPositionCrossings);
+
+    PendulumSystem sys;
+    for (int k=0; k < NumTimeCrossings; ++k)
+        sys.addEventReporter(new TimeCrossing(getCrossingTime(k), 
+                                              results.timeCrossings[k]));
+    for (int k=0; k < NumPositionCrossings; ++k)
+        sys.addEventReporter(new PositionCrossing
+           (sys, PositionCrossingLocations[k], results.positionCrossings[k]));
+    if (includeAccelerationTrigger)
+        sys.addEventReporter(new AccelerationCrossing
+                                (sys, results.accelerationCrossings));
+    sys.realizeTopology();
+
+    const Real qi[] = {1,0}; // (x,y)=(1,0)
+    const Real ui[] = {0,0}; // v=0
+    sys.setDefaultMass(10);
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+
+    IntegratorType integ(sys);
+    integ.setAccuracy(Accuracy);
+    integ.setConstraintTolerance(1e-6);
+    TimeStepper ts(sys, integ);
+    ts.initialize(sys.getDefaultState());
+    ts.stepTo(FinalTime);
+    SimTK_TEST(ts.getTime() == FinalTime);
+}
+
+template <class IntegratorType>
+void testLocalization() {
+    // Localization windows are the default fraction of the time scale 
+    // scaled by the accuracy; allow for that and a little roundoff.
+    PendulumSystem sys;
+    const Real window = Real(0.1)*Accuracy*sys.getDefaultTimeScale();
+    const Real tol = window + 100*SignificantReal;
+
+    Results results, resultsWithAccel;
+    simulate<IntegratorType>(false, results);
+    simulate<IntegratorType>(true, resultsWithAccel);
+
+    for (const Results* r : {&results, &resultsWithAccel}) {
+        // Every time crossing before the final time is reported once, and
+        // within the localization window of the exact time.
+        for (int k=0; k < NumTimeCrossings; ++k) {
+            const Array_<Real>& times = r->timeCrossings[k].times;
+            const Real tCross = getCrossingTime(k);
+            if (tCross >= FinalTime) {SimTK_TEST(times.empty()); continue;}
+            SimTK_TEST(times.size() == 1);
+            SimTK_TEST(std::abs(times[0] - tCross) <= tol);
+        }
+
+        // The pendulum swings from x=1 to x=-1 and back about every 2s, so
+        // every position crossing is seen repeatedly, and x has the crossing
+        // value (to within the distance moved during a window) each time.
+        for (int k=0; k < NumPositionCrossings; ++k) {
+            const Crossings& crossings = r->positionCrossings[k];
+            SimTK_TEST(crossings.times.size() >= 4);
+            for (Real err : crossings.values)
+                SimTK_TEST(std::abs(err) <= 10*window);
+        }
+    }
+
+    // Adding an acceleration-stage trigger doesn't disturb the others.
+    for (int k=0; k < NumPositionCrossings; ++k) {
+        const Array_<Real>& t0 = results.positionCrossings[k].times;
+        const Array_<Real>& t1 = resultsWithAccel.positionCrossings[k].times;
+        SimTK_TEST(t0.size() == t1.size());
+        for (unsigned i=0; i < std::min(t0.size(), t1.size()); ++i)
+            SimTK_TEST_EQ_TOL(t0[i], t1[i], 100*tol);
+    }
+
+    // The acceleration trigger itself fires with the x == 0 crossings.
+    const Array_<Real>& accelTimes = 
+        resultsWithAccel.accelerationCrossings.times;
+    const Array_<Real>& zeroTimes = 
+        resultsWithAccel.positionCrossings[ZeroCrossing].times;
+    SimTK_TEST(accelTimes.size() == zeroTimes.size());
+    for (unsigned i=0; i < std::min(accelTimes.size(), zeroTimes.size()); ++i)
+        SimTK_TEST_EQ_TOL(accelTimes[i], zeroTimes[i], 100*tol);
+}
+
+}
+
+int main() {
+    SimTK_START_TEST("EventLocalizationTest");
+        SimTK_SUBTEST(testLocalization<RungeKuttaMersonIntegrator>);
+        SimTK_SUBTEST(testLocalization<RungeKuttaFeldbergIntegrator>);
+        SimTK_SUBTEST(testLocalization<RungeKutta3Integrator>);
+    SimTK_END_TEST();
+}
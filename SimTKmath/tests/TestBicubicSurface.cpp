@@ -1035,12 +1035,91 @@ void testHint() {
 
 }
 
+// Check calcValues() against one-at-a-time evaluation, for points in
+// random order spread over all the patches, including the edges.
+// calcValues() promises exactly the results calcValue() and calcDerivative()
+// give, since it does the same operations in the same order. If the compiler
+// is allowed to fuse the scalar code's multiplies and adds, the two may be
+// rounded differently, so we can only check them to within a tolerance.
+#if defined(__FMA__) || defined(__FMA4__)
+    #define BATCH_TEST_EQ(a,b) SimTK_TEST_EQ(a,b)
+#else
+    #define BATCH_TEST_EQ(a,b) SimTK_TEST((a)==(b))
+#endif
+
+void testBatchValues() {
+    const Real xData[4] = { .1, 1, 2, 10 };
+    const Real yData[5] = { -3, -2, 0, 1, 3 };
+    const Real fData[] = { 1,   2,   3,   4,   5,
+                           1.1, 2.6, 3.1, 4.1, 5.1,
+                           1,   2,   3.5, 4,   5,
+                           1.2, 2.2, 3.2, 4.7, 5.2 };
+    const BicubicSurface irregular(Vector(4, xData), Vector(5, yData),
+                                   Matrix(4,5, fData), 0);
+    const BicubicSurface regular(Vec2(-1,2), Vec2(.5,.25),
+                                 Matrix(4,5, fData), 0);
+    const BicubicSurface* surfaces[2] = {&irregular, &regular};
+    const Array_<int> dx(1,0), dy(1,1);
+
+    Random::Uniform rand(0,1); rand.setSeed(7);
+    for (int s=0; s < 2; ++s) {
+        const BicubicSurface& surf = *surfaces[s];
+        const Vec2 lo = surf.getMinXY(), hi = surf.getMaxXY();
+        Array_<Vec2> XY;
+        for (int i=0; i < 101; ++i)
+            XY.push_back(Vec2(lo[0] + rand.getValue()*(hi[0]-lo[0]),
+                              lo[1] + rand.getValue()*(hi[1]-lo[1])));
+        XY.push_back(lo); XY.push_back(hi);
+        XY.push_back(Vec2(hi[0], lo[1])); XY.push_back(Vec2(lo[0], hi[1]));
+
+        Array_<Real> f, f2;
+        Array_<Vec2> gradf;
+        surf.resetStatistics();
+        surf.calcValues(XY, f);
+        SimTK_TEST(f.size() == XY.size());
+        SimTK_TEST(surf.getNumAccesses() == (int)XY.size());
+        // Only 12 patches so most points share one.
+        SimTK_TEST(surf.getNumAccessesSamePatch() >= (int)XY.size()-12);
+
+        surf.calcValues(XY, f2, gradf);
+        SimTK_TEST(gradf.size() == XY.size());
+        for (unsigned i=0; i < XY.size(); ++i) {
+            SimTK_TEST(f2[i] == f[i]);
+            BATCH_TEST_EQ(f[i], surf.calcValue(XY[i]));
+            BATCH_TEST_EQ(gradf[i][0], surf.calcDerivative(dx, XY[i]));
+            BATCH_TEST_EQ(gradf[i][1], surf.calcDerivative(dy, XY[i]));
+        }
+
+        SimTK_TEST_MUST_THROW(surf.calcValues(Array_<Vec2>(3, hi+Vec2(1,0)),
+                                              f));
+    }
+
+    // The height map passes straight through to the surface.
+    ContactGeometry::SmoothHeightMap map(irregular);
+    Array_<Vec2> XY;
+    XY.push_back(Vec2(.5,.5)); XY.push_back(Vec2(9,-2.5));
+    XY.push_back(Vec2(1.5,-1));
+    Array_<Real> height;
+    Array_<UnitVec3> normal;
+    map.calcSurfaceHeights(XY, height, normal);
+    SimTK_TEST(height.size() == 3 && normal.size() == 3);
+    for (unsigned i=0; i < XY.size(); ++i) {
+        SimTK_TEST_EQ(height[i], irregular.calcValue(XY[i]));
+        SimTK_TEST_EQ(normal[i], irregular.calcUnitNormal(XY[i]));
+    }
+
+    XY.clear();
+    map.calcSurfaceHeights(XY, height);
+    SimTK_TEST(height.empty());
+}
+
 int main() {
     //Evaluate the bicubic surface interpolation against an analytical 
     //function. Throw an error if the values of the function are different
     //at the knot points, or different within tolerance at the mid grid points
     SimTK_START_TEST("Testing Bicubic Interpolation");
         SimTK_SUBTEST(testHint);
+        SimTK_SUBTEST(testBatchValues);
 
     cout << "\n---------------------------------------------"<< endl;
     cout<< "\n\nANALYTICAL FUNCTION COMPARISON:" << endl;
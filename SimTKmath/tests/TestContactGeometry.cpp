@@ -461,6 +461,72 @@ void testProjectDownhillToNearestPoint(const ContactGeometry& geom, Real r) {
     }
 }
 
+// Check that repeated and nearby two-point geodesic calculations are served
+// from a surface's geodesic cache, and that the answers don't change.
+void testGeodesicCache() {
+    ContactGeometry::Sphere sphere(r);
+    ContactGeometry::Sphere uncached(r);
+    ASSERT(uncached.getGeodesicCacheSize() == 0); // off by default
+    sphere.setGeodesicCacheSize(4);
+    ASSERT(sphere.getGeodesicAccuracy() == 1e-6);
+
+    const Vec3 P = r*UnitVec3(1,0.2,0), Q = r*UnitVec3(-0.3,1,0.1);
+    const Vec3 Qnear = r*UnitVec3(-0.31,1,0.12);
+    const Real arcPQ = r*std::acos(~UnitVec3(P)*UnitVec3(Q));
+    Geodesic geod, again, near, nearCold;
+
+    sphere.calcGeodesicUsingOrthogonalMethod(P, Q, geod);
+    ASSERT(sphere.getNumGeodesicCacheMisses() == 1);
+    assertEqual(geod.getLength(), arcPQ);
+
+    // Same end points; nothing is calculated.
+    sphere.calcGeodesicUsingOrthogonalMethod(P, Q, again);
+    ASSERT(sphere.getNumGeodesicCacheHits() == 1);
+    ASSERT(again.getLength() == geod.getLength());
+    ASSERT(again.getNumPoints() == geod.getNumPoints());
+
+    // Nearby end points; warm started. This should take fewer shots than
+    // starting from the hints, and get the same answer.
+    sphere.calcGeodesicUsingOrthogonalMethod(P, Qnear, near);
+    ASSERT(sphere.getNumGeodesicCacheWarmStarts() == 1);
+    const int nWarmShots = sphere.getNumGeodesicsShot();
+    uncached.calcGeodesicUsingOrthogonalMethod(P, Qnear, nearCold);
+    ASSERT(uncached.getNumGeodesicCacheMisses() == 1);
+    ASSERT(uncached.getNumGeodesicCacheHits() == 0);
+    ASSERT(nWarmShots < uncached.getNumGeodesicsShot());
+    ASSERT(std::abs(near.getLength() - nearCold.getLength()) < 1e-8);
+    ASSERT((near.getPointQ() - Qnear).norm() < 1e-8);
+
+    // Far away, or asked to start in a very different direction; no help.
+    sphere.calcGeodesicUsingOrthogonalMethod(P, -Q, geod);
+    sphere.calcGeodesicUsingOrthogonalMethod(P, Qnear, 
+        -near.getTangentP().asVec3(), near.getLength(), geod);
+    ASSERT(sphere.getNumGeodesicCacheMisses() == 3);
+
+    // Copies get the settings but not the contents.
+    sphere.setGeodesicCacheSize(1);
+    sphere.setGeodesicAccuracy(1e-7);
+    ContactGeometry::Sphere copy(sphere);
+    ASSERT(copy.getGeodesicCacheSize() == 1);
+    ASSERT(copy.getGeodesicAccuracy() == 1e-7);
+    copy.calcGeodesicUsingOrthogonalMethod(P, Q, geod);
+    ASSERT(copy.getNumGeodesicCacheMisses() == 1);
+
+    // With room for only one, a different geodesic pushes it out.
+    copy.calcGeodesicUsingOrthogonalMethod(P, -Q, geod);
+    copy.calcGeodesicUsingOrthogonalMethod(P, Q, geod);
+    ASSERT(copy.getNumGeodesicCacheMisses() == 3);
+    copy.resetGeodesicCacheStatistics();
+    ASSERT(copy.getNumGeodesicCacheMisses() == 0);
+
+    // continueGeodesic() warm starts from the previous geodesic even when
+    // nothing is remembered.
+    copy.clearGeodesicCache();
+    copy.continueGeodesic(P, Qnear, again, GeodesicOptions(), geod);
+    ASSERT(copy.getNumGeodesicCacheWarmStarts() == 1);
+    const Real arcPQnear = r*std::acos(~UnitVec3(P)*UnitVec3(Qnear));
+    ASSERT(std::abs(geod.getLength() - arcPQnear) < 1e-6);
+}
 
 int main() {
     try {
@@ -476,6 +542,7 @@ int main() {
         testProjectDownhillToNearestPoint(ContactGeometry::Sphere(r), r);
         testProjectDownhillToNearestPoint(ContactGeometry::Ellipsoid(Vec3(1.5, 2.2, 3.1)), r);
 //        testProjectDownhillToNearestPoint(ContactGeometry::Torus(3*r, r), 3*r);
+        testGeodesicCache();
     }
     catch(const std::exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -24,6 +24,7 @@
 #include "SimTKmath.h"
 #include <vector>
 #include <exception>
+#include <sstream>
 
 using namespace SimTK;
 using namespace std;
@@ -201,6 +202,54 @@ void testOBBTree() {
         SimTK_TEST(faceReferenceCount[i] == 1);
 }
 
+void compareOBBTrees(ContactGeometry::TriangleMesh::OBBTreeNode node1, 
+                     ContactGeometry::TriangleMesh::OBBTreeNode node2) {
+    SimTK_TEST(node1.isLeafNode() == node2.isLeafNode());
+    SimTK_TEST(node1.getNumTriangles() == node2.getNumTriangles());
+    SimTK_TEST(node1.getBounds().getSize() == node2.getBounds().getSize());
+    SimTK_TEST(node1.getBounds().getTransform().p() 
+               == node2.getBounds().getTransform().p());
+    if (node1.isLeafNode()) {
+        SimTK_TEST(node1.getTriangles() == node2.getTriangles());
+    }
+    else {
+        compareOBBTrees(node1.getFirstChildNode(), node2.getFirstChildNode());
+        compareOBBTrees(node1.getSecondChildNode(), node2.getSecondChildNode());
+    }
+}
+
+void testSaveOBBTree() {
+    // Save the tree of a mesh and create a new mesh with it.
+    
+    PolygonalMesh sphere = PolygonalMesh::createSphereMesh(1, 3);
+    ContactGeometry::TriangleMesh mesh(sphere);
+    std::stringstream data;
+    mesh.writeOBBTree(data);
+    ContactGeometry::TriangleMesh mesh2(sphere, data);
+    compareOBBTrees(mesh.getOBBTreeNode(), mesh2.getOBBTreeNode());
+    vector<int> faceReferenceCount(mesh2.getNumFaces(), 0);
+    validateOBBTree(mesh2, mesh2.getOBBTreeNode(), mesh2.getOBBTreeNode(), 
+                    faceReferenceCount);
+    Real distance1, distance2;
+    UnitVec3 normal;
+    SimTK_TEST(mesh.intersectsRay(Vec3(2, 0.1, 0.2), UnitVec3(-1, 0, 0), 
+                                  distance1, normal));
+    SimTK_TEST(mesh2.intersectsRay(Vec3(2, 0.1, 0.2), UnitVec3(-1, 0, 0), 
+                                   distance2, normal));
+    SimTK_TEST(distance1 == distance2);
+    
+    // The tree can't be used with a different mesh, or if it is damaged.
+    
+    const string saved = data.str();
+    std::stringstream data2(saved);
+    SimTK_TEST_MUST_THROW(ContactGeometry::TriangleMesh
+        (PolygonalMesh::createSphereMesh(2, 3), data2));
+    std::stringstream truncated(saved.substr(0, saved.size()/2));
+    SimTK_TEST_MUST_THROW(ContactGeometry::TriangleMesh(sphere, truncated));
+    std::stringstream garbage(string(saved.size(), 'x'));
+    SimTK_TEST_MUST_THROW(ContactGeometry::TriangleMesh(sphere, garbage));
+}
+
 void testRayIntersection() {
     // Create an octrohedral mesh.
     
@@ -277,6 +326,52 @@ void testFindNearestPoint() {
     }
 }
 
+void testQueriesAgainstBruteForce() {
+    // Compare the tree-accelerated queries on a mesh large enough to have a
+    // deep OBBTree with checks of every face.
+
+    ContactGeometry::TriangleMesh mesh(PolygonalMesh::createSphereMesh(1, 3));
+    Random::Uniform random(-1.5, 1.5);
+    for (int i = 0; i < 200; i++) {
+        Vec3 pos(random.getValue(), random.getValue(), random.getValue());
+        bool inside;
+        UnitVec3 normal;
+        Vec3 nearest = mesh.findNearestPoint(pos, inside, normal);
+        Real minDist2 = MostPositiveReal;
+        for (int j = 0; j < mesh.getNumFaces(); j++) {
+            Vec2 uv;
+            Vec3 p = mesh.findNearestPointToFace(pos, j, uv);
+            minDist2 = std::min(minDist2, (p-pos).normSqr());
+        }
+        SimTK_TEST_EQ((nearest-pos).normSqr(), minDist2);
+
+        // A ray from outside the sphere aimed near its center.
+        
+        Vec3 origin = 3*UnitVec3(pos);
+        UnitVec3 dir(0.5*pos-origin);
+        Real distance;
+        SimTK_TEST(mesh.intersectsRay(origin, dir, distance, normal));
+        Real minDistance = MostPositiveReal;
+        for (int j = 0; j < mesh.getNumFaces(); j++) {
+            const Vec3& n = mesh.getFaceNormal(j);
+            Real t = ~n*(mesh.getVertexPosition(mesh.getFaceVertex(j, 0))
+                         -origin)/(~n*dir);
+            Vec3 hit = origin+t*dir;
+            bool insideFace = true;
+            for (int k = 0; k < 3; k++) {
+                const Vec3& a = mesh.getVertexPosition(mesh.getFaceVertex(j, k));
+                const Vec3& b = mesh.getVertexPosition(
+                                    mesh.getFaceVertex(j, (k+1)%3));
+                if (~n*((b-a)%(hit-a)) < -1e-12)
+                    insideFace = false;
+            }
+            if (t >= 0 && insideFace)
+                minDistance = std::min(minDistance, t);
+        }
+        SimTK_TEST_EQ(distance, minDistance);
+    }
+}
+
 void testBoundingSphere() {
     Random::Uniform random(0, 10);
     for (int i = 0; i < 100; i++) {
@@ -312,9 +407,11 @@ int main() {
         SimTK_SUBTEST(testTriangleMesh);
         SimTK_SUBTEST(testIncorrectMeshes);
         SimTK_SUBTEST(testOBBTree);
+        SimTK_SUBTEST(testSaveOBBTree);
         SimTK_SUBTEST(testRayIntersection);
         SimTK_SUBTEST(testSmoothMesh);
         SimTK_SUBTEST(testFindNearestPoint);
+        SimTK_SUBTEST(testQueriesAgainstBruteForce);
         SimTK_SUBTEST(testBoundingSphere);
     SimTK_END_TEST();
 }
@@ -0,0 +1,85 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Time height and gradient queries for the contact points of a tracked
+// vehicle on a terrain: a few hundred points in clusters, one per track
+// link, each step. Compare querying one point at a time with a shared
+// PatchHint against a single BicubicSurface::calcValues() call.
+
+#include "SimTKmath.h"
+
+#include <cstdio>
+
+using namespace SimTK;
+
+int main() {
+    // 100x100 patches of rolling terrain.
+    const int NGrid = 101;
+    Matrix heights(NGrid, NGrid);
+    for (int i=0; i < NGrid; ++i)
+        for (int j=0; j < NGrid; ++j)
+            heights(i,j) = 0.3*std::sin(0.2*i)*std::cos(0.15*j);
+    const BicubicSurface terrain(Vec2(0), Vec2(1), heights);
+
+    // Two tracks of 80 links with 4 contact points per link.
+    Array_<Vec2> XY;
+    for (int track=0; track < 2; ++track)
+        for (int link=0; link < 80; ++link)
+            for (int p=0; p < 4; ++p)
+                XY.push_back(Vec2(20 + 0.1*link + 0.02*p, 40 + 3*track + 0.1*p));
+
+    const int NSteps = 2000;
+    const Array_<int> dx(1,0), dy(1,1);
+    Array_<Real> f(XY.size());
+    Array_<Vec2> gradf(XY.size());
+
+    BicubicSurface::PatchHint hint;
+    Real sum = 0;
+    double start = realTime();
+    for (int step=0; step < NSteps; ++step) {
+        const Vec2 shift(0.01*step, 0);
+        for (unsigned i=0; i < XY.size(); ++i) {
+            const Vec2 p = XY[i] + shift;
+            f[i] = terrain.calcValue(p, hint);
+            gradf[i] = Vec2(terrain.calcDerivative(dx, p, hint),
+                            terrain.calcDerivative(dy, p, hint));
+        }
+        sum += f[0] + gradf.back()[1];
+    }
+    printf("one point at a time %8.2f ms  sum %.12g\n",
+           1000*(realTime()-start), (double)sum);
+
+    Array_<Vec2> shifted(XY.size());
+    sum = 0;
+    start = realTime();
+    for (int step=0; step < NSteps; ++step) {
+        const Vec2 shift(0.01*step, 0);
+        for (unsigned i=0; i < XY.size(); ++i)
+            shifted[i] = XY[i] + shift;
+        terrain.calcValues(shifted, f, gradf);
+        sum += f[0] + gradf.back()[1];
+    }
+    printf("calcValues()        %8.2f ms  sum %.12g\n",
+           1000*(realTime()-start), (double)sum);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Time a cable-like sequence of geodesic calculations on an ellipsoid, where
+// the end points creep along a little at each step and each step revisits
+// the same points a few times, as a path solver's Newton iterations do.
+// Compare no caching, caching at the default accuracy, and caching at a
+// looser accuracy.
+
+#include "SimTKmath.h"
+
+#include <cstdio>
+
+using namespace SimTK;
+
+static void run(const char* name, int cacheSize, Real accuracy) {
+    ContactGeometry::Ellipsoid ellipsoid(Vec3(1, 1.5, 2));
+    ellipsoid.setGeodesicCacheSize(cacheSize);
+    ellipsoid.setGeodesicAccuracy(accuracy);
+
+    const int NSteps = 200, NRepeats = 3;
+    Geodesic prev, geod;
+    Real totalLength = 0;
+    const double start = realTime();
+    for (int step=0; step < NSteps; ++step) {
+        const Real t = Real(step)/NSteps;
+        const Vec3 P(1, -0.8+0.2*t, 0.1), Q(-0.2+0.3*t, 1.5, 0.5);
+        for (int rep=0; rep < NRepeats; ++rep)
+            ellipsoid.continueGeodesic(P, Q, prev, GeodesicOptions(), geod);
+        totalLength += geod.getLength();
+        prev = geod;
+    }
+    const double elapsed = realTime() - start;
+    printf("%-22s %8.2f ms  hits %4d  warm %4d  misses %4d  sum(len) %.9g\n",
+           name, 1000*elapsed, ellipsoid.getNumGeodesicCacheHits(),
+           ellipsoid.getNumGeodesicCacheWarmStarts(),
+           ellipsoid.getNumGeodesicCacheMisses(), (double)totalLength);
+}
+
+int main() {
+    run("no cache", 0, 1e-6);
+    run("cache", 4, 1e-6);
+    run("cache, accuracy 1e-4", 4, 1e-4);
+    return 0;
+}
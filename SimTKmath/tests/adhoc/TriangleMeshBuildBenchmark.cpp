@@ -0,0 +1,57 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Time the construction of large TriangleMesh contact geometry, which is
+// dominated by building its OBB tree, and compare that with constructing the
+// same mesh from a tree saved with writeOBBTree(). Large subtrees are built
+// in parallel, so the build time depends on the number of processors.
+
+#include "SimTKmath.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace SimTK;
+
+int main() {
+    printf("%d processors\n", ParallelExecutor::getNumProcessors());
+    for (int resolution = 5; resolution <= 7; ++resolution) {
+        const PolygonalMesh sphere = 
+            PolygonalMesh::createSphereMesh(1, resolution);
+
+        double start = realTime();
+        ContactGeometry::TriangleMesh mesh(sphere);
+        const double buildTime = realTime() - start;
+
+        std::stringstream data;
+        mesh.writeOBBTree(data);
+        start = realTime();
+        ContactGeometry::TriangleMesh loaded(sphere, data);
+        const double loadTime = realTime() - start;
+
+        printf("%7d faces  build %8.3f s  load saved tree %8.3f s"
+               "  (%.1f MB)\n", mesh.getNumFaces(), buildTime, loadTime,
+               data.str().size()/1e6);
+    }
+    return 0;
+}
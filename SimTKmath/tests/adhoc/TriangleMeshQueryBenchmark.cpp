@@ -0,0 +1,226 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKmath                               *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Time nearest point and ray queries on large triangle meshes, comparing
+// TriangleMesh's flattened OBB tree traversal against a recursive traversal
+// of the same tree through the public OBBTreeNode interface, which is how
+// the queries used to be done. The two must agree on every query.
+
+#include "SimTKmath.h"
+
+#include <cstdio>
+
+using namespace SimTK;
+
+namespace {
+typedef ContactGeometry::TriangleMesh        Mesh;
+typedef ContactGeometry::TriangleMesh::OBBTreeNode Node;
+
+const int NQueries = 20000;
+
+Vec3 refNearestPoint(const Mesh& mesh, const Node& node, const Vec3& pos,
+                     Real& dist2, int& face) {
+    if (node.isLeafNode()) {
+        dist2 = MostPositiveReal;
+        Vec3 nearest;
+        const Array_<int>& tris = node.getTriangles();
+        for (unsigned i=0; i < tris.size(); ++i) {
+            Vec2 uv;
+            const Vec3 p = mesh.findNearestPointToFace(pos, tris[i], uv);
+            const Real d2 = (p-pos).normSqr();
+            if (d2 < dist2) {nearest = p; dist2 = d2; face = tris[i];}
+        }
+        return nearest;
+    }
+    const Node c[2] = {node.getFirstChildNode(), node.getSecondChildNode()};
+    Real bd2[2];
+    for (int k=0; k < 2; ++k)
+        bd2[k] = (c[k].getBounds().findNearestPoint(pos)-pos).normSqr();
+    const int first = bd2[1] < bd2[0] ? 1 : 0;
+    int f1; Real d1;
+    Vec3 p1 = refNearestPoint(mesh, c[first], pos, d1, f1);
+    if (bd2[1-first] < d1) {
+        int f2; Real d2;
+        Vec3 p2 = refNearestPoint(mesh, c[1-first], pos, d2, f2);
+        if (d2 < d1) {dist2 = d2; face = f2; return p2;}
+    }
+    dist2 = d1; face = f1;
+    return p1;
+}
+
+bool refIntersectsTriangle(const Mesh& mesh, int face, const Vec3& origin,
+                           const UnitVec3& dir, Real& t) {
+    const Vec3 a = mesh.getVertexPosition(mesh.getFaceVertex(face, 0));
+    const Vec3 e1 = mesh.getVertexPosition(mesh.getFaceVertex(face, 1)) - a;
+    const Vec3 e2 = mesh.getVertexPosition(mesh.getFaceVertex(face, 2)) - a;
+    const Vec3 p = dir % e2;
+    const Real det = ~e1*p;
+    if (det == 0) return false;
+    const Vec3 s = origin - a;
+    const Real u = (~s*p)/det;
+    if (u < 0 || u > 1) return false;
+    const Vec3 q = s % e1;
+    const Real v = (~dir*q)/det;
+    if (v < 0 || u+v > 1) return false;
+    t = (~e2*q)/det;
+    return t >= 0;
+}
+
+// The caller has already checked that the ray hits node's box.
+bool refIntersectsRay(const Mesh& mesh, const Node& node, const Vec3& origin,
+                      const UnitVec3& dir, Real& distance) {
+    if (node.isLeafNode()) {
+        bool found = false;
+        const Array_<int>& tris = node.getTriangles();
+        for (unsigned i=0; i < tris.size(); ++i) {
+            Real t;
+            if (refIntersectsTriangle(mesh, tris[i], origin, dir, t)
+                && (!found || t < distance)) {distance = t; found = true;}
+        }
+        return found;
+    }
+    const Node c[2] = {node.getFirstChildNode(), node.getSecondChildNode()};
+    Real d[2];
+    bool hit[2];
+    for (int k=0; k < 2; ++k)
+        hit[k] = c[k].getBounds().intersectsRay(origin, dir, d[k]);
+    const int first = (hit[1] && (!hit[0] || d[1] < d[0])) ? 1 : 0;
+    const int second = 1-first;
+    if (hit[first])
+        hit[first] = refIntersectsRay(mesh, c[first], origin, dir, d[first]);
+    if (hit[second] && (!hit[first] || d[second] < d[first]))
+        hit[second] = refIntersectsRay(mesh, c[second], origin, dir, d[second]);
+    else
+        hit[second] = false;
+    if (!hit[0] && !hit[1]) return false;
+    distance = !hit[1] || (hit[0] && d[0] < d[1]) ? d[0] : d[1];
+    return true;
+}
+
+bool refIntersectsRay(const Mesh& mesh, const Vec3& origin,
+                      const UnitVec3& dir, Real& distance) {
+    const Node root = mesh.getOBBTreeNode();
+    Real boxDist;
+    return root.getBounds().intersectsRay(origin, dir, boxDist)
+        && refIntersectsRay(mesh, root, origin, dir, distance);
+}
+
+void benchmark(const char* name, const Mesh& mesh) {
+    Vec3 center; Real radius;
+    mesh.getBoundingSphere(center, radius);
+    Random::Uniform rand(-1, 1); rand.setSeed(3);
+    Array_<Vec3> points(NQueries), origins(NQueries);
+    Array_<UnitVec3> dirs(NQueries);
+    for (int i=0; i < NQueries; ++i) {
+        points[i] = center + 1.5*radius*Vec3(rand.getValue(), rand.getValue(),
+                                             rand.getValue());
+        origins[i] = center + 2*radius*UnitVec3(rand.getValue(),
+                                    rand.getValue(), rand.getValue());
+        // Aim somewhere near the middle so that most rays hit.
+        dirs[i] = UnitVec3(center + 0.5*radius*Vec3(rand.getValue(),
+                           rand.getValue(), rand.getValue()) - origins[i]);
+    }
+    printf("%s: %d faces\n", name, mesh.getNumFaces());
+
+    int mismatches = 0;
+    double start = realTime();
+    for (int i=0; i < NQueries; ++i) {
+        Real d2; int face;
+        refNearestPoint(mesh, mesh.getOBBTreeNode(), points[i], d2, face);
+    }
+    const double refNearest = realTime() - start;
+    start = realTime();
+    for (int i=0; i < NQueries; ++i) {
+        bool inside; UnitVec3 normal;
+        mesh.findNearestPoint(points[i], inside, normal);
+    }
+    const double flatNearest = realTime() - start;
+    for (int i=0; i < NQueries; ++i) {
+        Real d2; int face; bool inside; UnitVec3 normal;
+        refNearestPoint(mesh, mesh.getOBBTreeNode(), points[i], d2, face);
+        const Vec3 p = mesh.findNearestPoint(points[i], inside, normal);
+        if (std::abs((p-points[i]).normSqr() - d2) > 1e-12*d2)
+            ++mismatches;
+    }
+
+    int hits = 0;
+    start = realTime();
+    for (int i=0; i < NQueries; ++i) {
+        Real t;
+        hits += refIntersectsRay(mesh, origins[i], dirs[i], t);
+    }
+    const double refRay = realTime() - start;
+    start = realTime();
+    for (int i=0; i < NQueries; ++i) {
+        Real t; UnitVec3 normal;
+        mesh.intersectsRay(origins[i], dirs[i], t, normal);
+    }
+    const double flatRay = realTime() - start;
+    for (int i=0; i < NQueries; ++i) {
+        Real t, tRef; UnitVec3 normal;
+        const bool hit = mesh.intersectsRay(origins[i], dirs[i], t, normal);
+        const bool hitRef = refIntersectsRay(mesh, origins[i], dirs[i],
+                                             tRef);
+        if (hit != hitRef || (hit && std::abs(t-tRef) > 1e-9*radius))
+            ++mismatches;
+    }
+
+    printf("  nearest point   recursive %7.3f us  flat %7.3f us  "
+           "speedup %.2fx\n",
+           1e6*refNearest/NQueries, 1e6*flatNearest/NQueries,
+           refNearest/flatNearest);
+    printf("  ray (%3d%% hit)  recursive %7.3f us  flat %7.3f us  "
+           "speedup %.2fx\n",
+           (100*hits)/NQueries, 1e6*refRay/NQueries, 1e6*flatRay/NQueries,
+           refRay/flatRay);
+    printf("  %d mismatched queries\n", mismatches);
+}
+}
+
+int main() {
+#if defined(SimTK_SMALLMATRIX_USE_SSE2)
+    printf("OBB tree box tests: SSE2\n");
+#else
+    printf("OBB tree box tests: scalar\n");
+#endif
+    benchmark("sphere", Mesh(PolygonalMesh::createSphereMesh(1, 6)));
+
+    // A cloud of small randomly placed spheres has many overlapping boxes.
+    PolygonalMesh cloud;
+    Random::Uniform rand(-5, 5); rand.setSeed(11);
+    const PolygonalMesh ball = PolygonalMesh::createSphereMesh(0.5, 2);
+    for (int k=0; k < 200; ++k) {
+        const Vec3 offset(rand.getValue(), rand.getValue(), rand.getValue());
+        const int base = cloud.getNumVertices();
+        for (int v=0; v < ball.getNumVertices(); ++v)
+            cloud.addVertex(ball.getVertexPosition(v) + offset);
+        for (int f=0; f < ball.getNumFaces(); ++f) {
+            Array_<int> verts(3);
+            for (int j=0; j < 3; ++j)
+                verts[j] = base + ball.getFaceVertex(f, j);
+            cloud.addFace(verts);
+        }
+    }
+    benchmark("sphere cloud", Mesh(cloud));
+    return 0;
+}
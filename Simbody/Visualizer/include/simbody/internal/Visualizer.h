@@ -467,6 +467,25 @@ Real getActualBufferLengthInSec() const;
 /** Get the actual length of the real time frame buffer in number of frames. **/
 int getActualBufferLengthInFrames() const;
 
+/** Send scenes to the visualizer GUI through a buffer in shared memory rather
+than through the pipe used for everything else. The pipe holds only a small 
+amount of data, so with large scenes or high frame rates the simulation can
+spend a lot of time waiting for the GUI to empty it. With the shared memory 
+transport the simulation never waits: if the GUI falls so far behind that a
+scene doesn't fit in the buffer, that scene is dropped, and the GUI always
+displays the newest complete scene it has received. A single scene that is
+larger than the whole buffer (16MB) is still sent through the pipe. This is
+off by default, and is available only on systems that support POSIX shared 
+memory; elsewhere, or if the shared memory can't be created, this has no
+effect and getUseSharedMemoryTransport() will return false.
+@param[in]      useSharedMemory
+    Whether to send scenes through shared memory.
+@return A reference to this Visualizer so that you can chain "set" calls. **/
+Visualizer& setUseSharedMemoryTransport(bool useSharedMemory);
+/** Return true if scenes are being sent to the GUI through shared memory.
+@see setUseSharedMemoryTransport() **/
+bool getUseSharedMemoryTransport() const;
+
 /** Add a new input listener to this Visualizer, methods of which will be
 called when the GUI detects user-driven events like key presses, menu picks, 
 and slider or mouse moves. See Visualizer::InputListener for more 
@@ -104,6 +104,8 @@ static void shutdown();
     #define CLOSE _close
 #else
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
     #define READ read
     #define WRITEFUNC write
     #define CLOSE close
@@ -2041,25 +2043,177 @@ static void readData(unsigned char* buffer, int bytes) {
     readDataFromPipe(inPipe, buffer, bytes);
 }
 
-// We have just processed a StartOfScene command. Read in all the scene
-// elements until we see an EndOfScene command. We allocate a new Scene
-// object to hold the scene and return a pointer to it. Don't forget to
-// delete that object when you are done with it.
-static Scene* readNewScene() {
+// Add a mesh to a scene given its record as sent by the simulator (see
+// MeshRecordBytes in VisualizerProtocol.h).
+static void addMeshToScene(Scene* newScene, const unsigned char* record) {
+    const char command = record[0];
+    float floatBuffer[13];
+    unsigned short shortBuffer[2];
+    memcpy(floatBuffer, record+1, 13*sizeof(float));
+    memcpy(shortBuffer, record+1+13*sizeof(float), 2*sizeof(short));
+
+    fTransform position;
+    position.updR().setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]));
+    position.updP() = fVec3(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
+    fVec3 scale = fVec3(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
+    fVec4 color = fVec4(floatBuffer[9], floatBuffer[10], floatBuffer[11], floatBuffer[12]);
+    short representation = (command == AddPointMesh ? DecorativeGeometry::DrawPoints : (command == AddWireframeMesh ? DecorativeGeometry::DrawWireframe : DecorativeGeometry::DrawSurface));
+    unsigned short meshIndex = shortBuffer[0];
+    unsigned short resolution = shortBuffer[1];
+    RenderedMesh mesh(position, scale, color, representation, meshIndex, resolution);
+    if (command != AddSolidMesh)
+        newScene->drawnMeshes.push_back(mesh);
+    else if (color[3] == 1)
+        newScene->solidMeshes.push_back(mesh);
+    else
+        newScene->transparentMeshes.push_back(mesh);
+    if (meshIndex < NumPredefinedMeshes && (meshes[meshIndex].size() <= resolution || meshes[meshIndex][resolution] == NULL)) {
+        // A real mesh will be generated from this the next
+        // time the scene is redrawn.
+        std::lock_guard<std::mutex> lock(sceneMutex); //-- LOCK SCENE --
+        pendingCommands.insert(pendingCommands.begin(), new PendingStandardMesh(meshIndex, resolution));
+                                                      //- UNLOCK SCENE -
+    }
+}
+
+static void addLineToScene(Scene* newScene, const unsigned char* record) {
+    float floatBuffer[10];
+    memcpy(floatBuffer, record+1, 10*sizeof(float));
+    fVec3 color = fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]);
+    float thickness = floatBuffer[3];
+    int index;
+    int numLines = (int)newScene->lines.size();
+    for (index = 0; index < numLines && (color != newScene->lines[index].getColor() || thickness != newScene->lines[index].getThickness()); index++)
+        ;
+    if (index == numLines)
+        newScene->lines.push_back(RenderedLine(color, thickness));
+    vector<GLfloat>& line = newScene->lines[index].getLines();
+    line.push_back(floatBuffer[4]);
+    line.push_back(floatBuffer[5]);
+    line.push_back(floatBuffer[6]);
+    line.push_back(floatBuffer[7]);
+    line.push_back(floatBuffer[8]);
+    line.push_back(floatBuffer[9]);
+}
+
+static void addTextToScene(Scene* newScene, const unsigned char* record) {
+    float floatBuffer[12];
+    short shortBuffer[3];
+    memcpy(floatBuffer, record+1, 12*sizeof(float));
+    memcpy(shortBuffer, record+1+12*sizeof(float), 3*sizeof(short));
+    fTransform X_GT;
+    X_GT.updR().setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]));
+    X_GT.updP() = fVec3(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
+    fVec3 scale = fVec3(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
+    fVec3 color = fVec3(floatBuffer[9], floatBuffer[10], floatBuffer[11]);
+    bool faceCamera = (shortBuffer[0] != 0);
+    bool isScreenText = (shortBuffer[1] != 0);
+    short length = shortBuffer[2];
+    const string text((const char*)record + TextRecordHeaderBytes, length);
+
+    if (isScreenText)
+        newScene->screenText.push_back(ScreenText(text));
+    else
+        newScene->sceneText.push_back(
+            RenderedText(X_GT, scale, color, text, faceCamera));
+}
+
+static void addCoordsToScene(Scene* newScene, const unsigned char* record) {
+    float floatBuffer[12];
+    memcpy(floatBuffer, record+1, 12*sizeof(float));
+    fRotation rotation;
+    rotation.setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], 
+                                             floatBuffer[1], 
+                                             floatBuffer[2]));
+    fVec3 position(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
+    fVec3 axisLengths(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
+    fVec3 textScale = fVec3(0.2f*min(axisLengths));
+    float lineThickness = 1;
+    fVec3 color = fVec3(floatBuffer[9], floatBuffer[10], floatBuffer[11]);
+    int index;
+    int numLines = (int)newScene->lines.size();
+    for (index = 0; 
+         index < numLines && (color != newScene->lines[index].getColor() 
+                              || newScene->lines[index].getThickness() 
+                                                      != lineThickness); 
+         index++)
+        ;
+    if (index == numLines)
+        newScene->lines.push_back(RenderedLine(color, lineThickness));
+    vector<GLfloat>& line = newScene->lines[index].getLines();
+    fVec3 end = position+rotation*fVec3(axisLengths[0], 0, 0);
+    line.push_back(position[0]);
+    line.push_back(position[1]);
+    line.push_back(position[2]);
+    line.push_back(end[0]);
+    line.push_back(end[1]);
+    line.push_back(end[2]);
+    newScene->sceneText.push_back(RenderedText(end, textScale, color, "X"));
+    end = position+rotation*fVec3(0, axisLengths[1], 0);
+    line.push_back(position[0]);
+    line.push_back(position[1]);
+    line.push_back(position[2]);
+    line.push_back(end[0]);
+    line.push_back(end[1]);
+    line.push_back(end[2]);
+    newScene->sceneText.push_back(RenderedText(end, textScale, color, "Y"));
+    end = position+rotation*fVec3(0, 0, axisLengths[2]);
+    line.push_back(position[0]);
+    line.push_back(position[1]);
+    line.push_back(position[2]);
+    line.push_back(end[0]);
+    line.push_back(end[1]);
+    line.push_back(end[2]);
+    newScene->sceneText.push_back(RenderedText(end, textScale, color, "Z"));
+}
+
+// Add an element to a scene given its record as sent by the simulator (see
+// MeshRecordBytes in VisualizerProtocol.h).
+static void addRecordToScene(Scene* newScene, const unsigned char* record) {
+    switch (record[0]) {
+    case AddLine:   addLineToScene(newScene, record); break;
+    case AddText:   addTextToScene(newScene, record); break;
+    case AddCoords: addCoordsToScene(newScene, record); break;
+    default:        addMeshToScene(newScene, record);
+    }
+}
+
+// The scene data received from the simulator, and the element records of the
+// current and previous scenes, which are needed to expand RepeatRecords.
+// These are used only by the listener thread.
+static vector<unsigned char> sceneData;
+static SceneRecords sceneRecords;
+
+// The shared memory scene buffer, if the simulator asked us to use one.
+static SharedSceneBuffer* sharedScenes = 0;
+
+// Process the scene elements in sceneData until we see an EndOfScene
+// command. We allocate a new Scene object to hold the scene and return a
+// pointer to it. Don't forget to delete that object when you are done with
+// it.
+static Scene* parseSceneData() {
     unsigned char buffer[256];
     float*          floatBuffer = (float*)          buffer;
-    int*            intBuffer   = (int*)            buffer;
     unsigned short* shortBuffer = (unsigned short*) buffer;
 
+    std::size_t pos = 0;
+    auto takeData = [&](unsigned char* dest, int bytes) {
+        SimTK_ASSERT_ALWAYS(pos + bytes <= sceneData.size(),
+            "Incomplete scene data sent to visualizer");
+        memcpy(dest, &sceneData[pos], bytes);
+        pos += bytes;
+    };
+
     Scene* newScene = new Scene;
+    sceneRecords.beginScene();
 
     // Simulated time for this frame comes first.
-    readData(buffer, sizeof(float));
+    takeData(buffer, sizeof(float));
     newScene->simTime = floatBuffer[0];
 
     bool finished = false;
     while (!finished) {
-        readData(buffer, 1);
+        takeData(buffer, 1);
         char command = buffer[0];
 
         switch (command) {
@@ -2072,124 +2226,34 @@ static Scene* readNewScene() {
             finished = true;
             break;
 
-        // Add a scene element that uses an already-cached mesh.
+        // Add a scene element.
         case AddPointMesh:
         case AddWireframeMesh:
-        case AddSolidMesh: {
-            readData(buffer, 13*sizeof(float)+2*sizeof(short));
-            fTransform position;
-            position.updR().setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]));
-            position.updP() = fVec3(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
-            fVec3 scale = fVec3(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
-            fVec4 color = fVec4(floatBuffer[9], floatBuffer[10], floatBuffer[11], floatBuffer[12]);
-            short representation = (command == AddPointMesh ? DecorativeGeometry::DrawPoints : (command == AddWireframeMesh ? DecorativeGeometry::DrawWireframe : DecorativeGeometry::DrawSurface));
-            unsigned short meshIndex = shortBuffer[13*sizeof(float)/sizeof(short)];
-            unsigned short resolution = shortBuffer[13*sizeof(float)/sizeof(short)+1];
-            RenderedMesh mesh(position, scale, color, representation, meshIndex, resolution);
-            if (command != AddSolidMesh)
-                newScene->drawnMeshes.push_back(mesh);
-            else if (color[3] == 1)
-                newScene->solidMeshes.push_back(mesh);
-            else
-                newScene->transparentMeshes.push_back(mesh);
-            if (meshIndex < NumPredefinedMeshes && (meshes[meshIndex].size() <= resolution || meshes[meshIndex][resolution] == NULL)) {
-                // A real mesh will be generated from this the next
-                // time the scene is redrawn.
-                std::lock_guard<std::mutex> lock(sceneMutex); //-- LOCK SCENE --
-                pendingCommands.insert(pendingCommands.begin(), new PendingStandardMesh(meshIndex, resolution));
-                                                              //- UNLOCK SCENE -
-            }
-            break;
-        }
-
-        case AddLine: {
-            readData(buffer, 10*sizeof(float));
-            fVec3 color = fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]);
-            float thickness = floatBuffer[3];
-            int index;
-            int numLines = (int)newScene->lines.size();
-            for (index = 0; index < numLines && (color != newScene->lines[index].getColor() || thickness != newScene->lines[index].getThickness()); index++)
-                ;
-            if (index == numLines)
-                newScene->lines.push_back(RenderedLine(color, thickness));
-            vector<GLfloat>& line = newScene->lines[index].getLines();
-            line.push_back(floatBuffer[4]);
-            line.push_back(floatBuffer[5]);
-            line.push_back(floatBuffer[6]);
-            line.push_back(floatBuffer[7]);
-            line.push_back(floatBuffer[8]);
-            line.push_back(floatBuffer[9]);
-            break;
-        }
-
-        case AddText: {
-            readData(buffer, 12*sizeof(float)+3*sizeof(short));
-            fTransform X_GT;
-            X_GT.updR().setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], floatBuffer[1], floatBuffer[2]));
-            X_GT.updP() = fVec3(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
-            fVec3 scale = fVec3(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
-            fVec3 color = fVec3(floatBuffer[9], floatBuffer[10], floatBuffer[11]);
-            unsigned short* shortp = &shortBuffer[12*sizeof(float)/sizeof(short)];
-            bool faceCamera = (shortp[0] != 0);
-            bool isScreenText = (shortp[1] != 0);
-            short length = shortp[2];
-            readData(buffer, length);
-
-            if (isScreenText)
-                newScene->screenText.push_back(
-                    ScreenText(string((char*)buffer, length)));
-            else
-                newScene->sceneText.push_back(
-                    RenderedText(X_GT, scale, color, string((char*)buffer, length), faceCamera));
+        case AddSolidMesh:
+        case AddLine:
+        case AddText:
+        case AddCoords: {
+            const unsigned char* record = &sceneData[pos-1];
+            const std::size_t nBytes = 
+                getSceneRecordBytes(record, sceneData.size() - (pos-1));
+            SimTK_ASSERT_ALWAYS(nBytes > 0, 
+                "Incomplete scene data sent to visualizer");
+            pos += nBytes - 1;
+            sceneRecords.add(record, nBytes);
+            addRecordToScene(newScene, record);
             break;
         }
 
-        case AddCoords: {
-            readData(buffer, 12*sizeof(float));
-            fRotation rotation;
-            rotation.setRotationToBodyFixedXYZ(fVec3(floatBuffer[0], 
-                                                     floatBuffer[1], 
-                                                     floatBuffer[2]));
-            fVec3 position(floatBuffer[3], floatBuffer[4], floatBuffer[5]);
-            fVec3 axisLengths(floatBuffer[6], floatBuffer[7], floatBuffer[8]);
-            fVec3 textScale = fVec3(0.2f*min(axisLengths));
-            float lineThickness = 1;
-            fVec3 color = fVec3(floatBuffer[9], floatBuffer[10], floatBuffer[11]);
-            int index;
-            int numLines = (int)newScene->lines.size();
-            for (index = 0; 
-                 index < numLines && (color != newScene->lines[index].getColor() 
-                                      || newScene->lines[index].getThickness() 
-                                                              != lineThickness); 
-                 index++)
-                ;
-            if (index == numLines)
-                newScene->lines.push_back(RenderedLine(color, lineThickness));
-            vector<GLfloat>& line = newScene->lines[index].getLines();
-            fVec3 end = position+rotation*fVec3(axisLengths[0], 0, 0);
-            line.push_back(position[0]);
-            line.push_back(position[1]);
-            line.push_back(position[2]);
-            line.push_back(end[0]);
-            line.push_back(end[1]);
-            line.push_back(end[2]);
-            newScene->sceneText.push_back(RenderedText(end, textScale, color, "X"));
-            end = position+rotation*fVec3(0, axisLengths[1], 0);
-            line.push_back(position[0]);
-            line.push_back(position[1]);
-            line.push_back(position[2]);
-            line.push_back(end[0]);
-            line.push_back(end[1]);
-            line.push_back(end[2]);
-            newScene->sceneText.push_back(RenderedText(end, textScale, color, "Y"));
-            end = position+rotation*fVec3(0, 0, axisLengths[2]);
-            line.push_back(position[0]);
-            line.push_back(position[1]);
-            line.push_back(position[2]);
-            line.push_back(end[0]);
-            line.push_back(end[1]);
-            line.push_back(end[2]);
-            newScene->sceneText.push_back(RenderedText(end, textScale, color, "Z"));
+        // These elements are unchanged from the same position in the
+        // previous scene.
+        case RepeatRecords: {
+            takeData(buffer, sizeof(short));
+            const int first = sceneRecords.getNumRecords();
+            SimTK_ASSERT_ALWAYS(sceneRecords.repeat(shortBuffer[0]),
+                "Visualizer was asked to repeat a scene element it never "
+                "received");
+            for (int i=first; i < sceneRecords.getNumRecords(); ++i)
+                addRecordToScene(newScene, sceneRecords.getRecord(i));
             break;
         }
 
@@ -2197,15 +2261,15 @@ static Scene* readNewScene() {
         // index. It will be cached here and then can be referenced in this
         // scene and others by using it mesh index.
         case DefineMesh: {
-            readData(buffer, 2*sizeof(short));
+            takeData(buffer, 2*sizeof(short));
             PendingMesh* mesh = new PendingMesh(); // assigns next mesh index
             int numVertices = shortBuffer[0];
             int numFaces = shortBuffer[1];
             mesh->vertices.resize(3*numVertices, 0);
             mesh->normals.resize(3*numVertices);
             mesh->faces.resize(3*numFaces);
-            readData((unsigned char*)&mesh->vertices[0], (int)(mesh->vertices.size()*sizeof(float)));
-            readData((unsigned char*)&mesh->faces[0], (int)(mesh->faces.size()*sizeof(short)));
+            takeData((unsigned char*)&mesh->vertices[0], (int)(mesh->vertices.size()*sizeof(float)));
+            takeData((unsigned char*)&mesh->faces[0], (int)(mesh->faces.size()*sizeof(short)));
 
             // Compute normal vectors for the mesh.
 
@@ -2245,9 +2309,61 @@ static Scene* readNewScene() {
         }
     }
 
+    sceneRecords.endScene();
+    return newScene;
+}
+
+// We have just processed a StartOfScene command. The simulator sends the
+// whole scene as one block, preceded by its size, so we read it all at once
+// and then parse it from memory.
+static Scene* readNewScene() {
+    unsigned sceneBytes;
+    readData((unsigned char*)&sceneBytes, sizeof(unsigned));
+    sceneData.resize(sceneBytes);
+    readData(sceneData.data(), (int)sceneBytes);
+    return parseSceneData();
+}
+
+// We have received a SceneAvailable command. Read every scene waiting in the
+// shared memory buffer, giving the space back to the simulator as we go. All
+// of them have to be parsed since they may define meshes or be the basis for
+// repeated meshes in later scenes, but only the newest one is returned; the
+// others are discarded without being drawn. Returns null if there were no
+// scenes, which happens if we already read them after an earlier 
+// notification.
+static Scene* readNewestSharedScene() {
+    sharedScenes->notifyPending = 0;
+    Scene* newScene = 0;
+    const unsigned writePos = sharedScenes->writePos.load();
+    while (sharedScenes->readPos.load(std::memory_order_relaxed) != writePos) {
+        sharedScenes->readScene(sceneData);
+        delete newScene;
+        newScene = parseSceneData();
+    }
     return newScene;
 }
 
+// Replace the front scene with a new one once the front scene has been drawn,
+// and ask for it to be displayed.
+static void showNewScene(Scene* newScene) {
+    std::unique_lock<std::mutex> lock(sceneMutex); //--- LOCK SCENE ----
+    if (scene != NULL) {
+        // -------- WAIT FOR CONDITION --------
+        // Give up the lock and wait for notice.
+        // Pass a predicate function so that we continue waiting if we
+        // caught a spurious wakeup.
+        sceneHasBeenDrawn.wait(lock,
+                [&] { return scene->sceneHasBeenDrawn; });
+        // Previous scene has been drawn.
+        delete scene; scene = 0;
+    }
+    // Swap in the new scene.
+    scene = newScene;
+    saveNextFrameToMovie = savingMovie;
+    lock.unlock();                                 //-- UNLOCK SCENE ---
+    forceActiveRedisplay();               //------- ACTIVE REDISPLAY ---
+}
+
 // This is the main program for the listener thread. It reads continuously
 // from the input pipe, which contains data from the simulator's calls
 // to a Visualizer object. Any changes to the scene must wait until the
@@ -2433,27 +2549,50 @@ void listenForInput() {
             break;                                        //--- UNLOCK SCENE ---
         }
         case StartOfScene: {
-            Scene* newScene = readNewScene();
-            std::unique_lock<std::mutex> lock(sceneMutex); //--- LOCK SCENE ----
-            if (scene != NULL) {
-                // -------- WAIT FOR CONDITION --------
-                // Give up the lock and wait for notice.
-                // Pass a predicate function so that we continue waiting if we
-                // caught a spurious wakeup.
-                sceneHasBeenDrawn.wait(lock,
-                        [&] { return scene->sceneHasBeenDrawn; });
-                // Previous scene has been drawn.
-                delete scene; scene = 0;
-            }
-            // Swap in the new scene.
-            scene = newScene;
-            saveNextFrameToMovie = savingMovie;
-            lock.unlock();                                 //-- UNLOCK SCENE ---
-            forceActiveRedisplay();               //------- ACTIVE REDISPLAY ---
+            showNewScene(readNewScene());
             issuedActiveRedisplay = true;
             break;
         }
 
+        case SceneAvailable: {
+            SimTK_ERRCHK_ALWAYS(sharedScenes != 0, "listenForInput()",
+                "Received a scene notification before any shared memory.");
+            Scene* newScene = readNewestSharedScene();
+            if (newScene) {
+                showNewScene(newScene);
+                issuedActiveRedisplay = true;
+            }
+            break;
+        }
+
+        case OpenSharedMemory: {
+            readData(buffer, sizeof(short));
+            const unsigned short nameLength = shortBuffer[0];
+            string name(nameLength, ' ');
+            readData((unsigned char*)&name[0], nameLength);
+        #ifdef _WIN32
+            SimTK_ERRCHK_ALWAYS(false, "listenForInput()",
+                "Shared memory scene transport is not supported on Windows.");
+        #else
+            const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+            SimTK_ERRCHK3_ALWAYS(fd != -1, "listenForInput()",
+                "Unable to open shared memory '%s'; errno=%d (%s).",
+                name.c_str(), errno, strerror(errno));
+            struct stat info;
+            fstat(fd, &info);
+            void* mem = mmap(0, (size_t)info.st_size, PROT_READ|PROT_WRITE,
+                             MAP_SHARED, fd, 0);
+            CLOSE(fd);
+            // Nobody else needs to find it by name now.
+            shm_unlink(name.c_str());
+            SimTK_ERRCHK3_ALWAYS(mem != MAP_FAILED, "listenForInput()",
+                "Unable to map shared memory '%s'; errno=%d (%s).",
+                name.c_str(), errno, strerror(errno));
+            sharedScenes = (SharedSceneBuffer*)mem;
+        #endif
+            break;
+        }
+
         case Shutdown:
             shutdown(); // doesn't return
             break;
@@ -939,6 +939,12 @@ int Visualizer::getActualBufferLengthInFrames() const
 Real Visualizer::getActualBufferLengthInSec() const 
 {   return getImpl().getActualBufferLengthInSec(); }
 
+Visualizer& Visualizer::setUseSharedMemoryTransport(bool useSharedMemory)
+{   updImpl().m_protocol.setUseSharedMemoryTransport(useSharedMemory); 
+    return *this; }
+bool Visualizer::getUseSharedMemoryTransport() const
+{   return getImpl().m_protocol.getUseSharedMemoryTransport(); }
+
 
 int Visualizer::addInputListener(Visualizer::InputListener* listener) {
     Impl& impl = updImpl();
@@ -31,6 +31,8 @@
 #include <cctype>
 #include <cerrno>
 #include <cstring>
+#include <algorithm>
+#include <new>
 #include <string>
 
 using namespace SimTK;
@@ -45,6 +47,9 @@ using namespace std;
     #define CLOSE _close
 #else
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
     #define READ read
     #define WRITEFUNC write
     #define CLOSE close
@@ -65,6 +70,18 @@ using namespace std;
 
 static int inPipe;
 
+// Write a block of data to a pipe, continuing after partial writes.
+static void writeAll(int pipeno, const unsigned char* data, std::size_t len) {
+    while (len > 0) {
+        const unsigned chunk = (unsigned)std::min(len, (std::size_t)1<<30);
+        const int status = (int)WRITEFUNC(pipeno, data, chunk);
+        SimTK_ERRCHK4_ALWAYS(status!=-1, "VisualizerProtocol",
+            "An attempt to write() %u bytes to pipe %d failed with errno=%d (%s).",
+            chunk, pipeno, errno, strerror(errno));
+        data += status; len -= status;
+    }
+}
+
 // Create the pipe going *from* simulator *to* visualizer, so only the
 // read end should be inherited by the visualizer.
 static int createPipeSim2Viz(int sim2viz[2]) {
@@ -193,7 +210,8 @@ static void readData(unsigned char* buffer, int bytes)
     readDataFromPipe(inPipe, buffer, bytes);
 }
 
-static void listenForVisualizerEvents(Visualizer& visualizer) {
+static void listenForVisualizerEvents(Visualizer& visualizer,
+                                      std::atomic<bool>& guiHasDisconnected) {
     unsigned char buffer[256];
 
     try
@@ -246,6 +264,7 @@ static void listenForVisualizerEvents(Visualizer& visualizer) {
         std::cout << "Visualizer listenerThread: unrecoverable error:\n";
         std::cout << e.what() << std::endl;
     }
+    guiHasDisconnected = true;
 }
 
 VisualizerProtocol::VisualizerProtocol
@@ -344,7 +363,7 @@ VisualizerProtocol::VisualizerProtocol
 
     // Spawn the thread to listen for events.
     eventListenerThread = std::thread(listenForVisualizerEvents,
-            std::ref(visualizer));
+            std::ref(visualizer), std::ref(guiHasDisconnected));
 }
 
 // This is executed on the main thread at GUI startup and thus does not
@@ -416,6 +435,14 @@ VisualizerProtocol::~VisualizerProtocol() {
     // If shutdownGUI() was not called, then the listener thread is still
     // running and we should kill it.
     stopListeningIfNecessary();
+#ifndef _WIN32
+    if (sharedScenes) {
+        munmap(sharedScenes, sharedMemoryBytes);
+        // The GUI normally removes the name as soon as it has mapped the
+        // buffer, so this is just cleanup in case it never did.
+        shm_unlink(sharedMemoryName.c_str());
+    }
+#endif
     int retval = CLOSE(outPipe); // TODO(chrisdembia) is this necessary?
     if (retval == -1) {
         std::cout << "Warning in Simbody VisualizerProtocol: "
@@ -435,22 +462,66 @@ void VisualizerProtocol::stopListeningIfNecessary() {
     }
 }
 
+// The scene is accumulated in the SceneEncoder and nothing is written to the
+// pipe until finishScene(), which sends the whole scene with one write.
 void VisualizerProtocol::beginScene(Real time) {
     sceneLockBeginFinishScene.lock();
-    char command = StartOfScene;
-    WRITE(outPipe, &command, 1);
-    float fTime = (float)time;
-    WRITE(outPipe, &fTime, sizeof(float));
+    scene.beginScene((float)time);
     // The sceneMutex is NOT unlocked at the end of this scope
     // (sceneLockBeginFinishScene is a member variable); see finishScene().
 }
 
 void VisualizerProtocol::finishScene() {
-    char command = EndOfScene;
-    WRITE(outPipe, &command, 1);
+    const std::vector<unsigned char>& sceneData = scene.finishScene();
+    const unsigned sceneBytes = 
+        (unsigned)(sceneData.size() - (1 + sizeof(unsigned)));
+
+    bool sent = true;
+    if (useSharedMemory 
+        && sizeof(unsigned) + sceneBytes <= sharedScenes->capacity)
+        sent = writeSceneToSharedMemory(sceneData);
+    else if (useSharedMemory && !waitForSharedScenesToBeRead()) {
+        // Scenes must reach the GUI in order, so a scene too big for the
+        // shared buffer has to wait until the GUI has read the ones already
+        // there. If the GUI isn't reading them, drop this scene rather than
+        // waiting forever; the simulation never waits on shared memory.
+        sent = false;
+    } else
+        writeAll(outPipe, sceneData.data(), sceneData.size());
+
+    if (sent)
+        scene.sceneWasSent();
+    else {
+        // The GUI never sees this scene, so the next one must be encoded
+        // relative to the previous one and define these meshes again.
+        for (const void* impl : meshesDefinedInScene)
+            meshes.erase(impl);
+    }
+    meshesDefinedInScene.clear();
     sceneLockBeginFinishScene.unlock();
 }
 
+// Copy the scene into the shared memory ring buffer and let the GUI know it
+// is there. If the GUI has fallen so far behind that there isn't room, the
+// scene is dropped and we return false; the simulation never waits here.
+bool VisualizerProtocol::
+writeSceneToSharedMemory(const std::vector<unsigned char>& sceneData) {
+    SharedSceneBuffer& ring = *sharedScenes;
+    // Send the size, then the scene data.
+    if (!ring.write(&sceneData[1], (unsigned)(sceneData.size() - 1)))
+        return false;
+    if (ring.notifyPending.exchange(1) == 0)
+        WRITE(outPipe, &SceneAvailable, 1);
+    return true;
+}
+
+// Give the GUI a limited time to catch up; see 
+// SharedSceneBuffer::waitUntilRead(). Returns false if it didn't.
+bool VisualizerProtocol::waitForSharedScenesToBeRead() const {
+    const double MaxStallInSec = 1;
+    return sharedScenes->waitUntilRead(guiHasDisconnected, MaxStallInSec);
+}
+
 void VisualizerProtocol::drawBox(const Transform& X_GB, const Vec3& scale, const Vec4& color, int representation) {
     drawMesh(X_GB, scale, color, (short) representation, MeshBox, 0);
 }
@@ -546,13 +617,14 @@ void VisualizerProtocol::drawPolygonalMesh(const PolygonalMesh& mesh, const Tran
         "Too many unique DecorativeMesh objects; max is 65535.");
     
     meshes[impl] = (unsigned short)index;    // insert new mesh
-    WRITE(outPipe, &DefineMesh, 1);
+    meshesDefinedInScene.push_back(impl);
+    scene.append(&DefineMesh, 1);
     unsigned short numVertices = (unsigned short)(vertices.size()/3);
     unsigned short numFaces = (unsigned short)(faces.size()/3);
-    WRITE(outPipe, &numVertices, sizeof(short));
-    WRITE(outPipe, &numFaces, sizeof(short));
-    WRITE(outPipe, &vertices[0], (unsigned)(vertices.size()*sizeof(float)));
-    WRITE(outPipe, &faces[0], (unsigned)(faces.size()*sizeof(short)));
+    scene.append(&numVertices, sizeof(short));
+    scene.append(&numFaces, sizeof(short));
+    scene.append(vertices.data(), (unsigned)(vertices.size()*sizeof(float)));
+    scene.append(faces.data(), (unsigned)(faces.size()*sizeof(short)));
 
     drawMesh(X_GM, scale, color, (short) representation, (unsigned short)index, 0);
 }
@@ -565,7 +637,6 @@ drawMesh(const Transform& X_GM, const Vec3& scale, const Vec4& color,
                     ? AddPointMesh 
                     : (representation == DecorativeGeometry::DrawWireframe 
                         ? AddWireframeMesh : AddSolidMesh));
-    WRITE(outPipe, &command, 1);
     float buffer[13];
     Vec3 rot = X_GM.R().convertRotationToBodyFixedXYZ();
     buffer[0] = (float) rot[0];
@@ -581,17 +652,20 @@ drawMesh(const Transform& X_GM, const Vec3& scale, const Vec4& color,
     buffer[10] = (float) color[1];
     buffer[11] = (float) color[2];
     buffer[12] = (float) color[3];
-    WRITE(outPipe, buffer, 13*sizeof(float));
     unsigned short buffer2[2];
     buffer2[0] = meshIndex;
     buffer2[1] = resolution;
-    WRITE(outPipe, buffer2, 2*sizeof(unsigned short));
+
+    unsigned char record[MeshRecordBytes];
+    record[0] = command;
+    memcpy(record+1, buffer, 13*sizeof(float));
+    memcpy(record+1+13*sizeof(float), buffer2, 2*sizeof(unsigned short));
+    scene.appendRecord(record, MeshRecordBytes);
 }
 
 void VisualizerProtocol::
 drawLine(const Vec3& end1, const Vec3& end2, const Vec4& color, Real thickness)
 {
-    WRITE(outPipe, &AddLine, 1);
     float buffer[10];
     buffer[0] = (float) color[0];
     buffer[1] = (float) color[1];
@@ -603,7 +677,11 @@ drawLine(const Vec3& end1, const Vec3& end2, const Vec4& color, Real thickness)
     buffer[7] = (float) end2[0];
     buffer[8] = (float) end2[1];
     buffer[9] = (float) end2[2];
-    WRITE(outPipe, buffer, 10*sizeof(float));
+
+    unsigned char record[LineRecordBytes];
+    record[0] = AddLine;
+    memcpy(record+1, buffer, 10*sizeof(float));
+    scene.appendRecord(record, LineRecordBytes);
 }
 
 void VisualizerProtocol::
@@ -613,7 +691,6 @@ drawText(const Transform& X_GT, const Vec3& scale, const Vec4& color,
         "VisualizerProtocol::drawText()",
         "Can't display DecorativeText longer than 256 characters;"
         " received text of length %u.", (unsigned)string.size());
-    WRITE(outPipe, &AddText, 1);
     float buffer[12];
     const Vec3 rot = X_GT.R().convertRotationToBodyFixedXYZ();
     buffer[0] = (float) rot[0];
@@ -628,19 +705,22 @@ drawText(const Transform& X_GT, const Vec3& scale, const Vec4& color,
     buffer[9] = (float) color[0];
     buffer[10]= (float) color[1];
     buffer[11]= (float) color[2];
-    WRITE(outPipe, buffer, 12*sizeof(float));
-    short face = (short)faceCamera;
-    WRITE(outPipe, &face, sizeof(short));
-    short screen = (short)isScreenText;
-    WRITE(outPipe, &screen, sizeof(short));
-    short length = (short)string.size();
-    WRITE(outPipe, &length, sizeof(short));
-    WRITE(outPipe, &string[0], length);
+    short buffer2[3];
+    buffer2[0] = (short)faceCamera;
+    buffer2[1] = (short)isScreenText;
+    buffer2[2] = (short)string.size();
+
+    unsigned char record[TextRecordHeaderBytes + 256];
+    record[0] = AddText;
+    memcpy(record+1, buffer, 12*sizeof(float));
+    memcpy(record+1+12*sizeof(float), buffer2, 3*sizeof(short));
+    memcpy(record+TextRecordHeaderBytes, string.data(), string.size());
+    scene.appendRecord(record, 
+                       TextRecordHeaderBytes + (unsigned)string.size());
 }
 
 void VisualizerProtocol::
 drawCoords(const Transform& X_GF, const Vec3& axisLengths, const Vec4& color) {
-    WRITE(outPipe, &AddCoords, 1);
     float buffer[12];
     const Vec3 rot = X_GF.R().convertRotationToBodyFixedXYZ();
     buffer[0] = (float) rot[0];
@@ -655,7 +735,11 @@ drawCoords(const Transform& X_GF, const Vec3& axisLengths, const Vec4& color) {
     buffer[9] = (float) color[0];
     buffer[10]= (float) color[1];
     buffer[11]= (float) color[2];
-    WRITE(outPipe, buffer, 12*sizeof(float));
+
+    unsigned char record[CoordsRecordBytes];
+    record[0] = AddCoords;
+    memcpy(record+1, buffer, 12*sizeof(float));
+    scene.appendRecord(record, CoordsRecordBytes);
 }
 
 void VisualizerProtocol::
@@ -818,6 +902,65 @@ void VisualizerProtocol::setClippingPlanes(Real near, Real far) const {
     WRITE(outPipe, buffer, 2*sizeof(float));
 }
 
+// The buffer is created the first time it is needed and kept until the
+// protocol is destructed; turning the transport off just sends scenes through
+// the pipe again.
+void VisualizerProtocol::setUseSharedMemoryTransport(bool use) {
+    std::lock_guard<std::mutex> lock(sceneMutex);
+    if (use == useSharedMemory)
+        return;
+#ifdef _WIN32
+    return; // POSIX shared memory is not available
+#else
+    if (!use) {
+        // Let the GUI read the scenes already in shared memory before we 
+        // start using the pipe again, but don't wait for one that isn't
+        // reading.
+        waitForSharedScenesToBeRead();
+        useSharedMemory = false;
+        return;
+    }
+
+    if (!sharedScenes) {
+        static std::atomic<int> numBuffers{0};
+        const unsigned capacity = 1u << 24; // 16MB; must be a power of 2
+        sharedMemoryName = "/simbody-visualizer-" + String(getpid()) + "-" 
+                           + String(numBuffers++);
+        sharedMemoryBytes = sizeof(SharedSceneBuffer) + capacity;
+
+        const int fd = shm_open(sharedMemoryName.c_str(), 
+                                O_CREAT|O_EXCL|O_RDWR, 0600);
+        void* mem = MAP_FAILED;
+        if (fd != -1) {
+            if (ftruncate(fd, (off_t)sharedMemoryBytes) == 0)
+                mem = mmap(0, sharedMemoryBytes, PROT_READ|PROT_WRITE, 
+                           MAP_SHARED, fd, 0);
+            CLOSE(fd);
+        }
+        if (mem == MAP_FAILED) {
+            // Scenes will continue to be sent through the pipe; the caller
+            // can tell from getUseSharedMemoryTransport().
+            if (fd != -1)
+                shm_unlink(sharedMemoryName.c_str());
+            return;
+        }
+
+        sharedScenes = new (mem) SharedSceneBuffer;
+        sharedScenes->capacity = capacity;
+        sharedScenes->writePos = 0;
+        sharedScenes->readPos = 0;
+        sharedScenes->notifyPending = 0;
+
+        WRITE(outPipe, &OpenSharedMemory, 1);
+        const unsigned short nameLength = 
+            (unsigned short)sharedMemoryName.size();
+        WRITE(outPipe, &nameLength, sizeof(unsigned short));
+        WRITE(outPipe, sharedMemoryName.c_str(), nameLength);
+    }
+    useSharedMemory = true;
+#endif
+}
+
 void VisualizerProtocol::
 setSystemUpDirection(const CoordinateDirection& upDir) {
     std::lock_guard<std::mutex> lock(sceneMutex);
@@ -28,7 +28,11 @@
 #include "simbody/internal/Visualizer.h"
 #include <utility>
 #include <map>
+#include <vector>
+#include <string>
 #include <atomic>
+#include <algorithm>
+#include <cstring>
 
 /** @file
  * This file defines commands that are used for communication between the 
@@ -37,7 +41,7 @@
 
 // Increment this every time you make *any* change to the protocol;
 // we insist on an exact match.
-static const unsigned ProtocolVersion   = 34;
+static const unsigned ProtocolVersion   = 37;
 
 // The visualizer has several predefined cached meshes for common
 // shapes so that we don't have to send them. These are the mesh 
@@ -51,7 +55,10 @@ static const unsigned short MeshCircle           = 3;
 // defined during this run.
 static const unsigned short NumPredefinedMeshes  = 4;
 
-// Commands sent to the GUI.
+// Commands sent to the GUI. Everything between StartOfScene and EndOfScene
+// is sent as a single block: StartOfScene is followed by the number of bytes
+// in the rest of the scene, which begins with the simulated time and ends
+// with the EndOfScene command.
 
 // This should always be command #1 so we can reliably check whether
 // we're talking to a compatible protocol.
@@ -87,6 +94,30 @@ static const unsigned char SetShowSimTime        = 28;
 static const unsigned char SetShowFrameNumber    = 29;
 static const unsigned char Shutdown              = 30;
 static const unsigned char StopCommunication     = 31;
+// Within a scene: repeat the next n element records of the previous scene
+// unchanged, where n is the unsigned short that follows.
+static const unsigned char RepeatRecords         = 32;
+// Map the shared memory scene buffer whose name follows (as an unsigned
+// short length and then the characters).
+static const unsigned char OpenSharedMemory      = 33;
+// One or more scenes have been put in the shared memory scene buffer.
+static const unsigned char SceneAvailable        = 34;
+
+// Each element of a scene is sent as a record consisting of its Add command
+// and then its data:
+//  - AddSolidMesh, AddPointMesh, or AddWireframeMesh: 13 floats (rotation,
+//    position, scale, color), then two unsigned shorts (mesh index and
+//    resolution);
+//  - AddLine: 10 floats (color, thickness, and the two ends);
+//  - AddText: 12 floats (rotation, position, scale, color), then three
+//    shorts (face camera, screen text, and length), then the characters;
+//  - AddCoords: 12 floats (rotation, position, axis lengths, color).
+static const unsigned MeshRecordBytes = 1 + 13*sizeof(float) 
+                                          + 2*sizeof(unsigned short);
+static const unsigned LineRecordBytes = 1 + 10*sizeof(float);
+static const unsigned TextRecordHeaderBytes = 1 + 12*sizeof(float) 
+                                                + 3*sizeof(short);
+static const unsigned CoordsRecordBytes = 1 + 12*sizeof(float);
 
 
 // Events sent from the GUI back to the simulation application.
@@ -100,6 +131,218 @@ static const unsigned char MenuSelected          = 3;
 static const unsigned char SliderMoved           = 4;
 
 namespace SimTK {
+
+// Scenes can be sent through a ring buffer in shared memory rather than
+// through the pipe; see Visualizer::setUseSharedMemoryTransport(). The shared
+// memory begins with this header, followed by the data area. Each scene in
+// the data area is the scene size followed by the same bytes that follow the
+// size in a StartOfScene command, wrapping around at the end of the data
+// area. Positions count bytes since the buffer was created (modulo 2^32, so
+// the capacity must be a power of 2). Only the simulator changes writePos
+// and only the GUI changes readPos; the simulator sends a SceneAvailable
+// command through the pipe whenever it adds a scene while notifyPending is
+// clear, and the GUI clears that flag before it reads.
+struct SharedSceneBuffer {
+    unsigned                capacity;
+    std::atomic<unsigned>   writePos;
+    std::atomic<unsigned>   readPos;
+    std::atomic<int>        notifyPending;
+
+    unsigned char* updData() {return reinterpret_cast<unsigned char*>(this+1);}
+
+    // Simulator side: append nBytes of data (a scene size and then the scene)
+    // if there is room for all of it, and return whether it was written.
+    bool write(const unsigned char* data, unsigned nBytes) {
+        const unsigned wp = writePos.load(std::memory_order_relaxed);
+        const unsigned rp = readPos.load(std::memory_order_acquire);
+        if (capacity - (wp - rp) < nBytes)
+            return false;
+        const unsigned offset = wp & (capacity-1);
+        const unsigned first = std::min(nBytes, capacity - offset);
+        std::memcpy(updData() + offset, data, first);
+        std::memcpy(updData(), data + first, nBytes - first);
+        writePos.store(wp + nBytes, std::memory_order_release);
+        return true;
+    }
+
+    // GUI side: read the next scene, which must be there, into sceneData and
+    // give its space back to the simulator.
+    void readScene(std::vector<unsigned char>& sceneData) {
+        const unsigned rp = readPos.load(std::memory_order_relaxed);
+        unsigned sceneBytes;
+        copyOut(rp, (unsigned char*)&sceneBytes, sizeof(unsigned));
+        sceneData.resize(sceneBytes);
+        copyOut(rp + sizeof(unsigned), sceneData.data(), sceneBytes);
+        readPos.store(rp + sizeof(unsigned) + sceneBytes, 
+                      std::memory_order_release);
+    }
+
+    // Simulator side: wait for the GUI to read everything written so far. 
+    // We give up and return false if the GUI has disconnected, or if it 
+    // stops making progress for maxStallInSec; the GUI may be hung or gone.
+    bool waitUntilRead(const std::atomic<bool>& guiHasDisconnected, 
+                       double maxStallInSec) const {
+        unsigned rp = readPos.load(std::memory_order_acquire);
+        double lastProgress = realTime();
+        while (rp != writePos.load(std::memory_order_relaxed)) {
+            if (guiHasDisconnected.load())
+                return false;
+            sleepInSec(0.001);
+            const unsigned now = readPos.load(std::memory_order_acquire);
+            if (now != rp) {rp = now; lastProgress = realTime();}
+            else if (realTime() - lastProgress > maxStallInSec)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    void copyOut(unsigned pos, unsigned char* dest, unsigned nBytes) {
+        const unsigned offset = pos & (capacity-1);
+        const unsigned first = std::min(nBytes, capacity - offset);
+        std::memcpy(dest, updData() + offset, first);
+        std::memcpy(dest + first, updData(), nBytes - first);
+    }
+};
+
+// Return the size of the scene element record that starts at data, or zero
+// if data doesn't start a record or fewer than nAvailable bytes of it are 
+// there.
+inline std::size_t getSceneRecordBytes(const unsigned char* data, 
+                                       std::size_t nAvailable) {
+    std::size_t nBytes = 0;
+    switch (data[0]) {
+    case AddSolidMesh:
+    case AddPointMesh:
+    case AddWireframeMesh:  nBytes = MeshRecordBytes; break;
+    case AddLine:           nBytes = LineRecordBytes; break;
+    case AddCoords:         nBytes = CoordsRecordBytes; break;
+    case AddText: {
+        if (nAvailable < TextRecordHeaderBytes)
+            return 0;
+        short length;
+        std::memcpy(&length, data + TextRecordHeaderBytes - sizeof(short), 
+                    sizeof(short));
+        nBytes = TextRecordHeaderBytes + length;
+        break;
+    }
+    default:
+        return 0;
+    }
+    return nBytes <= nAvailable ? nBytes : 0;
+}
+
+// The element records of the scene being built or parsed and of the previous
+// one, in the order they were drawn. The simulator and the GUI each keep one
+// of these: a record that matches the one at the same position in the 
+// previous scene is sent as part of a RepeatRecords run instead of in full.
+class SceneRecords {
+public:
+    // Start recording a new scene. The one recorded before the last call to
+    // endScene() remains the previous scene.
+    void beginScene() {data.clear(); ends.assign(1, 0);}
+    // Make the scene just recorded the previous one.
+    void endScene() {data.swap(prevData); ends.swap(prevEnds);}
+
+    int getNumRecords() const {return (int)ends.size() - 1;}
+    const unsigned char* getRecord(int i) const {return &data[ends[i]];}
+    std::size_t getRecordBytes(int i) const {return ends[i+1] - ends[i];}
+
+    // Add a record and return whether it matches the one at the same position
+    // in the previous scene.
+    bool add(const unsigned char* record, std::size_t nBytes) {
+        const std::size_t i = ends.size() - 1;
+        data.insert(data.end(), record, record + nBytes);
+        ends.push_back(data.size());
+        return i+1 < prevEnds.size() 
+            && prevEnds[i+1] - prevEnds[i] == nBytes
+            && std::memcmp(&prevData[prevEnds[i]], record, nBytes) == 0;
+    }
+
+    // Add the next count records of the previous scene. Returns false if the
+    // previous scene doesn't have that many more.
+    bool repeat(std::size_t count) {
+        const std::size_t i = ends.size() - 1;
+        if (i + count >= prevEnds.size())
+            return false;
+        data.insert(data.end(), prevData.begin() + prevEnds[i], 
+                                prevData.begin() + prevEnds[i+count]);
+        for (std::size_t k=1; k <= count; ++k)
+            ends.push_back(ends.back() + (prevEnds[i+k] - prevEnds[i+k-1]));
+        return true;
+    }
+
+private:
+    // All the records back to back; record i is data[ends[i]..ends[i+1]).
+    std::vector<unsigned char> data, prevData;
+    std::vector<std::size_t>   ends{0}, prevEnds{0};
+};
+
+// Simulator side: accumulates the data of one scene, starting with the
+// StartOfScene command and the scene size, so that it can be sent with a
+// single write. Element records that match the previous scene the GUI got
+// are replaced by RepeatRecords commands.
+class SceneEncoder {
+public:
+    // Room is left at the front for the StartOfScene command and the scene
+    // size, which isn't known until the end.
+    void beginScene(float time) {
+        buffer.assign(1 + sizeof(unsigned), 0);
+        buffer[0] = StartOfScene;
+        records.beginScene();
+        numRepeatedRecords = 0;
+        append(&time, sizeof(float));
+    }
+
+    // Add data other than an element record, such as a mesh definition. Any
+    // pending run of unchanged records must be sent first to keep the 
+    // records in order.
+    void append(const void* data, unsigned nBytes) {
+        flushRepeatedRecords();
+        const unsigned char* p = (const unsigned char*)data;
+        buffer.insert(buffer.end(), p, p+nBytes);
+    }
+
+    // Add an element record; see MeshRecordBytes. If it is exactly the one
+    // at the same position in the previous scene, just count it.
+    void appendRecord(const unsigned char* record, unsigned nBytes) {
+        if (!records.add(record, nBytes)) {
+            append(record, nBytes);
+            return;
+        }
+        if (numRepeatedRecords == 65535)
+            flushRepeatedRecords();
+        ++numRepeatedRecords;
+    }
+
+    // End the scene and return all its data.
+    const std::vector<unsigned char>& finishScene() {
+        append(&EndOfScene, 1);
+        const unsigned sceneBytes = 
+            (unsigned)(buffer.size() - (1 + sizeof(unsigned)));
+        std::memcpy(&buffer[1], &sceneBytes, sizeof(unsigned));
+        return buffer;
+    }
+
+    // Call this if the GUI got the finished scene, so that the next one is 
+    // encoded relative to it. A scene the GUI never sees must not be.
+    void sceneWasSent() {records.endScene();}
+
+private:
+    void flushRepeatedRecords() {
+        if (numRepeatedRecords == 0)
+            return;
+        const unsigned char* p = (const unsigned char*)&numRepeatedRecords;
+        buffer.push_back(RepeatRecords);
+        buffer.insert(buffer.end(), p, p+sizeof(unsigned short));
+        numRepeatedRecords = 0;
+    }
+
+    std::vector<unsigned char>  buffer;
+    SceneRecords                records;
+    unsigned short              numRepeatedRecords = 0;
+};
+
 class VisualizerProtocol {
 public:
     VisualizerProtocol(Visualizer& visualizer,
@@ -153,12 +396,32 @@ public:
     void lookAt(const Vec3& point, const Vec3& upDirection) const;
     void setFieldOfView(Real fov) const;
     void setClippingPlanes(Real near, Real far) const;
+    void setUseSharedMemoryTransport(bool useSharedMemory);
+    bool getUseSharedMemoryTransport() const {return useSharedMemory;}
 private:
     void drawMesh(const Transform& transform, const Vec3& scale, 
                   const Vec4& color, short representation, 
                   unsigned short meshIndex, unsigned short resolution);
+    bool writeSceneToSharedMemory(const std::vector<unsigned char>& data);
+    bool waitForSharedScenesToBeRead() const;
     int outPipe;
 
+    // Scene data is accumulated here between beginScene() and finishScene()
+    // and then sent to the GUI with a single write.
+    SceneEncoder scene;
+    // Meshes first defined in the scene being built. If the scene is dropped
+    // they must be defined again in a later one.
+    std::vector<const void*> meshesDefinedInScene;
+
+    // The shared memory scene buffer, if one has been created.
+    bool                useSharedMemory = false;
+    // Set by the listener thread when the GUI's pipe closes, so that we 
+    // don't wait for it to read scenes.
+    std::atomic<bool>   guiHasDisconnected{false};
+    SharedSceneBuffer*  sharedScenes = nullptr;
+    std::size_t         sharedMemoryBytes = 0;
+    std::string         sharedMemoryName;
+
     // For user-defined meshes, map their unique memory addresses to the 
     // assigned visualizer cache index.
     mutable std::map<const void*, unsigned short> meshes;
@@ -187,6 +187,16 @@ returned by getCableLength() so that getIntegratedCableLengthDot() will return
 the same values as getCableLength() during the simulations. **/
 void setIntegratedCableLengthDot(State& state, Real value) const;
 
+/** Control how much progress information the path solver writes to 
+std::cout. At the default level 0 nothing is written. Level 1 reports the 
+outcome of each path solve along with obstacle liftoff and touchdown events,
+and level 2 adds per-iteration progress and dumps of the path's internal 
+state. Diagnostics from different cable paths may be interleaved if the 
+CableTrackerSubsystem is solving paths in parallel. **/
+void setDiagnosticsLevel(int level);
+/** Return the level set with setDiagnosticsLevel(). **/
+int getDiagnosticsLevel() const;
+
 
 /** Default constructor creates an empty cable path not associated with any
 subsystem; don't use this. **/
@@ -325,7 +335,8 @@ Surface() : CableObstacle() {}
 /** Create a new wrapping surface obstacle and insert it into the given
 CablePath. The surface is fixed to mobilized body \a mobod and the surface
 frame S is positioned relative to that body's frame B according to the given 
-transform \a X_BS. **/
+transform \a X_BS. The obstacle keeps its own copy of \a surface, with the
+same geodesic cache size; see setGeodesicCacheSize(). **/
 Surface(CablePath& path, const MobilizedBody& mobod,
         const Transform& X_BS, const ContactGeometry& surface);
 
@@ -354,6 +365,19 @@ in the local frame S of the contact surface. **/
 Surface& setContactPointHints(const Vec3& startHint, 
                               const Vec3& endHint);
 
+/** Optionally have this obstacle's copy of the surface remember the last 
+\a n geodesics calculated on it, and warm start the path calculations from 
+them; see ContactGeometry::setGeodesicCacheSize(). That can save a lot of
+time since the cable asks for a slowly moving geodesic over and over. The
+default is 0 (off) unless the surface given to the constructor had caching
+enabled. The cache is part of the obstacle, not the State, so with it on the
+path found for a State depends on what was calculated earlier, including for
+other States and for integrator steps that were rejected; the results agree
+to within the path accuracy but are not repeatable bit for bit. **/
+Surface& setGeodesicCacheSize(int n);
+/** Return the number of geodesics this obstacle's surface remembers. **/
+int getGeodesicCacheSize() const;
+
 /** Return true if the given CableObstacle is a Surface. **/
 static bool isInstance(const CableObstacle&);
 /** Cast the given CableObstacle to a const Surface; will throw an exception
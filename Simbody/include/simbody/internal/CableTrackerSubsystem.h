@@ -80,6 +80,30 @@ const CablePath& getCablePath(CablePathIndex cableIx) const;
 /** Get writable access to a particular cable path. **/
 CablePath& updCablePath(CablePathIndex cableIx);
 
+/** Enable or disable solving for the paths of different cables concurrently
+during realizePosition(). Each cable path is solved independently and has 
+its own copy of its obstacles' geometry, so when this is enabled the paths
+are divided among a pool of worker threads; that pays off when there are
+many cables or cables wrapping over several obstacles. The results are
+identical either way. It is off by default.
+@see setNumberOfThreads() **/
+void setUseParallelPathSolves(bool useParallel);
+/** Return whether parallel path solves have been enabled with
+setUseParallelPathSolves(). **/
+bool getUseParallelPathSolves() const;
+
+/** Set the maximum number of threads that may be used for parallel path
+solves. By default this is the number of total processors (including 
+hyperthreads) on the machine. This has no effect unless parallel path
+solves have been enabled with setUseParallelPathSolves().
+
+@note This method should NOT be called while this subsystem is being realized.
+**/
+void setNumberOfThreads(unsigned numThreads);
+/** Return the maximum number of threads that may be used for parallel path
+solves. **/
+int getNumberOfThreads() const;
+
 /** @cond **/ // Hide from Doxygen.
 SimTK_PIMPL_DOWNCAST(CableTrackerSubsystem, Subsystem);
 class Impl;
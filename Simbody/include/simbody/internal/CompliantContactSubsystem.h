@@ -191,6 +191,38 @@ turned on energy tracking via setTrackDissipatedEnergy().
 @see getDissipatedEnergy(), setTrackDissipatedEnergy() **/
 void setDissipatedEnergy(State& state, Real energy) const;
 
+/** Enable or disable parallel calculation of contact forces. Each active
+Contact's force is produced independently by its ContactForceGenerator, so
+when this is enabled the contacts are divided among a pool of worker threads;
+that pays off when there are many contacts or some expensive ones, such as 
+elastic foundation mesh contacts. The resulting ContactForce objects are 
+identical to the serial ones and are kept in the same order. Each thread then
+accumulates its share of the forces into its own set of body forces, and those
+are added together in a fixed order so the total is reproducible from run to
+run for a given number of threads, although it may differ from the serial
+result in the last bits. It is off by default.
+
+@note If you register your own ContactForceGenerator objects, their 
+calcContactForce() methods must be safe to call concurrently for different
+contacts when this is enabled.
+@see setNumberOfThreads() **/
+void setUseParallelForces(bool useParallel);
+/** Return whether parallel contact force calculation has been enabled with
+setUseParallelForces(). **/
+bool getUseParallelForces() const;
+
+/** Set the maximum number of threads that may be used for parallel contact
+force calculation. By default this is the number of total processors 
+(including hyperthreads) on the machine. This has no effect unless parallel
+calculation has been enabled with setUseParallelForces().
+
+@note This method should NOT be called while this subsystem is being realized.
+**/
+void setNumberOfThreads(unsigned numThreads);
+/** Return the maximum number of threads that may be used for parallel contact
+force calculation. **/
+int getNumberOfThreads() const;
+
 
 /** Attach a new generator to this subsystem as the responder to be used when
 we see the kind of Contact type for which this generator is defined,
@@ -218,6 +218,77 @@ const Transform& getContactSurfaceTransform(ContactSurfaceIndex surfIx) const;
 /**@}**/
 
 
+/**@name                     Broad phase
+These methods select the algorithm used to find the pairs of contact surfaces
+whose bounding spheres overlap; only those are passed on to the narrow phase
+ContactTracker objects. The choice affects only performance, not results. **/
+/**@{**/
+
+/** Broad phase algorithms available for finding overlapping bounding
+spheres. **/
+enum BroadPhaseMethod {
+    /** Sort all the bounding spheres along the coordinate axis with the most
+    spread and sweep along it. This is fast for small numbers of surfaces but
+    everything is sorted from scratch at each evaluation, and it degrades when
+    many surfaces are clustered along that axis. This is the default. **/
+    SingleAxisSweepAndPrune = 0,
+    /** Maintain a dynamic tree of axis-aligned bounding boxes in the State
+    that persists from step to step and is updated incrementally as the
+    bodies move; only surfaces that move significantly cause any change to
+    the tree. This is the better choice for scenes with many (hundreds or
+    more) contact surfaces. Unbounded surfaces like half spaces are kept out
+    of the tree and are paired with everything. **/
+    BoundingBoxTree = 1
+};
+
+/** Select the broad phase algorithm to be used by this subsystem. This is a
+Topology-stage change so you will need to call realizeTopology() again
+afterwards.
+@see BroadPhaseMethod, getBroadPhaseMethod() **/
+void setBroadPhaseMethod(BroadPhaseMethod method);
+
+/** Return the broad phase algorithm currently selected for this subsystem.
+@see setBroadPhaseMethod() **/
+BroadPhaseMethod getBroadPhaseMethod() const;
+/**@}**/
+
+
+/**@name                     Narrow phase
+These methods control how the ContactTracker objects are invoked for the
+surface pairs that survive the broad phase. **/
+/**@{**/
+
+/** Enable or disable parallel execution of the narrow phase. Each candidate
+surface pair is tracked independently, so when this is enabled the pairs are
+divided among a pool of worker threads; that pays off when there are many
+pairs or some expensive ones, such as mesh-mesh contact. The results are
+merged in the same order as the serial calculation and new ContactIds are
+assigned during the merge, so the active contact set is identical either way.
+It is off by default.
+
+@note If you register your own ContactTracker objects, their trackContact()
+methods must be safe to call concurrently for different surface pairs when
+this is enabled.
+@see setNumberOfThreads() **/
+void setUseParallelNarrowPhase(bool useParallel);
+/** Return whether the parallel narrow phase has been enabled with
+setUseParallelNarrowPhase(). **/
+bool getUseParallelNarrowPhase() const;
+
+/** Set the maximum number of threads that may be used for the parallel
+narrow phase. By default this is the number of total processors (including
+hyperthreads) on the machine. This has no effect unless the parallel narrow
+phase has been enabled with setUseParallelNarrowPhase().
+
+@note This method should NOT be called while this subsystem is being realized.
+**/
+void setNumberOfThreads(unsigned numThreads);
+/** Return the maximum number of threads that may be used for the parallel
+narrow phase. **/
+int getNumberOfThreads() const;
+/**@}**/
+
+
 /**@name                     Contact Tracker management
 Most users won't need to use these methods. **/
 /**@{**/
@@ -261,6 +261,22 @@ public:
     virtual bool shouldBeParallelIfPossible() const {
         return false;
     }
+    /**
+     * Optionally tell Simbody exactly which bodies this force acts on. If
+     * calcForce() only ever adds body forces to the listed mobilized bodies
+     * and never applies particle or mobility forces, you may override this to
+     * fill in \a bodies and return true. The default implementation returns
+     * false, meaning that any entries may be affected.
+     *
+     * This is used only for forces that are calculated in parallel (see
+     * shouldBeParallelIfPossible()); each thread then collects only the
+     * listed bodies' forces rather than scanning whole force arrays, which
+     * matters when there are many cheap forces in a large system. It is consulted
+     * at Instance stage so the list must not change after that.
+     */
+    virtual bool getBodiesAffected(Array_<MobilizedBodyIndex>& bodies) const {
+        return false;
+    }
     /** The following methods may optionally be overridden to do specialized 
     realization for a Force. **/
     //@{
@@ -122,6 +122,20 @@ public:
      * may still invoke it to calculate forces based on contacts.
      */
     const Array_<Contact>& getContacts(const State& state, ContactSetIndex set) const;
+    /**
+     * Select the broad phase algorithm used to find pairs of bodies whose bounding spheres overlap.
+     * By default (false) the spheres are sorted along a single axis and swept at every evaluation.
+     * If set true, a tree of axis-aligned bounding boxes is maintained in the State for each contact
+     * set and updated incrementally as the bodies move, which is much faster when there are many
+     * bodies in a set. The contacts found are the same either way, although they may be reported in
+     * a different order. This is a Topology-stage change.
+     */
+    void setUseBoundingBoxTree(bool useTree);
+    /**
+     * Return the current setting of the broad phase algorithm flag.
+     * @see setUseBoundingBoxTree()
+     */
+    bool getUseBoundingBoxTree() const;
     SimTK_PIMPL_DOWNCAST(GeneralContactSubsystem, Subsystem);
 private:
     class GeneralContactSubsystemImpl& updImpl();
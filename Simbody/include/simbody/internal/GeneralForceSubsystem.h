@@ -91,6 +91,13 @@ public:
     shouldBeParallelIfPossible() method overridden). By default, the
     number of threads is the number of total processors (including hyperthreads)
     on the machine.
+
+    Each such force is a separate work item, and all the other forces together
+    form one more. Idle threads take the remaining item with the largest cost
+    as measured on previous evaluations with the same State, so expensive
+    forces are started first and cheap ones fill in around them. A force can
+    override Force::Custom::Implementation::getBodiesAffected() so that only
+    those bodies' entries have to be collected from it and added in.
     
     @note This method should NOT be called while realizing Stage::Dynamics.**/
     void setNumberOfThreads(unsigned numThreads);
@@ -205,6 +205,54 @@ void setShowDefaultGeometry(bool show);
 geometry that can be used to visualize this multibody system. **/
 bool getShowDefaultGeometry() const;
 
+/** Enable or disable parallel execution of the multibody tree sweeps. The
+base-to-tip and tip-to-base recursions used for position and velocity 
+kinematics, articulated body inertias, forward dynamics, inverse dynamics, and
+the M and M^-1 operators visit the mobilized bodies level by level. Bodies at 
+the same level of the tree are independent of one another, so when this is 
+enabled any level wide enough to be worth it is divided among a pool of worker 
+threads. Each body still performs exactly the same computation, so the results
+are bitwise identical to the serial sweep; this only pays off for wide, 
+branching trees with many bodies at the same level. It is off by default.
+
+@note If you use MobilizedBody::Custom mobilizers, their implementations must 
+be safe to evaluate concurrently for different bodies when this is enabled.
+@see setNumberOfThreads() **/
+void setUseParallelTreeSweeps(bool useParallel);
+/** Return whether parallel tree sweeps have been enabled with
+setUseParallelTreeSweeps(). **/
+bool getUseParallelTreeSweeps() const;
+
+/** Set the maximum number of threads that may be used for parallel tree 
+sweeps. By default this is the number of total processors (including 
+hyperthreads) on the machine. This has no effect unless parallel tree sweeps
+have been enabled with setUseParallelTreeSweeps().
+
+@note This method should NOT be called while this subsystem is being realized.
+**/
+void setNumberOfThreads(unsigned numThreads);
+/** Return the maximum number of threads that may be used for parallel tree
+sweeps. **/
+int getNumberOfThreads() const;
+
+/** Choose how position and velocity constraint projection (projectQ() and
+projectU()) solve their weighted least squares problems. By default the
+transposed constraint Jacobian is formed as a dense nfq X mp (or nfu X mpv)
+matrix and factored with a complete orthogonal factorization, which costs
+O(n m^2) and O(n m) memory. When this is enabled the weighted Jacobian is
+instead kept in sparse form and the minimum-norm solution is obtained from a
+sparse Cholesky factorization of its normal equations, so the cost grows
+with the number of nonzeros. This pays off for large systems with many
+constraints that each involve only a few mobilities; for small or densely
+coupled systems the dense method is usually faster and somewhat more robust
+near singular configurations. Redundant constraints are handled in both
+cases, though the two methods may retain different subsets of them. It is
+off by default. **/
+void setUseSparseConstraintProjection(bool useSparse);
+/** Return whether sparse constraint projection has been enabled with
+setUseSparseConstraintProjection(). **/
+bool getUseSparseConstraintProjection() const;
+
 /** The number of bodies includes all mobilized bodies \e including Ground,
 which is the first mobilized body, at MobilizedBodyIndex 0. (Note: if 
 special particle handling were implemented, the count here would \e not 
@@ -1420,6 +1468,16 @@ Even if G and M^-1 were already available, computing W by matrix multiplication
 would cost O(m^2*n + m*n^2) time and O(m*n) intermediate storage. Here we do 
 it in O(m*n) time with O(n) intermediate storage, which is a \e lot better.
 
+Constraint equations acting on disjoint subtrees of Ground (for example, 
+contacts between Ground and many independent bodies) are not coupled through
+M^-1, so W is block diagonal after a permutation. We find those blocks from
+the bodies and mobilizers each constraint involves, and compute one column of
+every block in a single pass of the operators above, so only k passes are 
+needed where k is the size of the largest block. Entries outside the blocks
+are set to exactly zero. If parallel tree sweeps are enabled (see 
+setUseParallelTreeSweeps()) the passes are divided among the worker threads;
+the result is the same either way.
+
 @par Required stage
   \c Stage::Velocity (articulated body inertias realized first if necessary)
      
@@ -2098,7 +2156,6 @@ void calcResidualForceIgnoringConstraints
     const Vector&              knownUdot,
     Vector&                    residualMobilityForces) const;
 
-
 /** This is the inverse dynamics operator for when you know both the 
 accelerations and Lagrange multipliers for a constrained system. Prescribed
 motion is ignored. Using position and velocity from the given state, a set of 
@@ -2519,6 +2576,72 @@ void addInMobilityForce(const State&        state,
                         MobilizerUIndex     which, 
                         Real                f,
                         Vector&             mobilityForces) const;
+
+/** Calculate the product Jv=J*v of the Jacobian J=d(qdot,udot)/d(q,u) of the
+system's equations of motion with a given vector v=(vq,vu). The result is 
+the directional derivative of (qdot,udot) along v, which is obtained with a
+single additional realization of the whole System through Acceleration stage
+(including all its force elements) in a copy of  state, rather than the
+2n realizations needed to form J. This is what matrix-free (Krylov) implicit 
+integrators and optimizers need. Auxiliary state variables z are held fixed.
+
+@param[in]      state
+    A State realized through Acceleration stage; it is not modified.
+@param[in]      v
+    The direction, of length nq+nu with the q-like part first.
+@param[out]     Jv
+    The result, of length nq+nu with the qdot part first; resized if needed.
+
+@par Required stage
+  \c Stage::Acceleration
+@see calcODEJacobian() **/
+void calcODEJacobianTimesVector(const State&    state,
+                                const Vector&   v,
+                                Vector&         Jv) const;
+
+/** Calculate the (nq+nu) X (nq+nu) Jacobian J=d(qdot,udot)/d(q,u) of the 
+system's equations of motion as a sparse matrix in compressed column form, 
+using the multibody tree structure to reduce the number of realizations 
+needed. The q's and u's are numbered as in the State, with the q's first.
+
+Since qdot=N(q)*u is block diagonal, each qdot depends only on its own 
+mobilizer's q's and u's. The udots depend on all the q's and u's of the bodies 
+connected to them through the tree, that is, in the same base subtree hanging
+from Ground, or in any other base subtree joined to it by a Constraint. Those
+entries make up the sparsity pattern of J; base subtrees that are coupled by
+neither path contribute no entries to each other's columns. Columns belonging 
+to uncoupled groups are perturbed together ("colored") so the number of 
+forward-difference realizations of the System is the number of q's and u's in
+the largest group, rather than nq+nu.
+
+Force elements may couple bodies that are otherwise independent (contact, or 
+a spring between two free bodies), and a %SimbodyMatterSubsystem can't tell 
+which ones do. So base subtrees are treated as independent only if you set
+\a independentSubtrees to assert that no force couples them; otherwise all 
+udots are treated as depending on all q's and u's, although the qdot rows 
+are still sparse.
+
+@param[in]      state
+    A State realized through Acceleration stage; it is not modified.
+@param[in]      independentSubtrees
+    Whether base subtrees not joined by Constraints may be treated as 
+    independent; see above.
+@param[out]     colStart
+    Resized to nq+nu+1; the entries of column j are at positions 
+    colStart[j] through colStart[j+1]-1 of \a rowIndex and \a value.
+@param[out]     rowIndex
+    The row of each stored entry, ascending within each column.
+@param[out]     value
+    The corresponding Jacobian entries.
+
+@par Required stage
+  \c Stage::Acceleration
+@see calcODEJacobianTimesVector() **/
+void calcODEJacobian(const State&   state,
+                     bool           independentSubtrees,
+                     Array_<int>&   colStart,
+                     Array_<int>&   rowIndex,
+                     Array_<Real>&  value) const;
 /**@}**/
 
 
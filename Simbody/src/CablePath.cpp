@@ -77,21 +77,21 @@ std::ostream& operator<<(std::ostream& o, const PathInstanceInfo& info) {
 }
 
 std::ostream& operator<<(std::ostream& o, const PathPosEntry& ppe) {
-    cout << "PathPosEntry: length=" << ppe.length << endl;
-    cout << "mapToActive: " << ppe.mapToActive << endl;
-    cout << "mapToActiveSurface: " << ppe.mapToActiveSurface << endl;
-    cout << "mapToCoords: " << ppe.mapToCoords << endl;
-    cout << "eIn_G: " << ppe.eIn_G << endl;
-    cout << "Fu_GB: " << ppe.Fu_GB << endl;
-    cout << "witnesses=" << ppe.witnesses << endl;
-
-    cout << "geodesics lengths=";
+    o << "PathPosEntry: length=" << ppe.length << endl;
+    o << "mapToActive: " << ppe.mapToActive << endl;
+    o << "mapToActiveSurface: " << ppe.mapToActiveSurface << endl;
+    o << "mapToCoords: " << ppe.mapToCoords << endl;
+    o << "eIn_G: " << ppe.eIn_G << endl;
+    o << "Fu_GB: " << ppe.Fu_GB << endl;
+    o << "witnesses=" << ppe.witnesses << endl;
+
+    o << "geodesics lengths=";
     for (ActiveSurfaceIndex asx(0); asx < ppe.geodesics.size(); ++asx)
-        cout << ppe.geodesics[asx].getLength() << " ";
-    cout << endl;
-    cout << "x=" << ppe.x << endl;
-    cout << "err=" << ppe.err << endl;
-    cout << "J dims=" << ppe.J.nrow() << " x " << ppe.J.ncol() << endl;
+        o << ppe.geodesics[asx].getLength() << " ";
+    o << endl;
+    o << "x=" << ppe.x << endl;
+    o << "err=" << ppe.err << endl;
+    o << "J dims=" << ppe.J.size() << " x " << ppe.J.size() << endl;
     return o;
 }
 
@@ -100,6 +100,110 @@ std::ostream& operator<<(std::ostream& o, const PathVelEntry& entry) {
 }
 
 
+
+//==============================================================================
+//                          PATH ERROR JACOBIAN
+//==============================================================================
+
+// Replace A by its LU factors using partial pivoting, with the row swaps
+// recorded in piv. Returns false if A is singular to working precision or 
+// contains non-finite values, in which case A is garbage.
+static bool factorBlock(Mat66& A, int piv[6]) {
+    const Real scale = A.norm();
+    if (!isFinite(scale) || scale == 0)
+        return false;
+    const Real tiny = SignificantReal*scale;
+    for (int j=0; j < 6; ++j) {
+        int p = j;
+        for (int i=j+1; i < 6; ++i)
+            if (std::abs(A(i,j)) > std::abs(A(p,j))) p = i;
+        piv[j] = p;
+        if (std::abs(A(p,j)) <= tiny)
+            return false;
+        if (p != j)
+            for (int c=0; c < 6; ++c) std::swap(A(p,c), A(j,c));
+        const Real ooPivot = 1/A(j,j);
+        for (int i=j+1; i < 6; ++i) {
+            const Real m = (A(i,j) *= ooPivot);
+            for (int c=j+1; c < 6; ++c)
+                A(i,c) -= m*A(j,c);
+        }
+    }
+    return true;
+}
+
+// Overwrite b with A^-1 b, given A's factors from factorBlock().
+static void solveBlock(const Mat66& LU, const int piv[6], Vec6& b) {
+    for (int j=0; j < 6; ++j)
+        std::swap(b[j], b[piv[j]]);
+    for (int j=0; j < 6; ++j)
+        for (int i=j+1; i < 6; ++i)
+            b[i] -= LU(i,j)*b[j];
+    for (int j=5; j >= 0; --j) {
+        for (int c=j+1; c < 6; ++c)
+            b[j] -= LU(j,c)*b[c];
+        b[j] /= LU(j,j);
+    }
+}
+
+// Block forward elimination: the eliminated diagonal block in row k is
+// D(k) - L(k) G(k-1) with G(k-1) = [D(k-1) - ...]^-1 U(k-1). That takes
+// a handful of 6x6 operations per block row.
+void PathErrorJacobian::factor() {
+    useDense = false;
+    LU.resize(nBlocks); G.resize(nBlocks); pivots.resize(6*nBlocks);
+    for (int k=0; k < nBlocks; ++k) {
+        LU[k] = k == 0 ? D[0] : D[k] - L[k]*G[k-1];
+        if (!factorBlock(LU[k], &pivots[6*k])) {
+            useDense = true;
+            denseLU.factor(calcDenseMatrix());
+            return;
+        }
+        if (k == nBlocks-1)
+            break;
+        for (int c=0; c < 6; ++c) {
+            Vec6 col = U[k](c);
+            solveBlock(LU[k], &pivots[6*k], col);
+            G[k](c) = col;
+        }
+    }
+}
+
+void PathErrorJacobian::solve(const Vector& b, Vector& x) const {
+    assert(b.size() == size());
+    if (useDense) {
+        denseLU.solve(b, x);
+        return;
+    }
+    x.resize(size());
+    // Forward substitution y(k) = [D(k) - L(k) G(k-1)]^-1 (b(k) - L(k) y(k-1))
+    // with y kept in x, then back substitution x(k) = y(k) - G(k) x(k+1).
+    for (int k=0; k < nBlocks; ++k) {
+        Vec6 y = Vec6::getAs(&b[k*BlockSize]);
+        if (k > 0)
+            y -= L[k]*Vec6::getAs(&x[(k-1)*BlockSize]);
+        solveBlock(LU[k], &pivots[6*k], y);
+        Vec6::updAs(&x[k*BlockSize]) = y;
+    }
+    for (int k=nBlocks-2; k >= 0; --k)
+        Vec6::updAs(&x[k*BlockSize]) -= 
+            G[k]*Vec6::getAs(&x[(k+1)*BlockSize]);
+}
+
+Matrix PathErrorJacobian::calcDenseMatrix() const {
+    Matrix J(size(), size(), Real(0));
+    for (int k=0; k < nBlocks; ++k) {
+        const int r = k*BlockSize;
+        J(r,r,BlockSize,BlockSize) = Matrix(D[k]);
+        if (k > 0)
+            J(r,r-BlockSize,BlockSize,BlockSize) = Matrix(L[k]);
+        if (k < nBlocks-1)
+            J(r,r+BlockSize,BlockSize,BlockSize) = Matrix(U[k]);
+    }
+    return J;
+}
+
+
 //==============================================================================
 //                              CABLE PATH 
 //==============================================================================
@@ -180,6 +284,12 @@ Real CablePath::getIntegratedCableLengthDot(const State& state) const
 void CablePath::setIntegratedCableLengthDot(State& state, Real value) const
 {   getImpl().setIntegratedLengthDot(state, value); }
 
+void CablePath::setDiagnosticsLevel(int level)
+{   updImpl().setDiagnosticsLevel(level); }
+
+int CablePath::getDiagnosticsLevel() const
+{   return getImpl().getDiagnosticsLevel(); }
+
 
 //==============================================================================
 //                           CABLE PATH :: IMPL
@@ -229,7 +339,8 @@ realizeTopology(State& state) {
     // Initialize instance info from defaults.
     PathInstanceInfo instInfo(obstacles);
 
-    cout << "In realizeTopology(): " << instInfo << endl;
+    if (diagnosticsLevel >= 2)
+        cout << "In realizeTopology(): " << instInfo << endl;
 
     // Allocate and initialize instance state variable.
     instanceInfoIx = cables->allocateDiscreteVariable(state,
@@ -357,8 +468,10 @@ realizeInstance(const State& state) const {
             surf.getContactPointHints(xPhint,xQhint);
         ppe.closestSurfacePoint[sox] = xPhint;
     }
-    cout << "INIT PE=" << ppe << endl;
-    cout << "INIT VE=" << pve << endl;
+    if (diagnosticsLevel >= 2) {
+        cout << "INIT PE=" << ppe << endl;
+        cout << "INIT VE=" << pve << endl;
+    }
 }
 
 
@@ -402,7 +515,8 @@ realizeAcceleration(const State& state) const {
 void CablePath::Impl::
 calcEventTriggerInfo(const State& state, Array_<EventTriggerInfo>& info) const
 {
-    std::cout << "In CablePath::Impl::calcEventTriggerInfo()\n";
+    if (diagnosticsLevel >= 2)
+        std::cout << "In CablePath::Impl::calcEventTriggerInfo()\n";
 
     for (std::map<EventId,CableObstacleIndex>::const_iterator p =
                                         mapEventIdToObstacle.begin();
@@ -426,9 +540,11 @@ void CablePath::Impl::handleEvents
     (State& state, Event::Cause cause, const Array_<EventId>& eventIds,
     const HandleEventsOptions& options, HandleEventsResults& results) const
 {
-    std::cout << "In CablePath::Impl::handleEvents() cause="
-              << Event::getCauseName(cause) << std::endl;
-    std::cout << "EventIds: " << eventIds << std::endl;
+    if (diagnosticsLevel >= 1) {
+        std::cout << "In CablePath::Impl::handleEvents() cause="
+                  << Event::getCauseName(cause) << std::endl;
+        std::cout << "EventIds: " << eventIds << std::endl;
+    }
 
 
     const PathInstanceInfo& instInfo = getInstanceInfo(state);
@@ -478,8 +594,10 @@ void CablePath::Impl::handleEvents
     // triggered the event. We'll modify the cache entry to change the 
     // obstacle activation, then write the modified entry onto the state.
     PathPosEntry& prevPPE = updPrevPosEntry(state);
-    std::cout << "PrevPPE in handler=\n" << prevPPE << std::endl;
-    std::cout << "CurrPPE in handler=\n" << currPPE << std::endl;
+    if (diagnosticsLevel >= 2) {
+        std::cout << "PrevPPE in handler=\n" << prevPPE << std::endl;
+        std::cout << "CurrPPE in handler=\n" << currPPE << std::endl;
+    }
 
     // Look through the triggered events to see if any of the event ids 
     // belong to this cable path. If so, activate or deactive the corresponding
@@ -495,7 +613,8 @@ void CablePath::Impl::handleEvents
             SimTK_DYNAMIC_CAST_DEBUG<const CableObstacle::Surface::Impl&>
                                                         (getObstacleImpl(ox));
         if (instInfo.obstacleDisabled[ox]) {
-            std::cout << "ENABLE OBSTACLE " << ox << std::endl;
+            if (diagnosticsLevel >= 1)
+                std::cout << "ENABLE OBSTACLE " << ox << std::endl;
             // Grab points before we invalidate the state.
             Vec3 rSQp = r_SQp[ox], rSPn = r_SPn[ox];
             updInstanceInfo(state).obstacleDisabled[ox] = false;
@@ -520,7 +639,8 @@ void CablePath::Impl::handleEvents
             obs.getContactPointsOnObstacle(state,instInfo,currPPE,P_S,Q_S);
             currPPE.closestSurfacePoint[sox] = (P_S+Q_S)/2;
             currPPE.closestPathPoint[sox] = (P_S+Q_S)/2;
-            std::cout << "DISABLE OBSTACLE " << ox << std::endl;
+            if (diagnosticsLevel >= 1)
+                std::cout << "DISABLE OBSTACLE " << ox << std::endl;
             updInstanceInfo(state).obstacleDisabled[ox] = true;
             cables->getSystem().realize(state, Stage::Instance);
         }
@@ -547,7 +667,8 @@ void CablePath::Impl::handleEvents
         updPrevVelEntry(state) = updVelEntry(state); // don't force computation
     }
 
-    std::cout << "Final CurrPPE in handler=\n" << currPPE << std::endl;
+    if (diagnosticsLevel >= 2)
+        std::cout << "Final CurrPPE in handler=\n" << currPPE << std::endl;
 
     results.setExitStatus(HandleEventsResults::Succeeded);
 }
@@ -693,8 +814,9 @@ ensureVelocityKinematicsCalculated(const State& state) const {
 
     if (ppe.x.size()) {
         findKinematicVelocityErrors(state, instInfo, ppe, pve);
-        ppe.JInv.solve(pve.nerrdotK, pve.xdot);
-        cout << "*** xdot=" << pve.xdot << endl;
+        ppe.J.solve(pve.nerrdotK, pve.xdot);
+        if (diagnosticsLevel >= 2)
+            cout << "*** xdot=" << pve.xdot << endl;
     }
 
     //TODO: calc length dot
@@ -819,8 +941,9 @@ solveForPathPoints(const State& state, const PathInstanceInfo& instInfo,
     Vector dx, xold, xchg;
 
     Real f = ppe.err.norm();
-    cout << "\n***PATH solveForPathPoints@t=" << state.getTime() 
-         << " err=" << f << "\n"; 
+    if (diagnosticsLevel >= 1)
+        cout << "\n***PATH solveForPathPoints@t=" << state.getTime() 
+             << " err=" << f << "\n"; 
 
     Real fold, lam = 1, nextlam = 1;
     Real dxnormPrev = Infinity;
@@ -830,33 +953,35 @@ solveForPathPoints(const State& state, const PathInstanceInfo& instInfo,
         // because we use it to solve for xdot. So we might as well do one
         // iteration.
         if (i > 0 && f <= ftol) {
-            std::cout << "\n***PATH converged in " 
-                << i << " iterations err=" << f << "\n\n";
+            if (diagnosticsLevel >= 1)
+                std::cout << "\n***PATH converged in " 
+                    << i << " iterations err=" << f << "\n\n";
             break;
         }
         //cout << "obstacle err = " << f << ", x = " << ppe.x << endl;
 
-        //diff.calcJacobian(ppe.x, ppe.err, ppe.J, 
+        //Matrix Jnum;
+        //diff.calcJacobian(ppe.x, ppe.err, Jnum, 
         //                  Differentiator::ForwardDifference);
-       // Matrix Jnum = ppe.J;
         calcPathErrorJacobian(state, instInfo, ppe);
 
-        //cout << "DIFF J=" << Jnum-ppe.J;
-        //cout << "DIFF NORM=" << (Jnum-ppe.J).norm() << "\n";
+        //cout << "DIFF J=" << Jnum-ppe.J.calcDenseMatrix();
+        //cout << "DIFF NORM=" << (Jnum-ppe.J.calcDenseMatrix()).norm() << "\n";
 
-        ppe.JInv.factor(ppe.J);
-        //ppe.JInv.factor(Jnum);
+        ppe.J.factor();
 
         fold = f;
         xold = ppe.x;
 
-        ppe.JInv.solve(ppe.err, dx);
+        ppe.J.solve(ppe.err, dx);
 
         const Real dxnorm = std::sqrt(dx.normSqr()/ppe.x.size()); // rms
-        cout << "|dx| = " << dxnorm << endl;
+        if (diagnosticsLevel >= 2)
+            cout << "|dx| = " << dxnorm << endl;
         if (dxnorm > Real(.99)*dxnormPrev) {
-           std::cout << "\nPATH stalled in " 
-                << i << " iterations err=" << f << " |dx|=" << dxnorm << "\n\n";
+            if (diagnosticsLevel >= 1)
+                std::cout << "\nPATH stalled in " << i 
+                    << " iterations err=" << f << " |dx|=" << dxnorm << "\n\n";
             break;
         }
 
@@ -1110,7 +1235,8 @@ calcPathError(const State& state, const PathInstanceInfo& instInfo,
                 Vec3::getAs(&ppe.x[xSlot]),  // xP
                 Vec3::getAs(&ppe.x[xSlot+3]),// xQ
                 eOut_S,
-                ppe.geodesics[asx] );
+                ppe.geodesics[asx],
+                diagnosticsLevel );
 
         const Geodesic& geod = ppe.geodesics[asx];
         const Real signP = (Real)sign(dot(eIn_S,geod.getTangentP()));
@@ -1133,8 +1259,8 @@ calcPathError(const State& state, const PathInstanceInfo& instInfo,
 //------------------------------------------------------------------------------
 //                          CALC PATH ERROR JACOBIAN
 //------------------------------------------------------------------------------
-// Assemble the nx X nx banded Jacobian J=D patherr / Dx from per-obstacle 
-// blocks. The obstacles compute the Jacobian of their own path error 
+// Assemble the nx X nx block tridiagonal Jacobian J=D patherr / Dx from 
+// per-obstacle blocks. The obstacles compute the Jacobian of their own path error 
 // functions, which are eHat(eIn_S, xP, xQ, eOut_S), with all arguments in the
 // obstacle frame S. The blocks we need are instead the Jacobian of
 //    e(xQ-1, xP, xQ, xP+1) = eHat(eIn_S(xQ-1,xP), xP, xQ, eOut_S(xQ,xP+1))
@@ -1152,8 +1278,7 @@ calcPathErrorJacobian(const State&            state,
     const PathPosEntry& prevPPE = getPrevPosEntry(state);
 
     const int nx = ppe.x.size();
-    ppe.J.resize(nx, nx);
-    ppe.J.setToZero();
+    ppe.J.resize(nx);
     if (nx == 0)
         return; // only via points; nothing to do
 
@@ -1276,12 +1401,16 @@ calcPathErrorJacobian(const State&            state,
         //cout << "DehatDxQ1=" << DehatDxQ1;
         //cout << "diff=" << (DehatDxQ-DehatDxQ1).norm() << ": " << (DehatDxQ-DehatDxQ1);
 
-        if (xSlot >= 3)
-            ppe.J(xSlot,xSlot-3,6,3) = Matrix(DehatDein*DeinDQp);
-        ppe.J(xSlot,xSlot,  6,3) = Matrix(DehatDxP + DehatDein *DeinDP);
-        ppe.J(xSlot,xSlot+3,6,3) = Matrix(DehatDxQ + DehatDeout*DeoutDQ);
-        if (xSlot+9 < nx)
-            ppe.J(xSlot,xSlot+6,6,3) = Matrix(DehatDeout*DeoutDPn);
+        // Block row k couples to the previous surface's xQ (the last three
+        // columns of block column k-1) and the next one's xP (the first 
+        // three columns of block column k+1).
+        const int k = xSlot / PathErrorJacobian::BlockSize;
+        if (k > 0)
+            ppe.J.updL(k).updSubMat<6,3>(0,3) = DehatDein*DeinDQp;
+        ppe.J.updD(k).updSubMat<6,3>(0,0) = DehatDxP + DehatDein *DeinDP;
+        ppe.J.updD(k).updSubMat<6,3>(0,3) = DehatDxQ + DehatDeout*DeoutDQ;
+        if (k+1 < ppe.J.getNumBlocks())
+            ppe.J.updU(k).updSubMat<6,3>(0,0) = DehatDeout*DeoutDPn;
 
         prevActiveOx = thisActiveOx;
         thisActiveOx = ppe.findNextActiveObstacle(prevActiveOx);       
@@ -1394,6 +1523,18 @@ setContactPointHints(const Vec3& Phint_S, const Vec3& Qhint_S) {
     return *this; 
 }
 
+CableObstacle::Surface& CableObstacle::Surface::
+setGeodesicCacheSize(int n) { 
+    Impl& surfImpl = SimTK_DYNAMIC_CAST_DEBUG<Impl&>(*impl);
+    surfImpl.surface.setGeodesicCacheSize(n); 
+    return *this; 
+}
+
+int CableObstacle::Surface::getGeodesicCacheSize() const { 
+    const Impl& surfImpl = SimTK_DYNAMIC_CAST_DEBUG<const Impl&>(*impl);
+    return surfImpl.surface.getGeodesicCacheSize(); 
+}
+
 //==============================================================================
 //                   CABLE OBSTACLE :: SURFACE :: IMPL
 //==============================================================================
@@ -1418,7 +1559,8 @@ Vec6 CableObstacle::Surface::Impl::calcSurfacePathError
     const Vec3&     xP,     // coordinates of Pi
     const Vec3&     xQ,     // coordinates of Qi
     const UnitVec3& eOut,   // from Qi to Pi+1, in S
-    Geodesic&       current) const
+    Geodesic&       current,
+    int             diagnosticsLevel) const
 {
     surface.continueGeodesic(xP, xQ, previous, GeodesicOptions(), current);
 
@@ -1439,9 +1581,9 @@ Vec6 CableObstacle::Surface::Impl::calcSurfacePathError
     // If length is very short, or geodesic is backwards, use path binormals
     // rather than geodesic binormals.
     const Real ShortLength = Real(1e-3);
-    if (length <= ShortLength)
+    if (length <= ShortLength && diagnosticsLevel >= 2)
         cout << "==> Using short formulation for length=" << length << endl;
-    if (signP < 0 || signQ < 0) { 
+    if ((signP < 0 || signQ < 0) && diagnosticsLevel >= 1) { 
         cout << "==> Backwards geodesic with length=" << length 
              << " eIn*tP=" << ~eIn*tP << " eOut*tQ=" << ~eOut*tQ << endl;
         if (signP != signQ) {
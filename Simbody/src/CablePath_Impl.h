@@ -86,6 +86,76 @@ public:
 };
 
 
+// This is the Jacobian J=D patherr/Dx of a path's errors with respect to its
+// contact point coordinates, and its factorization. Each active surface
+// obstacle owns a 6-element slot in x and in patherr, and its errors depend
+// only on its own coordinates, the Q point of the preceding surface, and the
+// P point of the following one. So J is block tridiagonal with 6x6 blocks
+// and we store only those blocks: D(k) on the diagonal, L(k) to its left and
+// U(k) to its right in block row k.
+//
+// We factor with block Gaussian elimination (the block Thomas algorithm),
+// which is linear rather than cubic in the number of active surfaces. There
+// is no pivoting across block rows, so if one of the eliminated diagonal
+// blocks turns out to be singular we fall back to a dense LU factorization of
+// the assembled matrix, which is what we used to do all the time.
+class PathErrorJacobian {
+public:
+    static const int BlockSize = 6;
+
+    PathErrorJacobian() : nBlocks(0), useDense(false) {}
+
+    // Set the number of unknowns, which must be a multiple of BlockSize.
+    // Block contents are lost.
+    void resize(int nx) {
+        assert(nx % BlockSize == 0);
+        nBlocks = nx / BlockSize;
+        D.resize(nBlocks); L.resize(nBlocks); U.resize(nBlocks);
+        setToZero();
+    }
+
+    void setToZero() {
+        for (int k=0; k < nBlocks; ++k)
+            D[k] = L[k] = U[k] = 0;
+        useDense = false;
+    }
+
+    int size() const {return nBlocks*BlockSize;}
+    int getNumBlocks() const {return nBlocks;}
+
+    // Block row k. L(0) and U(nBlocks-1) lie outside the matrix and must
+    // stay zero.
+    Mat66& updD(int k) {return D[k];}
+    Mat66& updL(int k) {return L[k];}
+    Mat66& updU(int k) {return U[k];}
+
+    // Factor the current contents; call again after changing any blocks.
+    void factor();
+
+    // Solve J x = b using the most recent factorization.
+    void solve(const Vector& b, Vector& x) const;
+
+    // Return true if the last factor() had to fall back to dense LU.
+    bool isUsingDenseFactorization() const {return useDense;}
+
+    // Assemble J as a full nx X nx matrix.
+    Matrix calcDenseMatrix() const;
+
+private:
+    int                 nBlocks;
+    Array_<Mat66>       D, L, U;
+
+    // Block factorization. LU(k) holds the row-pivoted LU factors of the
+    // eliminated diagonal block D(k)-L(k)G(k-1), with its row swaps in 
+    // pivots[6k..6k+5], and G(k) is that block's inverse times U(k).
+    Array_<Mat66>       LU, G;
+    Array_<int>         pivots;
+
+    // Used only if the block factorization failed.
+    bool                useDense;
+    FactorLU            denseLU;
+};
+
 // This is a cache entry for holding a path's calculated position-level 
 // information. At the time it is created we know the total number of
 // obstacles n (including the end points), but not which ones are active. We 
@@ -128,7 +198,7 @@ public:
         geodesics.clear(); geodesics.resize(nas);
         x.clear(); x.resize(nx);
         err.clear(); err.resize(nx);
-        J.clear(); J.resize(nx,nx);
+        J.resize(nx);
     }
 
     // Return the obstacle index of the first active obstacle following the
@@ -209,11 +279,9 @@ public:
     // This is the patherr corresponding to x and is always the same length.
     Vector      err;    // patherr (nx of these)
 
-    // This is J(x) where J=partial(patherr)/partial(x), and its LU 
+    // This is J(x) where J=partial(patherr)/partial(x), and its 
     // factorization for use in solving for length dot at Velocity stage.
-    // TODO: this is banded but we're treating it as full.
-    Matrix      J;      // nx X nx
-    FactorLU    JInv;
+    PathErrorJacobian   J;  // nx X nx, block tridiagonal
 };
 
 
@@ -382,9 +450,9 @@ friend class CableObstacle;
 // counted so that CablePath objects can be multiply referenced.
 class CablePath::Impl {
 public:
-    Impl() : referenceCount(0), cables(0) {}
+    Impl() : referenceCount(0), cables(0), diagnosticsLevel(0) {}
     Impl(CableTrackerSubsystem& cables)
-    :   referenceCount(0), cables(&cables) {}
+    :   referenceCount(0), cables(&cables), diagnosticsLevel(0) {}
     ~Impl() {assert(referenceCount == 0);}
 
     int getNumObstacles() const {return obstacles.size();}
@@ -409,6 +477,10 @@ public:
 
     void solveForInitialCablePath(State& state) const;
 
+    // 0 means silent; see CablePath::setDiagnosticsLevel().
+    void setDiagnosticsLevel(int level) {diagnosticsLevel = level;}
+    int getDiagnosticsLevel() const {return diagnosticsLevel;}
+
     Real getCableLength(const State& state) const {
         const PathPosEntry& posEntry = getPosEntry(state);
         return posEntry.length;
@@ -582,6 +654,8 @@ friend class CablePath;
     EventTriggerByStageIndex    eventIx; // 1st index; one for each surface
     std::map<EventId, CableObstacleIndex> mapEventIdToObstacle;
 
+    int                         diagnosticsLevel;
+
     mutable int                 referenceCount;
 };
 
@@ -691,13 +765,15 @@ public:
 
     // Calculate the surface-local path error due to the given entry/exit
     // points and directions being inconsistent with a geodesic connecting
-    // those points.
+    // those points. Unusual geodesics are reported on std::cout according to
+    // the path's diagnostics level.
     Vec6 calcSurfacePathError(  const Geodesic& previous,
                                 const UnitVec3& entryDir_S,
                                 const Vec3&     xP,
                                 const Vec3&     xQ,
                                 const UnitVec3& exitDir_S,
-                                Geodesic&       next) const;
+                                Geodesic&       next,
+                                int             diagnosticsLevel = 0) const;
 
     // Calculate the 6-vector surface-local path error due to the given 
     // entry/exit points and directions being inconsistent with a geodesic 
@@ -85,3 +85,15 @@ CablePath& CableTrackerSubsystem::
 updCablePath(CablePathIndex cableIx)
 {   return updImpl().updCablePath(cableIx); }
 
+void CableTrackerSubsystem::setUseParallelPathSolves(bool useParallel)
+{   updImpl().useParallelPathSolves = useParallel; }
+
+bool CableTrackerSubsystem::getUseParallelPathSolves() const
+{   return getImpl().useParallelPathSolves; }
+
+void CableTrackerSubsystem::setNumberOfThreads(unsigned numThreads)
+{   updImpl().pathSolveExecutor.setNumberOfThreads(numThreads); }
+
+int CableTrackerSubsystem::getNumberOfThreads() const
+{   return getImpl().pathSolveExecutor.getNumberOfThreads(); }
+
@@ -32,6 +32,7 @@
 #include "simbody/internal/CablePath.h"
 
 #include "CablePath_Impl.h"
+#include "ParallelSlices.h"
 
 #include <cassert>
 #include <iostream>
@@ -48,7 +49,7 @@ class CableTrackerSubsystem::Impl : public Subsystem::Guts {
 public:
 // Constructor registers a default set of Trackers to use with geometry
 // we know about. These can be overridden later.
-Impl() {}
+Impl() : useParallelPathSolves(false) {}
 
 ~Impl() {}
 
@@ -124,11 +125,17 @@ int realizeSubsystemInstanceImpl(const State& state) const override {
     return 0;
 }
 
+// This is where the path solving happens. Each path writes only its own
+// state variables and cache entries, so different paths can be solved
+// concurrently.
 int realizeSubsystemPositionImpl(const State& state) const override {
-    for (CablePathIndex ix(0); ix < cablePaths.size(); ++ix) {
-        const CablePath& path = getCablePath(ix);
-        path.getImpl().realizePosition(state);
-    }
+    const int numPaths = getNumCablePaths();
+    const int nTasks = 
+        useParallelPathSolves && numPaths >= MinPathsForParallelSolve 
+            ? numPaths : 1;
+    auto solvePath = [this, &state](int i)
+    {   getCablePath(CablePathIndex(i)).getImpl().realizePosition(state); };
+    pathSolveExecutor.executeInSlices(numPaths, nTasks, solvePath);
     return 0;
 }
 
@@ -257,6 +264,13 @@ int calcDecorativeGeometryAndAppendImpl
 
 SimTK_DOWNCAST(Impl, Subsystem::Guts);
 
+// Paths are solved in parallel only if enabled and there are at least this
+// many of them.
+static const int MinPathsForParallelSolve = 2;
+
+bool            useParallelPathSolves;
+SliceExecutor   pathSolveExecutor;
+
 private:
 // TOPOLOGY STATE
 Array_<CablePath, CablePathIndex> cablePaths;
@@ -36,6 +36,8 @@ patch analysis methods.
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 #include "simbody/internal/MultibodySystem.h"
 
+#include "ParallelSlices.h"
+
 namespace SimTK {
 
 //==============================================================================
@@ -50,7 +52,8 @@ CompliantContactSubsystemImpl(const ContactTrackerSubsystem& tracker)
 :   ForceSubsystemRep("CompliantContactSubsystem", "0.0.1"),
     m_tracker(tracker), m_transitionVelocity(Real(0.01)), 
     m_ooTransitionVelocity(1/m_transitionVelocity), 
-    m_trackDissipatedEnergy(false), m_defaultGenerator(0) 
+    m_trackDissipatedEnergy(false), m_useParallelForces(false),
+    m_defaultGenerator(0) 
 {   
 }
 
@@ -67,6 +70,15 @@ void setTrackDissipatedEnergy(bool shouldTrack) {
 }
 bool getTrackDissipatedEnergy() const {return m_trackDissipatedEnergy;}
 
+void setUseParallelForces(bool useParallel) 
+{   m_useParallelForces = useParallel; }
+bool getUseParallelForces() const {return m_useParallelForces;}
+
+void setNumberOfThreads(unsigned numThreads)
+{   m_forceExecutor.setNumberOfThreads(numThreads); }
+int getNumberOfThreads() const 
+{   return m_forceExecutor.getNumberOfThreads(); }
+
 int getNumContactForces(const State& s) const {
     ensureForceCacheValid(s);
     const Array_<ContactForce>& forces = getForceCache(s);
@@ -230,6 +242,10 @@ int realizeSubsystemTopologyImpl(State& s) const override {
     // calculate the forces.
     wThis->m_potEnergyCacheIx = allocateLazyCacheEntry(s, 
         Stage::Position, new Value<Real>(NaN));
+    // Scratch space for the parallel force accumulation; kept here so it
+    // needn't be reallocated each time forces are applied.
+    wThis->m_bodyForceAccumIx = allocateLazyCacheEntry(s, 
+        Stage::Topology, new Value<Array_<Vector_<SpatialVec> > >());
 
     // This state variable is used to integrate power to get dissipated
     // energy. Allocate only if requested.
@@ -274,26 +290,58 @@ int realizeSubsystemDynamicsImpl(const State& s) const override {
     // Accumulate the values from the cache into the global arrays.
     const ContactSnapshot& contacts = m_tracker.getActiveContacts(s);
     const Array_<ContactForce>& forces = getForceCache(s);
-    for (unsigned i=0; i < forces.size(); ++i) {
-        const ContactForce& force = forces[i];
-        const Contact& contact = contacts.getContactById(force.getContactId());
-        const MobilizedBody& mobod1 = m_tracker.getMobilizedBody
-                                                (contact.getSurface1());
-        const MobilizedBody& mobod2 = m_tracker.getMobilizedBody
-                                                (contact.getSurface2());
-        const Vec3 r1 = force.getContactPoint() - mobod1.getBodyOriginLocation(s);
-        const Vec3 r2 = force.getContactPoint() - mobod2.getBodyOriginLocation(s);
-        const SpatialVec& F2cpt = force.getForceOnSurface2(); // at contact pt
-        // Shift applied force to body origins.
-        const SpatialVec F2( F2cpt[0] + r2 %  F2cpt[1],  F2cpt[1]);
-        const SpatialVec F1(-F2cpt[0] + r1 % -F2cpt[1], -F2cpt[1]);
-        mobod1.applyBodyForce(s, F1, rigidBodyForces);
-        mobod2.applyBodyForce(s, F2, rigidBodyForces);
+    const int nForces = (int)forces.size();
+    const int nTasks = m_useParallelForces && nForces >= MinForcesForParallel
+                        ? std::min(getNumberOfThreads(), nForces) : 1;
+    if (nTasks == 1) {
+        for (int i=0; i < nForces; ++i)
+            applyContactForce(s, contacts, forces[i], rigidBodyForces);
+        return 0;
     }
 
+    // Each slice of the contact forces is accumulated into its own array of
+    // body forces. Those are added to the global array in slice order so the
+    // result doesn't depend on how the threads happened to be scheduled.
+    Array_<Vector_<SpatialVec> >& partial = updBodyForceAccumulators(s);
+    partial.resize(nTasks);
+    const int nb = rigidBodyForces.size();
+    auto accumulate = [&](int t) {
+        Vector_<SpatialVec>& bodyForces = partial[t];
+        bodyForces.resize(nb);
+        bodyForces.setToZero();
+        const int begin = (t*nForces) / nTasks;
+        const int end   = ((t+1)*nForces) / nTasks;
+        for (int i=begin; i < end; ++i)
+            applyContactForce(s, contacts, forces[i], bodyForces);
+    };
+    m_forceExecutor.executeInSlices(nTasks, nTasks, accumulate);
+    for (int t=0; t < nTasks; ++t)
+        rigidBodyForces += partial[t];
+
     return 0;
 }
 
+// Shift a contact force from the contact point to the two body origins and
+// add the results into the given body force array.
+void applyContactForce(const State&               s,
+                       const ContactSnapshot&     contacts,
+                       const ContactForce&        force,
+                       Vector_<SpatialVec>&       bodyForces) const {
+    const Contact& contact = contacts.getContactById(force.getContactId());
+    const MobilizedBody& mobod1 = m_tracker.getMobilizedBody
+                                            (contact.getSurface1());
+    const MobilizedBody& mobod2 = m_tracker.getMobilizedBody
+                                            (contact.getSurface2());
+    const Vec3 r1 = force.getContactPoint() - mobod1.getBodyOriginLocation(s);
+    const Vec3 r2 = force.getContactPoint() - mobod2.getBodyOriginLocation(s);
+    const SpatialVec& F2cpt = force.getForceOnSurface2(); // at contact pt
+    // Shift applied force to body origins.
+    const SpatialVec F2( F2cpt[0] + r2 %  F2cpt[1],  F2cpt[1]);
+    const SpatialVec F1(-F2cpt[0] + r1 % -F2cpt[1], -F2cpt[1]);
+    mobod1.applyBodyForce(s, F1, bodyForces);
+    mobod2.applyBodyForce(s, F2, bodyForces);
+}
+
 // Potential energy is normally a side effect of force calculation done after
 // Velocity stage. But if only positions are available, we
 // have to calculate forces at zero velocity and then throw away everything
@@ -342,6 +390,9 @@ Real& updPotentialEnergyCache(const State& s) const
 Array_<ContactForce>& updForceCache(const State& s) const
 {   return Value<Array_<ContactForce> >::updDowncast
                                     (updCacheEntry(s,m_forceCacheIx)); }
+Array_<Vector_<SpatialVec> >& updBodyForceAccumulators(const State& s) const
+{   return Value<Array_<Vector_<SpatialVec> > >::updDowncast
+                                    (updCacheEntry(s,m_bodyForceAccumIx)); }
 
 bool isPotentialEnergyCacheValid(const State& s) const
 {   return isCacheValueRealized(s,m_potEnergyCacheIx); }
@@ -356,6 +407,19 @@ void markForceCacheValid(const State& s) const
 
 void ensurePotentialEnergyCacheValid(const State&) const;
 void ensureForceCacheValid(const State&) const;
+void calcContactForce(const State&, const Contact&, ContactForce&) const;
+
+// How many tasks to divide the force generation for nContacts contacts into.
+// Generators can differ enormously in cost (consider a mesh contact vs. a 
+// point contact) so each contact is a separate task when running in 
+// parallel, and the executor deals them out to the threads.
+int getNumForceGenerationTasks(int nContacts) const {
+    return m_useParallelForces && nContacts >= MinForcesForParallel
+            ? nContacts : 1;
+}
+
+// With fewer contacts than this, forces are always calculated serially.
+static const int MinForcesForParallel = 2;
 
 
 
@@ -383,6 +447,11 @@ GeneratorMap                        m_generators;
 // this will either do nothing silently or throw an error.
 ContactForceGenerator*              m_defaultGenerator;
 
+// If set, the force generators are run concurrently for different contacts
+// and their results accumulated in parallel.
+bool                                m_useParallelForces;
+SliceExecutor                       m_forceExecutor;
+
     // TOPOLOGY "CACHE"
 
 // These must be set during realizeTopology and treated as const thereafter.
@@ -391,6 +460,7 @@ ContactForceGenerator*              m_defaultGenerator;
 ZIndex                              m_dissipatedEnergyIx;
 CacheEntryIndex                     m_potEnergyCacheIx;
 CacheEntryIndex                     m_forceCacheIx;
+CacheEntryIndex                     m_bodyForceAccumIx;
 };
 
 void CompliantContactSubsystemImpl::
@@ -419,14 +489,19 @@ ensurePotentialEnergyCacheValid(const State& state) const {
     // results except for the PE.
     const ContactSnapshot& active = m_tracker.getActiveContacts(state);
     const int nContacts = active.getNumContacts();
-    for (int i=0; i<nContacts; ++i) {
+    Array_<Real> contactPE(nContacts);
+    auto calcPE = [&](int i) {
         const Contact& contact = active.getContact(i);
         const ContactForceGenerator& generator = 
             getForceGenerator(contact.getTypeId());
         ContactForce force;
         generator.calcContactForce(state,contact,SpatialVec(Vec3(0)), force);
-        pe += force.getPotentialEnergy();
-    }
+        contactPE[i] = force.getPotentialEnergy();
+    };
+    m_forceExecutor.executeInSlices(nContacts, 
+        getNumForceGenerationTasks(nContacts), calcPE);
+    for (int i=0; i<nContacts; ++i)
+        pe += contactPE[i];
 
     markPotentialEnergyCacheValid(state);
 }
@@ -439,56 +514,75 @@ ensureForceCacheValid(const State& state) const {
     SimTK_STAGECHECK_GE_ALWAYS(getStage(state), Stage::Velocity,
         "CompliantContactSubystemImpl::ensureForceCacheValid()");
 
+    // Each active contact gets its own slot to be filled in by its force
+    // generator, so the slots can be filled concurrently. Then the contacts
+    // that aren't generating any force are squeezed out, preserving order.
     Array_<ContactForce>& forces = updForceCache(state);
     forces.clear();
 
-
     const ContactSnapshot& active = m_tracker.getActiveContacts(state);
     const int nContacts = active.getNumContacts();
+    forces.resize(nContacts);
+    auto calcForce = [&](int i) 
+    {   calcContactForce(state, active.getContact(i), forces[i]); };
+    m_forceExecutor.executeInSlices(nContacts, 
+        getNumForceGenerationTasks(nContacts), calcForce);
+
+    int nValid = 0;
     for (int i=0; i<nContacts; ++i) {
-        const Contact& contact = active.getContact(i);
-        if (contact.getCondition() == Contact::Broken) {
-            // No need to generate forces; this will be gone next time.
+        if (!forces[i].isValid()) 
             continue;
-        }
-        const Transform& X_S1S2 = contact.getTransform();
-        const ContactSurfaceIndex surf1(contact.getSurface1());
-        const ContactSurfaceIndex surf2(contact.getSurface2());
-        const MobilizedBody& mobod1 = m_tracker.getMobilizedBody(surf1);
-        const MobilizedBody& mobod2 = m_tracker.getMobilizedBody(surf2);
-
-        // TODO: These two are expensive (63 flops each) and shouldn't have 
-        // to be recalculated here since we must have used them in creating
-        // the Contact and X_S1S2.
-        const Transform X_GS1 = mobod1.findFrameTransformInGround
-            (state, m_tracker.getContactSurfaceTransform(surf1));
-        const Transform X_GS2 = mobod2.findFrameTransformInGround
-            (state, m_tracker.getContactSurfaceTransform(surf2));
-
-        const SpatialVec V_GS1 = mobod1.findFrameVelocityInGround
-            (state, m_tracker.getContactSurfaceTransform(surf1));
-        const SpatialVec V_GS2 = mobod2.findFrameVelocityInGround
-            (state, m_tracker.getContactSurfaceTransform(surf2));
-
-        // Calculate the relative velocity of S2 in S1, expressed in S1.
-        const SpatialVec V_S1S2 =
-            findRelativeVelocity(X_GS1, V_GS1, X_GS2, V_GS2);   // 51 flops
-
-        const ContactForceGenerator& generator = 
-            getForceGenerator(contact.getTypeId());
-        forces.push_back(); // allocate a new garbage ContactForce
-        // Calculate the contact force measured and expressed in S1.
-        generator.calcContactForce(state, contact, V_S1S2, forces.back());
-        // Re-express the contact force in Ground for later use.
-        if (forces.back().isValid())
-            forces.back().changeFrameInPlace(X_GS1); // switch to Ground
-        else
-            forces.pop_back(); // never mind ...
+        if (nValid != i) 
+            forces[nValid] = forces[i];
+        ++nValid;
     }
+    forces.resize(nValid);
 
     markForceCacheValid(state);
 }
 
+// Calculate the force produced by a single active contact, expressed in 
+// Ground. The force is left invalid if this contact isn't generating one.
+// This may be running concurrently for different contacts so must not modify
+// anything but the supplied force.
+void CompliantContactSubsystemImpl::
+calcContactForce(const State& state, const Contact& contact, 
+                 ContactForce& force) const {
+    if (contact.getCondition() == Contact::Broken) {
+        // No need to generate forces; this will be gone next time.
+        return;
+    }
+    const ContactSurfaceIndex surf1(contact.getSurface1());
+    const ContactSurfaceIndex surf2(contact.getSurface2());
+    const MobilizedBody& mobod1 = m_tracker.getMobilizedBody(surf1);
+    const MobilizedBody& mobod2 = m_tracker.getMobilizedBody(surf2);
+
+    // TODO: These two are expensive (63 flops each) and shouldn't have 
+    // to be recalculated here since we must have used them in creating
+    // the Contact and X_S1S2.
+    const Transform X_GS1 = mobod1.findFrameTransformInGround
+        (state, m_tracker.getContactSurfaceTransform(surf1));
+    const Transform X_GS2 = mobod2.findFrameTransformInGround
+        (state, m_tracker.getContactSurfaceTransform(surf2));
+
+    const SpatialVec V_GS1 = mobod1.findFrameVelocityInGround
+        (state, m_tracker.getContactSurfaceTransform(surf1));
+    const SpatialVec V_GS2 = mobod2.findFrameVelocityInGround
+        (state, m_tracker.getContactSurfaceTransform(surf2));
+
+    // Calculate the relative velocity of S2 in S1, expressed in S1.
+    const SpatialVec V_S1S2 =
+        findRelativeVelocity(X_GS1, V_GS1, X_GS2, V_GS2);   // 51 flops
+
+    const ContactForceGenerator& generator = 
+        getForceGenerator(contact.getTypeId());
+    // Calculate the contact force measured and expressed in S1.
+    generator.calcContactForce(state, contact, V_S1S2, force);
+    // Re-express the contact force in Ground for later use.
+    if (force.isValid())
+        force.changeFrameInPlace(X_GS1); // switch to Ground
+}
+
 
 //==============================================================================
 //                      COMPLIANT CONTACT SUBSYSTEM
@@ -589,6 +683,16 @@ setDissipatedEnergy(State& s, Real energy) const {
 }
 
 
+void CompliantContactSubsystem::setUseParallelForces(bool useParallel)
+{   updImpl().setUseParallelForces(useParallel); }
+bool CompliantContactSubsystem::getUseParallelForces() const
+{   return getImpl().getUseParallelForces(); }
+
+void CompliantContactSubsystem::setNumberOfThreads(unsigned numThreads)
+{   updImpl().setNumberOfThreads(numThreads); }
+int CompliantContactSubsystem::getNumberOfThreads() const
+{   return getImpl().getNumberOfThreads(); }
+
 void CompliantContactSubsystem::adoptForceGenerator
    (ContactForceGenerator* generator)
 {   return updImpl().adoptForceGenerator(this, generator); }
@@ -27,6 +27,9 @@
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 #include "simbody/internal/ContactTrackerSubsystem.h"
 
+#include "DynamicAABBTree.h"
+#include "ParallelSlices.h"
+
 #include <utility>
 using std::pair; using std::make_pair;
 #include <iostream>
@@ -116,6 +119,20 @@ std::ostream& operator<<(std::ostream& o, const PairMap& pm) {
     return o;
 }
 
+// One candidate surface pair for the narrow phase, with the result of
+// tracking it. The surfaces are ordered index1 < index2 as in PairMap;
+// trackSurf1 and trackSurf2 are the same surfaces in the order required by
+// the ContactTracker.
+struct NarrowPhasePair {
+    ContactSurfaceIndex index1, index2;
+    const Contact*      prev;   // null if not currently tracked
+    ContactSurfaceIndex trackSurf1, trackSurf2;
+    Contact             next;   // empty if not in contact
+};
+
+// Below this many surface pairs the narrow phase is always done serially.
+const int MinPairsForParallelNarrowPhase = 2;
+
 } // end of anonymous namespace
 
 namespace SimTK {
@@ -126,7 +143,10 @@ class ContactTrackerSubsystemImpl : public Subsystem::Guts {
 public:
 // Constructor registers a default set of Trackers to use with geometry
 // we know about. These can be overridden later.
-ContactTrackerSubsystemImpl() : m_defaultTracker(0) {
+ContactTrackerSubsystemImpl() 
+:   m_defaultTracker(0), 
+    m_broadPhaseMethod(ContactTrackerSubsystem::SingleAxisSweepAndPrune),
+    m_useParallelNarrowPhase(false) {
     adoptContactTracker(new ContactTracker::HalfSpaceSphere());
     adoptContactTracker(new ContactTracker::SphereSphere());
     adoptContactTracker(new ContactTracker::HalfSpaceEllipsoid());
@@ -224,6 +244,11 @@ int realizeSubsystemTopologyImpl(State& state) const override {
     wThis->m_predictedContactsIx = allocateAutoUpdateDiscreteVariable
         (state, Stage::Dynamics, new Value<ContactSnapshot>(), 
          Stage::Acceleration);  // update depends on accelerations
+    // The broad phase tree is computed from positions when needed. The
+    // previous value is left in place when positions change, so bringing
+    // it up to date only has to move the bubbles that escaped their boxes.
+    wThis->m_broadPhaseTreeIx = allocateLazyCacheEntry
+        (state, Stage::Position, new Value<BoundingSphereTree>());
 
     const SimbodyMatterSubsystem& matter = getMatterSubsystem();
 
@@ -277,19 +302,28 @@ int realizeSubsystemVelocityImpl(const State& state) const override {
 // Adds new pairs to the existing set, if not already present.
 void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
     const int numBubbles = getNumBubbles();
-    
-    // Perform a sweep-and-prune on a single axis to identify potential 
-    // contacts. First, find which axis has the most variation in body 
-    // locations. That is the axis we will use.
-    // TODO: this one-axis method is not good enough in general
-    
-    Vector_<Vec3> centers(numBubbles);
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector_<Vec3> centers = arena.allocateVector<Vec3>(numBubbles);
     for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx) {
         const Bubble&  bubb = m_bubbles[bbx];
         const Surface& surf = m_surfaces[bubb.surface];
         centers[bbx] = surf.mobod->getBodyTransform(state) 
                         * bubb.getCenter();
     }
+
+    if (m_broadPhaseMethod == ContactTrackerSubsystem::BoundingBoxTree)
+        addInTreePairs(state, centers, pairs);
+    else
+        addInSweepAndPrunePairs(centers, pairs);
+}
+
+// Perform a sweep-and-prune on a single axis to identify potential 
+// contacts. First, find which axis has the most variation in body 
+// locations. That is the axis we will use.
+void addInSweepAndPrunePairs(const Vector_<Vec3>& centers, 
+                             PairMap& pairs) const {
+    const int numBubbles = getNumBubbles();
     Vec3 average = mean(centers);
     Vec3 var(0);
     for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx)
@@ -300,7 +334,10 @@ void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
     
     // Find the extent of each bubble along the axis and sort them by 
     // starting location.
-    Array_<BubbleExtent,int> extents(numBubbles);
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Array_<BubbleExtent,int> extents = 
+        arena.allocateArray<BubbleExtent,int>(numBubbles);
     for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx) {
         const Real radius = m_bubbles[bbx].getRadius();
         const Real center = centers[bbx][axis];
@@ -315,9 +352,6 @@ void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
     
     for (int ex1=0; ex1 < numBubbles; ++ex1) {
         const BubbleExtent& extent1 = extents[ex1];
-        const Bubble&       bubb1   = m_bubbles[extent1.index];
-        const Real          radius1 = bubb1.getRadius();
-        const Vec3&         center1 = centers[extent1.index];
 
         // Loop over just the overlapping bubbles.
         for (int ex2(ex1+1); ex2 < numBubbles; ++ex2) {
@@ -327,34 +361,74 @@ void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
 
             // These bubbles do overlap along this axis. See if they are
             // actually touching.
-            const Bubble& bubb2   = m_bubbles[extent2.index];
-            const Real    radius2 = bubb2.getRadius();
-            const Vec3&   center2 = centers[extent2.index];
-            if ((center1-center2).normSqr() > square(radius1+radius2))
-                continue; // nope
-
-            // The bubbles are touching. We'll add the corresponding surfaces
-            // to the narrow-phase list unless there are relevant exclusions.
-            const Surface& surf1 = m_surfaces[bubb1.surface];
-            const Surface& surf2 = m_surfaces[bubb2.surface];
-            // Ignore if on the same body.
-            if (surf1.mobod == surf2.mobod) continue;
-            assert(bubb1.surface != bubb2.surface); // duh!
-            // Ignore if surfaces are in a common clique.
-            if (surf1.surface->isInSameClique(*surf2.surface)) continue;
-            // We'll need to do a narrow phase investigation of these two
-            // surfaces; use the lower-numbered one as the index to avoid
-            // duplicates.
-            ContactSurfaceIndex low=bubb1.surface, high=bubb2.surface;
-            if (low > high) std::swap(low,high);
-            ContactSurfaceSet& surfSet = pairs[low];
-            // Insert this pair with null Contact if the pair isn't already
-            // in the PairMap.
-            surfSet.insert(make_pair(high,(Contact*)0));
+            addPairIfTouching(extent1.index, extent2.index, centers, pairs);
         }
     }
 }
 
+// Realize the broad phase tree cache entry for the current bubble locations
+// if necessary. Only bubbles that have moved outside the slack we gave them 
+// last time cause changes to the tree.
+const BoundingSphereTree& 
+ensureBroadPhaseTreeRealized(const State& state, 
+                             const Vector_<Vec3>& centers) const {
+    if (!isCacheValueRealized(state, m_broadPhaseTreeIx)) {
+        const int numBubbles = getNumBubbles();
+        BoundingSphereTree& tree = Value<BoundingSphereTree>::updDowncast
+            (updCacheEntry(state, m_broadPhaseTreeIx)).upd();
+        tree.resize(numBubbles);
+        for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx)
+            tree.setSphere(bbx, centers[bbx], m_bubbles[bbx].getRadius());
+        markCacheValueRealized(state, m_broadPhaseTreeIx);
+    }
+    return Value<BoundingSphereTree>::downcast
+        (getCacheEntry(state, m_broadPhaseTreeIx));
+}
+
+// Use the broad phase tree to find overlapping bubbles.
+void addInTreePairs(const State& state, const Vector_<Vec3>& centers,
+                    PairMap& pairs) const {
+    const BoundingSphereTree& tree = 
+        ensureBroadPhaseTreeRealized(state, centers);
+
+    // The boxes overlap; see whether the bubbles actually touch.
+    auto reportPair = [&](int bbx1, int bbx2) {
+        addPairIfTouching(BubbleIndex(bbx1), BubbleIndex(bbx2), 
+                          centers, pairs);
+    };
+    tree.findPairs(reportPair);
+}
+
+// Given two bubbles whose bounds overlap, check whether they are actually
+// touching. If so, add the corresponding surfaces to the narrow-phase list
+// unless there are relevant exclusions.
+void addPairIfTouching(BubbleIndex bbx1, BubbleIndex bbx2,
+                       const Vector_<Vec3>& centers, PairMap& pairs) const {
+    const Bubble& bubb1   = m_bubbles[bbx1];
+    const Bubble& bubb2   = m_bubbles[bbx2];
+    const Real    radius1 = bubb1.getRadius();
+    const Real    radius2 = bubb2.getRadius();
+    if ((centers[bbx1]-centers[bbx2]).normSqr() > square(radius1+radius2))
+        return; // nope
+
+    const Surface& surf1 = m_surfaces[bubb1.surface];
+    const Surface& surf2 = m_surfaces[bubb2.surface];
+    // Ignore if on the same body.
+    if (surf1.mobod == surf2.mobod) return;
+    assert(bubb1.surface != bubb2.surface); // duh!
+    // Ignore if surfaces are in a common clique.
+    if (surf1.surface->isInSameClique(*surf2.surface)) return;
+    // We'll need to do a narrow phase investigation of these two
+    // surfaces; use the lower-numbered one as the index to avoid
+    // duplicates.
+    ContactSurfaceIndex low=bubb1.surface, high=bubb2.surface;
+    if (low > high) std::swap(low,high);
+    ContactSurfaceSet& surfSet = pairs[low];
+    // Insert this pair with null Contact if the pair isn't already
+    // in the PairMap.
+    surfSet.insert(make_pair(high,(Contact*)0));
+}
+
 // Call this any time after positions are known, to ensure that the active
 // contact set has been updated for those positions. We can use three
 // sources of information to compute the update:
@@ -408,74 +482,101 @@ void ensureActiveContactsUpdated(const State& state) const {
     addInBroadPhasePairs(state, interesting);
     //cout << "Interesting pairs:\n" << interesting << "\n";
 
+    // Flatten the interesting pairs into a list so that the narrow phase can
+    // be divided among threads. The results are merged below in list order,
+    // which is the order the pairs would have been processed serially.
+    Array_<NarrowPhasePair> work;
     PairMap::const_iterator p = interesting.begin();
     for (; p != interesting.end(); ++p) {
-        const ContactSurfaceIndex index1 = p->first;
-        const Transform transform1 = 
-            m_surfaces[index1].mobod->getBodyTransform(state)
-                * m_surfaces[index1].X_BS;
-        const ContactGeometry& geom1 = m_surfaces[index1].surface->getShape();
-        const ContactGeometryTypeId typeId1 = geom1.getTypeId();
-
         const ContactSurfaceSet& others = p->second;
         ContactSurfaceSet::const_iterator q = others.begin();
         for (; q != others.end(); ++q) {
-            const ContactSurfaceIndex index2 = q->first;
-            const Transform transform2 = 
-                m_surfaces[index2].mobod->getBodyTransform(state)
-                    * m_surfaces[index2].X_BS;
-            const ContactGeometry& geom2 = 
-                m_surfaces[index2].surface->getShape();
-            const ContactGeometryTypeId typeId2 = geom2.getTypeId();
-            if (!hasContactTracker(typeId1,typeId2))
-                continue; // No algorithm available for detecting collisions between these two objects.
-            bool mustReverse;
-            const ContactTracker& tracker = 
-                getContactTracker(typeId1, typeId2, mustReverse);
-
-            // Put the surfaces in the order required by the tracker.
-            const ContactSurfaceIndex trackSurf1 = (mustReverse? index2:index1);
-            const ContactSurfaceIndex trackSurf2 = (mustReverse? index1:index2);
-
-            UntrackedContact untracked; // empty handle in case we need it
-            const Contact* prev = q->second;
-            if (prev && prev->getCondition() == Contact::Broken)
-                prev = 0; // that contact expired
-            if (!prev) { 
-                untracked = UntrackedContact(trackSurf1, trackSurf2);
-                prev = &untracked;
-            }
-            Contact next; // empty handle
-            if (mustReverse)
-                tracker.trackContact
-                   (*prev, transform2,geom2, transform1,geom1, 0/*TODO*/, next);
-            else
-                tracker.trackContact
-                   (*prev, transform1,geom1, transform2,geom2, 0/*TODO*/, next);
-
-            if (!next.isEmpty()) {
-                next.setSurfaces(trackSurf1,trackSurf2);
-                next.setContactId(prev->getCondition()==Contact::Untracked
-                                    ? Contact::createNewContactId()
-                                    : prev->getContactId()); // persistent
-                if (   prev->getCondition()==Contact::Untracked
-                    || prev->getCondition()==Contact::Anticipated)
-                    next.setCondition(Contact::NewContact);
-                else { // was NewContact or Ongoing; now Ongoing or Broken
-                    assert(prev->getCondition()==Contact::NewContact
-                           || prev->getCondition()==Contact::Ongoing);
-                    if (next.getTypeId() != BrokenContact::classTypeId())
-                        next.setCondition(Contact::Ongoing);
-                    // Condition will already by Broken for a BrokenContact
-                }
-                nextActive.adoptContact(next);
-            }
+            work.push_back(); // default construct
+            NarrowPhasePair& pair = work.back();
+            pair.index1 = p->first;
+            pair.index2 = q->first;
+            pair.prev   = q->second;
+            if (pair.prev && pair.prev->getCondition() == Contact::Broken)
+                pair.prev = 0; // that contact expired
         }
     }
 
+    const int numPairs = (int)work.size();
+    const int nTasks = 
+        m_useParallelNarrowPhase && numPairs >= MinPairsForParallelNarrowPhase
+            ? numPairs : 1;
+    auto trackPair = [this, &state, &work](int i) 
+    {   trackNarrowPhasePair(state, work[i]); };
+    m_narrowPhaseExecutor.executeInSlices(numPairs, nTasks, trackPair);
+
+    // Contact ids are handed out here, serially, so they don't depend on
+    // the order in which the threads finished.
+    for (NarrowPhasePair& pair : work) {
+        Contact& next = pair.next;
+        if (next.isEmpty())
+            continue;
+        const Contact::Condition prevCondition = 
+            pair.prev ? pair.prev->getCondition() : Contact::Untracked;
+        next.setSurfaces(pair.trackSurf1,pair.trackSurf2);
+        next.setContactId(prevCondition==Contact::Untracked
+                            ? Contact::createNewContactId()
+                            : pair.prev->getContactId()); // persistent
+        if (   prevCondition==Contact::Untracked
+            || prevCondition==Contact::Anticipated)
+            next.setCondition(Contact::NewContact);
+        else { // was NewContact or Ongoing; now Ongoing or Broken
+            assert(prevCondition==Contact::NewContact
+                   || prevCondition==Contact::Ongoing);
+            if (next.getTypeId() != BrokenContact::classTypeId())
+                next.setCondition(Contact::Ongoing);
+            // Condition will already by Broken for a BrokenContact
+        }
+        nextActive.adoptContact(next);
+    }
+
     markDiscreteVarUpdateValueRealized(state, m_activeContactsIx);
 }
 
+// Run the narrow phase ContactTracker for one pair of surfaces, leaving the
+// result in pair.next (empty if they are not in contact). This must not
+// modify anything but the given pair since it may be running concurrently
+// with other pairs.
+void trackNarrowPhasePair(const State& state, NarrowPhasePair& pair) const {
+    const ContactSurfaceIndex index1 = pair.index1, index2 = pair.index2;
+    const ContactGeometry& geom1 = m_surfaces[index1].surface->getShape();
+    const ContactGeometry& geom2 = m_surfaces[index2].surface->getShape();
+    const ContactGeometryTypeId typeId1 = geom1.getTypeId();
+    const ContactGeometryTypeId typeId2 = geom2.getTypeId();
+    if (!hasContactTracker(typeId1,typeId2))
+        return; // No algorithm available for detecting collisions between these two objects.
+    const Transform transform1 = 
+        m_surfaces[index1].mobod->getBodyTransform(state)
+            * m_surfaces[index1].X_BS;
+    const Transform transform2 = 
+        m_surfaces[index2].mobod->getBodyTransform(state)
+            * m_surfaces[index2].X_BS;
+    bool mustReverse;
+    const ContactTracker& tracker = 
+        getContactTracker(typeId1, typeId2, mustReverse);
+
+    // Put the surfaces in the order required by the tracker.
+    pair.trackSurf1 = (mustReverse? index2:index1);
+    pair.trackSurf2 = (mustReverse? index1:index2);
+
+    UntrackedContact untracked; // empty handle in case we need it
+    const Contact* prev = pair.prev;
+    if (!prev) { 
+        untracked = UntrackedContact(pair.trackSurf1, pair.trackSurf2);
+        prev = &untracked;
+    }
+    if (mustReverse)
+        tracker.trackContact
+           (*prev, transform2,geom2, transform1,geom1, 0/*TODO*/, pair.next);
+    else
+        tracker.trackContact
+           (*prev, transform1,geom1, transform2,geom2, 0/*TODO*/, pair.next);
+}
+
 // Call this any time after accelerations are known, to ensure that the
 // predicted contact set has been updated for new velocities and accelerations.
 // We can use three sources of information to compute the update:
@@ -581,6 +682,10 @@ friend class ContactTrackerSubsystem;
 // delete it when replacing or destructing.
 TrackerMap          m_contactTrackers;
 ContactTracker*     m_defaultTracker;
+ContactTrackerSubsystem::BroadPhaseMethod
+                    m_broadPhaseMethod;
+bool                m_useParallelNarrowPhase;
+SliceExecutor       m_narrowPhaseExecutor;
 
     // TOPOLOGY CACHE
 // The pair is the first assigned index, and the number of contact surfaces
@@ -591,6 +696,7 @@ Array_<Surface,ContactSurfaceIndex>     m_surfaces;
 Array_<Bubble,BubbleIndex>              m_bubbles;
 DiscreteVariableIndex                   m_activeContactsIx;
 DiscreteVariableIndex                   m_predictedContactsIx;
+CacheEntryIndex                         m_broadPhaseTreeIx;
 };
 
 } // namespace SimTK
@@ -654,6 +760,29 @@ getContactSurfaceIndex(MobilizedBodyIndex mobod,
                        int contactSurfaceOrdinal) const
 {   return getImpl().getContactSurfaceIndex(mobod,contactSurfaceOrdinal); }
 
+void ContactTrackerSubsystem::
+setBroadPhaseMethod(BroadPhaseMethod method) {
+    invalidateSubsystemTopologyCache();
+    updImpl().m_broadPhaseMethod = method;
+}
+
+ContactTrackerSubsystem::BroadPhaseMethod ContactTrackerSubsystem::
+getBroadPhaseMethod() const
+{   return getImpl().m_broadPhaseMethod; }
+
+void ContactTrackerSubsystem::
+setUseParallelNarrowPhase(bool useParallel)
+{   updImpl().m_useParallelNarrowPhase = useParallel; }
+
+bool ContactTrackerSubsystem::getUseParallelNarrowPhase() const
+{   return getImpl().m_useParallelNarrowPhase; }
+
+void ContactTrackerSubsystem::setNumberOfThreads(unsigned numThreads)
+{   updImpl().m_narrowPhaseExecutor.setNumberOfThreads(numThreads); }
+
+int ContactTrackerSubsystem::getNumberOfThreads() const
+{   return getImpl().m_narrowPhaseExecutor.getNumberOfThreads(); }
+
 void ContactTrackerSubsystem::
 adoptContactTracker(ContactTracker* tracker)
 {   updImpl().adoptContactTracker(tracker); }
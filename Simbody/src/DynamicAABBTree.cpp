@@ -0,0 +1,276 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+
+namespace SimTK {
+
+int DynamicAABBTree::
+insertLeaf(const Vec3& lo, const Vec3& hi, Real margin, int userData) {
+    const int leaf = allocateNode();
+    Node& node = m_nodes[leaf];
+    node.lo = lo - margin;
+    node.hi = hi + margin;
+    node.child1 = node.child2 = -1;
+    node.height = 0;
+    node.userData = userData;
+    insertIntoTree(leaf);
+    ++m_numLeaves;
+    return leaf;
+}
+
+void DynamicAABBTree::removeLeaf(int leaf) {
+    assert(0 <= leaf && leaf < (int)m_nodes.size());
+    assert(m_nodes[leaf].isLeaf() && m_nodes[leaf].height == 0);
+    removeFromTree(leaf);
+    freeNode(leaf);
+    --m_numLeaves;
+}
+
+bool DynamicAABBTree::
+updateLeaf(int leaf, const Vec3& lo, const Vec3& hi, Real margin) {
+    assert(0 <= leaf && leaf < (int)m_nodes.size());
+    Node& node = m_nodes[leaf];
+    assert(node.isLeaf() && node.height == 0);
+    if (   node.lo[0] <= lo[0] && node.lo[1] <= lo[1] && node.lo[2] <= lo[2]
+        && hi[0] <= node.hi[0] && hi[1] <= node.hi[1] && hi[2] <= node.hi[2])
+        return false; // still inside the fat box
+
+    removeFromTree(leaf);
+    node.lo = lo - margin;
+    node.hi = hi + margin;
+    insertIntoTree(leaf);
+    return true;
+}
+
+int DynamicAABBTree::allocateNode() {
+    if (m_freeList < 0) {
+        m_nodes.push_back(); // default construct
+        return (int)m_nodes.size() - 1;
+    }
+    const int i = m_freeList;
+    m_freeList = m_nodes[i].parent;
+    return i;
+}
+
+void DynamicAABBTree::freeNode(int i) {
+    Node& node = m_nodes[i];
+    node.child1 = node.child2 = -1;
+    node.height = -1; // marks as free
+    node.userData = -1;
+    node.parent = m_freeList;
+    m_freeList = i;
+}
+
+//------------------------------------------------------------------------------
+//                             INSERT INTO TREE
+//------------------------------------------------------------------------------
+// Walk down from the root choosing at each level whichever is cheapest: pair
+// the new leaf with the current node right here, or descend into one of the
+// current node's children. The cost is the total surface area of the boxes
+// that would have to be created or enlarged.
+void DynamicAABBTree::insertIntoTree(int leaf) {
+    if (m_root < 0) {
+        m_root = leaf;
+        m_nodes[leaf].parent = -1;
+        return;
+    }
+
+    Vec3 lo, hi;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const Node& node = m_nodes[index];
+        unionOf(node, m_nodes[leaf], lo, hi);
+        const Real combined  = calcCost(lo, hi);
+        const Real costHere  = 2*combined;
+        const Real inherited = 2*(combined - calcCost(node.lo, node.hi));
+
+        Real childCost[2];
+        const int children[2] = {node.child1, node.child2};
+        for (int c=0; c < 2; ++c) {
+            const Node& child = m_nodes[children[c]];
+            unionOf(child, m_nodes[leaf], lo, hi);
+            childCost[c] = calcCost(lo, hi) + inherited;
+            if (!child.isLeaf())
+                childCost[c] -= calcCost(child.lo, child.hi);
+        }
+
+        if (costHere < childCost[0] && costHere < childCost[1])
+            break;
+        index = childCost[0] < childCost[1] ? children[0] : children[1];
+    }
+
+    // Make a new parent for the chosen sibling and the new leaf. Careful --
+    // allocating may move the nodes.
+    const int sibling   = index;
+    const int newParent = allocateNode();
+    const int oldParent = m_nodes[sibling].parent;
+    Node& parent = m_nodes[newParent];
+    parent.parent   = oldParent;
+    parent.child1   = sibling;
+    parent.child2   = leaf;
+    parent.height   = m_nodes[sibling].height + 1;
+    parent.userData = -1;
+    unionOf(m_nodes[sibling], m_nodes[leaf], parent.lo, parent.hi);
+    m_nodes[sibling].parent = m_nodes[leaf].parent = newParent;
+
+    if (oldParent < 0)
+        m_root = newParent;
+    else if (m_nodes[oldParent].child1 == sibling)
+        m_nodes[oldParent].child1 = newParent;
+    else
+        m_nodes[oldParent].child2 = newParent;
+
+    refitAncestors(newParent);
+}
+
+//------------------------------------------------------------------------------
+//                             REMOVE FROM TREE
+//------------------------------------------------------------------------------
+// Detach a leaf; its parent is freed and the leaf's sibling takes the parent's
+// place. The leaf node itself is left allocated.
+void DynamicAABBTree::removeFromTree(int leaf) {
+    if (leaf == m_root) {
+        m_root = -1;
+        return;
+    }
+
+    const int parent  = m_nodes[leaf].parent;
+    const int grand   = m_nodes[parent].parent;
+    const int sibling = m_nodes[parent].child1 == leaf
+                            ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    m_nodes[sibling].parent = grand;
+    freeNode(parent);
+    if (grand < 0) {
+        m_root = sibling;
+        return;
+    }
+    if (m_nodes[grand].child1 == parent) m_nodes[grand].child1 = sibling;
+    else                                 m_nodes[grand].child2 = sibling;
+    refitAncestors(grand);
+}
+
+// Starting at node i, rebalance and recalculate the box and height of each
+// node on the way to the root.
+void DynamicAABBTree::refitAncestors(int i) {
+    while (i >= 0) {
+        i = rotateIfUnbalanced(i);
+        Node& node = m_nodes[i];
+        const Node& c1 = m_nodes[node.child1];
+        const Node& c2 = m_nodes[node.child2];
+        node.height = 1 + std::max(c1.height, c2.height);
+        unionOf(c1, c2, node.lo, node.hi);
+        i = node.parent;
+    }
+}
+
+//------------------------------------------------------------------------------
+//                           ROTATE IF UNBALANCED
+//------------------------------------------------------------------------------
+// If the heights of internal node A's children B and C differ by more than 1,
+// promote the taller one (say C, with children F and G) to A's position. A
+// keeps B and adopts the shorter of F and G; C keeps the taller one and
+// adopts A. Returns the node that is now at A's former position.
+int DynamicAABBTree::rotateIfUnbalanced(int a) {
+    Node& A = m_nodes[a];
+    if (A.isLeaf())
+        return a;
+
+    // A's own height may be stale here; its children's are up to date.
+    const int balance = m_nodes[A.child2].height - m_nodes[A.child1].height;
+    if (-1 <= balance && balance <= 1)
+        return a;
+
+    // Arrange that "up" is the taller child and "stay" the other.
+    const bool rightHeavy = balance > 0;
+    const int up   = rightHeavy ? A.child2 : A.child1;
+    const int stay = rightHeavy ? A.child1 : A.child2;
+    Node& U = m_nodes[up];
+    const int f = U.child1, g = U.child2;
+    const bool fTaller = m_nodes[f].height > m_nodes[g].height;
+    const int keep  = fTaller ? f : g;
+    const int adopt = fTaller ? g : f;
+
+    // U replaces A under A's parent.
+    U.parent = A.parent;
+    if (U.parent < 0)
+        m_root = up;
+    else if (m_nodes[U.parent].child1 == a)
+        m_nodes[U.parent].child1 = up;
+    else
+        m_nodes[U.parent].child2 = up;
+
+    // A now has children stay and adopt, and becomes a child of U.
+    A.parent = up;
+    if (rightHeavy) A.child2 = adopt; else A.child1 = adopt;
+    m_nodes[adopt].parent = a;
+    unionOf(m_nodes[stay], m_nodes[adopt], A.lo, A.hi);
+    A.height = 1 + std::max(m_nodes[stay].height, m_nodes[adopt].height);
+
+    U.child1 = a;
+    U.child2 = keep;
+    unionOf(A, m_nodes[keep], U.lo, U.hi);
+    U.height = 1 + std::max(A.height, m_nodes[keep].height);
+    return up;
+}
+
+void DynamicAABBTree::validate() const {
+    int nLeaves = 0;
+    if (m_root >= 0) {
+        SimTK_ASSERT_ALWAYS(m_nodes[m_root].parent == -1,
+            "DynamicAABBTree::validate(): root has a parent.");
+        Array_<int> stack(1, m_root);
+        while (!stack.empty()) {
+            const int i = stack.back(); stack.pop_back();
+            const Node& node = m_nodes[i];
+            if (node.isLeaf()) {
+                SimTK_ASSERT_ALWAYS(node.height == 0,
+                    "DynamicAABBTree::validate(): bad leaf height.");
+                ++nLeaves;
+                continue;
+            }
+            const Node& c1 = m_nodes[node.child1];
+            const Node& c2 = m_nodes[node.child2];
+            SimTK_ASSERT_ALWAYS(c1.parent == i && c2.parent == i,
+                "DynamicAABBTree::validate(): bad parent link.");
+            SimTK_ASSERT_ALWAYS(
+                node.height == 1 + std::max(c1.height, c2.height),
+                "DynamicAABBTree::validate(): bad node height.");
+            Vec3 lo, hi;
+            unionOf(c1, c2, lo, hi);
+            SimTK_ASSERT_ALWAYS(lo == node.lo && hi == node.hi,
+                "DynamicAABBTree::validate(): box doesn't match children.");
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+    SimTK_ASSERT_ALWAYS(nLeaves == m_numLeaves,
+        "DynamicAABBTree::validate(): wrong number of leaves.");
+}
+
+} // namespace SimTK
@@ -0,0 +1,257 @@
+#ifndef SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
+#define SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include <cassert>
+
+namespace SimTK {
+
+//==============================================================================
+//                            DYNAMIC AABB TREE
+//==============================================================================
+// This is a persistent bounding volume hierarchy of axis-aligned boxes used
+// for broad phase contact detection. Each leaf holds an integer supplied by
+// the caller (e.g. a bubble index) and a "fat" box that encloses the object's
+// actual bounds with some margin. As the objects move, updateLeaf() restructures
+// the tree only for those whose bounds have escaped their fat boxes, so in a
+// typical time step very little work is done beyond the overlap queries.
+//
+// Leaves are inserted by walking down from the root toward the sibling that
+// gives the least increase in total box surface area, and AVL-style rotations
+// on the way back up keep the tree from getting much taller than necessary.
+// (The surface area heuristic can pair a leaf with a large subtree, so the
+// tree is not strictly height balanced.) Node storage is pooled in an array
+// with a free list so a tree that is updated every step stops allocating heap
+// once it reaches its working size.
+//
+// Boxes must be finite; callers should handle unbounded objects (such as half
+// spaces) separately.
+class DynamicAABBTree {
+public:
+    DynamicAABBTree() {clear();}
+
+    // Remove all leaves; heap space is retained.
+    void clear() {
+        m_nodes.clear();
+        m_root = m_freeList = -1;
+        m_numLeaves = 0;
+    }
+
+    // Add a leaf whose box is [lo,hi] expanded by margin in every direction.
+    // Returns a leaf id that is used to refer to this leaf subsequently; it
+    // remains valid until the leaf is removed.
+    int insertLeaf(const Vec3& lo, const Vec3& hi, Real margin, int userData);
+
+    // Remove a leaf that was returned by insertLeaf().
+    void removeLeaf(int leaf);
+
+    // Report new bounds for a leaf. If [lo,hi] is still inside the leaf's
+    // fat box nothing happens and we return false. Otherwise the leaf gets
+    // a new fat box with the given margin and is reinserted; then we return
+    // true.
+    bool updateLeaf(int leaf, const Vec3& lo, const Vec3& hi, Real margin);
+
+    // Call f(userData) for every leaf whose fat box overlaps [lo,hi]. This
+    // only reads the tree, so concurrent queries are fine.
+    template <class F>
+    void findOverlaps(const Vec3& lo, const Vec3& hi, F& f) const {
+        auto report = [this, &f](int leaf) {f(m_nodes[leaf].userData);};
+        findOverlapsById(lo, hi, report);
+    }
+
+    // Call f(userData1, userData2) once for each pair of distinct leaves
+    // whose fat boxes overlap. The order of the pairs and of the two
+    // arguments is unspecified.
+    template <class F>
+    void findAllPairs(F& f) const {
+        for (int leaf=0; leaf < (int)m_nodes.size(); ++leaf) {
+            const Node& node = m_nodes[leaf];
+            if (!node.isLeaf() || node.height < 0) continue; // free node
+            PairReporter<F> reporter(leaf, m_nodes, f);
+            findOverlapsById(node.lo, node.hi, reporter);
+        }
+    }
+
+    int getNumLeaves() const {return m_numLeaves;}
+    // Height of the tree; a lone leaf has height 0 and an empty tree -1.
+    int getHeight() const {return m_root < 0 ? -1 : m_nodes[m_root].height;}
+    int getUserData(int leaf) const {return m_nodes[leaf].userData;}
+    const Vec3& getFatLo(int leaf) const {return m_nodes[leaf].lo;}
+    const Vec3& getFatHi(int leaf) const {return m_nodes[leaf].hi;}
+
+    // Check internal consistency of parent links, heights, and boxes; for
+    // debugging and testing. Throws if something is wrong.
+    void validate() const;
+
+    static bool boxesOverlap(const Vec3& lo1, const Vec3& hi1,
+                             const Vec3& lo2, const Vec3& hi2) {
+        return lo1[0] <= hi2[0] && lo2[0] <= hi1[0]
+            && lo1[1] <= hi2[1] && lo2[1] <= hi1[1]
+            && lo1[2] <= hi2[2] && lo2[2] <= hi1[2];
+    }
+
+private:
+    struct Node {
+        bool isLeaf() const {return child1 < 0;}
+        Vec3    lo, hi;         // fat box for a leaf, union of children else
+        int     parent;         // or next free node when on the free list
+        int     child1, child2; // -1 for a leaf
+        int     height;         // leaf is 0; -1 marks a free node
+        int     userData;
+    };
+
+    // Reports leaf pairs (self,other) with self < other so each overlapping
+    // pair is seen once.
+    template <class F>
+    class PairReporter {
+    public:
+        PairReporter(int self, const Array_<Node>& nodes, F& f)
+        :   self(self), nodes(nodes), f(f) {}
+        void operator()(int other) const {
+            if (other > self) f(nodes[self].userData, nodes[other].userData);
+        }
+    private:
+        int                 self;
+        const Array_<Node>& nodes;
+        F&                  f;
+    };
+
+    // Same as findOverlaps() but reports node ids rather than user data.
+    // The traversal stack comes from the calling thread's scratch arena. A
+    // depth-first walk holds at most one pending sibling per level plus the
+    // two children just pushed, so height+1 entries are enough.
+    template <class F>
+    void findOverlapsById(const Vec3& lo, const Vec3& hi, F& f) const {
+        if (m_root < 0) return;
+        ScratchArena& arena = ScratchArena::getThreadArena();
+        ScratchArena::Scope scope(arena);
+        const int maxDepth = m_nodes[m_root].height + 1;
+        int* stack = arena.allocate<int>(maxDepth);
+        int n = 0;
+        stack[n++] = m_root;
+        while (n) {
+            const int i = stack[--n];
+            const Node& node = m_nodes[i];
+            if (!boxesOverlap(node.lo, node.hi, lo, hi)) continue;
+            if (node.isLeaf()) f(i);
+            else {
+                assert(n+2 <= maxDepth);
+                stack[n++] = node.child1; stack[n++] = node.child2;
+            }
+        }
+    }
+
+    // Half the surface area of a box; used as the insertion cost.
+    static Real calcCost(const Vec3& lo, const Vec3& hi) {
+        const Vec3 d = hi - lo;
+        return d[0]*d[1] + d[1]*d[2] + d[2]*d[0];
+    }
+    static void unionOf(const Node& a, const Node& b, Vec3& lo, Vec3& hi) {
+        for (int k=0; k < 3; ++k) {
+            lo[k] = std::min(a.lo[k], b.lo[k]);
+            hi[k] = std::max(a.hi[k], b.hi[k]);
+        }
+    }
+
+    int allocateNode();
+    void freeNode(int i);
+    void insertIntoTree(int leaf);
+    void removeFromTree(int leaf);
+    void refitAncestors(int i);
+    int rotateIfUnbalanced(int i);
+
+    Array_<Node>        m_nodes;
+    int                 m_root;
+    int                 m_freeList;
+    int                 m_numLeaves;
+};
+
+
+
+//==============================================================================
+//                          BOUNDING SPHERE TREE
+//==============================================================================
+// Broad phase for a fixed-size collection of bounding spheres numbered 0..n-1,
+// such as the contact subsystems use. Each sphere with a finite radius gets a
+// leaf in a DynamicAABBTree whose box is padded by a fraction of the radius.
+// Unbounded spheres (infinite radius, as for a half space) are kept out of the
+// tree and are reported as potentially overlapping with every other sphere.
+//
+// Typical use is to keep one of these around from step to step (e.g. in a
+// State cache entry), call setSphere() for every sphere when positions change,
+// then call findPairs() and apply an exact test to the reported pairs.
+class BoundingSphereTree {
+public:
+    // If n differs from the current number of spheres, start over with n
+    // spheres. Otherwise this does nothing.
+    void resize(int n) {
+        if (n == (int)m_leafOf.size()) return;
+        m_tree.clear();
+        m_leafOf.clear(); m_leafOf.resize(n, -1);
+    }
+
+    // Supply the current location and size of sphere i. This must be done
+    // for every sphere before the first call to findPairs().
+    void setSphere(int i, const Vec3& center, Real radius) {
+        int& leaf = m_leafOf[i];
+        if (radius == Infinity) {
+            if (leaf >= 0) {m_tree.removeLeaf(leaf); leaf = -1;}
+            return;
+        }
+        const Real margin = MarginFraction*radius;
+        if (leaf < 0) leaf = m_tree.insertLeaf(center-radius, center+radius,
+                                               margin, i);
+        else m_tree.updateLeaf(leaf, center-radius, center+radius, margin);
+    }
+
+    // Call f(i,j) once for each pair of distinct spheres that might overlap.
+    template <class F>
+    void findPairs(F& f) const {
+        m_tree.findAllPairs(f);
+        const int n = (int)m_leafOf.size();
+        for (int i=0; i < n; ++i) {
+            if (m_leafOf[i] >= 0) continue;
+            for (int j=0; j < n; ++j)
+                if (j != i && (m_leafOf[j] >= 0 || j > i)) f(i,j);
+        }
+    }
+
+    int getNumSpheres() const {return (int)m_leafOf.size();}
+    const DynamicAABBTree& getTree() const {return m_tree;}
+
+    // Slack given to a sphere's leaf box, as a fraction of its radius, so
+    // that small motions don't require any change to the tree.
+    static constexpr Real MarginFraction = Real(0.1);
+
+private:
+    DynamicAABBTree m_tree;
+    Array_<int>     m_leafOf;   // leaf id for each sphere; -1 if unbounded
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
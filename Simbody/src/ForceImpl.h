@@ -52,6 +52,12 @@ public:
     virtual bool shouldBeParallelIfPossible() const{
         return false;
     }
+    // Optionally report the only bodies to which calcForce() applies body
+    // forces, for a force that applies no particle or mobility forces. Return
+    // false if that isn't known.
+    virtual bool getBodiesAffected(Array_<MobilizedBodyIndex>& bodies) const {
+        return false;
+    }
     ForceIndex getForceIndex() const {return index;}
     const GeneralForceSubsystem& getForceSubsystem() const 
     {   assert(forces); return *forces; }
@@ -620,6 +626,9 @@ public:
     bool shouldBeParallelIfPossible() const override {
         return implementation->shouldBeParallelIfPossible();
     }
+    bool getBodiesAffected(Array_<MobilizedBodyIndex>& bodies) const override {
+        return implementation->getBodiesAffected(bodies);
+    }
     ~CustomImpl() {
         delete implementation;
     }
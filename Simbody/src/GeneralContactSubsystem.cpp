@@ -28,6 +28,8 @@
 #include "simbody/internal/MultibodySystem.h"
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 
+#include "DynamicAABBTree.h"
+
 #include <algorithm>
 
 namespace SimTK {
@@ -64,7 +66,7 @@ public:
 //==============================================================================
 class GeneralContactSubsystemImpl : public Subsystem::Guts {
 public:
-    GeneralContactSubsystemImpl() {}
+    GeneralContactSubsystemImpl() : useBoundingBoxTree(false) {}
 
     GeneralContactSubsystemImpl* cloneImpl() const override {
         return new GeneralContactSubsystemImpl(*this);
@@ -126,6 +128,15 @@ public:
         return sets[set].transforms[index];
     }
 
+    void setUseBoundingBoxTree(bool useTree) {
+        invalidateSubsystemTopologyCache();
+        useBoundingBoxTree = useTree;
+    }
+
+    bool getUseBoundingBoxTree() const {
+        return useBoundingBoxTree;
+    }
+
     const Array_<Contact>& getContacts(const State& state, ContactSetIndex set) const {
         assert(set >= 0 && set < sets.size());
         SimTK_STAGECHECK_GE_ALWAYS(state.getSubsystemStage(getMySubsystemIndex()), Stage::Dynamics, "GeneralContactSubsystemImpl::getContacts()");
@@ -136,6 +147,10 @@ public:
     int realizeSubsystemTopologyImpl(State& state) const override {
         contactsCacheIndex = state.allocateCacheEntry(getMySubsystemIndex(), Stage::Dynamics, new Value<Array_<Array_<Contact> > >());
         contactsValidCacheIndex = state.allocateCacheEntry(getMySubsystemIndex(), Stage::Position, new Value<bool>());
+        // The broad phase trees are computed from positions along with the
+        // contacts. Their previous value is kept when positions change, so
+        // updating them only has to move the bodies that escaped their boxes.
+        treesCacheIndex = state.allocateLazyCacheEntry(getMySubsystemIndex(), Stage::Position, new Value<Array_<BoundingSphereTree> >());
         for (int i = 0; i < (int) sets.size(); ++i) {
             const ContactSet& set = sets[i];
             int numBodies = set.bodies.size();
@@ -169,12 +184,29 @@ public:
             const ContactSet& set = sets[setIndex];
             int numBodies = set.bodies.size();
             
-            // Perform a sweep-and-prune on a single axis to identify potential contacts.  First, find which
-            // axis has the most variation in body locations.  That is the axis we will use.
-            
             Vector_<Vec3> centers(numBodies);
             for (ContactSurfaceIndex i(0); i < numBodies; i++)
                 centers[i] = set.bodies[i].getBodyTransform(state)*set.sphereCenters[i];
+
+            if (useBoundingBoxTree) {
+                // Update this set's persistent tree with the new locations and
+                // examine the pairs whose boxes overlap.
+                Array_<BoundingSphereTree>& trees = Value<Array_<BoundingSphereTree> >::updDowncast(updCacheEntry(state, treesCacheIndex)).upd();
+                trees.resize(numSets);
+                BoundingSphereTree& tree = trees[setIndex];
+                tree.resize(numBodies);
+                for (ContactSurfaceIndex i(0); i < numBodies; i++)
+                    tree.setSphere(i, centers[i], set.sphereRadii[i]);
+                auto processPair = [&](int i, int j) {
+                    addContactIfTouching(state, set, centers, ContactSurfaceIndex(std::min(i,j)), ContactSurfaceIndex(std::max(i,j)), contacts[setIndex]);
+                };
+                tree.findPairs(processPair);
+                continue;
+            }
+            
+            // Perform a sweep-and-prune on a single axis to identify potential contacts.  First, find which
+            // axis has the most variation in body locations.  That is the axis we will use.
+            
             Vec3 average = mean(centers);
             Vec3 var(0);
             for (int i = 0; i < numBodies; i++)
@@ -192,54 +224,56 @@ public:
             
             // Now sweep along the axis, finding potential contacts.
             
-            for (int i = 0; i < numBodies; i++) {
-                const ContactSurfaceIndex index1 = extents[i].index;
-                const Transform transform1 = set.bodies[index1].getBodyTransform(state)*set.transforms[index1];
-                const ContactGeometry& geom1 = set.geometry[index1];
-                const ContactGeometryTypeId typeId1 = geom1.getTypeId();
-                for (int j = i+1; j < numBodies && extents[j].start <= extents[i].end; j++) {
-                    // They overlap along this axis.  See if the bounding spheres overlap.
-                    
-                    const ContactSurfaceIndex index2 = extents[j].index;
-                    const Real sumRadius = set.sphereRadii[index1]+set.sphereRadii[index2];
-                    if ((centers[index1]-centers[index2]).normSqr() <= sumRadius*sumRadius) {
-                        // Do a full collision detection.
-
-                        const Transform transform2 = set.bodies[index2].getBodyTransform(state)*set.transforms[index2];
-                        const ContactGeometry& geom2 = set.geometry[index2];
-                        const ContactGeometryTypeId typeId2 = geom2.getTypeId();
-                        CollisionDetectionAlgorithm* algorithm = 
-                            CollisionDetectionAlgorithm::getAlgorithm
-                                                            (typeId1, typeId2);
-                        if (algorithm == NULL) {
-                            algorithm = CollisionDetectionAlgorithm::
-                                                getAlgorithm(typeId2, typeId1);
-                            if (algorithm == NULL)
-                                continue; // No algorithm available for detecting collisions between these two objects.
-                            algorithm->processObjects(index2, geom2, transform2,
-                                                      index1, geom1, transform1,
-                                                      contacts[setIndex]);
-                        }
-                        else {
-                            algorithm->processObjects(index1, geom1, transform1,
-                                                      index2, geom2, transform2,
-                                                      contacts[setIndex]);
-                        }
-                    }
-                }
-            }
+            for (int i = 0; i < numBodies; i++)
+                for (int j = i+1; j < numBodies && extents[j].start <= extents[i].end; j++)
+                    // They overlap along this axis.
+                    addContactIfTouching(state, set, centers, extents[i].index, extents[j].index, contacts[setIndex]);
         }
+        if (useBoundingBoxTree)
+            markCacheValueRealized(state, treesCacheIndex);
         contactsValid = true;
         return 0;
     }
 
+    // See if the bounding spheres of two bodies overlap, and if so do a full
+    // collision detection.
+    void addContactIfTouching(const State& state, const ContactSet& set, const Vector_<Vec3>& centers,
+                              ContactSurfaceIndex index1, ContactSurfaceIndex index2, Array_<Contact>& contacts) const {
+        const Real sumRadius = set.sphereRadii[index1]+set.sphereRadii[index2];
+        if ((centers[index1]-centers[index2]).normSqr() > sumRadius*sumRadius)
+            return;
+        const Transform transform1 = set.bodies[index1].getBodyTransform(state)*set.transforms[index1];
+        const ContactGeometry& geom1 = set.geometry[index1];
+        const ContactGeometryTypeId typeId1 = geom1.getTypeId();
+        const Transform transform2 = set.bodies[index2].getBodyTransform(state)*set.transforms[index2];
+        const ContactGeometry& geom2 = set.geometry[index2];
+        const ContactGeometryTypeId typeId2 = geom2.getTypeId();
+        CollisionDetectionAlgorithm* algorithm = 
+            CollisionDetectionAlgorithm::getAlgorithm(typeId1, typeId2);
+        if (algorithm == NULL) {
+            algorithm = CollisionDetectionAlgorithm::getAlgorithm(typeId2, typeId1);
+            if (algorithm == NULL)
+                return; // No algorithm available for detecting collisions between these two objects.
+            algorithm->processObjects(index2, geom2, transform2,
+                                      index1, geom1, transform1,
+                                      contacts);
+        }
+        else {
+            algorithm->processObjects(index1, geom1, transform1,
+                                      index2, geom2, transform2,
+                                      contacts);
+        }
+    }
+
     SimTK_DOWNCAST(GeneralContactSubsystemImpl, Subsystem::Guts);
 
 private:
     Array_<ContactSet>      sets;
+    bool                    useBoundingBoxTree;
 
     mutable CacheEntryIndex contactsCacheIndex;
     mutable CacheEntryIndex contactsValidCacheIndex;
+    mutable CacheEntryIndex treesCacheIndex;
 };
 
 
@@ -287,6 +321,14 @@ const Array_<Contact>& GeneralContactSubsystem::getContacts(const State& state,
     return getImpl().getContacts(state, set);
 }
 
+void GeneralContactSubsystem::setUseBoundingBoxTree(bool useTree) {
+    updImpl().setUseBoundingBoxTree(useTree);
+}
+
+bool GeneralContactSubsystem::getUseBoundingBoxTree() const {
+    return getImpl().getUseBoundingBoxTree();
+}
+
 bool GeneralContactSubsystem::isInstanceOf(const Subsystem& s) {
     return GeneralContactSubsystemImpl::isA(s.getSubsystemGuts());
 }
@@ -38,482 +38,341 @@
 #include <exception>
 
 #include "ForceImpl.h"
+#include "ParallelSlices.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 
-//Threading constants used by CalcForcesTask
 namespace {
 using namespace SimTK;
 
-const int NumNonParallelThreads = 1;
-const int NonParallelForcesIndex = 0;
+// Which forces a CalcForcesTask should calculate, and where their results go.
+enum CalcForcesMode {
+    All,                // every enabled force, into the System's arrays
+    CachedAndNonCached, // position-only forces go to the subsystem's cache
+    NonCached           // only the forces that aren't position-only
+};
 
-/* Base class for CalcForcesParallelTask and CalcForcesNonParallelTask - lays 
-out common methods that will be implemented to suit the parallel/non-parallel
-use cases*/
-class CalcForcesTask : public ParallelExecutor::Task {
-public:
-    CalcForcesTask() = default;
-    
-    virtual CalcForcesTask* clone() const = 0;
-    
-    virtual void initializeAll(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) = 0;
-    virtual void initializeCachedAndNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces,
-            Vector_<SpatialVec>& rigidBodyForceCache,
-            Vector_<Vec3>& particleForceCache,
-            Vector& mobilityForceCache) = 0;
-    virtual void initializeNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) = 0;
-    
+// Pointers to a set of force arrays dimensioned like the System's.
+struct ForceTargets {
+    ForceTargets() : rigidBody(0), particle(0), mobility(0) {}
+    ForceTargets(Vector_<SpatialVec>& rigidBody, Vector_<Vec3>& particle,
+                 Vector& mobility)
+    :   rigidBody(&rigidBody), particle(&particle), mobility(&mobility) {}
+    bool isValid() const {return rigidBody != 0;}
+
+    Vector_<SpatialVec>*    rigidBody;
+    Vector_<Vec3>*          particle;
+    Vector*                 mobility;
 };
-/*Calculates each enabled force's contribution in the MultibodySystem.
-CalcForcesParallelTask allows force calculations to occur in parallel with
-non-parallel forces being calculated on Thread NonParallelForcesIndex and all
-other parallel forces being calculated on separate threads.*/
 
-//Implementation of CalcForcesTask for parallel forces
-class CalcForcesParallelTask : public CalcForcesTask {
-public:
-    //The different categories of force calculations that GeneralForceSubsystem
-    //chooses between
-    enum Mode {
-        All,
-        CachedAndNonCached,
-        NonCached
-    };
-    
-    CalcForcesParallelTask* clone() const override {
-        return new CalcForcesParallelTask();
-    }
-    // Each different force calculation Mode requires different parameters
-    //
-    // Note: Execute MUST be called directly after CalcForceTask is initialized
-    void initializeAll(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) override
-    {
-        m_forces = &forces;
-        m_state = &s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
-        
-        m_mode = All;
-    }
-    void initializeCachedAndNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces,
-            Vector_<SpatialVec>& rigidBodyForceCache,
-            Vector_<Vec3>& particleForceCache,
-            Vector& mobilityForceCache) override
-    {
-        m_forces = &forces;
-        m_state = s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
-        m_rigidBodyForceCache = &rigidBodyForceCache;
-        m_particleForceCache = &particleForceCache;
-        m_mobilityForceCache = &mobilityForceCache;
-
-        m_mode = CachedAndNonCached;
-    }
-    void initializeNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) override
-    {
-        m_forces = &forces;
-        m_state = s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
+// The bodies that a parallel force says are the only ones it touches, if it
+// knows; see ForceImpl::getBodiesAffected().
+struct AffectedBodies {
+    AffectedBodies() : known(false) {}
+    bool                        known;
+    Array_<MobilizedBodyIndex>  bodies;
+};
 
-        m_mode = NonCached;
-    }
-    
-    // Set all of the local force contribution arrays to 0. This is so that
-    // each local thread can sum up its force contribution to be later
-    // added into the total force array.
-    void initialize() override {
-        m_rigidBodyForcesLocalStatic.resize(m_rigidBodyForces->size());
-        m_rigidBodyForcesLocalStatic.setToZero();
-        m_particleForcesLocalStatic.resize(m_particleForces->size());
-        m_particleForcesLocalStatic.setToZero();
-        m_mobilityForcesLocalStatic.resize(m_mobilityForces->size());
-        m_mobilityForcesLocalStatic.setToZero();
-
-        if (m_mode == CachedAndNonCached) {
-            m_rigidBodyForceCacheLocalStatic.resize(m_rigidBodyForceCache->size());
-            m_rigidBodyForceCacheLocalStatic.setToZero();
-            m_particleForceCacheLocalStatic.resize(m_particleForceCache->size());
-            m_particleForceCacheLocalStatic.setToZero();
-            m_mobilityForceCacheLocalStatic.resize(m_mobilityForceCache->size());
-            m_mobilityForceCacheLocalStatic.setToZero();
+// One parallel force's contribution, recorded as just the entries it set so
+// that it can be added into its target later, in ForceIndex order, without
+// keeping a full set of force arrays for each force. The Arrays are cleared
+// but not freed between uses.
+struct ForceContribution {
+    ForceContribution() : target(-1) {}
+
+    void clear() {
+        target = -1;
+        bodies.clear(); bodyForces.clear();
+        particles.clear(); particleForces.clear();
+        mobilities.clear(); mobilityForces.clear();
+    }
+
+    void addInto(const ForceTargets& dest) const {
+        for (int i=0; i < (int)bodies.size(); ++i)
+            (*dest.rigidBody)[bodies[i]] += bodyForces[i];
+        for (int i=0; i < (int)particles.size(); ++i)
+            (*dest.particle)[particles[i]] += particleForces[i];
+        for (int i=0; i < (int)mobilities.size(); ++i)
+            (*dest.mobility)[mobilities[i]] += mobilityForces[i];
+    }
+
+    int                         target; // 0, 1, or -1 if not calculated
+    Array_<MobilizedBodyIndex>  bodies;
+    Array_<SpatialVec>          bodyForces;
+    Array_<int>                 particles;
+    Array_<Vec3>                particleForces;
+    Array_<int>                 mobilities;
+    Array_<Real>                mobilityForces;
+};
+
+// One task's force arrays, with one set for each possible target (the
+// System's arrays or the position-only cache). A parallel force is calculated
+// into these, then the entries it set are moved into its ForceContribution,
+// leaving the arrays all zero again for the task's next force.
+struct TaskAccumulator {
+    // Make sure the arrays for target t match the target's dimensions,
+    // preserving the all-zero invariant.
+    void resizeLike(int t, const ForceTargets& target) {
+        if (rigidBody[t].size() != target.rigidBody->size()) {
+            rigidBody[t].resize(target.rigidBody->size());
+            rigidBody[t].setToZero();
+        }
+        if (particle[t].size() != target.particle->size()) {
+            particle[t].resize(target.particle->size());
+            particle[t].setToZero();
+        }
+        if (mobility[t].size() != target.mobility->size()) {
+            mobility[t].resize(target.mobility->size());
+            mobility[t].setToZero();
         }
     }
-    
-    // Calculate all enabled forces (taking into account mode and parallelism)
-    void execute(int threadIndex) override {
-      switch (m_mode) {
-        case All:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto force = m_forces.getRef()[forceIndex];
-                    force->getImpl().calcForce(*m_state, m_rigidBodyForcesLocalStatic, m_particleForcesLocalStatic, m_mobilityForcesLocalStatic);
-                }
-            } else {
-                // Process a single parallel force. Subtract 1 from index b/c
-                // we use 0 for the non-parallel forces.
-                const auto& forceIndex =
-                        m_enabledParallelForces->getElt(threadIndex-1);
-                const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                impl.calcForce(*m_state, m_rigidBodyForcesLocalStatic, m_particleForcesLocalStatic, m_mobilityForcesLocalStatic);
 
+    // Move what a force just calculated into set t over to its contribution.
+    // If the force reported the bodies it affects only those entries are
+    // looked at; otherwise every entry is, and only the nonzero ones are kept.
+    void moveInto(int t, const AffectedBodies& affected,
+                  ForceContribution& contrib) {
+        const SpatialVec zeroSpatial(Vec3(0), Vec3(0));
+        contrib.target = t;
+        if (affected.known) {
+            for (MobilizedBodyIndex mbx : affected.bodies) {
+                contrib.bodies.push_back(mbx);
+                contrib.bodyForces.push_back(rigidBody[t][mbx]);
+                rigidBody[t][mbx] = zeroSpatial;
+            }
+            return;
+        }
+        for (MobilizedBodyIndex mbx(0); mbx < rigidBody[t].size(); ++mbx)
+            if (rigidBody[t][mbx] != zeroSpatial) {
+                contrib.bodies.push_back(mbx);
+                contrib.bodyForces.push_back(rigidBody[t][mbx]);
+                rigidBody[t][mbx] = zeroSpatial;
             }
-            break;
-
-        case CachedAndNonCached:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces.
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                    if (impl.dependsOnlyOnPositions()) {
-                        impl.calcForce(*m_state, *m_rigidBodyForceCache, *m_particleForceCache, *m_mobilityForceCache);
-                    } else { // ordinary velocity dependent force
-                        impl.calcForce(*m_state, *m_rigidBodyForces, *m_particleForces, *m_mobilityForces);
-                    }
-                }
-            } else {
-                // Process a single parallel force. Subtract 1 from threadIndex b/c
-                // we use 0 for the non-parallel forces.
-                const auto& forceIndex =
-                        m_enabledParallelForces->getElt(threadIndex-1);
-                const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                if (impl.dependsOnlyOnPositions()) {
-                    impl.calcForce(*m_state, m_rigidBodyForceCacheLocalStatic, m_particleForceCacheLocalStatic, m_mobilityForceCacheLocalStatic);
-                } else { // ordinary velocity dependent force
-                    impl.calcForce(*m_state, m_rigidBodyForcesLocalStatic, m_particleForcesLocalStatic, m_mobilityForcesLocalStatic);
-                }
+        for (int i=0; i < particle[t].size(); ++i)
+            if (particle[t][i] != Vec3(0)) {
+                contrib.particles.push_back(i);
+                contrib.particleForces.push_back(particle[t][i]);
+                particle[t][i] = Vec3(0);
             }
-            break;
-
-        case NonCached:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces.
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                    if (!impl.dependsOnlyOnPositions()) {
-                        impl.calcForce(*m_state,
-                                *m_rigidBodyForces, *m_particleForces,
-                                *m_mobilityForces);
-                    }
-                }
-            } else {
-                // Process a single parallel force. Subtract 1 from index b/c
-                // we use 0 for the non-parallel forces.
-                const auto& forceIndex =
-                        m_enabledParallelForces->getElt(threadIndex-1);
-                const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                if (!impl.dependsOnlyOnPositions()) {
-                    impl.calcForce(*m_state,
-                            m_rigidBodyForcesLocalStatic, m_particleForcesLocalStatic,
-                            m_mobilityForcesLocalStatic);
-                }
+        for (int i=0; i < mobility[t].size(); ++i)
+            if (mobility[t][i] != 0) {
+                contrib.mobilities.push_back(i);
+                contrib.mobilityForces.push_back(mobility[t][i]);
+                mobility[t][i] = 0;
             }
-            break;
-        }
     }
-    
-    //Once a thread has finished its force calculations, we add in the thread's
-    //contribution into the cached force arrays in the State
-    void finish() override {
-        *m_rigidBodyForces += m_rigidBodyForcesLocalStatic;
-        *m_particleForces += m_particleForcesLocalStatic;
-        *m_mobilityForces += m_mobilityForcesLocalStatic;
-
-        if (m_mode == CachedAndNonCached) {
-            *m_rigidBodyForceCache += m_rigidBodyForceCacheLocalStatic;
-            *m_particleForceCache += m_particleForceCacheLocalStatic;
-            *m_mobilityForceCache += m_mobilityForceCacheLocalStatic;
+
+    // Restore the all-zero invariant after a force threw part way through.
+    void setToZero() {
+        for (int t=0; t < 2; ++t) {
+            rigidBody[t].setToZero();
+            particle[t].setToZero();
+            mobility[t].setToZero();
         }
     }
-private:
-    Mode m_mode;
-
-    ReferencePtr<const Array_<Force*>> m_forces;
-    ReferencePtr<const State> m_state;
 
-    // Constant state-cache variables for the enabled parallel and non-parallel
-    // forces.
-    ReferencePtr<const Array_<ForceIndex>> m_enabledNonParallelForces;
-    ReferencePtr<const Array_<ForceIndex>> m_enabledParallelForces;
-
-    // ReferencePtrs that point to caches in the state; We eventually add our
-    // thread-local result to these vectors.
-    ReferencePtr<Vector_<SpatialVec>> m_rigidBodyForces;
-    ReferencePtr<Vector_<Vec3>> m_particleForces;
-    ReferencePtr<Vector> m_mobilityForces;
+    Vector_<SpatialVec>         rigidBody[2];
+    Vector_<Vec3>               particle[2];
+    Vector                      mobility[2];
+};
 
-    ReferencePtr<Vector_<SpatialVec>> m_rigidBodyForceCache;
-    ReferencePtr<Vector_<Vec3>> m_particleForceCache;
-    ReferencePtr<Vector> m_mobilityForceCache;
-    
-    // These variables are local to a thread. They are set to their default
-    // value when the threads are spawned. We use them to keep track of each
-    // thread's contribution that we will later add in to the final state cache.
-    static thread_local Vector_<SpatialVec> m_rigidBodyForcesLocalStatic;
-    static thread_local Vector_<Vec3> m_particleForcesLocalStatic;
-    static thread_local Vector m_mobilityForcesLocalStatic;
-
-    static thread_local Vector_<SpatialVec> m_rigidBodyForceCacheLocalStatic;
-    static thread_local Vector_<Vec3> m_particleForceCacheLocalStatic;
-    static thread_local Vector m_mobilityForceCacheLocalStatic;
+// Scratch space for scheduling the forces, kept in the State so that it is
+// reused from one evaluation to the next. The measured costs are smoothed
+// wall clock times in seconds, one for each Force plus one at the end for the
+// group of non-parallel forces; zero means not yet measured. There is one
+// accumulator for each task and one contribution for each enabled parallel
+// force.
+struct ForceSchedule {
+    Array_<double>              cost;
+    Array_<int>                 order;
+    Array_<double>              itemTime;
+    Array_<TaskAccumulator>     accumulators;
+    Array_<ForceContribution>   contributions;
 };
 
-//local declarations of static member variables
-/*static*/ thread_local Vector_<SpatialVec>
-                    CalcForcesParallelTask::m_rigidBodyForcesLocalStatic;
-/*static*/ thread_local Vector_<Vec3>
-                    CalcForcesParallelTask::m_particleForcesLocalStatic;
-/*static*/ thread_local Vector
-                    CalcForcesParallelTask::m_mobilityForcesLocalStatic;
-
-/*static*/ thread_local Vector_<SpatialVec>
-                    CalcForcesParallelTask::m_rigidBodyForceCacheLocalStatic;
-/*static*/ thread_local Vector_<Vec3>
-                    CalcForcesParallelTask::m_particleForceCacheLocalStatic;
-/*static*/ thread_local Vector
-                    CalcForcesParallelTask::m_mobilityForceCacheLocalStatic;
-
-/* Calculates each enabled force's contribution in the MultibodySystem. These
-calculations occur on the main thread, without use of local thread variables.*/
-
-//Implementation of CalcForcesTask for non-parallel forces
-class CalcForcesNonParallelTask : public CalcForcesTask {
+// Weight given to the latest measurement when updating a cost estimate.
+const double CostSmoothing = 0.25;
+
+//==============================================================================
+//                            CALC FORCES TASK
+//==============================================================================
+/* Calculates each enabled force's contribution in the MultibodySystem. The
+work items are the enabled parallel forces, one each, plus one item that runs
+all the non-parallel forces in order. Idle threads take the next item from a
+shared queue sorted by decreasing cost as measured on previous evaluations, so
+the expensive forces get started first and the cheap ones fill in around them
+on whichever threads come free.
+
+The item with the non-parallel forces accumulates directly into the target
+arrays since nothing else touches them until all the items are done. Each
+parallel force is calculated into the force arrays of the task that picked it
+up, and the entries it set are then moved out into that force's own sparse
+ForceContribution. reduce() adds the contributions in afterwards in ForceIndex
+order. So the sums are formed in the same order no matter how many threads
+there are or which thread ran which item; only the order in which the items
+are started depends on the measured costs. Full-size arrays are needed only
+for each task, not for each force, and the serial reduction touches only the
+entries the parallel forces actually set.
+
+runSerially() instead calculates every force directly into the targets, in
+ForceIndex order, on the calling thread. */
+class CalcForcesTask : public ParallelExecutor::Task {
 public:
-    //The different categories of force calculations that GeneralForceSubsystem
-    //chooses between
-    enum Mode {
-        All,
-        CachedAndNonCached,
-        NonCached
-    };
-    
-    CalcForcesNonParallelTask* clone() const override {
-        return new CalcForcesNonParallelTask();
+    CalcForcesTask(const Array_<Force*>& forces, const State& state,
+                   CalcForcesMode mode,
+                   const Array_<ForceIndex>& nonParallelForces,
+                   const Array_<ForceIndex>& parallelForces,
+                   const Array_<AffectedBodies>& affected,
+                   const ForceTargets& forceTarget,
+                   const ForceTargets& cacheTarget,
+                   ForceSchedule& schedule)
+    :   forces(forces), state(state), mode(mode), 
+        nonParallelForces(nonParallelForces), parallelForces(parallelForces),
+        affected(affected), schedule(schedule), nextItem(0)
+    {   target[0] = forceTarget; target[1] = cacheTarget; }
+
+    // Item numbers are indices into parallelForces, or this one for the
+    // non-parallel group.
+    int getNonParallelItem() const {return (int)parallelForces.size();}
+
+    // Return the number of items that have work to do.
+    int getNumItems() const {
+        return (int)parallelForces.size() + (nonParallelForces.empty() ? 0:1);
+    }
+
+    // Fill in schedule.order with the items that have work to do, most
+    // expensive first. This only determines the order in which the threads
+    // pick up the items, not the order in which results are summed.
+    void prepareSchedule() {
+        const int nForces = (int)forces.size();
+        schedule.cost.resize(nForces+1, 0.);
+        schedule.itemTime.resize(getNonParallelItem()+1);
+        schedule.order.clear();
+        for (int item=0; item < getNonParallelItem(); ++item)
+            schedule.order.push_back(item);
+        if (!nonParallelForces.empty())
+            schedule.order.push_back(getNonParallelItem());
+        std::stable_sort(schedule.order.begin(), schedule.order.end(),
+            [this](int a, int b) {return getCost(a) > getCost(b);});
+    }
+
+    // Calculate all the forces on this thread, directly into the targets, in
+    // ForceIndex order. The two lists of forces are each in that order
+    // already so we just merge them.
+    void runSerially() const {
+        const int nNonParallel = (int)nonParallelForces.size();
+        const int nParallel    = (int)parallelForces.size();
+        for (int np=0, p=0; np < nNonParallel || p < nParallel;) {
+            const bool takeNonParallel = p == nParallel || (np < nNonParallel
+                && nonParallelForces[np] < parallelForces[p]);
+            const ForceIndex fx = takeNonParallel ? nonParallelForces[np++]
+                                                  : parallelForces[p++];
+            const ForceImpl& impl = forces[fx]->getImpl();
+            const int t = chooseTarget(impl);
+            if (t >= 0) calcForceInto(impl, target[t]);
+        }
     }
-    
-    // Each different force calculation Mode requires different parameters
-    //
-    // Note: Execute MUST be called directly after CalcForceTask is initialized
-    void initializeAll(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) override
-    {
-        m_forces = &forces;
-        m_state = &s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
-        
-        m_mode = All;
-    }
-    void initializeCachedAndNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces,
-            Vector_<SpatialVec>& rigidBodyForceCache,
-            Vector_<Vec3>& particleForceCache,
-            Vector& mobilityForceCache) override
-    {
-        m_forces = &forces;
-        m_state = s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
-        m_rigidBodyForceCache = &rigidBodyForceCache;
-        m_particleForceCache = &particleForceCache;
-        m_mobilityForceCache = &mobilityForceCache;
-
-        m_mode = CachedAndNonCached;
-    }
-    void initializeNonCached(
-            const Array_<Force*>& forces, const State& s,
-            const Array_<ForceIndex>& enabledNonParallelForces,
-            const Array_<ForceIndex>& enabledParallelForces,
-            Vector_<SpatialVec>& rigidBodyForces,
-            Vector_<Vec3>& particleForces,
-            Vector& mobilityForces) override
-    {
-        m_forces = &forces;
-        m_state = s;
-        m_enabledNonParallelForces = &enabledNonParallelForces;
-        m_enabledParallelForces = &enabledParallelForces;
-        m_rigidBodyForces = &rigidBodyForces;
-        m_particleForces = &particleForces;
-        m_mobilityForces = &mobilityForces;
 
-        m_mode = NonCached;
-    }
-    
-    // Set all of the local force contribution arrays to 0. This is so that
-    // each local thread can sum up it's force contribution to be later
-    // added into the total force array.
-    void initialize() override {
-        m_rigidBodyForcesLocal.resize(m_rigidBodyForces->size());
-        m_rigidBodyForcesLocal.setToZero();
-        m_particleForcesLocal.resize(m_particleForces->size());
-        m_particleForcesLocal.setToZero();
-        m_mobilityForcesLocal.resize(m_mobilityForces->size());
-        m_mobilityForcesLocal.setToZero();
-
-        if (m_mode == CachedAndNonCached) {
-            m_rigidBodyForceCacheLocal.resize(m_rigidBodyForceCache->size());
-            m_rigidBodyForceCacheLocal.setToZero();
-            m_particleForceCacheLocal.resize(m_particleForceCache->size());
-            m_particleForceCacheLocal.setToZero();
-            m_mobilityForceCacheLocal.resize(m_mobilityForceCache->size());
-            m_mobilityForceCacheLocal.setToZero();
+    // Get ready to run on nTasks threads.
+    void prepareAccumulators(int nTasks) {
+        schedule.accumulators.resize(nTasks);
+        for (TaskAccumulator& acc : schedule.accumulators)
+            for (int t=0; t < 2; ++t)
+                if (target[t].isValid()) acc.resizeLike(t, target[t]);
+        schedule.contributions.resize(parallelForces.size());
+        for (ForceContribution& contrib : schedule.contributions)
+            contrib.clear();
+        errors.clear(); errors.resize(nTasks);
+    }
+
+    void execute(int taskNum) override {
+        const int nItems = (int)schedule.order.size();
+        try {
+            for (int k = nextItem++; k < nItems; k = nextItem++)
+                runItem(schedule.order[k], taskNum);
+        } catch (...) {
+            errors[taskNum] = std::current_exception();
+            schedule.accumulators[taskNum].setToZero();
         }
     }
-    
-    // Calculate all enabled forces (taking into account mode and parallelism)
-    void execute(int threadIndex) override {
-      switch (m_mode) {
-        case All:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto force = m_forces.getRef()[forceIndex];
-                    force->getImpl().calcForce(*m_state, m_rigidBodyForcesLocal,
-                                  m_particleForcesLocal, m_mobilityForcesLocal);
-                }
-            }
-            break;
-
-        case CachedAndNonCached:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces.
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                    if (impl.dependsOnlyOnPositions()) {
-                        impl.calcForce(*m_state, *m_rigidBodyForceCache,
-                                  *m_particleForceCache, *m_mobilityForceCache);
-                    } else { // ordinary velocity dependent force
-                        impl.calcForce(*m_state, *m_rigidBodyForces,
-                                          *m_particleForces, *m_mobilityForces);
-                    }
-                }
-            }
-            break;
-
-        case NonCached:
-            if (threadIndex == NonParallelForcesIndex) {
-                // Process all non-parallel forces.
-                for (const auto& forceIndex : *m_enabledNonParallelForces) {
-                    const auto& impl = m_forces.getRef()[forceIndex]->getImpl();
-                    if (!impl.dependsOnlyOnPositions()) {
-                        impl.calcForce(*m_state,
-                                *m_rigidBodyForces, *m_particleForces,
-                                *m_mobilityForces);
-                    }
-                }
-            }
-            break;
-        }
+
+    // After a parallel run, add the parallel forces' contributions into the
+    // targets in ForceIndex order, update the cost estimates, and rethrow the
+    // first exception if any of the forces threw.
+    void reduce() {
+        for (const ForceContribution& contrib : schedule.contributions)
+            if (contrib.target >= 0) contrib.addInto(target[contrib.target]);
+        updateCosts();
+        for (const std::exception_ptr& error : errors)
+            if (error) std::rethrow_exception(error);
     }
-    
-    //Once a thread has finished it's force calculations, we add in the thread's
-    //contribution into the cached force arrays in the State
-    void finish() override {
-        *m_rigidBodyForces += m_rigidBodyForcesLocal;
-        *m_particleForces += m_particleForcesLocal;
-        *m_mobilityForces += m_mobilityForcesLocal;
-
-        if (m_mode == CachedAndNonCached) {
-            *m_rigidBodyForceCache += m_rigidBodyForceCacheLocal;
-            *m_particleForceCache += m_particleForceCacheLocal;
-            *m_mobilityForceCache += m_mobilityForceCacheLocal;
+
+private:
+    double getCost(int item) const {
+        return item == getNonParallelItem() 
+            ? schedule.cost[forces.size()]
+            : schedule.cost[parallelForces[item]];
+    }
+
+    void updateCosts() {
+        for (int item : schedule.order) {
+            double& cost = item == getNonParallelItem() 
+                ? schedule.cost[forces.size()]
+                : schedule.cost[parallelForces[item]];
+            const double measured = schedule.itemTime[item];
+            cost = cost == 0 ? measured 
+                             : cost + CostSmoothing*(measured - cost);
         }
     }
-private:
-    Mode m_mode;
-
-    ReferencePtr<const Array_<Force*>> m_forces;
-    ReferencePtr<const State> m_state;
 
-    // Const. state-cache variables for the enabled parallel and non-parallel
-    // forces.
-    ReferencePtr<const Array_<ForceIndex>> m_enabledNonParallelForces;
-    ReferencePtr<const Array_<ForceIndex>> m_enabledParallelForces;
+    // Returns 0 to put this force's contribution in the force arrays, 1 for
+    // the position-only cache, or -1 if it isn't to be calculated now.
+    int chooseTarget(const ForceImpl& impl) const {
+        if (mode == All) return 0;
+        if (impl.dependsOnlyOnPositions()) 
+            return mode == CachedAndNonCached ? 1 : -1;
+        return 0;
+    }
 
-    // ReferencePtrs that point to caches in the state; We eventually add our
-    // thread-local result to these vectors.
-    ReferencePtr<Vector_<SpatialVec>> m_rigidBodyForces;
-    ReferencePtr<Vector_<Vec3>> m_particleForces;
-    ReferencePtr<Vector> m_mobilityForces;
+    void calcForceInto(const ForceImpl& impl, const ForceTargets& dest) const {
+        impl.calcForce(state, *dest.rigidBody, *dest.particle, *dest.mobility);
+    }
 
-    ReferencePtr<Vector_<SpatialVec>> m_rigidBodyForceCache;
-    ReferencePtr<Vector_<Vec3>> m_particleForceCache;
-    ReferencePtr<Vector> m_mobilityForceCache;
-    
-    // These variables belong to the main thread. We use them to keep track of
-    // each thread's contribution that we will later add in to the final state
-    // cache.
-    Vector_<SpatialVec> m_rigidBodyForcesLocal;
-    Vector_<Vec3> m_particleForcesLocal;
-    Vector m_mobilityForcesLocal;
-
-    Vector_<SpatialVec> m_rigidBodyForceCacheLocal;
-    Vector_<Vec3> m_particleForceCacheLocal;
-    Vector m_mobilityForceCacheLocal;
+    void runItem(int item, int taskNum) {
+        const auto start = std::chrono::steady_clock::now();
+        if (item == getNonParallelItem()) {
+            for (ForceIndex fx : nonParallelForces) {
+                const ForceImpl& impl = forces[fx]->getImpl();
+                const int t = chooseTarget(impl);
+                if (t >= 0) calcForceInto(impl, target[t]);
+            }
+        } else {
+            const ForceImpl& impl = forces[parallelForces[item]]->getImpl();
+            const int t = chooseTarget(impl);
+            if (t >= 0) {
+                TaskAccumulator& acc = schedule.accumulators[taskNum];
+                impl.calcForce(state, acc.rigidBody[t], acc.particle[t],
+                               acc.mobility[t]);
+                acc.moveInto(t, affected[item], schedule.contributions[item]);
+            }
+        }
+        schedule.itemTime[item] = std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - start).count();
+    }
+
+    const Array_<Force*>&           forces;
+    const State&                    state;
+    const CalcForcesMode            mode;
+    const Array_<ForceIndex>&       nonParallelForces;
+    const Array_<ForceIndex>&       parallelForces;
+    const Array_<AffectedBodies>&   affected;
+    ForceTargets                    target[2];
+    ForceSchedule&                  schedule;
+    std::atomic<int>                nextItem;
+    Array_<std::exception_ptr>      errors;
 };
 } //namespace
 
@@ -531,7 +390,6 @@ public:
     {
         //The default number of threads is the physical number of processors
         //call setNumberOfThreads() if you want to override the thread count
-        calcForcesExecutor = new ParallelExecutor();
     }
 
     ~GeneralForceSubsystemRep() {
@@ -591,11 +449,11 @@ public:
     void setNumberOfThreads(unsigned numThreads) {
         SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "GeneralForceSubsystemRep",
                     "setNumberOfThreads", "Number of threads must be positive");
-        calcForcesExecutor = new ParallelExecutor(numThreads);
+        calcForcesExecutor.setNumberOfThreads(numThreads);
     }
     
     int getNumberOfThreads() const{
-      return calcForcesExecutor->getMaxThreads();
+      return calcForcesExecutor.getNumberOfThreads();
     }
 
     // These override default implementations of virtual methods in the
@@ -608,6 +466,8 @@ public:
         forceEnabledIndex.invalidate();
         enabledParallelForcesIndex.invalidate();
         enabledNonParallelForcesIndex.invalidate();
+        parallelForceBodiesIndex.invalidate();
+        forceScheduleIndex.invalidate();
         cachedForcesAreValidCacheIndex.invalidate();
         rigidBodyForceCacheIndex.invalidate();
         mobilityForceCacheIndex.invalidate();
@@ -652,32 +512,15 @@ public:
         enabledParallelForcesIndex = allocateCacheEntry(s, Stage::Instance,
                 new Value<Array_<ForceIndex> >(enabledParallelForces));
 
-        //Determine whether the subsystem has parallel forces - if so, use the
-        //parallel implementation of CalcForcesTask (even if those parallel
-        //forces are not currently enabled - they could be enabled in the
-        //future)
-        //
-        // *Consider the following example:*
-        // Parallel Forces: A B C
-        // NonParallel Forces: D E
-        //
-        // Enabled Forces at Time 0: D E
-        // Enabled Forces at Time 1: A B C D E
-        
-        bool hasParallelForces = false;
-        for(int x = 0; x < (int)forces.size(); ++x)
-        {
-            if (forces[x]->getImpl().shouldBeParallelIfPossible())
-            {
-                hasParallelForces = true;
-                break;
-            }
-        }
-        if (hasParallelForces)
-            calcForcesTask = new CalcForcesParallelTask();
-        else
-            calcForcesTask = new CalcForcesNonParallelTask();
-        
+        // For each enabled parallel force, the bodies it says it affects.
+        parallelForceBodiesIndex = allocateCacheEntry(s, Stage::Instance,
+                new Value<Array_<AffectedBodies> >());
+
+        // Measured force costs and scratch space for parallel evaluation.
+        // This persists from one evaluation to the next.
+        forceScheduleIndex = allocateLazyCacheEntry(s, Stage::Topology,
+                new Value<ForceSchedule>());
+
         // Note that we'll allocate these even if all the needs-caching
         // elements are presently disabled. That way they'll be around when
         // the force gets enabled.
@@ -740,6 +583,19 @@ public:
                     enabledNonParallelForces.push_back(ForceIndex(i));
             }
         }
+
+        // Ask the parallel forces which bodies they affect, so that threads
+        // that evaluate them need only add in those bodies' forces.
+        Array_<AffectedBodies>& parallelForceBodies =
+                Value< Array_<AffectedBodies> >::
+                    updDowncast(updCacheEntry(s,parallelForceBodiesIndex));
+        parallelForceBodies.resize(enabledParallelForces.size());
+        for (int i = 0; i < (int) enabledParallelForces.size(); ++i) {
+            AffectedBodies& affected = parallelForceBodies[i];
+            affected.bodies.clear();
+            affected.known = forces[enabledParallelForces[i]]->getImpl()
+                                            .getBodiesAffected(affected.bodies);
+        }
         return 0;
     }
 
@@ -781,12 +637,6 @@ public:
         // force element is enabled.
         const Array_<bool>& forceEnabled = Value< Array_<bool> >::downcast
                                     (getDiscreteVariable(s, forceEnabledIndex));
-        const Array_<ForceIndex>& enabledNonParallelForces =
-                Value<Array_<ForceIndex>>::
-                      downcast(getCacheEntry(s, enabledNonParallelForcesIndex));
-        const Array_<ForceIndex>& enabledParallelForces =
-                Value<Array_<ForceIndex>>::
-                         downcast(getCacheEntry(s, enabledParallelForcesIndex));
 
         // Get access to System-global force cache arrays.
         Vector_<SpatialVec>&   rigidBodyForces =
@@ -801,11 +651,9 @@ public:
         // exist?), not the contents.
         if (!cachedForcesAreValidCacheIndex.isValid()) {
             // Call calcForce() on all Forces, in parallel.
-            calcForcesTask->initializeAll(forces, s,
-                    enabledNonParallelForces, enabledParallelForces,
-                    rigidBodyForces, particleForces, mobilityForces);
-            calcForcesExecutor->execute(calcForcesTask.updRef(),
-                          enabledParallelForces.size() + NumNonParallelThreads);
+            calcForces(s, All,
+                ForceTargets(rigidBodyForces, particleForces, mobilityForces),
+                ForceTargets());
 
             // Allow forces to do their own realization, but wait until all
             // forces have executed calcForce(). TODO: not sure if that is
@@ -843,22 +691,17 @@ public:
 
             // Run through all the forces, accumulating directly into the
             // force arrays or indirectly into the cache as appropriate.
-            calcForcesTask->initializeCachedAndNonCached(forces, s,
-                                enabledNonParallelForces, enabledParallelForces,
-                                rigidBodyForces, particleForces, mobilityForces,
-                                rigidBodyForceCache, particleForceCache,
-                                mobilityForceCache);
-            calcForcesExecutor->execute(calcForcesTask.updRef(),
-                          enabledParallelForces.size() + NumNonParallelThreads);
+            calcForces(s, CachedAndNonCached,
+                ForceTargets(rigidBodyForces, particleForces, mobilityForces),
+                ForceTargets(rigidBodyForceCache, particleForceCache,
+                             mobilityForceCache));
             cachedForcesAreValid = true;
         } else {
             // Cache already valid; just need to do the non-cached ones (the
             // ones for which dependsOnlyOnPositions is false).
-            calcForcesTask->initializeNonCached(forces, s,
-                               enabledNonParallelForces, enabledParallelForces,
-                               rigidBodyForces, particleForces, mobilityForces);
-            calcForcesExecutor->execute(calcForcesTask.updRef(),
-                          enabledParallelForces.size() + NumNonParallelThreads);
+            calcForces(s, NonCached,
+                ForceTargets(rigidBodyForces, particleForces, mobilityForces),
+                ForceTargets());
         }
 
         // Accumulate the values from the cache into the global arrays.
@@ -873,6 +716,37 @@ public:
         return 0;
     }
 
+    // Call calcForce() on the enabled forces as selected by the mode, with
+    // the parallel ones divided among the threads if there's more than one.
+    void calcForces(const State& s, CalcForcesMode mode,
+                    const ForceTargets& forceTarget,
+                    const ForceTargets& cacheTarget) const {
+        const Array_<ForceIndex>& enabledNonParallelForces =
+                Value<Array_<ForceIndex>>::
+                      downcast(getCacheEntry(s, enabledNonParallelForcesIndex));
+        const Array_<ForceIndex>& enabledParallelForces =
+                Value<Array_<ForceIndex>>::
+                         downcast(getCacheEntry(s, enabledParallelForcesIndex));
+        const Array_<AffectedBodies>& parallelForceBodies =
+                Value<Array_<AffectedBodies>>::
+                         downcast(getCacheEntry(s, parallelForceBodiesIndex));
+        ForceSchedule& schedule = Value<ForceSchedule>::
+                         updDowncast(updCacheEntry(s, forceScheduleIndex));
+
+        CalcForcesTask task(forces, s, mode, enabledNonParallelForces,
+                            enabledParallelForces, parallelForceBodies,
+                            forceTarget, cacheTarget, schedule);
+        const int nTasks = std::min(getNumberOfThreads(), task.getNumItems());
+        if (nTasks <= 1) {
+            task.runSerially();
+            return;
+        }
+        task.prepareSchedule();
+        task.prepareAccumulators(nTasks);
+        calcForcesExecutor.execute(task, nTasks);
+        task.reduce();
+    }
+
     Real calcPotentialEnergy(const State& state) const override {
         const Array_<bool>& forceEnabled = Value<Array_<bool> >::downcast
            (getDiscreteVariable(state, forceEnabledIndex)).get();
@@ -918,8 +792,7 @@ private:
     Array_<Force*>                  forces;
 
     // For parallel calculation of forces.
-    mutable ClonePtr<ParallelExecutor>               calcForcesExecutor;
-    mutable ClonePtr<CalcForcesTask>                 calcForcesTask;
+    SliceExecutor                   calcForcesExecutor;
     
     // TOPOLOGY "CACHE"
     // These indices must be filled in during realizeTopology and treated
@@ -932,6 +805,10 @@ private:
     //parallel and non-parallel forces
     mutable CacheEntryIndex   enabledParallelForcesIndex;
     mutable CacheEntryIndex   enabledNonParallelForcesIndex;
+    mutable CacheEntryIndex   parallelForceBodiesIndex;
+
+    // Measured costs and scratch space for parallel evaluation.
+    mutable CacheEntryIndex   forceScheduleIndex;
 
     // This set of cache entries is allocated only if some force element
     // overrode dependsOnlyOnPositions().
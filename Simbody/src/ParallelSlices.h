@@ -0,0 +1,138 @@
+#ifndef SimTK_SIMBODY_PARALLEL_SLICES_H_
+#define SimTK_SIMBODY_PARALLEL_SLICES_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include <exception>
+#include <mutex>
+
+// Private helpers shared by the subsystems that can optionally divide their
+// work among a ParallelExecutor's threads.
+
+namespace SimTK {
+
+//==============================================================================
+//                               SLICE TASK
+//==============================================================================
+// A ParallelExecutor task that calls body(i) for every i in [0,n), with the
+// range split into nTasks contiguous slices. An exception thrown by body() is
+// caught and saved; rethrowIfFailed() rethrows the one from the lowest-
+// numbered failing slice so errors are reported as they would be by a serial
+// loop.
+template <class Body>
+class SliceTask : public ParallelExecutor::Task {
+public:
+    SliceTask(int n, int nTasks, Body& body)
+    :   n(n), nTasks(nTasks), body(body), errors(nTasks) {}
+
+    void execute(int taskNum) override {
+        const int begin = (taskNum*n) / nTasks;
+        const int end   = ((taskNum+1)*n) / nTasks;
+        try {
+            for (int i=begin; i < end; ++i)
+                body(i);
+        } catch (...) {
+            errors[taskNum] = std::current_exception();
+        }
+    }
+
+    void rethrowIfFailed() const {
+        for (int t=0; t < nTasks; ++t)
+            if (errors[t]) std::rethrow_exception(errors[t]);
+    }
+private:
+    const int                   n;
+    const int                   nTasks;
+    Body&                       body;
+    Array_<std::exception_ptr>  errors;
+};
+
+// Run the task on the executor's threads unless someone else is already using
+// that executor (the mutex is locked) or we are being called from inside a
+// worker thread; in those cases the task is run serially on this thread.
+inline void executeTaskIfIdle(ParallelExecutor& executor, std::mutex& busy,
+                              ParallelExecutor::Task& task, int nTasks) {
+    std::unique_lock<std::mutex> lock(busy, std::try_to_lock);
+    if (!lock.owns_lock() || ParallelExecutor::isWorkerThread()) {
+        task.initialize();
+        for (int t=0; t < nTasks; ++t)
+            task.execute(t);
+        task.finish();
+        return;
+    }
+    executor.execute(task, nTasks);
+}
+
+//==============================================================================
+//                             SLICE EXECUTOR
+//==============================================================================
+// A ParallelExecutor together with the mutex that keeps it from being used by
+// two threads at once, packaged so that it can be a member of a copyable
+// subsystem implementation class. Copying gives an executor with the same
+// number of threads and a new mutex. Worker threads are not started until
+// the first parallel execution.
+class SliceExecutor {
+public:
+    SliceExecutor() : executor(new ParallelExecutor()) {}
+    SliceExecutor(const SliceExecutor& src) : executor(src.executor) {}
+    SliceExecutor& operator=(const SliceExecutor& src)
+    {   executor = src.executor; return *this; }
+
+    void setNumberOfThreads(unsigned numThreads) {
+        SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "SliceExecutor",
+            "setNumberOfThreads", "Number of threads must be positive");
+        executor = new ParallelExecutor(numThreads);
+    }
+    int getNumberOfThreads() const {return executor->getMaxThreads();}
+
+    // Run an arbitrary task nTasks times, in parallel if the executor isn't
+    // already busy; see executeTaskIfIdle().
+    void execute(ParallelExecutor::Task& task, int nTasks) const
+    {   executeTaskIfIdle(*executor, busy, task, nTasks); }
+
+    // Call body(i) for every i in [0,n) split into nTasks contiguous slices
+    // that may run concurrently; with nTasks <= 1 this is an ordinary loop.
+    // Exceptions are rethrown here once all the slices are done.
+    template <class Body>
+    void executeInSlices(int n, int nTasks, Body& body) const {
+        if (nTasks <= 1) {
+            for (int i=0; i < n; ++i)
+                body(i);
+            return;
+        }
+        SliceTask<Body> task(n, nTasks, body);
+        executeTaskIfIdle(*executor, busy, task, nTasks);
+        task.rethrowIfFailed();
+    }
+
+private:
+    mutable ClonePtr<ParallelExecutor>  executor;
+    mutable std::mutex                  busy;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_PARALLEL_SLICES_H_
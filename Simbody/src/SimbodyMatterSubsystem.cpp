@@ -28,6 +28,7 @@
 
 #include "SimTKcommon.h"
 #include "simbody/internal/MobilizedBody.h"
+#include "simbody/internal/Constraint.h"
 
 #include "MobilizedBodyImpl.h"
 #include "SimbodyMatterSubsystemRep.h"
@@ -107,6 +108,30 @@ void SimbodyMatterSubsystem::setShowDefaultGeometry(bool show) {
     updRep().setShowDefaultGeometry(show);
 }
 
+bool SimbodyMatterSubsystem::getUseParallelTreeSweeps() const {
+    return getRep().getUseParallelTreeSweeps();
+}
+
+void SimbodyMatterSubsystem::setUseParallelTreeSweeps(bool useParallel) {
+    updRep().setUseParallelTreeSweeps(useParallel);
+}
+
+void SimbodyMatterSubsystem::setNumberOfThreads(unsigned numThreads) {
+    updRep().setNumberOfThreads(numThreads);
+}
+
+int SimbodyMatterSubsystem::getNumberOfThreads() const {
+    return getRep().getNumberOfThreads();
+}
+
+bool SimbodyMatterSubsystem::getUseSparseConstraintProjection() const {
+    return getRep().getUseSparseConstraintProjection();
+}
+
+void SimbodyMatterSubsystem::setUseSparseConstraintProjection(bool useSparse) {
+    updRep().setUseSparseConstraintProjection(useSparse);
+}
+
 
 ConstraintIndex SimbodyMatterSubsystem::
 adoptConstraint(Constraint& child) {return updRep().adoptConstraint(child);}
@@ -1069,6 +1094,174 @@ void SimbodyMatterSubsystem::multiplyByNDot
 
 
 
+//==============================================================================
+//                               ODE JACOBIAN
+//==============================================================================
+// Both methods perturb a copy of the State and realize the whole System
+// through Acceleration stage, then difference the resulting qdot and udot
+// against those already in the State. State copies share their cache 
+// entries until they are written, so making the copies is cheap.
+
+void SimbodyMatterSubsystem::calcODEJacobianTimesVector
+   (const State& state, const Vector& v, Vector& Jv) const
+{
+    const int nq = getQ(state).size(), nu = getU(state).size();
+    SimTK_STAGECHECK_GE_ALWAYS(state.getSystemStage(), Stage::Acceleration,
+        "SimbodyMatterSubsystem::calcODEJacobianTimesVector()");
+    SimTK_APIARGCHECK2_ALWAYS(v.size() == nq+nu,
+        "SimbodyMatterSubsystem", "calcODEJacobianTimesVector",
+        "Got a direction v of length %d but nq+nu=%d.", v.size(), nq+nu);
+
+    Jv.resize(nq+nu);
+    const Real vNorm = v.normRMS();
+    if (vNorm == 0) {Jv.setToZero(); return;}
+
+    // Choose the step so that the perturbation of y is about SqrtEps 
+    // relative to y's RMS size (absolute if y is small).
+    const Real yNorm = std::sqrt((getQ(state).normSqr() 
+                                  + getU(state).normSqr()) / (nq+nu));
+    const Real h = SqrtEps*std::max(Real(1), yNorm) / vNorm;
+
+    State perturbed = state;
+    updQ(perturbed) += h*v(0,nq);
+    updU(perturbed) += h*v(nq,nu);
+    getSystem().realize(perturbed, Stage::Acceleration);
+
+    const Real oneOverH = 1/h;
+    Jv(0,nq)  = oneOverH*(getQDot(perturbed) - getQDot(state));
+    Jv(nq,nu) = oneOverH*(getUDot(perturbed) - getUDot(state));
+}
+
+void SimbodyMatterSubsystem::calcODEJacobian
+   (const State& state, bool independentSubtrees,
+    Array_<int>& colStart, Array_<int>& rowIndex, Array_<Real>& value) const
+{
+    const int nq = getQ(state).size(), nu = getU(state).size();
+    const int n = nq+nu, nb = getNumBodies();
+    SimTK_STAGECHECK_GE_ALWAYS(state.getSystemStage(), Stage::Acceleration,
+        "SimbodyMatterSubsystem::calcODEJacobian()");
+
+    // Find the base subtree of each body, that is, the child of Ground it
+    // descends from. Bodies are numbered with parents first. Then merge 
+    // base subtrees that are connected by an enabled Constraint, using a 
+    // union-find forest over base body numbers. Ground is group -1.
+    Array_<int> group(nb, -1), link(nb);
+    for (MobodIndex mbx(1); mbx < nb; ++mbx) {
+        const MobodIndex parent = getMobilizedBody(mbx)
+                                    .getParentMobilizedBody()
+                                    .getMobilizedBodyIndex();
+        group[mbx] = (parent == 0 ? (int)mbx : group[parent]);
+        link[mbx] = group[mbx];
+    }
+    auto findRoot = [&link](int g) {
+        while (link[g] != g) g = link[g] = link[link[g]];
+        return g;
+    };
+    auto join = [&](int g1, int g2) {
+        if (g1 < 0 || g2 < 0) return; // Ground doesn't couple anything
+        g1 = findRoot(g1); g2 = findRoot(g2);
+        if (g1 != g2) link[std::max(g1,g2)] = std::min(g1,g2);
+    };
+
+    if (!independentSubtrees) {
+        for (MobodIndex mbx(2); mbx < nb; ++mbx)
+            join(group[1], group[mbx]);
+    } else {
+        for (ConstraintIndex cx(0); cx < getNumConstraints(); ++cx) {
+            const Constraint& c = getConstraint(cx);
+            if (c.isDisabled(state)) continue;
+            int first = -1;
+            for (ConstrainedBodyIndex cbx(0); 
+                 cbx < c.getNumConstrainedBodies(); ++cbx) {
+                const int g = group[c.getMobilizedBodyFromConstrainedBody(cbx)
+                                     .getMobilizedBodyIndex()];
+                if (first < 0) first = g; else join(first, g);
+            }
+            for (ConstrainedMobilizerIndex cmx(0); 
+                 cmx < c.getNumConstrainedMobilizers(); ++cmx) {
+                const int g = group[c.getMobilizedBodyFromConstrainedMobilizer
+                                     (cmx).getMobilizedBodyIndex()];
+                if (first < 0) first = g; else join(first, g);
+            }
+        }
+    }
+
+    // Collect the columns (q's, then u's) and the udot rows of each group, 
+    // and note which body owns each column since that body's qdots are the
+    // only qdots that can depend on it.
+    Array_<Array_<int> > groupCols(nb), groupURows(nb);
+    Array_<MobodIndex> colOwner(n);
+    Array_<int> colGroup(n);
+    for (MobodIndex mbx(1); mbx < nb; ++mbx) {
+        const MobilizedBody& mobod = getMobilizedBody(mbx);
+        const int g = findRoot(group[mbx]);
+        const int q0 = mobod.getFirstQIndex(state), mq = mobod.getNumQ(state);
+        const int u0 = mobod.getFirstUIndex(state), mu = mobod.getNumU(state);
+        for (int i=0; i < mq; ++i) {
+            groupCols[g].push_back(q0+i);
+            colOwner[q0+i] = mbx; colGroup[q0+i] = g;
+        }
+        for (int i=0; i < mu; ++i) {
+            groupCols[g].push_back(nq+u0+i);
+            groupURows[g].push_back(nq+u0+i);
+            colOwner[nq+u0+i] = mbx; colGroup[nq+u0+i] = g;
+        }
+    }
+    int nColors = 0;
+    for (int g=0; g < nb; ++g) {
+        std::sort(groupURows[g].begin(), groupURows[g].end());
+        nColors = std::max(nColors, (int)groupCols[g].size());
+    }
+
+    // Lay out the sparsity pattern: in column j, the owner's qdots (which
+    // precede all the udots) followed by the udots of j's group.
+    colStart.resize(n+1);
+    rowIndex.clear();
+    colStart[0] = 0;
+    for (int j=0; j < n; ++j) {
+        const MobilizedBody& owner = getMobilizedBody(colOwner[j]);
+        const int q0 = owner.getFirstQIndex(state), mq = owner.getNumQ(state);
+        for (int i=0; i < mq; ++i)
+            rowIndex.push_back(q0+i);
+        const Array_<int>& uRows = groupURows[colGroup[j]];
+        rowIndex.insert(rowIndex.end(), uRows.begin(), uRows.end());
+        colStart[j+1] = (int)rowIndex.size();
+    }
+    value.resize(rowIndex.size());
+
+    // Each color perturbs the k'th column of every group that has one; those
+    // columns have no rows in common so their differences can be separated.
+    Vector y0(n), f0(n), f(n);
+    y0(0,nq) = getQ(state);    y0(nq,nu) = getU(state);
+    f0(0,nq) = getQDot(state); f0(nq,nu) = getUDot(state);
+    Array_<int> perturbedCols;
+    Array_<Real> steps;
+    for (int k=0; k < nColors; ++k) {
+        State perturbed = state;
+        Vector& q = updQ(perturbed);
+        Vector& u = updU(perturbed);
+        perturbedCols.clear(); steps.clear();
+        for (int g=0; g < nb; ++g) {
+            if (k >= (int)groupCols[g].size()) continue;
+            const int j = groupCols[g][k];
+            const Real h = SqrtEps*std::max(Real(1), std::abs(y0[j]));
+            if (j < nq) q[j] += h; else u[j-nq] += h;
+            perturbedCols.push_back(j); steps.push_back(h);
+        }
+        getSystem().realize(perturbed, Stage::Acceleration);
+        f(0,nq) = getQDot(perturbed); f(nq,nu) = getUDot(perturbed);
+
+        for (unsigned p=0; p < perturbedCols.size(); ++p) {
+            const int j = perturbedCols[p];
+            const Real oneOverH = 1/steps[p];
+            for (int e=colStart[j]; e < colStart[j+1]; ++e)
+                value[e] = oneOverH*(f[rowIndex[e]] - f0[rowIndex[e]]);
+        }
+    }
+}
+
+
+
 
 //==============================================================================
 //                            JACOBIAN METHODS
@@ -35,13 +35,17 @@
 #include "MobilizedBodyImpl.h"
 #include "ConstraintImpl.h"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 using std::cout; using std::endl;
 
 SimbodyMatterSubsystemRep::SimbodyMatterSubsystemRep
    (const SimbodyMatterSubsystemRep& src)
-:   SimTK::Subsystem::Guts("SimbodyMatterSubsystemRep", "X.X.X")
+:   SimTK::Subsystem::Guts("SimbodyMatterSubsystemRep", "X.X.X"),
+    useParallelTreeSweeps(src.useParallelTreeSweeps),
+    treeSweepExecutor(src.treeSweepExecutor),
+    useSparseConstraintProjection(src.useSparseConstraintProjection)
 {
     assert(!"SimbodyMatterSubsystemRep copy constructor ... TODO!");
 }
@@ -477,6 +481,14 @@ int SimbodyMatterSubsystemRep::realizeSubsystemTopologyImpl(State& s) const {
         allocateLazyCacheEntry(s, Stage::Dynamics,
                                new Value<SBConstrainedAccelerationCache>());
 
+    // The factored projected inverse mass matrix G M^-1 ~G is needed for 
+    // every constrained acceleration and impulse calculation at a given
+    // configuration. It is only calculated when needed, and may then be 
+    // reused until t or q change (and possibly u; see SBProjectedMInvCache).
+    tc.projectedMInvCacheIndex =
+        allocateLazyCacheEntry(s, Stage::Position,
+                               new Value<SBProjectedMInvCache>());
+
     tc.valid = true;
 
     // Allocate a cache entry for the topologyCache, and save a copy there.
@@ -1130,9 +1142,8 @@ realizePositionKinematics(const State& state) const {
     // Any body which is using quaternions should calculate the quaternion
     // constraint here and put it in the appropriate slot of qErr.
     // Set generalized coordinates: sweep from base to tips.
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; i++) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++)
-            rbNodeLevels[i][j]->realizePosition(stateDigest); 
+    sweepOutward([&](const RigidBodyNode& node)
+                 {   node.realizePosition(stateDigest); });
 
     // Ask the constraints to calculate ancestor-relative kinematics (still 
     // goes in TreePositionCache).
@@ -1238,9 +1249,8 @@ realizeArticulatedBodyInertias(const State& state) const {
     SBArticulatedBodyInertiaCache&  abc = updArticulatedBodyInertiaCache(state);
 
     // tip-to-base sweep
-    for (int i=rbNodeLevels.size()-1 ; i>=0 ; --i) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; ++j)
-            rbNodeLevels[i][j]->realizeArticulatedBodyInertiasInward(ic,tpc,abc);
+    sweepInward([&](const RigidBodyNode& node)
+                {   node.realizeArticulatedBodyInertiasInward(ic,tpc,abc); });
 
     markCacheValueRealized(state, abx);
 }
@@ -1374,9 +1384,8 @@ realizeVelocityKinematics(const State& state) const {
     // and all global velocities relative to Ground (G). Also computes qdots.
 
     // Set generalized speeds: sweep from base to tips.
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; ++i) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; ++j)
-            rbNodeLevels[i][j]->realizeVelocity(stateDigest); 
+    sweepOutward([&](const RigidBodyNode& node)
+                 {   node.realizeVelocity(stateDigest); });
 
     // Ask the constraints to calculate ancestor-relative velocity kinematics 
     // (still goes in TreeVelocityCache).
@@ -1453,10 +1462,9 @@ realizeArticulatedBodyVelocity(const State& state) const {
 
     // Order doesn't matter for this calculation. Ground's entries are
     // precalculated so start at level 1.
-    for (int i=1 ; i<(int)rbNodeLevels.size() ; i++) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++)
-            rbNodeLevels[i][j]->realizeArticulatedBodyVelocityCache
-                                                            (tpc,tvc,abc,abvc);
+    sweepOutward([&](const RigidBodyNode& node)
+                 {   node.realizeArticulatedBodyVelocityCache(tpc,tvc,abc,abvc); },
+                 1);
 
     markCacheValueRealized(state, abvx);
 }
@@ -2533,11 +2541,13 @@ calcPVATranspose(   const State&     s,
     if (m==0 || nu==0)
         return;
 
-    Vector lambda(m, Real(0));
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector lambda = arena.allocateVector<Real>(m, Real(0));
 
     // If PVAt's columns are contiguous we can avoid copying.
     const bool isContiguous = PVAt(0).hasContiguousData();
-    Vector contig_col(isContiguous ? 0 : m);
+    Vector contig_col = arena.allocateVector<Real>(isContiguous ? 0 : nu);
     for (int j=0; j < m; ++j) {
         lambda[j] = 1; // column we're working on
         if (isContiguous) {
@@ -2662,8 +2672,11 @@ calcWeightedPqrTranspose(
 
     assert(Pqw_rt(0).hasContiguousData());
 
-    Vector Ptcol(nu), PNInvtcol;
-    Vector lambdap(mp, Real(0));
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector Ptcol = arena.allocateVector<Real>(nu);
+    Vector PNInvtcol = arena.allocateVector<Real>(mustPack ? nq : 0);
+    Vector lambdap = arena.allocateVector<Real>(mp, Real(0));
 
     for (int j=0; j < mp; ++j) {
         lambdap[j] = Tp[j]; // this gives column j of ~P scaled by Tp[j]
@@ -2729,9 +2742,11 @@ calcWeightedPVrTranspose(
 
     assert(PVw_rt.hasContiguousData());
 
-    Vector lambdapv(mpv, Real(0));
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector lambdapv = arena.allocateVector<Real>(mpv, Real(0));
     if (mustPack) {
-        Vector PVtcol(nu);
+        Vector PVtcol = arena.allocateVector<Real>(nu);
         for (int j=0; j < mpv; ++j) {
             lambdapv[j] = Tpv[j]; // this gives column j of ~PV scaled by Tpv[i]
             multiplyByPVATranspose(s, true, true, false, lambdapv, PVtcol);
@@ -2752,6 +2767,202 @@ calcWeightedPVrTranspose(
 
 
 
+
+//==============================================================================
+//                      CALC SPARSE WEIGHTED Pq_r and PV_r
+//==============================================================================
+// These produce the same weighted matrices as calcWeightedPqrTranspose() and
+// calcWeightedPVrTranspose() above, but untransposed and in sparse form. 
+// Rather than generating each row with an O(n) operator, we ask each 
+// Constraint for the forces produced by one multiplier at a time and map 
+// those to generalized forces only along the paths from its constrained 
+// bodies to Ground. So the cost is proportional to the number of nonzeros
+// rather than to m*n, and the dense factorization is avoided entirely.
+template <class Column>
+void SimbodyMatterSubsystemRep::
+forEachSparsePVTransposeColumn(const State& s, bool includeV, 
+                               Column& column) const
+{
+    const SBInstanceCache&      ic  = getInstanceCache(s);
+    const SBTreePositionCache&  tpc = getTreePositionCache(s);
+    const int mp = ic.totalNHolonomicConstraintEquationsInUse;
+
+    Vector fu(getNU(s), Real(0));
+    Array_<MobilizedBodyIndex>          touched;
+    Array_<bool,MobilizedBodyIndex>     isTouched(getNumBodies(), false);
+    auto touch = [&](MobilizedBodyIndex mbx) {
+        if (!isTouched[mbx]) {isTouched[mbx] = true; touched.push_back(mbx);}
+    };
+
+    Array_<SpatialVec,ConstrainedBodyIndex> oneF_A; // body forces in A
+    Array_<Real,      ConstrainedUIndex>    onefu;
+    Array_<Real> lambda, noLambda;
+
+    for (ConstraintIndex cx(0); cx < constraints.size(); ++cx) {
+        if (isConstraintDisabled(s,cx))
+            continue;
+
+        const ConstraintImpl& crep = constraints[cx]->getImpl();
+        const SBInstancePerConstraintInfo& 
+                              cInfo = ic.getConstraintInstanceInfo(cx);
+        const Rotation R_GA = crep.isAncestorDifferentFromGround()
+            ? crep.getAncestorMobilizedBody().getBodyRotation(s) : Rotation();
+
+        for (int level=0; level < (includeV ? 2 : 1); ++level) {
+            const Segment& seg = level==0 ? cInfo.holoErrSegment 
+                                          : cInfo.nonholoErrSegment;
+            lambda.resize(seg.length); lambda.fill(Real(0));
+            for (int k=0; k < seg.length; ++k) {
+                lambda[k] = 1;
+                if (level==0)
+                    crep.calcConstraintForcesFromMultipliers
+                       (s, lambda, noLambda, noLambda, oneF_A, onefu);
+                else
+                    crep.calcConstraintForcesFromMultipliers
+                       (s, noLambda, lambda, noLambda, oneF_A, onefu);
+                lambda[k] = 0;
+
+                for (ConstrainedMobilizerIndex cmx(0); 
+                     cmx < crep.getNumConstrainedMobilizers(); ++cmx)
+                    touch(crep.getMobilizedBodyIndexOfConstrainedMobilizer(cmx));
+                for (ConstrainedUIndex cux(0); cux < onefu.size(); ++cux)
+                    fu[cInfo.getUIndexFromConstrainedU(cux)] += onefu[cux];
+
+                // This is ~J applied to the force on each constrained body,
+                // following just the path from that body to Ground; see
+                // multiplyBySystemJacobianTranspose().
+                for (ConstrainedBodyIndex cbx(0); cbx < oneF_A.size(); ++cbx) {
+                    SpatialVec z = R_GA*oneF_A[cbx];
+                    const RigidBodyNode* node = &getRigidBodyNode
+                        (crep.getMobilizedBodyIndexOfConstrainedBody(cbx));
+                    for (; node->getLevel() > 0; node = node->getParent()) {
+                        touch(MobilizedBodyIndex(node->getNodeNum()));
+                        for (int d=0; d < node->getDOF(); ++d)
+                            fu[node->getUIndex()+d] += 
+                                ~node->getHCol(tpc, d) * z;
+                        z = node->getPhi(tpc) * z;
+                    }
+                }
+
+                column(level==0 ? seg.offset+k : mp+seg.offset+k, 
+                       fu, (const Array_<MobilizedBodyIndex>&)touched);
+
+                for (MobilizedBodyIndex mbx : touched) {
+                    const RigidBodyNode& node = getRigidBodyNode(mbx);
+                    for (int d=0; d < node.getDOF(); ++d)
+                        fu[node.getUIndex()+d] = 0;
+                    isTouched[mbx] = false;
+                }
+                touched.clear();
+            }
+        }
+    }
+}
+
+void SimbodyMatterSubsystemRep::
+calcSparseWeightedPqr( 
+        const State&                s,
+        const Vector&               Tp,   // 1/perr tols (mp)
+        const Vector&               ooWu, // 1/u weights (nu)
+        SparseConstraintProjection& Pqw_r) const // mp X nfq
+{
+    const SBInstanceCache& ic = getInstanceCache(s);
+
+    const int mp = ic.totalNHolonomicConstraintEquationsInUse;
+    const int nu = getNU(s);
+    const int nq = getNQ(s);
+    const int nfq = ic.getTotalNumFreeQ();
+
+    assert(Tp.size() == mp);
+    assert(ooWu.size() == nu);
+
+    Pqw_r.clear(mp, nfq);
+    if (mp==0 || nfq==0)
+        return;
+
+    // Where each q goes in the packed free q's, or -1 if it is prescribed.
+    const Array_<QIndex>& freeQX = getFreeQIndex(s);
+    Array_<int> freeOfQ(nq, -1);
+    for (int i=0; i < nfq; ++i)
+        freeOfQ[freeQX[i]] = i;
+
+    // The rows are completed out of order, so hold them until the end.
+    const SBStateDigest sbState(s, *this, Stage(Stage::Position).next());
+    Array_< Array_<std::pair<int,Real> > > rows(mp);
+    Array_<Real> qcol; // N^-T applied to one mobilizer's u's
+    auto column = [&](int j, Vector& fu, 
+                      const Array_<MobilizedBodyIndex>& touched) {
+        Array_<std::pair<int,Real> >& row = rows[j];
+        for (MobilizedBodyIndex mbx : touched) {
+            const RigidBodyNode& node = getRigidBodyNode(mbx);
+            const int maxNQ = node.getMaxNQ();
+            if (maxNQ == 0) continue;
+            const int ux = node.getUIndex(), qx = node.getQIndex();
+            for (int d=0; d < node.getDOF(); ++d)
+                fu[ux+d] *= Tp[j]*ooWu[ux+d]; // now (Wu^-1 ~P Tp)_j
+            qcol.resize(maxNQ);
+            qcol[maxNQ-1] = 0; // see multiplyByNInv()
+            node.multiplyByNInv(sbState, true/*transpose*/, &fu[ux], &qcol[0]);
+            for (int i=0; i < maxNQ; ++i)
+                if (freeOfQ[qx+i] >= 0)
+                    row.push_back(std::make_pair(freeOfQ[qx+i], qcol[i]));
+        }
+        std::sort(row.begin(), row.end());
+    };
+    forEachSparsePVTransposeColumn(s, false, column);
+
+    for (int j=0; j < mp; ++j)
+        Pqw_r.setRow(j, rows[j]);
+}
+
+void SimbodyMatterSubsystemRep::
+calcSparseWeightedPVr(
+        const State&                s,
+        const Vector&               Tpv,  // 1/verr tols (mp+mv)
+        const Vector&               ooWu, // 1/u weights (nu)
+        SparseConstraintProjection& PVw_r) const // mpv X nfu
+{
+    const SBInstanceCache& ic = getInstanceCache(s);
+
+    const int mp = ic.totalNHolonomicConstraintEquationsInUse;
+    const int mv = ic.totalNNonholonomicConstraintEquationsInUse;
+    const int mpv = mp+mv;
+    const int nu = getNU(s);
+    const int nfu = ic.getTotalNumFreeU();
+
+    assert(Tpv.size() == mpv);
+    assert(ooWu.size() == nu);
+
+    PVw_r.clear(mpv, nfu);
+    if (mpv==0 || nfu==0)
+        return;
+
+    // Where each u goes in the packed free u's, or -1 if it is prescribed.
+    const Array_<UIndex>& freeUX = getFreeUIndex(s);
+    Array_<int> freeOfU(nu, -1);
+    for (int i=0; i < nfu; ++i)
+        freeOfU[freeUX[i]] = i;
+
+    Array_< Array_<std::pair<int,Real> > > rows(mpv);
+    auto column = [&](int j, Vector& fu, 
+                      const Array_<MobilizedBodyIndex>& touched) {
+        Array_<std::pair<int,Real> >& row = rows[j];
+        for (MobilizedBodyIndex mbx : touched) {
+            const RigidBodyNode& node = getRigidBodyNode(mbx);
+            const int ux = node.getUIndex();
+            for (int d=0; d < node.getDOF(); ++d)
+                if (freeOfU[ux+d] >= 0) // (Wu^-1 ~PV Tpv)_j
+                    row.push_back(std::make_pair(freeOfU[ux+d], 
+                                                 fu[ux+d]*Tpv[j]*ooWu[ux+d]));
+        }
+        std::sort(row.begin(), row.end());
+    };
+    forEachSparsePVTransposeColumn(s, true, column);
+
+    for (int j=0; j < mpv; ++j)
+        PVw_r.setRow(j, rows[j]);
+}
+
 //==============================================================================
 //                      CALC BIAS FOR MULTIPLY BY PVA
 //==============================================================================
@@ -3447,13 +3658,15 @@ calcPVA(const State&     s,
     if (m==0 || nu==0)
         return;
 
-    Vector bias(m);
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector bias = arena.allocateVector<Real>(m);
     calcBiasForMultiplyByPVA(s, includeP, includeV, includeA, bias);
-    Vector ulike(nu, Real(0));
+    Vector ulike = arena.allocateVector<Real>(nu, Real(0));
 
     // If PVA's columns are contiguous we can avoid copying.
     const bool isContiguous = PVA(0).hasContiguousData();
-    Vector contig_col(isContiguous ? 0 : m); // temp space if needed
+    Vector contig_col = arena.allocateVector<Real>(isContiguous ? 0 : m);
     for (int j=0; j < nu; ++j) {
         ulike[j] = 1; // column we're working on
         if (isContiguous) {
@@ -3470,6 +3683,117 @@ calcPVA(const State&     s,
 
 
 
+// =============================================================================
+//                    FIND DYNAMICALLY COUPLED EQUATIONS
+// =============================================================================
+// Two constraint equations can be coupled through M^-1 only if the mobilities
+// they involve lie in the same grounded subtree, that is, if their constrained
+// bodies and constrained mobilizers share a base body (a body whose parent is
+// Ground). Equations from constraints that touch disjoint grounded subtrees
+// produce exact zeroes in G M^-1 ~G, since a force applied in one subtree
+// produces no acceleration in another. Here we partition the active constraint
+// equations, numbered as rows of G=[P;V;A], into groups such that G M^-1 ~G is 
+// block diagonal when its rows and columns are permuted by group. Equations 
+// within a group are in increasing order, and groups are ordered by their 
+// first equation. A constraint that involves only Ground forms a group of its
+// own.
+//
+// Complexity is O(m + d*ncb) where ncb is the total number of constrained 
+// bodies and mobilizers and d is the depth of the tree.
+void SimbodyMatterSubsystemRep::
+findDynamicallyCoupledEquations(const State&            s,
+                                Array_< Array_<int> >&  groups) const
+{
+    const SBInstanceCache& ic = getInstanceCache(s);
+    const int mHolo    = ic.totalNHolonomicConstraintEquationsInUse;
+    const int mNonholo = ic.totalNNonholonomicConstraintEquationsInUse;
+    const int nb       = getNumBodies();
+
+    groups.clear();
+
+    // Disjoint sets of base bodies; two base bodies end up in the same set
+    // when some constraint involves both of their subtrees.
+    Array_<MobilizedBodyIndex,MobilizedBodyIndex> setOf(nb);
+    for (MobilizedBodyIndex mbx(0); mbx < nb; ++mbx)
+        setOf[mbx] = mbx;
+    auto findSet = [&setOf](MobilizedBodyIndex b) {
+        while (setOf[b] != b)
+            b = setOf[b] = setOf[setOf[b]];
+        return b;
+    };
+    auto findBaseBody = [this](MobilizedBodyIndex mbx) {
+        const RigidBodyNode* node = &getRigidBodyNode(mbx);
+        while (node->getLevel() > 1)
+            node = node->getParent();
+        return node->getNodeNum(); // Ground if mbx is Ground
+    };
+
+    // One base body from each enabled constraint's subtrees; invalid if the
+    // constraint involves only Ground.
+    Array_<MobilizedBodyIndex,ConstraintIndex> baseOf(constraints.size());
+    for (ConstraintIndex cx(0); cx < constraints.size(); ++cx) {
+        if (isConstraintDisabled(s,cx))
+            continue;
+        const ConstraintImpl& crep = constraints[cx]->getImpl();
+        MobilizedBodyIndex& first = baseOf[cx];
+        auto join = [&](MobilizedBodyIndex mbx) {
+            const MobilizedBodyIndex base = findBaseBody(mbx);
+            if (base == GroundIndex) return;
+            if (!first.isValid()) {first = base; return;}
+            setOf[findSet(base)] = findSet(first);
+        };
+        for (ConstrainedBodyIndex cbx(0); 
+             cbx < crep.getNumConstrainedBodies(); ++cbx)
+            join(crep.getMobilizedBodyIndexOfConstrainedBody(cbx));
+        for (ConstrainedMobilizerIndex cmx(0); 
+             cmx < crep.getNumConstrainedMobilizers(); ++cmx)
+            join(crep.getMobilizedBodyIndexOfConstrainedMobilizer(cmx));
+    }
+
+    // Now collect each constraint's equations into the group for its set.
+    Array_<int,MobilizedBodyIndex> groupOfSet(nb, -1);
+    for (ConstraintIndex cx(0); cx < constraints.size(); ++cx) {
+        if (isConstraintDisabled(s,cx))
+            continue;
+        const SBInstancePerConstraintInfo& 
+                        cInfo = ic.getConstraintInstanceInfo(cx);
+        const Segment& holoSeg    = cInfo.holoErrSegment;
+        const Segment& nonholoSeg = cInfo.nonholoErrSegment;
+        const Segment& accOnlySeg = cInfo.accOnlyErrSegment;
+        if (holoSeg.length+nonholoSeg.length+accOnlySeg.length == 0)
+            continue;
+
+        int g;
+        if (baseOf[cx].isValid()) {
+            const MobilizedBodyIndex set = findSet(baseOf[cx]);
+            if (groupOfSet[set] < 0) {
+                groupOfSet[set] = (int)groups.size();
+                groups.push_back();
+            }
+            g = groupOfSet[set];
+        } else {
+            g = (int)groups.size();
+            groups.push_back();
+        }
+
+        Array_<int>& group = groups[g];
+        for (int i=0; i < holoSeg.length; ++i)
+            group.push_back(holoSeg.offset + i);
+        for (int i=0; i < nonholoSeg.length; ++i)
+            group.push_back(mHolo + nonholoSeg.offset + i);
+        for (int i=0; i < accOnlySeg.length; ++i)
+            group.push_back(mHolo + mNonholo + accOnlySeg.offset + i);
+    }
+
+    for (auto& group : groups)
+        std::sort(group.begin(), group.end());
+    std::sort(groups.begin(), groups.end(), 
+              [](const Array_<int>& g1, const Array_<int>& g2)
+              {   return g1.front() < g2.front(); });
+}
+
+
+
 // =============================================================================
 //                            CALC G MInv G^T
 // =============================================================================
@@ -3477,7 +3801,8 @@ calcPVA(const State&     s,
 //     (G M^-1 ~G) lambda = aerr
 // and need a fast way to explicitly calculate this mXm matrix.
 // Optimally, we would calculate it in O(m^2) time. I don't know 
-// how to calculate it that fast, but using m calls to operator sequence:
+// how to calculate it that fast, but using a series of calls to the operator
+// sequence:
 //     Gt_j       = Gt* lambda_j        O(n)
 //     MInvGt_j   = M^-1* Gt_j          O(n)
 //     GMInvGt(j) = G* MInvGt_j         O(n)
@@ -3487,6 +3812,20 @@ calcPVA(const State&     s,
 // reasonable. One slip up and you'll toss in a factor of mn^2 or m^2n and
 // screw this up -- be careful!
 //
+// We do partition it into subblocks: equations from constraints acting on 
+// disjoint grounded subtrees are not coupled by M^-1 (see
+// findDynamicallyCoupledEquations()), so the matrix is block diagonal after
+// a permutation. And because the operators above don't mix up disjoint 
+// subtrees, we can compute one column from *every* block in the same operator
+// sweep by setting one lambda_j for each block. So the number of sweeps is
+// the size k of the largest block rather than m, and the complexity drops to
+// O(k*n). For example, a few hundred contacts between the ground and many
+// independent free bodies costs only as much as the few contacts on the most
+// heavily constrained body. The off-block entries are left exactly zero
+// without being computed; they would have come out zero anyway. When 
+// parallel tree sweeps are enabled, the sweeps for different sets of columns 
+// are done concurrently.
+//
 // When there is prescribed motion in the system the matrix we want is
 // Gr Mrr^-1 ~Gr. That is still an mXm matrix and we are able to produce it
 // with no visible effort due to the definition of our a=M^-1*f operator. It 
@@ -3495,14 +3834,12 @@ calcPVA(const State&     s,
 // removing the Gp columns of G in the final operation. Note: the resulting
 // matrix is *not* a submatrix of G*M^-1*~G!
 //
-// Note that we do not require contiguous storage for GMInvGt's columns, 
-// although we'll take advantage of it if they are. If not, we'll work in
-// a contiguous temp and then copy back. This is because we want to allow
-// any matrix at the Simbody API level and we don't want to force the API
-// method to have to allocate a whole new mXm matrix when all we need for
-// a temporary here is an m-length temporary.
+// Note that we do not require contiguous storage for GMInvGt's columns; we
+// work in contiguous temporaries and then copy the block entries in. This is
+// because we want to allow any matrix at the Simbody API level and we don't 
+// want to force the API method to have to allocate a whole new mXm matrix.
 //
-// Complexity is O(m^2 + m*n) = O(m*n).
+// Complexity is O(m^2 + k*n), with k <= m the size of the largest block.
 //
 // TODO: as long as the force transmission matrix for all constraints is G^T
 // the resulting matrix is symmetric. But (a) I don't know how to take 
@@ -3520,63 +3857,323 @@ calcGMInvGt(const State&   s,
     const int mNonholo = ic.totalNNonholonomicConstraintEquationsInUse;
     const int mAccOnly = ic.totalNAccelerationOnlyConstraintEquationsInUse;
     const int m        = mHolo+mNonholo+mAccOnly;  
-    const int nu       = getNU(s);
 
     GMInvGt.resize(m,m);
     if (m==0) return;
+    GMInvGt.setToZero();
 
-    // If the output matrix doesn't have columns in contiguous memory, we'll
-    // allocate a contiguous-memory temp that we can use to hold one column
-    // at a time as we compute them.
-    const bool columnsAreContiguous = GMInvGt(0).hasContiguousData();
-    Vector GMInvGt_j(columnsAreContiguous ? 0 : m);
+    Array_< Array_<int> > groups;
+    findDynamicallyCoupledEquations(s, groups);
+    calcGMInvGtBlocks(s, groups, GMInvGt);
+} 
 
-    // These two temporaries are always needed to hold one column of Gt,
-    // then one column of M^-1 * Gt.
-    Vector Gtcol(nu), MInvGtcol(nu);
+void SimbodyMatterSubsystemRep::
+calcGMInvGtBlocks(const State&                  s,
+                  const Array_< Array_<int> >&  groups,
+                  Matrix&                       GMInvGt) const
+{
+    const int m  = GMInvGt.nrow();
+    const int nu = getNU(s);
+
+    // Sweep number "color" computes the color'th column of every group that 
+    // has that many columns.
+    int nColors = 0;
+    for (const auto& group : groups)
+        nColors = std::max(nColors, (int)group.size());
 
     // Precalculate bias so we can perform multiplication by G efficiently.
-    Vector bias(m);
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector bias = arena.allocateVector<Real>(m);
     calcBiasForMultiplyByPVA(s,true,true,true,bias);
-   
-    // Lambda is used to pluck out one column at a time of Gt. Exactly one
-    // element at a time of lambda will be 1, the rest are 0.
-    Vector lambda(m, Real(0));
 
-    for (int j=0; j < m; ++j) {
-        lambda[j] = 1;
+    // multiplyByMInv() would realize these on demand, but that must not
+    // happen concurrently from several threads.
+    realizeArticulatedBodyInertias(s);
+
+    auto calcColumns = [&](int color) {
+        // This may be running on a worker thread, which has its own arena.
+        ScratchArena& colArena = ScratchArena::getThreadArena();
+        ScratchArena::Scope colScratch(colArena);
+        // Lambda is used to pluck out one column of Gt from each group. 
+        Vector lambda     = colArena.allocateVector<Real>(m, Real(0));
+        Vector Gtcol      = colArena.allocateVector<Real>(nu);
+        Vector MInvGtcol  = colArena.allocateVector<Real>(nu);
+        Vector GMInvGtcol = colArena.allocateVector<Real>(m);
+        for (const auto& group : groups)
+            if (color < (int)group.size())
+                lambda[group[color]] = 1;
+
         multiplyByPVATranspose(s, true, true, true, lambda, Gtcol);
-        lambda[j] = 0;
         multiplyByMInv(s, Gtcol, MInvGtcol);
-        if (columnsAreContiguous)
-            multiplyByPVA(s, true, true, true, bias, MInvGtcol, GMInvGt(j));
-        else {
-            multiplyByPVA(s, true, true, true, bias, MInvGtcol, GMInvGt_j);
-            GMInvGt(j) = GMInvGt_j;
+        multiplyByPVA(s, true, true, true, bias, MInvGtcol, GMInvGtcol);
+
+        for (const auto& group : groups) {
+            if (color >= (int)group.size())
+                continue;
+            const int j = group[color];
+            for (int i : group)
+                GMInvGt(i,j) = GMInvGtcol[i];
         }
-    }
+    };
+
+    executeInSlices(nColors, calcNumGMInvGtTasks(s, nColors), calcColumns);
 } 
 
+// We can't evaluate the same constraint concurrently on several threads if it
+// writes to scratch space in the constraint object itself. Of the built-in
+// constraints only CoordinateCoupler, SpeedCoupler and PrescribedMotion do
+// that (their mutable "temp" Vector), and those are implemented as
+// Constraint::Custom, as are all user-written constraints, about which we
+// can't know anything. So columns are calculated serially if any enabled
+// constraint is a Custom one. The other built-in constraints write their
+// mutable members only when topology is realized.
+int SimbodyMatterSubsystemRep::
+calcNumGMInvGtTasks(const State& s, int nColors) const {
+    if (!useParallelTreeSweeps || nColors < 2)
+        return 1;
+    for (ConstraintIndex cx(0); cx < constraints.size(); ++cx)
+        if (!isConstraintDisabled(s,cx) && dynamic_cast<const Constraint::
+                CustomImpl*>(&constraints[cx]->getImpl()))
+            return 1;
+    return std::min(nColors, getNumberOfThreads());
+}
+
+
+
+// =============================================================================
+//                       REALIZE PROJECTED MINV FACTOR
+// =============================================================================
+// Make sure the cached factorization of G M^-1 ~G is valid, calculating it if
+// necessary. This is O(m^3) for the factorization plus O(k*n) for forming the
+// matrix (see calcGMInvGt()), but when all that has changed since the cached
+// matrix was formed is that some constraints were enabled or disabled we 
+// only have to recalculate the blocks of dynamically coupled equations that
+// contain a newly-enabled constraint. The other blocks consist entirely of
+// entries for constraints that are still enabled, and since each block is 
+// calculated independently of the others those entries are exactly what a
+// fresh calculation would produce; we just move them to their new rows and
+// columns. So the updated matrix doesn't depend on the history of enabling
+// and disabling, nor on the matrix being symmetric. We don't have a way to 
+// update a rank-revealing factorization, so we refactor from scratch; that is
+// necessary anyway to handle redundant constraints the same way as for a 
+// freshly-formed matrix.
+const SBProjectedMInvCache& SimbodyMatterSubsystemRep::
+realizeProjectedMInvFactor(const State& s) const {
+    const SBInstanceCache& ic = getInstanceCache(s);
+    const int mHolo    = ic.totalNHolonomicConstraintEquationsInUse;
+    const int mNonholo = ic.totalNNonholonomicConstraintEquationsInUse;
+    const int mAccOnly = ic.totalNAccelerationOnlyConstraintEquationsInUse;
+    const int m        = mHolo+mNonholo+mAccOnly;
+
+    const CacheEntryIndex pmcx = topologyCache.projectedMInvCacheIndex;
+    SBProjectedMInvCache& pmc = updProjectedMInvCache(s);
+    const bool dependsOnU = mNonholo+mAccOnly > 0;
+    if (   isCacheValueRealized(s, pmcx) 
+        && (!dependsOnU || pmc.uVersion == s.getUValueVersion()))
+        return pmc;
+
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Matrix GMInvGt = arena.allocateMatrix<Real>(m,m);
+    if (canUpdateProjectedMInv(s, pmc)) {
+        // Find the old row of each current equation, or -1 if it is new.
+        Array_<int> oldRow = arena.allocateArray<int>(m);
+        oldRow.fill(-1);
+        for (ConstraintIndex cx(0); cx < constraints.size(); ++cx) {
+            if (isConstraintDisabled(s,cx) || pmc.constraintIsDisabled[cx])
+                continue;
+            const SBInstancePerConstraintInfo& 
+                            cInfo = ic.getConstraintInstanceInfo(cx);
+            const Segment& holoSeg    = cInfo.holoErrSegment;
+            const Segment& nonholoSeg = cInfo.nonholoErrSegment;
+            const Segment& accOnlySeg = cInfo.accOnlyErrSegment;
+            for (int i=0; i < holoSeg.length; ++i)
+                oldRow[holoSeg.offset + i] = 
+                    pmc.holoErrSegment[cx].offset + i;
+            for (int i=0; i < nonholoSeg.length; ++i)
+                oldRow[mHolo + nonholoSeg.offset + i] = 
+                    pmc.mHolo + pmc.nonholoErrSegment[cx].offset + i;
+            for (int i=0; i < accOnlySeg.length; ++i)
+                oldRow[mHolo + mNonholo + accOnlySeg.offset + i] =
+                    pmc.mHolo + pmc.mNonholo 
+                    + pmc.accOnlyErrSegment[cx].offset + i;
+        }
+
+        // Copy the blocks that have no new equations and recalculate the rest.
+        Array_< Array_<int> > groups, newGroups;
+        findDynamicallyCoupledEquations(s, groups);
+        GMInvGt.setToZero();
+        for (const auto& group : groups) {
+            bool isNew = false;
+            for (int i : group)
+                if (oldRow[i] < 0) {isNew = true; break;}
+            if (isNew) {
+                newGroups.push_back(group);
+                continue;
+            }
+            for (int j : group)
+                for (int i : group)
+                    GMInvGt(i,j) = pmc.GMInvGt(oldRow[i],oldRow[j]);
+        }
+        if (!newGroups.empty())
+            calcGMInvGtBlocks(s, newGroups, GMInvGt);
+    } else
+        calcGMInvGt(s, GMInvGt);
+
+    pmc.GMInvGt = GMInvGt;
+
+    // Conditioning tolerance. This determines when we'll drop a 
+    // constraint. 
+    // TODO: this is probably too tight; should depend on constraint tolerance
+    // and should be consistent with position and velocity projection ranks.
+    // Tricky here because conditioning depends on mass matrix as well as
+    // constraints.
+    const Real conditioningTol = m 
+        //* SignificantReal;
+        * SqrtEps*std::sqrt(SqrtEps); // Eps^(3/4)
+    if (m)
+        pmc.factor.factor(pmc.GMInvGt, conditioningTol);
+
+    // Remember the equation layout so that the matrix can be updated later.
+    pmc.mHolo = mHolo; pmc.mNonholo = mNonholo; pmc.mAccOnly = mAccOnly;
+    const int nc = constraints.size();
+    pmc.constraintIsDisabled.resize(nc);
+    pmc.holoErrSegment.resize(nc);
+    pmc.nonholoErrSegment.resize(nc);
+    pmc.accOnlyErrSegment.resize(nc);
+    for (ConstraintIndex cx(0); cx < nc; ++cx) {
+        const SBInstancePerConstraintInfo& 
+                        cInfo = ic.getConstraintInstanceInfo(cx);
+        pmc.constraintIsDisabled[cx] = isConstraintDisabled(s,cx);
+        pmc.holoErrSegment[cx]       = cInfo.holoErrSegment;
+        pmc.nonholoErrSegment[cx]    = cInfo.nonholoErrSegment;
+        pmc.accOnlyErrSegment[cx]    = cInfo.accOnlyErrSegment;
+    }
+    pmc.isValid = true;
+    recordProjectedMInvDependencies(s, pmc);
+
+    markCacheValueRealized(s, pmcx);
+    return pmc;
+}
+
+void SimbodyMatterSubsystemRep::
+recordProjectedMInvDependencies(const State&            s,
+                                SBProjectedMInvCache&   pmc) const {
+    const SubsystemIndex subx = getMySubsystemIndex();
+    const PerSubsystemInfo& info = s.getPerSubsystemInfo(subx);
+    pmc.modelStageVersion = info.getStageVersion(Stage::Model);
+    pmc.qVersion = s.getQValueVersion();
+    pmc.uVersion = s.getUValueVersion();
+    pmc.time     = s.getTime();
+    pmc.instanceVars = getInstanceVars(s);
+    pmc.discreteVarVersions.clear();
+    for (DiscreteVariableIndex dx(0); 
+         dx < info.getNextDiscreteVariableIndex(); ++dx)
+        pmc.discreteVarVersions.push_back
+           (info.getDiscreteVarInfo(dx).getValueVersion());
+}
+
+// Return true if two sets of instance variables are identical, except 
+// possibly for which constraints are disabled.
+static bool 
+sameInstanceVarsExceptConstraints(const SBInstanceVars& a,
+                                  const SBInstanceVars& b) {
+    if (a.bodyMassProperties.size() != b.bodyMassProperties.size())
+        return false;
+    for (MobilizedBodyIndex mbx(0); mbx < a.bodyMassProperties.size(); ++mbx) {
+        const MassProperties& ma = a.bodyMassProperties[mbx];
+        const MassProperties& mb = b.bodyMassProperties[mbx];
+        if (   ma.getMass() != mb.getMass() 
+            || ma.getMassCenter() != mb.getMassCenter()
+            || !(ma.getUnitInertia() == mb.getUnitInertia()))
+            return false;
+    }
+    auto sameVector = [](const Vector& va, const Vector& vb) {
+        if (va.size() != vb.size()) return false;
+        for (int i=0; i < va.size(); ++i)
+            if (va[i] != vb[i]) return false;
+        return true;
+    };
+    return a.outboardMobilizerFrames == b.outboardMobilizerFrames
+        && a.inboardMobilizerFrames  == b.inboardMobilizerFrames
+        && a.mobilizerLockLevel      == b.mobilizerLockLevel
+        && sameVector(a.lockedQs, b.lockedQs)
+        && sameVector(a.lockedUs, b.lockedUs)
+        && a.prescribedMotionIsDisabled == b.prescribedMotionIsDisabled
+        && sameVector(a.particleMasses, b.particleMasses);
+}
+
+// The cached matrix can be updated if it has been calculated before and 
+// nothing it depends on has changed other than the set of enabled 
+// constraints. Instance variables are a special case since the enabled flags
+// are kept there, so we compare their contents rather than their version.
+bool SimbodyMatterSubsystemRep::
+canUpdateProjectedMInv(const State&                 s,
+                       const SBProjectedMInvCache&  pmc) const {
+    if (!pmc.isValid)
+        return false;
+
+    const SubsystemIndex subx = getMySubsystemIndex();
+    const PerSubsystemInfo& info = s.getPerSubsystemInfo(subx);
+    const bool dependsOnU = 
+           getNumNonholonomicConstraintEquationsInUse(s) 
+         + getNumAccelerationOnlyConstraintEquationsInUse(s) > 0;
+    if (   pmc.modelStageVersion != info.getStageVersion(Stage::Model)
+        || pmc.qVersion != s.getQValueVersion()
+        || (dependsOnU && pmc.uVersion != s.getUValueVersion())
+        || pmc.time != s.getTime())
+        return false;
+
+    const DiscreteVariableIndex ivx = topologyCache.topoInstanceVarsIndex;
+    if (!sameInstanceVarsExceptConstraints(pmc.instanceVars, 
+                                           getInstanceVars(s)))
+        return false;
+    if (pmc.discreteVarVersions.size() != info.getNextDiscreteVariableIndex())
+        return false;
+    for (DiscreteVariableIndex dx(0); 
+         dx < info.getNextDiscreteVariableIndex(); ++dx)
+        if (dx != ivx && pmc.discreteVarVersions[dx] 
+                            != info.getDiscreteVarInfo(dx).getValueVersion())
+            return false;
+
+    // Constraints that are enabled now and were before must still be using
+    // the same number of equations.
+    if (pmc.constraintIsDisabled.size() != constraints.size())
+        return false;
+    const SBInstanceCache& ic = getInstanceCache(s);
+    for (ConstraintIndex cx(0); cx < constraints.size(); ++cx) {
+        if (isConstraintDisabled(s,cx) || pmc.constraintIsDisabled[cx])
+            continue;
+        const SBInstancePerConstraintInfo& 
+                        cInfo = ic.getConstraintInstanceInfo(cx);
+        if (   cInfo.holoErrSegment.length 
+                    != pmc.holoErrSegment[cx].length
+            || cInfo.nonholoErrSegment.length 
+                    != pmc.nonholoErrSegment[cx].length
+            || cInfo.accOnlyErrSegment.length 
+                    != pmc.accOnlyErrSegment[cx].length)
+            return false;
+    }
+    return true;
+}
+
 
 
 // =============================================================================
 //                     SOLVE FOR CONSTRAINT IMPULSES
 // =============================================================================
-// Current implementation computes G*M^-1*~G, factors it, and does a single
-// solve all at great expense.
-// TODO: should realize factored matrix if needed and reuse if possible.
+// This uses the same cached factorization of G*M^-1*~G as is used for forward 
+// dynamics, calculating it first if necessary, so repeated impulse solves at
+// the same configuration cost only O(m^2) each.
 void SimbodyMatterSubsystemRep::
 solveForConstraintImpulses(const State&     state,
                            const Vector&    deltaV,
                            Vector&          impulse) const
 {
-    Matrix GMInvGt;
-    calcGMInvGt(state, GMInvGt);
-    // MUST DUPLICATE SIMBODY'S METHOD HERE:
-    const Real conditioningTol = GMInvGt.nrow() 
-                                    * SqrtEps*std::sqrt(SqrtEps); // Eps^(3/4)
-    FactorQTZ qtz(GMInvGt, conditioningTol); 
-    qtz.solve(deltaV, impulse);
+    const SBProjectedMInvCache& pmc = realizeProjectedMInvFactor(state);
+    if (pmc.GMInvGt.nrow() == 0) {impulse.resize(0); return;}
+    pmc.factor.solve(deltaV, impulse);
 }
 
 
@@ -4257,29 +4854,47 @@ int SimbodyMatterSubsystemRep::projectQ
       //* SignificantReal; -- too tight
         * SqrtEps;
 
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+
     // Keep the starting q in case we have to restore it, which we'll do
     // if the attempts here make the constraint norm worse.
-    const Vector saveQ = getQ(s);
-
-    Matrix Pqwrt(nfq,mHolo);
-    Vector dfq_WLS(nfq), du(nu), dq(nq); // = Wq^+ dq_WLS
-    Vector udfq_WLS(hasPrescribedMotion ? nq : 0); // unpacked if needed
+    Vector saveQ = arena.allocateVector<Real>(nq);
+    saveQ = getQ(s);
+
+    // If requested, we keep the weighted Jacobian sparse and solve with its
+    // normal equations instead of the dense pseudoinverse.
+    const bool useSparse = useSparseConstraintProjection;
+    Matrix Pqwrt = arena.allocateMatrix<Real>(useSparse ? 0 : nfq, 
+                                              useSparse ? 0 : mHolo);
+    Vector dfq_WLS = arena.allocateVector<Real>(nfq); // = Wq^+ dq_WLS
+    Vector du = arena.allocateVector<Real>(nu);
+    Vector dq = arena.allocateVector<Real>(nq);
+    // unpacked if needed
+    Vector udfq_WLS = arena.allocateVector<Real>(hasPrescribedMotion ? nq : 0);
     udfq_WLS.setToZero(); // must initialize unwritten elements
     FactorQTZ Pqwr_qtz;
+    SparseConstraintProjection Pqwr_sparse;
     Real prevPerrNormAchieved = perrNormAchieved; // watch for divergence
     bool diverged = false;
     const int MaxIterations  = 20;
     do {
-        calcWeightedPqrTranspose(s, perrWeights, uAbsScale, Pqwrt);//nfq X mp
+        if (useSparse) {
+            calcSparseWeightedPqr(s, perrWeights, uAbsScale, Pqwr_sparse);
+            Pqwr_sparse.factor(conditioningTol);
+            Pqwr_sparse.solve(scaledPerrs, dfq_WLS); // weighted dq_WLS=Wq*dq
+        } else {
+            calcWeightedPqrTranspose(s, perrWeights, uAbsScale, Pqwrt);
 
-        // This factorization acts like a pseudoinverse.
-        Pqwr_qtz.factor<Real>(~Pqwrt, conditioningTol); 
+            // This factorization acts like a pseudoinverse.
+            Pqwr_qtz.factor<Real>(~Pqwrt, conditioningTol); 
 
-        //printf("projectQ %d: m=%d condTol=%g rank=%d rcond=%g\n",
-        //    nItsUsed, Pqwrt.ncol(), conditioningTol, Pqwr_qtz.getRank(),
-        //    Pqwr_qtz.getRCondEstimate());
+            //printf("projectQ %d: m=%d condTol=%g rank=%d rcond=%g\n",
+            //    nItsUsed, Pqwrt.ncol(), conditioningTol, Pqwr_qtz.getRank(),
+            //    Pqwr_qtz.getRCondEstimate());
 
-        Pqwr_qtz.solve(scaledPerrs, dfq_WLS); // this is weighted dq_WLS=Wq*dq
+            Pqwr_qtz.solve(scaledPerrs, dfq_WLS); // weighted dq_WLS=Wq*dq
+        }
         lastChangeMadeWRMS = dfq_WLS.normRMS(); // change in weighted norm
 
         // switch back to unweighted dq=Wq^+*dq_WLS
@@ -4394,13 +5009,15 @@ int SimbodyMatterSubsystemRep::projectQ
             zeroKnownQ(s, qErrest_0); // zero out prescribed entries
             multiplyByPq(s, bias_p, qErrest_0, Tp_Pq_qErrest); // (Pq*qErrest)_r
             Tp_Pq_qErrest.rowScaleInPlace(perrWeights); // now Tp*(Pq*qErrest)_r
-            Pqwr_qtz.solve(Tp_Pq_qErrest, dfq_WLS); // weighted
+            if (useSparse) Pqwr_sparse.solve(Tp_Pq_qErrest, dfq_WLS);
+            else Pqwr_qtz.solve(Tp_Pq_qErrest, dfq_WLS); // weighted
             unpackFreeQ(s, dfq_WLS, udfq_WLS); // zeroes in q_p slots
             multiplyByNInv(s,false,udfq_WLS,du);
         } else {
             multiplyByPq(s, bias_p, qErrest, Tp_Pq_qErrest); // Pq*qErrest
             Tp_Pq_qErrest.rowScaleInPlace(perrWeights); // now Tp*Pq*qErrest
-            Pqwr_qtz.solve(Tp_Pq_qErrest, dfq_WLS); // weighted
+            if (useSparse) Pqwr_sparse.solve(Tp_Pq_qErrest, dfq_WLS);
+            else Pqwr_qtz.solve(Tp_Pq_qErrest, dfq_WLS); // weighted
             multiplyByNInv(s,false,dfq_WLS,du);
         }
         // Here du = du_WLS = N^+ * dq_WLS
@@ -4794,32 +5411,44 @@ int SimbodyMatterSubsystemRep::projectU
         //* SignificantReal;
         * SqrtEps;
 
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+
     // Keep the starting u in case we have to restore it, which we'll do
     // if the attempts here make the constraint norm worse.
-    const Vector saveU = getU(s);
+    Vector saveU = arena.allocateVector<Real>(nu);
+    saveU = getU(s);
 
-    Matrix PVwrt(nfu, mHolo+mNonholo);
-    Vector dfu_WLS(nfu);
-    Vector du(nu); // unpacked into here if necessary
+    Vector dfu_WLS = arena.allocateVector<Real>(nfu);
+    Vector du = arena.allocateVector<Real>(nu); // unpacked into here if needed
     if (hasPrescribedMotion)
         du.setToZero(); // must initialize unwritten elements
 
-    calcWeightedPVrTranspose(s, pverrWeights, uRelScale, PVwrt);
-    // PVwrt is now Eu^-1 (Pt Vt) Tpv
-
-    // Calculate pseudoinverse (just once)
+    // Calculate pseudoinverse (just once), either densely or by factoring the
+    // sparse normal equations if that was requested.
+    const bool useSparse = useSparseConstraintProjection;
     FactorQTZ PVwr_qtz;
-    PVwr_qtz.factor<Real>(~PVwrt, conditioningTol);
+    SparseConstraintProjection PVwr_sparse;
+    if (useSparse) {
+        calcSparseWeightedPVr(s, pverrWeights, uRelScale, PVwr_sparse);
+        PVwr_sparse.factor(conditioningTol);
+    } else {
+        Matrix PVwrt = arena.allocateMatrix<Real>(nfu, mHolo+mNonholo);
+        calcWeightedPVrTranspose(s, pverrWeights, uRelScale, PVwrt);
+        // PVwrt is now Eu^-1 (Pt Vt) Tpv
+        PVwr_qtz.factor<Real>(~PVwrt, conditioningTol);
 
-    //printf("projectU m=%d condTol=%g rank=%d rcond=%g\n",
-    //    PVwrt.ncol(), conditioningTol, PVwr_qtz.getRank(),
-    //    PVwr_qtz.getRCondEstimate());
+        //printf("projectU m=%d condTol=%g rank=%d rcond=%g\n",
+        //    PVwrt.ncol(), conditioningTol, PVwr_qtz.getRank(),
+        //    PVwr_qtz.getRCondEstimate());
+    }
 
     Real prevPVerrNormAchieved = pverrNormAchieved; // watch for divergence
     bool diverged = false;
     const int MaxIterations  = 7;
     do {
-        PVwr_qtz.solve(scaledPVerrs, dfu_WLS);
+        if (useSparse) PVwr_sparse.solve(scaledPVerrs, dfu_WLS);
+        else PVwr_qtz.solve(scaledPVerrs, dfu_WLS);
         lastChangeMadeWRMS = dfu_WLS.normRMS(); // change in weighted norm
 
         // switch back to unweighted du=Eu^-1*du_WLS
@@ -4921,12 +5550,14 @@ int SimbodyMatterSubsystemRep::projectU
             multiplyByPVA(s,true,true,false,bias_pv,
                             uErrest_0,Tpv_PV_uErrest);
             Tpv_PV_uErrest.rowScaleInPlace(pverrWeights); // = Tpv*PV*uErrest_0
-            PVwr_qtz.solve(Tpv_PV_uErrest, dfu_WLS);
+            if (useSparse) PVwr_sparse.solve(Tpv_PV_uErrest, dfu_WLS);
+            else PVwr_qtz.solve(Tpv_PV_uErrest, dfu_WLS);
             unpackFreeU(s, dfu_WLS, du); // still weighted
         } else {
             multiplyByPVA(s,true,true,false,bias_pv,uErrest,Tpv_PV_uErrest);
             Tpv_PV_uErrest.rowScaleInPlace(pverrWeights); // = Tpv PV uErrEst
-            PVwr_qtz.solve(Tpv_PV_uErrest, du);
+            if (useSparse) PVwr_sparse.solve(Tpv_PV_uErrest, du);
+            else PVwr_qtz.solve(Tpv_PV_uErrest, du);
         }
         du.rowScaleInPlace(uRelScale); // now du=Eu^-1*unpack(dfu_WLS)
         uErrest -= du; // this is unweighted now
@@ -5069,10 +5700,11 @@ void SimbodyMatterSubsystemRep::realizeTreeForwardDynamics(
 // Given a State realized through Stage::Dynamics, and a complete set of applied 
 // forces, calculate all acceleration results resulting from those forces AND 
 // enforcement of the acceleration constraints. The results go into the return 
-// arguments here. This routine *does not* affect the State cache -- it is an 
-// operator. In typical usage, the output arguments actually will be part of 
-// the state cache to effect a response, but this method can also be used to 
-// effect an operator.
+// arguments here. This routine *does not* affect the State cache, other than
+// to realize the factored G M^-1 ~G matrix if needed -- it is an operator.
+// In typical usage, the output arguments actually will be part of the state
+// cache to effect a response, but this method can also be used to effect an
+// operator.
 void SimbodyMatterSubsystemRep::calcLoopForwardDynamicsOperator
    (const State& s, 
     const Vector&                   mobilityForces,
@@ -5107,37 +5739,28 @@ void SimbodyMatterSubsystemRep::calcLoopForwardDynamicsOperator
     if (m==0) return;
     if (nu==0) {multipliers.setToZero(); return;}
 
-    // Conditioning tolerance. This determines when we'll drop a 
-    // constraint. 
-    // TODO: this is probably too tight; should depend on constraint tolerance
-    // and should be consistent with position and velocity projection ranks.
-    // Tricky here because conditioning depends on mass matrix as well as
-    // constraints.
-    const Real conditioningTol = m 
-        //* SignificantReal;
-        * SqrtEps*std::sqrt(SqrtEps); // Eps^(3/4)
-
     // Calculate multipliers lambda as
     //     (G M^-1 ~G) lambda = aerr
-    // The method here calculates the mXm matrix G*M^-1*G^T as fast as 
-    // I know how to do, O(m*n) with O(n) temporary memory, using a series
-    // of O(n) operators. Then we'll factor it here in O(m^3) time. 
-    Matrix GMInvGt(m,m);
-    calcGMInvGt(s, GMInvGt);
-    
-    // specify 1/cond at which we declare rank deficiency
-    FactorQTZ qtz(GMInvGt, conditioningTol); 
+    // The mXm matrix G*M^-1*G^T is calculated as fast as I know how to do, 
+    // O(m*n) with O(n) temporary memory, using a series of O(n) operators. 
+    // Then it is factored in O(m^3) time. Both are done only when the cached 
+    // factorization is out of date; most of the time this is just an O(m^2)
+    // solve.
+    const SBProjectedMInvCache& pmc = realizeProjectedMInvFactor(s);
 
-    //printf("fwdDynamics: m=%d condTol=%g rank=%d rcond=%g\n",
-    //    GMInvGt.nrow(), conditioningTol, qtz.getRank(),
-    //    qtz.getRCondEstimate());
+    //printf("fwdDynamics: m=%d rank=%d rcond=%g\n",
+    //    pmc.GMInvGt.nrow(), pmc.factor.getRank(),
+    //    pmc.factor.getRCondEstimate());
 
-    qtz.solve(udotErr, multipliers);
+    pmc.factor.solve(udotErr, multipliers);
 
     // We have the multipliers, now turn them into forces.
 
-    Vector_<SpatialVec> bodyForcesInG;
-    Vector              mobilityF;
+    ScratchArena& arena = ScratchArena::getThreadArena();
+    ScratchArena::Scope scratch(arena);
+    Vector_<SpatialVec> bodyForcesInG = 
+        arena.allocateVector<SpatialVec>(getNumBodies());
+    Vector              mobilityF = arena.allocateVector<Real>(nu);
     calcConstraintForcesFromMultipliers(s,multipliers,bodyForcesInG,mobilityF,
         cac.constrainedBodyForcesInG, cac.constraintMobilityForces);
     // Note that constraint forces have the opposite sign from applied forces
@@ -5324,22 +5947,18 @@ void SimbodyMatterSubsystemRep::calcTreeAccelerations(const State& s,
     for (int i=0; i < (int)ic.zeroUDot.size(); ++i)
         udotPtr[ic.zeroUDot[i]] = 0;
 
-    for (int i=rbNodeLevels.size()-1 ; i>=0 ; i--) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.calcUDotPass1Inward(ic,tpc,abc,abvc,
-                mobilityForcePtr, bodyForcePtr, udotPtr, zPtr, zPlusPtr,
-                hingeForcePtr);
-        }
+    sweepInward([&](const RigidBodyNode& node) {
+        node.calcUDotPass1Inward(ic,tpc,abc,abvc,
+            mobilityForcePtr, bodyForcePtr, udotPtr, zPtr, zPlusPtr,
+            hingeForcePtr);
+    });
 
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; i++)
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.calcUDotPass2Outward(ic,tpc,abc,tvc,dc, 
-                hingeForcePtr, aPtr, udotPtr, tauPtr);
-            node.calcQDotDot(sbs, &udotPtr[node.getUIndex()], 
-                             &qdotdotPtr[node.getQIndex()]);
-        }
+    sweepOutward([&](const RigidBodyNode& node) {
+        node.calcUDotPass2Outward(ic,tpc,abc,tvc,dc, 
+            hingeForcePtr, aPtr, udotPtr, tauPtr);
+        node.calcQDotDot(sbs, &udotPtr[node.getUIndex()], 
+                         &qdotdotPtr[node.getQIndex()]);
+    });
 }
 //......................... CALC TREE ACCELERATIONS ............................
 
@@ -5384,19 +6003,15 @@ void SimbodyMatterSubsystemRep::multiplyByMInv(const State& s,
     const Real* fPtr     = &f[0];       
     Real*       MInvfPtr = &MInvf[0];
 
-    for (int i=rbNodeLevels.size()-1 ; i>=0 ; i--) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.multiplyByMInvPass1Inward(ic,tpc,abc,
-                fPtr, z.begin(), zPlus.begin(), eps.begin());
-        }
+    sweepInward([&](const RigidBodyNode& node) {
+        node.multiplyByMInvPass1Inward(ic,tpc,abc,
+            fPtr, z.begin(), zPlus.begin(), eps.begin());
+    });
 
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; i++)
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.multiplyByMInvPass2Outward(ic,tpc,abc, 
-                eps.cbegin(), A_GB.begin(), MInvfPtr);
-        }
+    sweepOutward([&](const RigidBodyNode& node) {
+        node.multiplyByMInvPass2Outward(ic,tpc,abc, 
+            eps.cbegin(), A_GB.begin(), MInvfPtr);
+    });
 }
 //............................. CALC M INVERSE F ...............................
 
@@ -5433,17 +6048,13 @@ void SimbodyMatterSubsystemRep::multiplyByM(const State&    s,
     const Real* aPtr    = &a[0];       
     Real*       MaPtr   = &Ma[0];
 
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; i++)
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.multiplyByMPass1Outward(tpc, aPtr, A_GB.begin());
-        }
+    sweepOutward([&](const RigidBodyNode& node) {
+        node.multiplyByMPass1Outward(tpc, aPtr, A_GB.begin());
+    });
 
-    for (int i=rbNodeLevels.size()-1 ; i>=0 ; i--) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.multiplyByMPass2Inward(tpc,A_GB.cbegin(),fTmp.begin(),MaPtr);
-        }
+    sweepInward([&](const RigidBodyNode& node) {
+        node.multiplyByMPass2Inward(tpc,A_GB.cbegin(),fTmp.begin(),MaPtr);
+    });
 }
 
 
@@ -5598,21 +6209,17 @@ void SimbodyMatterSubsystemRep::calcTreeResidualForces(const State& s,
                         ? &residualMobilityForces[0] : NULL;
     SpatialVec* tempPtr = allFTmp.size() ? &allFTmp[0] : NULL;
 
-    for (int i=0 ; i<(int)rbNodeLevels.size() ; i++)
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.calcBodyAccelerationsFromUdotOutward
-               (tpc,tvc,knownUdotPtr,aPtr);
-        }
+    sweepOutward([&](const RigidBodyNode& node) {
+        node.calcBodyAccelerationsFromUdotOutward
+           (tpc,tvc,knownUdotPtr,aPtr);
+    });
 
-    for (int i=rbNodeLevels.size()-1 ; i>=0 ; i--) 
-        for (int j=0 ; j<(int)rbNodeLevels[i].size() ; j++) {
-            const RigidBodyNode& node = *rbNodeLevels[i][j];
-            node.calcInverseDynamicsPass2Inward(
-                tpc,tvc,aPtr,
-                mobilityForcePtr,bodyForcePtr,
-                tempPtr,residualPtr);
-        }
+    sweepInward([&](const RigidBodyNode& node) {
+        node.calcInverseDynamicsPass2Inward(
+            tpc,tvc,aPtr,
+            mobilityForcePtr,bodyForcePtr,
+            tempPtr,residualPtr);
+    });
 }
 //........................ CALC TREE RESIDUAL FORCES ...........................
 
@@ -6397,6 +7004,22 @@ void SimbodyMatterSubsystemRep::setShowDefaultGeometry(bool show) {
     showDefaultGeometry = show;
 }
 
+void SimbodyMatterSubsystemRep::setNumberOfThreads(unsigned numThreads) {
+    treeSweepExecutor.setNumberOfThreads(numThreads);
+}
+
+int SimbodyMatterSubsystemRep::getNumberOfThreads() const {
+    return treeSweepExecutor.getNumberOfThreads();
+}
+
+int SimbodyMatterSubsystemRep::
+calcNumTreeSweepTasks(int nodesInLevel) const {
+    if (!useParallelTreeSweeps || nodesInLevel < MinNodesPerParallelLevel)
+        return 1;
+    const int maxTasks = nodesInLevel / MinNodesPerTreeSweepTask;
+    return std::min(maxTasks, treeSweepExecutor.getNumberOfThreads());
+}
+
 std::ostream& operator<<(std::ostream& o, const SimbodyMatterSubsystemRep& tree) {
     o << "SimbodyMatterSubsystemRep has " << tree.getNumBodies() << " bodies (incl. G) in "
       << tree.rbNodeLevels.size() << " levels." << std::endl;
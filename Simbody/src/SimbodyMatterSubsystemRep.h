@@ -35,6 +35,8 @@
 
 #include "SimbodyTreeState.h"
 #include "RigidBodyNode.h"
+#include "SparseConstraintProjection.h"
+#include "ParallelSlices.h"
 
 #include <set>
 #include <map>
@@ -48,6 +50,8 @@ using std::pair;
 #include <map>
 #include <set>
 #include <algorithm>
+#include <exception>
+#include <mutex>
 
 class RigidBodyNode;
 class RBDistanceConstraint;
@@ -141,7 +145,9 @@ private:
 class SimbodyMatterSubsystemRep : public SimTK::Subsystem::Guts {
 public:
     SimbodyMatterSubsystemRep() 
-      : Subsystem::Guts("SimbodyMatterSubsystem", "0.7.1")
+      : Subsystem::Guts("SimbodyMatterSubsystem", "0.7.1"),
+        useParallelTreeSweeps(false),
+        useSparseConstraintProjection(false)
     { 
         clearTopologyCache();
     }
@@ -923,23 +929,40 @@ public:
     void calcPq(    const State&     state,
                     Matrix&          Pq) const;
 
+    // Partition the active constraint equations (rows of G) into groups 
+    // that are not coupled to one another through M^-1 because they act on
+    // disjoint grounded subtrees. Each group lists its equations in 
+    // increasing order; groups are ordered by their first equation.
+    void findDynamicallyCoupledEquations(const State&           state,
+                                         Array_< Array_<int> >& groups) const;
+
     // Calculate the mXm "projected mass matrix" G * M^-1 * G^T. By using
-    // a combination of O(n) operators we can calculate this in O(m*n) time.
+    // a combination of O(n) operators we can calculate this in O(k*n) time,
+    // where k <= m is the size of the largest block of dynamically coupled
+    // constraint equations; entries outside those blocks are exactly zero.
     // The method requires only O(n) memory also, except for the mXm result.
     // State must be realized through Velocity stage unless all constraints
     // are holonomic in which case Position will do. This matrix is used
     // when solving for Lagrange multipliers: (G M^-1 G^T) lambda = aerr
-    // gives values for lambda that elimnate aerr.
-    // Performance is best if the output matrix has columns stored 
-    // contiguously in memory, but this method will work anyway, in that case
-    // using a contiguous temporary for column calculations and then copying
-    // out into the result.
+    // gives values for lambda that elimnate aerr. Columns are computed 
+    // concurrently if parallel tree sweeps are enabled.
     void calcGMInvGt(const State&   state,
                      Matrix&        GMInvGt) const;
 
+    // Calculate and factor G M^-1 G^T if the cached factorization isn't
+    // already valid, and return it. When the only change since it was last
+    // calculated is that some constraints have been enabled or disabled, the
+    // blocks of the stale matrix that are unaffected are reused, only the 
+    // blocks involving newly-enabled constraints are recalculated, and the
+    // result is refactored. 
+    // State must be realized as for calcGMInvGt().
+    const SBProjectedMInvCache& 
+    realizeProjectedMInvFactor(const State& state) const;
+
     // Use factored GMInvGt to solve GMinvGt*impulse=deltaV. The main benefit
     // of this method is that it promises to use the same method Simbody does
-    // to deal with constraint redundancies.
+    // to deal with constraint redundancies; it uses the same cached 
+    // factorization as forward dynamics.
     void solveForConstraintImpulses(const State&     state,
                                     const Vector&    deltaV,
                                     Vector&          impulse) const;
@@ -1139,6 +1162,13 @@ public:
             (s.updCacheEntry(getMySubsystemIndex(),topologyCache.constrainedAccelerationCacheIndex)).upd();
     }
 
+    // This is used even when it isn't valid; see SBProjectedMInvCache. Use
+    // realizeProjectedMInvFactor() to get a valid one.
+    SBProjectedMInvCache& updProjectedMInvCache(const State& s) const { //mutable
+        return Value<SBProjectedMInvCache>::updDowncast
+            (s.updCacheEntry(getMySubsystemIndex(),topologyCache.projectedMInvCacheIndex)).upd();
+    }
+
 
     const SBModelVars& getModelVars(const State& s) const {
         return Value<SBModelVars>::downcast
@@ -1210,6 +1240,17 @@ public:
     bool getShowDefaultGeometry() const;
     void setShowDefaultGeometry(bool show);
 
+    bool getUseParallelTreeSweeps() const {return useParallelTreeSweeps;}
+    void setUseParallelTreeSweeps(bool useParallel)
+    {   useParallelTreeSweeps = useParallel; }
+    void setNumberOfThreads(unsigned numThreads);
+    int getNumberOfThreads() const;
+
+    bool getUseSparseConstraintProjection() const
+    {   return useSparseConstraintProjection; }
+    void setUseSparseConstraintProjection(bool useSparse)
+    {   useSparseConstraintProjection = useSparse; }
+
     void calcTreeForwardDynamicsOperator(const State&,
         const Vector&                   mobilityForces,
         const Vector_<Vec3>&            particleForces,
@@ -1269,6 +1310,31 @@ public:
         const Vector&    Wuinv, // 1/u weights
         Matrix&          PVrt) const;
 
+    // Same as above but stored as the sparse (mp X nfq) or (mpv X nfu)
+    // weighted constraint matrix itself, ready to be factored.
+    void calcSparseWeightedPqr(
+        const State&                s,
+        const Vector&               Tp,
+        const Vector&               Wqinv,
+        SparseConstraintProjection& Pqw_r) const;
+    void calcSparseWeightedPVr(
+        const State&                s,
+        const Vector&               Tpv,
+        const Vector&               Wuinv,
+        SparseConstraintProjection& PVw_r) const;
+
+    // Helper for the above. For each holonomic and (if includeV) each 
+    // nonholonomic constraint equation j, calculate column j of ~PV and call
+    // column(j, fu, touched). Only the entries of fu belonging to the 
+    // mobilizers listed in touched can be nonzero; those are the mobilizers
+    // constrained directly by j's Constraint and those on the paths from its
+    // constrained bodies to Ground. So the cost of each column is 
+    // proportional to its number of nonzeros rather than to n. The callback
+    // may overwrite the touched entries of fu.
+    template <class Column>
+    void forEachSparsePVTransposeColumn(const State& s, bool includeV,
+                                        Column& column) const;
+
     const Array_<QIndex>& getFreeQIndex(const State& state) const;
     const Array_<QIndex>& getPresQIndex(const State& state) const;
     const Array_<QIndex>& getZeroQIndex(const State& state) const;
@@ -1323,6 +1389,73 @@ public:
     SimTK_DOWNCAST(SimbodyMatterSubsystemRep, Subsystem::Guts);
 
 private:
+        // TREE SWEEPS
+
+    // Visit every RigidBodyNode from level firstLevel out to the tips (base
+    // to tip) or from the tips in to Ground (tip to base), calling 
+    // visit(node) for each. Nodes at the same level depend only on their
+    // parents (outward) or children (inward), never on each other, so when
+    // parallel tree sweeps are enabled a sufficiently wide level is split
+    // into contiguous slices that are handed to the worker threads. Each node
+    // still performs exactly the same computation so the results are
+    // bitwise identical to the serial sweep. The visitor must write only to
+    // the slots belonging to the node it was given.
+    template <class Visitor>
+    void sweepOutward(Visitor visit, int firstLevel=0) const {
+        for (int i=firstLevel; i < (int)rbNodeLevels.size(); ++i)
+            visitLevel(i, visit);
+    }
+    template <class Visitor>
+    void sweepInward(Visitor visit) const {
+        for (int i=(int)rbNodeLevels.size()-1; i >= 0; --i)
+            visitLevel(i, visit);
+    }
+
+    // Levels with fewer nodes than this are always processed serially since
+    // waking up the worker threads would cost more than it saves.
+    static const int MinNodesPerParallelLevel = 8;
+    static const int MinNodesPerTreeSweepTask = 4;
+
+    // Return the number of tasks into which a level of the given width should
+    // be split; 1 means the level should be processed serially.
+    int calcNumTreeSweepTasks(int nodesInLevel) const;
+
+    // Helpers for realizeProjectedMInvFactor(). The first records in the
+    // cache everything G M^-1 ~G depends on. The second checks whether a 
+    // stale cached matrix can be updated to the current State because 
+    // nothing but the set of enabled constraints has changed.
+    void recordProjectedMInvDependencies(const State&          state,
+                                         SBProjectedMInvCache& pmc) const;
+    bool canUpdateProjectedMInv(const State&                state,
+                                const SBProjectedMInvCache& pmc) const;
+
+    // Calculate the diagonal blocks of G M^-1 ~G belonging to the given 
+    // groups of dynamically coupled equations, as found by 
+    // findDynamicallyCoupledEquations(), and write them into GMInvGt. Other
+    // entries are left untouched. This is the work horse for calcGMInvGt().
+    void calcGMInvGtBlocks(const State&                 state,
+                           const Array_< Array_<int> >& groups,
+                           Matrix&                      GMInvGt) const;
+
+    // Return the number of tasks among which calcGMInvGt() should divide 
+    // its nColors column sweeps; 1 means they should be done serially.
+    int calcNumGMInvGtTasks(const State& state, int nColors) const;
+
+    // Call body(i) for every i in [0,n), splitting the range into nTasks
+    // contiguous slices that may be executed concurrently by the tree sweep
+    // executor; see SliceExecutor::executeInSlices().
+    template <class Body>
+    void executeInSlices(int n, int nTasks, Body& body) const
+    {   treeSweepExecutor.executeInSlices(n, nTasks, body); }
+
+    template <class Visitor>
+    void visitLevel(int level, Visitor& visit) const {
+        const RBNodePtrList& nodes = rbNodeLevels[level];
+        auto visitNode = [&nodes, &visit](int j) {visit(*nodes[j]);};
+        executeInSlices((int)nodes.size(), 
+                        calcNumTreeSweepTasks((int)nodes.size()), visitNode);
+    }
+
         // TOPOLOGY "STATE VARIABLES"
 
     void clearTopologyState(); // note that this requires non-const access
@@ -1436,6 +1569,16 @@ private:
     
     // Specifies whether default decorative geometry should be shown.
     bool showDefaultGeometry;
+
+    // Specifies whether wide levels of the tree should be swept in parallel,
+    // and the worker pool used to do it. Only one sweep at a time can use the
+    // executor; concurrent realizations of different States run serially.
+    bool            useParallelTreeSweeps;
+    SliceExecutor   treeSweepExecutor;
+
+    // Specifies whether projectQ() and projectU() use the sparse normal
+    // equations solver rather than a dense QTZ factorization.
+    bool                                useSparseConstraintProjection;
 };
 
 std::ostream& operator<<(std::ostream&, const SimbodyMatterSubsystemRep&);
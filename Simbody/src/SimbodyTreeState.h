@@ -66,6 +66,8 @@ allocated if necessary), and then advance to stage Whatever. */
 #include "simbody/internal/common.h"
 #include "simbody/internal/Motion.h"
 
+#include "simmath/LinearAlgebra.h"
+
 #include <cassert>
 #include <iostream>
 using std::cout; using std::endl;
@@ -92,6 +94,7 @@ class SBConstrainedVelocityCache;
 class SBDynamicsCache;
 class SBTreeAccelerationCache;
 class SBConstrainedAccelerationCache;
+class SBProjectedMInvCache;
 
 class SBModelVars;
 class SBInstanceVars;
@@ -156,7 +159,8 @@ public:
                           articulatedBodyVelocityCacheIndex,
                           dynamicsCacheIndex, 
                           treeAccelerationCacheIndex, 
-                          constrainedAccelerationCacheIndex;
+                          constrainedAccelerationCacheIndex,
+                          projectedMInvCacheIndex;
 
 
     // These are instance variables that exist regardless of modeling
@@ -1230,7 +1234,6 @@ public:
 
 
 
-
 /* 
  * Generalized state variable collection for a SimbodyMatterSubsystem. 
  * Variables are divided into Stages, according to when their values
@@ -1339,6 +1342,57 @@ public:
 
 
 
+// =============================================================================
+//                           PROJECTED MINV CACHE
+// =============================================================================
+// This holds the mXm projected inverse mass matrix W=G M^-1 ~G and its
+// rank-revealing factorization, used to calculate constraint multipliers in
+// forward dynamics and to solve for constraint impulses. Forming W costs 
+// O(k*n) (see calcGMInvGt()) and factoring it O(m^3), and the same matrix is
+// needed for every acceleration-level calculation at a given configuration,
+// so we compute it once and reuse it.
+//
+// This is a lazy cache entry with depends-on stage Position. W depends only
+// on t and q unless there are nonholonomic or acceleration-only constraints,
+// in which case we conservatively treat it as depending on u also and check
+// uVersion explicitly before using it.
+//
+// When the entry has been invalidated, the stale contents may still be useful:
+// if the only thing that changed is that some constraints were enabled or 
+// disabled, the blocks of W that involve only the remaining constraints are
+// still correct. So we record here everything W depends on. The enabled flags
+// are instance variables, so we keep a copy of those to check that nothing
+// else about them has changed. Then W can be updated by moving the still-valid
+// blocks and calculating only the blocks with new equations, and refactored.
+class SBProjectedMInvCache {
+public:
+    SBProjectedMInvCache() : isValid(false) {}
+
+    bool        isValid;    // false until computed the first time
+    Matrix      GMInvGt;    // mXm
+    FactorQTZ   factor;     // rank-revealing factorization of GMInvGt
+
+    // This is the constraint equation layout that was used for the rows and
+    // columns of GMInvGt; see SBInstancePerConstraintInfo.
+    int mHolo, mNonholo, mAccOnly;
+    Array_<bool,    ConstraintIndex> constraintIsDisabled;
+    Array_<Segment, ConstraintIndex> holoErrSegment, nonholoErrSegment,
+                                     accOnlyErrSegment;
+
+    // These are the versions of the quantities GMInvGt was calculated from.
+    // The discrete variable versions are for all the matter subsystem's 
+    // discrete variables; the one for its instance variables is ignored since
+    // we compare instanceVars instead.
+    StageVersion                modelStageVersion;
+    ValueVersion                qVersion, uVersion;
+    Real                        time;
+    Array_<ValueVersion>        discreteVarVersions;
+    SBInstanceVars              instanceVars;
+};
+//........................... PROJECTED MINV CACHE .............................
+
+
+
 // =============================================================================
 //                                 TIME VARS
 // =============================================================================
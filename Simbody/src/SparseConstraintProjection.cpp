@@ -0,0 +1,231 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include "SparseConstraintProjection.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace SimTK {
+
+void SparseConstraintProjection::clear(int nRows, int nCols) {
+    assert(nRows >= 0 && nCols >= 0);
+    m = nRows; n = nCols; rank = 0;
+    rowStart.clear(); rowStart.push_back(0);
+    colIndex.clear(); value.clear();
+    perm.clear(); first.clear(); rowOffset.clear();
+    envelope.clear(); isDropped.clear();
+}
+
+void SparseConstraintProjection::
+setRow(int i, const Array_<std::pair<int,Real> >& entries) {
+    assert(i == (int)rowStart.size()-1 && i < m);
+    for (const auto& entry : entries) {
+        assert(0 <= entry.first && entry.first < n);
+        assert((int)colIndex.size() == rowStart.back() 
+               || colIndex.back() < entry.first);
+        if (entry.second != 0) {
+            colIndex.push_back(entry.first);
+            value.push_back(entry.second);
+        }
+    }
+    rowStart.push_back((int)colIndex.size());
+}
+
+//------------------------------------------------------------------------------
+//                        CALC REVERSE CUTHILL MCKEE
+//------------------------------------------------------------------------------
+// Breadth-first numbering of each connected component of the row adjacency
+// graph starting from a node of minimum degree, visiting neighbors in order of
+// increasing degree; the resulting order is then reversed. This is the usual
+// heuristic for keeping the envelope of a sparse symmetric matrix small.
+void SparseConstraintProjection::
+calcReverseCuthillMcKee(const Array_<Array_<int> >& adjacent) {
+    perm.clear(); perm.reserve(m);
+    Array_<bool> visited(m, false);
+
+    // Seed candidates in order of increasing degree.
+    Array_<int> byDegree(m);
+    for (int i=0; i < m; ++i) byDegree[i] = i;
+    std::stable_sort(byDegree.begin(), byDegree.end(),
+        [&adjacent](int a, int b)
+        {   return adjacent[a].size() < adjacent[b].size(); });
+
+    Array_<int> nbrs;
+    for (int seed : byDegree) {
+        if (visited[seed]) continue;
+        int head = (int)perm.size();
+        perm.push_back(seed); visited[seed] = true;
+        while (head < (int)perm.size()) {
+            const int node = perm[head++];
+            nbrs.clear();
+            for (int j : adjacent[node])
+                if (!visited[j]) {nbrs.push_back(j); visited[j] = true;}
+            std::stable_sort(nbrs.begin(), nbrs.end(),
+                [&adjacent](int a, int b)
+                {   return adjacent[a].size() < adjacent[b].size(); });
+            for (int j : nbrs) perm.push_back(j);
+        }
+    }
+    assert((int)perm.size() == m);
+    std::reverse(perm.begin(), perm.end());
+}
+
+//------------------------------------------------------------------------------
+//                                  FACTOR
+//------------------------------------------------------------------------------
+void SparseConstraintProjection::factor(Real conditioningTol) {
+    assert((int)rowStart.size() == m+1);
+    rank = 0;
+    if (m == 0) return;
+
+    // Rows of A that share a column are coupled in A ~A. Find those pairs
+    // by way of the column structure of A.
+    Array_<Array_<int> > rowsInCol(n);
+    for (int i=0; i < m; ++i)
+        for (int p=rowStart[i]; p < rowStart[i+1]; ++p)
+            rowsInCol[colIndex[p]].push_back(i);
+
+    Array_<Array_<int> > adjacent(m);
+    Array_<int> mark(m, -1);
+    for (int i=0; i < m; ++i) {
+        mark[i] = i;
+        for (int p=rowStart[i]; p < rowStart[i+1]; ++p)
+            for (int k : rowsInCol[colIndex[p]])
+                if (mark[k] != i) {mark[k] = i; adjacent[i].push_back(k);}
+    }
+
+    calcReverseCuthillMcKee(adjacent);
+    Array_<int> inv(m);
+    for (int k=0; k < m; ++k) inv[perm[k]] = k;
+
+    // Envelope of the permuted A ~A; Cholesky produces no fill outside it.
+    first.resize(m); rowOffset.resize(m);
+    int envSize = 0;
+    for (int k=0; k < m; ++k) {
+        int f = k;
+        for (int j : adjacent[perm[k]]) f = std::min(f, inv[j]);
+        first[k] = f;
+        rowOffset[k] = envSize;
+        envSize += k - f + 1;
+    }
+    envelope.resize(envSize);
+    isDropped.resize(m);
+
+    Vector work(n, Real(0)); // scattered copy of one row of A
+    for (int k=0; k < m; ++k) {
+        const int fk = first[k];
+        Real* Lk = &envelope[rowOffset[k]]; // Lk[c-fk] is L(k,c)
+        for (int c=fk; c <= k; ++c) Lk[c-fk] = 0;
+
+        // Fill in row k of the permuted A ~A up to the diagonal.
+        const int i = perm[k];
+        Real diag = 0;
+        for (int p=rowStart[i]; p < rowStart[i+1]; ++p) {
+            work[colIndex[p]] = value[p];
+            diag += square(value[p]);
+        }
+        for (int j : adjacent[i]) {
+            const int c = inv[j];
+            if (c > k) continue;
+            Real dot = 0;
+            for (int p=rowStart[j]; p < rowStart[j+1]; ++p)
+                dot += value[p]*work[colIndex[p]];
+            Lk[c-fk] = dot;
+        }
+        for (int p=rowStart[i]; p < rowStart[i+1]; ++p)
+            work[colIndex[p]] = 0;
+
+        // Row-oriented Cholesky within the envelope.
+        for (int c=fk; c < k; ++c) {
+            if (isDropped[c]) {Lk[c-fk] = 0; continue;}
+            const int fc = first[c];
+            const Real* Lc = &envelope[rowOffset[c]];
+            Real sum = Lk[c-fk];
+            for (int t=std::max(fk, fc); t < c; ++t)
+                sum -= Lk[t-fk]*Lc[t-fc];
+            Lk[c-fk] = sum / Lc[c-fc];
+        }
+        Real pivot = diag;
+        for (int t=fk; t < k; ++t)
+            pivot -= square(Lk[t-fk]);
+
+        // A pivot that has nearly vanished means this equation is (nearly)
+        // a combination of ones already factored; drop it.
+        if (!(pivot > square(conditioningTol)*diag)) {
+            isDropped[k] = true;
+            for (int c=fk; c < k; ++c) Lk[c-fk] = 0;
+            Lk[k-fk] = 1;
+        } else {
+            isDropped[k] = false;
+            Lk[k-fk] = std::sqrt(pivot);
+            ++rank;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//                                  SOLVE
+//------------------------------------------------------------------------------
+void SparseConstraintProjection::solve(const Vector& b, Vector& x) const {
+    assert(b.size() == m);
+    assert((int)isDropped.size() == m);
+    x.resize(n);
+    x.setToZero();
+    if (m == 0) return;
+
+    // Forward substitution L z = P b.
+    Array_<Real> z(m);
+    for (int k=0; k < m; ++k) {
+        if (isDropped[k]) {z[k] = 0; continue;}
+        const int fk = first[k];
+        const Real* Lk = &envelope[rowOffset[k]];
+        Real sum = b[perm[k]];
+        for (int t=fk; t < k; ++t)
+            sum -= Lk[t-fk]*z[t];
+        z[k] = sum / Lk[k-fk];
+    }
+
+    // Back substitution ~L y = z, working column-wise through the rows of L.
+    for (int k=m-1; k >= 0; --k) {
+        if (isDropped[k]) {z[k] = 0; continue;}
+        const int fk = first[k];
+        const Real* Lk = &envelope[rowOffset[k]];
+        const Real yk = (z[k] /= Lk[k-fk]);
+        for (int t=fk; t < k; ++t)
+            z[t] -= Lk[t-fk]*yk;
+    }
+
+    // x = ~A y
+    for (int k=0; k < m; ++k) {
+        const int i = perm[k];
+        const Real yi = z[k];
+        if (yi == 0) continue;
+        for (int p=rowStart[i]; p < rowStart[i+1]; ++p)
+            x[colIndex[p]] += value[p]*yi;
+    }
+}
+
+} // namespace SimTK
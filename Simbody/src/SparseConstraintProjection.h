@@ -0,0 +1,103 @@
+#ifndef SimTK_SIMBODY_SPARSE_CONSTRAINT_PROJECTION_H_
+#define SimTK_SIMBODY_SPARSE_CONSTRAINT_PROJECTION_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+namespace SimTK {
+
+//==============================================================================
+//                       SPARSE CONSTRAINT PROJECTION
+//==============================================================================
+// This is a sparse replacement for the FactorQTZ pseudoinverse used by
+// position and velocity projection. It holds an m X n weighted constraint
+// matrix A (one row per constraint equation, n free q's or u's) in compressed
+// row form and computes the minimum-norm least squares solution of A x = b
+// via the normal equations:
+//                 (A ~A) y = b,   x = ~A y.
+// The m X m matrix A ~A is symmetric positive semidefinite; it is ordered
+// with reverse Cuthill-McKee to reduce its profile and then factored in place
+// by envelope (skyline) Cholesky. Since the constraints couple only a few
+// mobilities each, both A and A ~A are typically very sparse and the cost
+// scales with their number of nonzeros rather than with n*m^2 as for the
+// dense factorization.
+//
+// Redundant constraint equations show up as negligible Cholesky pivots;
+// those equations are dropped (their y is zero), which is the analog of the
+// rank reduction done by FactorQTZ.
+class SparseConstraintProjection {
+public:
+    SparseConstraintProjection() : m(0), n(0), rank(0) {}
+
+    // Prepare to receive nRows rows each with nCols columns. Rows must then be
+    // supplied in order 0..nRows-1 with setRow().
+    void clear(int nRows, int nCols);
+
+    // Supply row i of A as its (column, value) entries in increasing column
+    // order; explicit zeros are dropped.
+    void setRow(int i, const Array_<std::pair<int,Real> >& entries);
+
+    // Form and factor A ~A. conditioningTol has the same meaning as for
+    // FactorQTZ, where it is relative to the singular values of A. Since those
+    // are squared in A ~A, a pivot is considered zero if it is less than 
+    // conditioningTol^2 times the corresponding diagonal of A ~A.
+    void factor(Real conditioningTol);
+
+    // Given b (m), return the minimum-norm least squares x (n) with A x = b,
+    // restricted to the equations that were retained during factoring.
+    void solve(const Vector& b, Vector& x) const;
+
+    int getNumRows() const {return m;}
+    int getNumCols() const {return n;}
+    int getRank() const {return rank;}
+    int getNumNonzeros() const {return (int)value.size();}
+    int getProfileSize() const {return (int)envelope.size();}
+
+private:
+    void calcReverseCuthillMcKee(const Array_<Array_<int> >& adjacent);
+
+    int             m, n, rank;
+
+    // A in compressed row form, column indices ascending in each row.
+    Array_<int>     rowStart;   // m+1
+    Array_<int>     colIndex;   // nnz
+    Array_<Real>    value;      // nnz
+
+    // Symmetric permutation applied to A ~A; perm[k] is the original row
+    // that is k'th in the factored ordering.
+    Array_<int>     perm;
+
+    // Envelope storage of the Cholesky factor L in the permuted ordering.
+    // Row k of L occupies columns first[k]..k and is stored contiguously
+    // starting at envelope[rowOffset[k]], with the diagonal last.
+    Array_<int>     first;      // m
+    Array_<int>     rowOffset;  // m
+    Array_<Real>    envelope;
+    Array_<bool>    isDropped;  // m, permuted ordering
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_SPARSE_CONSTRAINT_PROJECTION_H_
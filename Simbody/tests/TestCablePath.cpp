@@ -0,0 +1,208 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check the cable path solver on paths over spheres, where the answer can be
+// verified geometrically, and check that solving several paths in parallel
+// gives the same answers as solving them one at a time.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace SimTK;
+using std::cout; using std::endl;
+
+namespace {
+
+const Real Rad = 1;
+
+// Each cable runs from (-5,0,z) to (5,0,z), over the first sphere, under the
+// second and over the third. Every sphere is welded to Ground on a body of its
+// own whose origin is at the sphere center. The obstacles remember the given
+// number of geodesics.
+struct Model {
+    explicit Model(int nCables, int geodesicCacheSize=0) 
+    :   matter(system), cables(system) {
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        const Vec3 centers[3] = {Vec3(-2.5,-0.4,0), Vec3(0,1.2,0),
+                                 Vec3(2.5,-0.4,0)};
+        const Real side[3] = {1, -1, 1}; // cable over (+1) or under (-1)
+        for (int c=0; c < nCables; ++c) {
+            const Vec3 zOffset(0, 0, 3*c);
+            CablePath path(cables, matter.Ground(), Vec3(-5,0,0) + zOffset,
+                           matter.Ground(), Vec3(5,0,0) + zOffset);
+            for (int s=0; s < 3; ++s) {
+                MobilizedBody::Weld sphereBody(matter.Ground(),
+                    Transform(centers[s] + zOffset), body, Transform());
+                spheres.push_back(sphereBody);
+                CableObstacle::Surface obs(path, sphereBody, Transform(),
+                    ContactGeometry::Sphere(Rad));
+                // Rough guesses, deliberately off the plane of the solution.
+                obs.setContactPointHints(
+                    Rad*UnitVec3(-0.5, side[s], 0.1),
+                    Rad*UnitVec3( 0.5, side[s], -0.1));
+                if (geodesicCacheSize)
+                    obs.setGeodesicCacheSize(geodesicCacheSize);
+            }
+            paths.push_back(path);
+        }
+    }
+
+    MultibodySystem         system;
+    SimbodyMatterSubsystem  matter;
+    CableTrackerSubsystem   cables;
+    Array_<MobilizedBody>   spheres;
+    Array_<CablePath>       paths;
+};
+
+// Tension in a frictionless cable can only push on a sphere along its
+// surface normals, so once the path has been solved the net moment about
+// each sphere's center must vanish.
+void checkPathIsSolved(const Model& model, const State& state, int c) {
+    Vector_<SpatialVec> forces(model.matter.getNumBodies(), SpatialVec(Vec3(0)));
+    model.paths[c].applyBodyForces(state, 1, forces);
+    for (int s=0; s < 3; ++s) {
+        const SpatialVec& F = forces[model.spheres[3*c+s].getMobilizedBodyIndex()];
+        SimTK_TEST(F[1].norm() > Real(0.1));
+        SimTK_TEST_EQ_TOL(F[0], Vec3(0), 1e-6);
+    }
+}
+
+}
+
+void testSinglePathOverSphere() {
+    // Straight from (-2,-0.5,0) to (2,-0.5,0) would cut through the sphere,
+    // so the cable wraps along a great circle underneath it.
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    CableTrackerSubsystem cables(system);
+    const Vec3 A(-2,-0.5,0), B(2,-0.5,0);
+    CablePath path(cables, matter.Ground(), A, matter.Ground(), B);
+    CableObstacle::Surface obs(path, matter.Ground(), Transform(),
+                               ContactGeometry::Sphere(Rad));
+    obs.setContactPointHints(Rad*UnitVec3(-0.4,-1,0.05),
+                             Rad*UnitVec3( 0.4,-1,0.05));
+    SimTK_TEST(obs.getGeodesicCacheSize() == 0); // off unless asked for
+
+    State state = system.realizeTopology();
+    system.realize(state, Stage::Velocity);
+
+    const Real tangentLength = std::sqrt(A.normSqr() - Rad*Rad);
+    const Real wrapAngle = std::acos(dot(A,B)/(A.norm()*B.norm()))
+                           - 2*std::acos(Rad/A.norm());
+    // The geodesic is integrated numerically; that limits the accuracy.
+    SimTK_TEST_EQ_TOL(path.getCableLength(state),
+                      2*tangentLength + Rad*wrapAngle, 1e-6);
+    // Nothing moves.
+    SimTK_TEST_EQ_TOL(path.getCableLengthDot(state), 0, 1e-10);
+}
+
+void testPathOverSeveralSpheres() {
+    Model model(1);
+    State state = model.system.realizeTopology();
+    model.system.realize(state, Stage::Velocity);
+    checkPathIsSolved(model, state, 0);
+    // Longer than the straight line, shorter than going around the hints.
+    const Real length = model.paths[0].getCableLength(state);
+    SimTK_TEST(10 < length && length < 14);
+}
+
+// The serial and parallel solves use separate, identical Models so that 
+// neither can start from anything the other one calculated.
+void testParallelPathSolves() {
+    const int nCables = 4;
+    Model serialModel(nCables), parallelModel(nCables);
+    SimTK_TEST(!serialModel.cables.getUseParallelPathSolves());
+
+    State serial = serialModel.system.realizeTopology();
+    serialModel.system.realize(serial, Stage::Position);
+
+    parallelModel.cables.setUseParallelPathSolves(true);
+    parallelModel.cables.setNumberOfThreads(3);
+    SimTK_TEST(parallelModel.cables.getUseParallelPathSolves());
+    SimTK_TEST(parallelModel.cables.getNumberOfThreads() == 3);
+
+    State parallel = parallelModel.system.realizeTopology();
+    parallelModel.system.realize(parallel, Stage::Position);
+    for (int c=0; c < nCables; ++c) {
+        checkPathIsSolved(parallelModel, parallel, c);
+        SimTK_TEST(parallelModel.paths[c].getCableLength(parallel)
+                   == serialModel.paths[c].getCableLength(serial));
+    }
+}
+
+// With geodesic caching turned on, solving the same paths again reuses the
+// remembered geodesics, and the answers agree with those found without
+// caching to within the path accuracy.
+void testGeodesicCacheOptIn() {
+    Model plain(2), cached(2, 4);
+    State plainState = plain.system.realizeTopology();
+    plain.system.realize(plainState, Stage::Position);
+
+    for (int trial=0; trial < 2; ++trial) {
+        State state = cached.system.realizeTopology();
+        cached.system.realize(state, Stage::Position);
+        for (int c=0; c < 2; ++c) {
+            checkPathIsSolved(cached, state, c);
+            SimTK_TEST_EQ_TOL(cached.paths[c].getCableLength(state),
+                              plain.paths[c].getCableLength(plainState), 1e-6);
+        }
+    }
+}
+
+// Separate Models again, so that each solve starts from scratch.
+void testDiagnostics() {
+    Model quietModel(1), chattyModel(1);
+    SimTK_TEST(quietModel.paths[0].getDiagnosticsLevel() == 0);
+    chattyModel.paths[0].setDiagnosticsLevel(1);
+
+    // Capture everything written to cout while realizing.
+    std::ostringstream captured;
+    std::streambuf* coutBuf = cout.rdbuf(captured.rdbuf());
+    State quiet = quietModel.system.realizeTopology();
+    quietModel.system.realize(quiet, Stage::Velocity);
+    const std::string quietOutput = captured.str();
+
+    captured.str("");
+    State chatty = chattyModel.system.realizeTopology();
+    chattyModel.system.realize(chatty, Stage::Velocity);
+    const std::string chattyOutput = captured.str();
+    cout.rdbuf(coutBuf);
+
+    SimTK_TEST(quietOutput.empty());
+    SimTK_TEST(chattyOutput.find("converged") != std::string::npos);
+    SimTK_TEST(chattyModel.paths[0].getCableLength(chatty) 
+               == quietModel.paths[0].getCableLength(quiet));
+}
+
+int main() {
+    SimTK_START_TEST("TestCablePath");
+        SimTK_SUBTEST(testSinglePathOverSphere);
+        SimTK_SUBTEST(testPathOverSeveralSpheres);
+        SimTK_SUBTEST(testParallelPathSolves);
+        SimTK_SUBTEST(testGeodesicCacheOptIn);
+        SimTK_SUBTEST(testDiagnostics);
+    SimTK_END_TEST();
+}
@@ -582,6 +582,255 @@ void testConstraintMatrices() {
     delete &system;
 }
 
+// Many constraints acting on independent subtrees produce a projected inverse
+// mass matrix that is block diagonal. Check that the structured calculation
+// in calcProjectedMInv() agrees exactly with the one-column-at-a-time 
+// definition, both with and without parallel tree sweeps.
+void testProjectedMInvBlocks() {
+    State state;
+    MultibodySystem& system = createSystem();
+    SimbodyMatterSubsystem& matter = system.updMatterSubsystem();
+    MobilizedBody& first = matter.updMobilizedBody(MobilizedBodyIndex(1));
+    MobilizedBody& last = matter.updMobilizedBody(MobilizedBodyIndex(NUM_BODIES));
+    Constraint::Ball ball(first, last);
+
+    const MassProperties mprops(1, Vec3(.01,.02,.03), Inertia(1,1.1,1.2));
+    Array_<MobilizedBody> free;
+    for (int i=0; i < 12; ++i) {
+        free.push_back(MobilizedBody::Free(matter.Ground(), mprops));
+        Constraint::PointInPlane(matter.Ground(), UnitVec3(0,1,0), 0,
+                                 free.back(), Vec3(.1,-.2,.3));
+    }
+    // Couple a few of the free bodies together, and add a nonholonomic
+    // and an acceleration-only constraint.
+    Constraint::Rod(free[0], Vec3(.1,0,0), free[1], Vec3(0,.2,0), 1);
+    Constraint::Rod(free[1], free[2], 1);
+    Constraint::ConstantSpeed(free[3], MobilizerUIndex(2), .1);
+    Constraint::ConstantAcceleration(free[4], MobilizerUIndex(0), .01);
+    createState(system, state);
+
+    const int m = matter.getNUDotErr(state);
+    const int nu = matter.getNU(state);
+    Matrix colByCol(m,m);
+    Vector lambda(m, Real(0)), Gtcol, MInvGtcol, GMInvGtcol;
+    for (int j=0; j < m; ++j) {
+        lambda[j] = 1;
+        matter.multiplyByGTranspose(state, lambda, Gtcol);
+        matter.multiplyByMInv(state, Gtcol, MInvGtcol);
+        matter.multiplyByG(state, MInvGtcol, GMInvGtcol);
+        colByCol(j) = GMInvGtcol;
+        lambda[j] = 0;
+    }
+
+    Matrix MInv, G;
+    matter.calcMInv(state, MInv);
+    matter.calcG(state, G);
+    SimTK_TEST(MInv.ncol() == nu);
+
+    for (int pass=0; pass < 2; ++pass) {
+        matter.setUseParallelTreeSweeps(pass == 1);
+        matter.setNumberOfThreads(3);
+        Matrix GMInvGt;
+        matter.calcProjectedMInv(state, GMInvGt);
+        SimTK_TEST(GMInvGt.nrow() == m && GMInvGt.ncol() == m);
+        SimTK_TEST_EQ(GMInvGt, G*MInv*~G);
+        for (int i=0; i < m; ++i)
+            for (int j=0; j < m; ++j)
+                SimTK_TEST(GMInvGt(i,j) == colByCol(i,j));
+    }
+    matter.setUseParallelTreeSweeps(false);
+
+    delete &system;
+}
+
+// Forward dynamics and impulse solves share a cached factorization of 
+// G M^-1 ~G. Check that it gives the same answers as a fresh factorization,
+// including after constraints are disabled and re-enabled, which updates the
+// cached matrix rather than recalculating it.
+void testCachedProjectedMInvFactor() {
+    State state;
+    MultibodySystem& system = createSystem();
+    SimbodyMatterSubsystem& matter = system.updMatterSubsystem();
+    MobilizedBody& first = matter.updMobilizedBody(MobilizedBodyIndex(1));
+    MobilizedBody& second = matter.updMobilizedBody(MobilizedBodyIndex(2));
+    MobilizedBody& fifth = matter.updMobilizedBody(MobilizedBodyIndex(5));
+    MobilizedBody& last = matter.updMobilizedBody(MobilizedBodyIndex(NUM_BODIES));
+
+    Constraint::Ball ball(first, last);
+    Constraint::ConstantAcceleration accel2(second, MobilizerUIndex(1), .01);
+    Constraint::ConstantSpeed speed5(fifth, MobilizerUIndex(1), .1);
+    Constraint::Rod rod(second, fifth, 1);
+    createState(system, state);
+
+    // Compare the cached results against a freshly-formed matrix and against
+    // a state that has never had the factorization calculated.
+    auto check = [&]() {
+        system.realize(state, Stage::Velocity);
+        const int m = matter.getNUDotErr(state);
+        Matrix GMInvGt;
+        matter.calcProjectedMInv(state, GMInvGt);
+        const Real tol = m*SqrtEps*std::sqrt(SqrtEps);
+        FactorQTZ qtz(GMInvGt, tol);
+
+        const Vector deltaV = Test::randVector(m);
+        Vector impulse, freshImpulse;
+        matter.solveForConstraintImpulses(state, deltaV, impulse);
+        qtz.solve(deltaV, freshImpulse);
+        SimTK_TEST_EQ_SIZE(impulse, freshImpulse, m);
+        // Second solve uses the same factorization.
+        Vector again;
+        matter.solveForConstraintImpulses(state, deltaV, again);
+        SimTK_TEST(again.size() == m);
+        for (int i=0; i < m; ++i)
+            SimTK_TEST(again[i] == impulse[i]);
+
+        State fresh = system.getDefaultState();
+        for (ConstraintIndex cx(0); cx < matter.getNumConstraints(); ++cx)
+            matter.setConstraintIsDisabled(fresh, cx, 
+                                matter.isConstraintDisabled(state, cx));
+        fresh.updQ() = state.getQ();
+        fresh.updU() = state.getU();
+        system.realize(fresh, Stage::Acceleration);
+        system.realize(state, Stage::Acceleration);
+        SimTK_TEST_EQ_SIZE(state.getUDot(), fresh.getUDot(), m);
+        SimTK_TEST_EQ_SIZE(state.getMultipliers(), fresh.getMultipliers(), m);
+
+        // An updated factorization must not depend on which constraints were
+        // enabled before; it has to match the fresh one exactly.
+        Vector freshCachedImpulse;
+        matter.solveForConstraintImpulses(fresh, deltaV, freshCachedImpulse);
+        SimTK_TEST(freshCachedImpulse.size() == m);
+        for (int i=0; i < m; ++i)
+            SimTK_TEST(freshCachedImpulse[i] == impulse[i]);
+    };
+
+    check();
+    rod.disable(state);
+    check();
+    ball.disable(state);
+    check();
+    rod.enable(state);
+    check();
+    ball.enable(state);
+    speed5.disable(state);
+    check();
+
+    // A configuration change requires a new factorization.
+    state.updQ()[0] += 0.1;
+    check();
+
+    delete &system;
+}
+
+// Position and velocity projection using the sparse normal equations should
+// produce the same results as the default dense QTZ projection, including the
+// projected error estimates and when some constraints are redundant.
+void testSparseConstraintProjection() {
+    State state;
+    MultibodySystem& system = createSystem();
+    SimbodyMatterSubsystem& matter = system.updMatterSubsystem();
+    MobilizedBody& first = matter.updMobilizedBody(MobilizedBodyIndex(1));
+    MobilizedBody& fifth = matter.updMobilizedBody(MobilizedBodyIndex(5));
+    MobilizedBody& last = matter.updMobilizedBody(MobilizedBodyIndex(NUM_BODIES));
+    Constraint::Ball ball(first, last);
+    Constraint::ConstantSpeed speed5(fifth, MobilizerUIndex(1), .1);
+
+    const MassProperties mprops(1, Vec3(.01,.02,.03), Inertia(1,1.1,1.2));
+    Array_<MobilizedBody> free;
+    for (int i=0; i < 8; ++i) {
+        free.push_back(MobilizedBody::Free(matter.Ground(), mprops));
+        Constraint::PointInPlane(matter.Ground(), UnitVec3(0,1,0), 0,
+                                 free.back(), Vec3(.1,-.2,.3));
+    }
+    Constraint::Rod(free[0], Vec3(.1,0,0), free[1], Vec3(0,.2,0), 1);
+    Constraint::Rod(free[1], free[2], 1);
+    // This one duplicates free[3]'s PointInPlane constraint.
+    Constraint::PointInPlane(matter.Ground(), UnitVec3(0,1,0), 0,
+                             free[3], Vec3(.1,-.2,.3));
+    createState(system, state);
+
+    // Perturb away from the constraint manifold.
+    for (int i=0; i < state.getNQ(); ++i)
+        state.updQ()[i] += 1e-3*std::sin(Real(i+1));
+    for (int i=0; i < state.getNU(); ++i)
+        state.updU()[i] += 1e-2*std::cos(Real(i+1));
+
+    const ProjectOptions opts(1e-10);
+    const Vector qErr0 = 1e-4*Test::randVector(state.getNQ());
+    const Vector uErr0 = 1e-4*Test::randVector(state.getNU());
+
+    State states[2]; Vector qErrs[2], uErrs[2];
+    for (int pass=0; pass < 2; ++pass) {
+        matter.setUseSparseConstraintProjection(pass == 1);
+        SimTK_TEST(matter.getUseSparseConstraintProjection() == (pass == 1));
+        states[pass] = state;
+        qErrs[pass] = qErr0; uErrs[pass] = uErr0;
+        system.realize(states[pass], Stage::Velocity);
+        ProjectResults results;
+        system.projectQ(states[pass], qErrs[pass], opts, results);
+        SimTK_TEST(results.getExitStatus() == ProjectResults::Succeeded);
+        system.realize(states[pass], Stage::Velocity);
+        system.projectU(states[pass], uErrs[pass], opts, results);
+        SimTK_TEST(results.getExitStatus() == ProjectResults::Succeeded);
+        system.realize(states[pass], Stage::Velocity);
+        SimTK_TEST(states[pass].getQErr().normRMS() <= 1e-10);
+        SimTK_TEST(states[pass].getUErr().normRMS() <= 1e-10);
+    }
+    matter.setUseSparseConstraintProjection(false);
+
+    SimTK_TEST_EQ_TOL(states[1].getQ(), states[0].getQ(), 1e-9);
+    SimTK_TEST_EQ_TOL(states[1].getU(), states[0].getU(), 1e-9);
+    SimTK_TEST_EQ_TOL(qErrs[1], qErrs[0], 1e-9);
+    SimTK_TEST_EQ_TOL(uErrs[1], uErrs[0], 1e-9);
+
+    delete &system;
+}
+
+// Temporaries in constraint projection and loop forward dynamics come from the
+// thread's scratch arena. Once the arena has grown to fit them, repeating the
+// same calculations must not grow it any further. This checks only the arena
+// itself, not other heap activity; view handles, for example, are still
+// allocated on every call.
+void testScratchArenaStopsGrowing() {
+    State state;
+    MultibodySystem& system = createSystem();
+    SimbodyMatterSubsystem& matter = system.updMatterSubsystem();
+    MobilizedBody& first = matter.updMobilizedBody(MobilizedBodyIndex(1));
+    MobilizedBody& fifth = matter.updMobilizedBody(MobilizedBodyIndex(5));
+    MobilizedBody& last = matter.updMobilizedBody(MobilizedBodyIndex(NUM_BODIES));
+    Constraint::Ball ball(first, last);
+    Constraint::ConstantSpeed speed5(fifth, MobilizerUIndex(1), .1);
+    createState(system, state);
+
+    const ProjectOptions opts(1e-10);
+    const ScratchArena& arena = ScratchArena::getThreadArena();
+    auto step = [&](int i) {
+        state.updQ()[0] += 1e-3*std::sin(Real(i+1));
+        state.updU()[1] += 1e-2*std::cos(Real(i+1));
+        system.realize(state, Stage::Position);
+        ProjectResults results;
+        Vector qErr, uErr;
+        system.projectQ(state, qErr, opts, results);
+        SimTK_TEST(results.getExitStatus() == ProjectResults::Succeeded);
+        system.realize(state, Stage::Velocity);
+        system.projectU(state, uErr, opts, results);
+        SimTK_TEST(results.getExitStatus() == ProjectResults::Succeeded);
+        system.realize(state, Stage::Acceleration);
+        SimTK_TEST(state.getUDotErr().normRMS() <= 1e-8);
+    };
+
+    step(0);
+    const long long nAllocs = arena.getNumHeapAllocations();
+    const std::size_t capacity = arena.getCapacity();
+    SimTK_TEST(capacity > 0);
+    for (int i=1; i < 10; ++i)
+        step(i);
+    SimTK_TEST(arena.getNumHeapAllocations() == nAllocs);
+    SimTK_TEST(arena.getCapacity() == capacity);
+
+    delete &system;
+}
+
 // Test the operator SimbodyMatterSubsystem::calcConstraintAccelerationErrors(),
 // which computes pvaerr = G udot - b. For the most part, we just ensure that
 // this operator gives results consistent with other methods.
@@ -737,6 +986,10 @@ int main() {
         SimTK_SUBTEST(testWeldConstraintWithPreAssembly);
         SimTK_SUBTEST(testConstraintForces);
         SimTK_SUBTEST(testConstraintMatrices);
+        SimTK_SUBTEST(testProjectedMInvBlocks);
+        SimTK_SUBTEST(testCachedProjectedMInvFactor);
+        SimTK_SUBTEST(testSparseConstraintProjection);
+        SimTK_SUBTEST(testScratchArenaStopsGrowing);
         SimTK_SUBTEST(testConstraintAccelerationErrors);
         SimTK_SUBTEST(testDisablingConstraints);
     SimTK_END_TEST();
@@ -0,0 +1,161 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that the bounding box tree broad phase finds exactly the same contacts
+// as the single-axis sweep-and-prune, in both ContactTrackerSubsystem and
+// GeneralContactSubsystem, as a crowd of spheres moves about over a half space.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+#include <set>
+#include <utility>
+
+using namespace SimTK;
+
+namespace {
+
+const int NumSpheres = 120;
+typedef std::set<std::pair<int,int> > PairSet;
+
+Real sphereRadius(int i) {return 0.05 + 0.15*((i*37) % 11)/10.;}
+
+void buildSystem(MultibodySystem& system, SimbodyMatterSubsystem& matter,
+                 ContactTrackerSubsystem& tracker,
+                 GeneralContactSubsystem& general, bool useTree) {
+    const ContactMaterial material(1e6, 0.1, 0.8, 0.5, 0.1);
+    const Transform X_GH(Rotation(-Pi/2, ZAxis)); // half space is y < 0
+    matter.Ground().updBody().addContactSurface(X_GH,
+        ContactSurface(ContactGeometry::HalfSpace(), material));
+
+    const ContactSetIndex set = general.createContactSet();
+    general.addBody(set, matter.Ground(), ContactGeometry::HalfSpace(), X_GH);
+
+    for (int i=0; i < NumSpheres; ++i) {
+        const ContactGeometry::Sphere sphere(sphereRadius(i));
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        body.addContactSurface(Transform(), ContactSurface(sphere, material));
+        MobilizedBody::Translation mobod(matter.Ground(), body);
+        general.addBody(set, mobod, sphere, Transform());
+    }
+
+    if (useTree) {
+        tracker.setBroadPhaseMethod(ContactTrackerSubsystem::BoundingBoxTree);
+        general.setUseBoundingBoxTree(true);
+    }
+    system.realizeTopology();
+}
+
+// Surface pairs, low index first.
+void getTrackerPairs(const ContactTrackerSubsystem& tracker,
+                     const State& state, PairSet& pairs) {
+    pairs.clear();
+    const ContactSnapshot& snapshot = tracker.getActiveContacts(state);
+    for (int i=0; i < snapshot.getNumContacts(); ++i) {
+        const Contact& contact = snapshot.getContact(i);
+        const int s1 = contact.getSurface1(), s2 = contact.getSurface2();
+        pairs.insert(std::make_pair(std::min(s1,s2), std::max(s1,s2)));
+    }
+}
+
+void getGeneralPairs(const GeneralContactSubsystem& general,
+                     const State& state, PairSet& pairs) {
+    pairs.clear();
+    const Array_<Contact>& contacts =
+        general.getContacts(state, ContactSetIndex(0));
+    for (unsigned i=0; i < contacts.size(); ++i) {
+        const int s1 = contacts[i].getSurface1(), s2 = contacts[i].getSurface2();
+        pairs.insert(std::make_pair(std::min(s1,s2), std::max(s1,s2)));
+    }
+}
+
+}
+
+void testSameContacts() {
+    MultibodySystem sweepSystem, treeSystem;
+    SimbodyMatterSubsystem sweepMatter(sweepSystem), treeMatter(treeSystem);
+    ContactTrackerSubsystem sweepTracker(sweepSystem), treeTracker(treeSystem);
+    GeneralContactSubsystem sweepGeneral(sweepSystem), treeGeneral(treeSystem);
+    buildSystem(sweepSystem, sweepMatter, sweepTracker, sweepGeneral, false);
+    buildSystem(treeSystem, treeMatter, treeTracker, treeGeneral, true);
+
+    SimTK_TEST(sweepTracker.getBroadPhaseMethod()
+               == ContactTrackerSubsystem::SingleAxisSweepAndPrune);
+    SimTK_TEST(treeTracker.getBroadPhaseMethod()
+               == ContactTrackerSubsystem::BoundingBoxTree);
+    SimTK_TEST(!sweepGeneral.getUseBoundingBoxTree());
+    SimTK_TEST(treeGeneral.getUseBoundingBoxTree());
+
+    State sweepState = sweepSystem.getDefaultState();
+    State treeState  = treeSystem.getDefaultState();
+
+    // Start the spheres strung out along x (the worst case for the sweep)
+    // with a few near the ground, then jiggle them around. Occasionally one
+    // takes a big jump so that the tree has to be restructured.
+    Random::Uniform rand(0, 1); rand.setSeed(17);
+    Vector q(3*NumSpheres);
+    for (int i=0; i < NumSpheres; ++i) {
+        q[3*i]   = 6*rand.getValue();
+        q[3*i+1] = 0.6*rand.getValue();
+        q[3*i+2] = 0.6*rand.getValue();
+    }
+
+    int numTrackerPairs = 0, numGeneralPairs = 0;
+    PairSet sweepPairs, treePairs;
+    for (int config=0; config < 20; ++config) {
+        for (int i=0; i < q.size(); ++i)
+            q[i] += (rand.getValue() < 0.02 ? 1 : 0.02)*(rand.getValue()-0.5);
+        sweepState.updQ() = q; treeState.updQ() = q;
+        sweepSystem.realize(sweepState, Stage::Dynamics);
+        treeSystem.realize(treeState, Stage::Dynamics);
+
+        getTrackerPairs(sweepTracker, sweepState, sweepPairs);
+        getTrackerPairs(treeTracker, treeState, treePairs);
+        SimTK_TEST(treePairs == sweepPairs);
+        numTrackerPairs += (int)treePairs.size();
+
+        getGeneralPairs(sweepGeneral, sweepState, sweepPairs);
+        getGeneralPairs(treeGeneral, treeState, treePairs);
+        SimTK_TEST(treePairs == sweepPairs);
+        numGeneralPairs += (int)treePairs.size();
+    }
+    // Make sure this was a real test.
+    SimTK_TEST(numTrackerPairs > 100 && numGeneralPairs > 100);
+
+    // A copy of a State carries its tree along with it.
+    State copy = treeState;
+    q *= -1;
+    copy.updQ() = q;
+    treeSystem.realize(copy, Stage::Dynamics);
+    sweepState.updQ() = q;
+    sweepSystem.realize(sweepState, Stage::Dynamics);
+    getTrackerPairs(sweepTracker, sweepState, sweepPairs);
+    getTrackerPairs(treeTracker, copy, treePairs);
+    SimTK_TEST(treePairs == sweepPairs);
+}
+
+int main() {
+    SimTK_START_TEST("TestContactBroadPhase");
+        SimTK_SUBTEST(testSameContacts);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,190 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check SimbodyMatterSubsystem::calcODEJacobian() and
+// calcODEJacobianTimesVector() against a Jacobian formed column by column
+// with central differences.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using std::cout; using std::endl;
+
+namespace {
+
+// Two independent pendulum chains and a free body, each hanging from Ground.
+struct Model {
+    Model() : matter(system), forces(system) {
+        Force::Gravity(forces, matter, -YAxis, 9.81);
+        Body::Rigid body(MassProperties(1, Vec3(0.1,-0.2,0.05),
+                                        UnitInertia(1.1,1.2,1.3,0.01,0.02,0.03)));
+        MobilizedBody parent = matter.updGround();
+        for (int i=0; i < 3; ++i) {
+            chainA.push_back(MobilizedBody::Pin(parent, Vec3(0,-1,0),
+                                                body, Vec3(0,0.5,0)));
+            parent = chainA.back();
+        }
+        Force::MobilityLinearSpring(forces, chainA[1], 0, 20, 0.3);
+        chainB.push_back(MobilizedBody::Ball(matter.updGround(), Vec3(2,0,0),
+                                             body, Vec3(0,0.5,0)));
+        chainB.push_back(MobilizedBody::Universal(chainB[0], Vec3(0,-0.5,0),
+                                                  body, Vec3(0,0.5,0)));
+        free = MobilizedBody::Free(matter.updGround(), Vec3(-2,0,0),
+                                   body, Vec3(0));
+    }
+
+    // Give the state some motion and realize it.
+    void setState(State& state) const {
+        Random::Uniform rand(-1,1); rand.setSeed(17);
+        for (int i=0; i < state.getNQ(); ++i) state.updQ()[i] = rand.getValue();
+        for (int i=0; i < state.getNU(); ++i) state.updU()[i] = rand.getValue();
+        system.realize(state, Stage::Position);
+        matter.normalizeQuaternions(state);
+        system.realize(state, Stage::Acceleration);
+    }
+
+    MultibodySystem         system;
+    SimbodyMatterSubsystem  matter;
+    GeneralForceSubsystem   forces;
+    Array_<MobilizedBody>   chainA, chainB;
+    MobilizedBody           free;
+};
+
+// Central difference Jacobian of (qdot,udot) with respect to (q,u).
+Matrix calcReferenceJacobian(const Model& model, const State& state) {
+    const int nq = state.getNQ(), nu = state.getNU(), n = nq+nu;
+    Matrix J(n, n);
+    const Real h = 1e-6;
+    for (int j=0; j < n; ++j) {
+        State sp = state, sm = state;
+        if (j < nq) {sp.updQ()[j] += h; sm.updQ()[j] -= h;}
+        else        {sp.updU()[j-nq] += h; sm.updU()[j-nq] -= h;}
+        model.system.realize(sp, Stage::Acceleration);
+        model.system.realize(sm, Stage::Acceleration);
+        J(0,j,nq,1)  = (sp.getQDot() - sm.getQDot())/(2*h);
+        J(nq,j,nu,1) = (sp.getUDot() - sm.getUDot())/(2*h);
+    }
+    return J;
+}
+
+Matrix expandSparse(int n, const Array_<int>& colStart,
+                    const Array_<int>& rowIndex, const Array_<Real>& value) {
+    Matrix J(n, n, Real(0));
+    for (int j=0; j < n; ++j)
+        for (int e=colStart[j]; e < colStart[j+1]; ++e)
+            J(rowIndex[e], j) = value[e];
+    return J;
+}
+
+// Check the sparse Jacobian against the reference. Entries outside the
+// pattern are implicitly zero, so this also checks the pattern.
+int checkJacobian(const Model& model, const State& state,
+                  bool independentSubtrees) {
+    const int n = state.getNQ() + state.getNU();
+    Array_<int> colStart, rowIndex;
+    Array_<Real> value;
+    model.matter.calcODEJacobian(state, independentSubtrees,
+                                 colStart, rowIndex, value);
+    SimTK_TEST((int)colStart.size() == n+1);
+    SimTK_TEST(colStart[n] == (int)rowIndex.size());
+    for (int j=0; j < n; ++j)
+        for (int e=colStart[j]+1; e < colStart[j+1]; ++e)
+            SimTK_TEST(rowIndex[e-1] < rowIndex[e]);
+
+    const Matrix J = expandSparse(n, colStart, rowIndex, value);
+    const Matrix Jref = calcReferenceJacobian(model, state);
+    SimTK_TEST_EQ_TOL(J, Jref, 1e-5);
+    return (int)rowIndex.size();
+}
+
+}
+
+void testIndependentSubtrees() {
+    Model model;
+    State state = model.system.realizeTopology();
+    model.setState(state);
+    const int nq = state.getNQ(), nu = state.getNU(), n = nq+nu;
+
+    const int nnzSparse = checkJacobian(model, state, true);
+    const int nnzCoupled = checkJacobian(model, state, false);
+    SimTK_TEST(nnzSparse < nnzCoupled);
+    SimTK_TEST(nnzCoupled < n*n); // qdot rows are always sparse
+
+    // A udot in chain A must not be listed as depending on chain B.
+    Array_<int> colStart, rowIndex;
+    Array_<Real> value;
+    model.matter.calcODEJacobian(state, true, colStart, rowIndex, value);
+    const int uA = model.chainA[0].getFirstUIndex(state);
+    const int jB = nq + model.chainB[0].getFirstUIndex(state);
+    for (int e=colStart[jB]; e < colStart[jB+1]; ++e)
+        SimTK_TEST(rowIndex[e] < nq || rowIndex[e] >= nq+uA+3);
+}
+
+void testConstraintCoupling() {
+    // A rod between the ends of the two chains couples them even when
+    // independentSubtrees is set.
+    Model model;
+    Constraint::Rod(model.chainA.back(), Vec3(0,-0.5,0),
+                    model.chainB.back(), Vec3(0,-0.5,0), 2);
+    State state = model.system.realizeTopology();
+    model.setState(state);
+    model.system.project(state, 1e-10);
+    model.system.realize(state, Stage::Acceleration);
+    checkJacobian(model, state, true);
+}
+
+void testJacobianTimesVector() {
+    Model model;
+    State state = model.system.realizeTopology();
+    model.setState(state);
+    const int n = state.getNQ() + state.getNU();
+
+    Array_<int> colStart, rowIndex;
+    Array_<Real> value;
+    model.matter.calcODEJacobian(state, true, colStart, rowIndex, value);
+    const Matrix J = expandSparse(n, colStart, rowIndex, value);
+
+    Random::Gaussian rand; rand.setSeed(5);
+    Vector v(n);
+    for (int i=0; i < n; ++i) v[i] = rand.getValue();
+    Vector Jv;
+    model.matter.calcODEJacobianTimesVector(state, v, Jv);
+    SimTK_TEST_EQ_TOL(Jv, J*v, 1e-5);
+
+    model.matter.calcODEJacobianTimesVector(state, Vector(n, Real(0)), Jv);
+    SimTK_TEST(Jv.size() == n && Jv.normInf() == 0);
+
+    SimTK_TEST_MUST_THROW(
+        model.matter.calcODEJacobianTimesVector(state, Vector(n+1), Jv));
+}
+
+int main() {
+    SimTK_START_TEST("TestODEJacobian");
+        SimTK_SUBTEST(testIndependentSubtrees);
+        SimTK_SUBTEST(testConstraintCoupling);
+        SimTK_SUBTEST(testJacobianTimesVector);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,156 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that parallel evaluation of compliant contact forces produces the
+// same ContactForce objects as the serial calculation, and body forces that
+// agree with the serial ones and are exactly reproducible.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+using namespace SimTK;
+
+namespace {
+
+const int NumBodies = 24;
+
+void buildSystem(MultibodySystem& system, SimbodyMatterSubsystem& matter,
+                 CompliantContactSubsystem& contact, bool useParallel) {
+    const ContactMaterial material(1e6, 0.1, 0.8, 0.5, 0.1);
+    matter.Ground().updBody().addContactSurface(
+        Transform(Rotation(-Pi/2, ZAxis)), // half space is y < 0
+        ContactSurface(ContactGeometry::HalfSpace(), material));
+
+    const PolygonalMesh brick = PolygonalMesh::createBrickMesh(Vec3(0.1), 2);
+    for (int i=0; i < NumBodies; ++i) {
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        if (i % 3 == 0)
+            body.addContactSurface(Transform(),
+                ContactSurface(ContactGeometry::Sphere(0.1), material));
+        else
+            body.addContactSurface(Transform(),
+                ContactSurface(ContactGeometry::TriangleMesh(brick),
+                               material, 0.05));
+        MobilizedBody::Free(matter.Ground(), body);
+    }
+
+    if (useParallel) {
+        contact.setUseParallelForces(true);
+        contact.setNumberOfThreads(3);
+    }
+    system.realizeTopology();
+}
+
+// Bodies sit in a row, sunk a little into the ground and into each other,
+// tilted and moving a bit so that friction and dissipation are involved.
+void setState(int config, State& state) {
+    Random::Uniform rand(-1, 1); rand.setSeed(config+1);
+    for (int i=0; i < NumBodies; ++i) {
+        const Vec3 p(0.19*i, 0.08 + 0.02*rand.getValue(), 0.01*rand.getValue());
+        const Rotation R(BodyRotationSequence, 0.1*rand.getValue(), XAxis,
+                                               0.1*rand.getValue(), ZAxis);
+        Vector& q = state.updQ();
+        const Vec4 quat = R.convertRotationToQuaternion().asVec4();
+        for (int k=0; k < 4; ++k) q[7*i+k] = quat[k];
+        for (int k=0; k < 3; ++k) q[7*i+4+k] = p[k];
+        for (int k=0; k < 6; ++k) state.updU()[6*i+k] = 0.3*rand.getValue();
+    }
+}
+
+}
+
+void testSameForces() {
+    MultibodySystem serialSystem, parallelSystem;
+    SimbodyMatterSubsystem serialMatter(serialSystem),
+                           parallelMatter(parallelSystem);
+    ContactTrackerSubsystem serialTracker(serialSystem),
+                            parallelTracker(parallelSystem);
+    CompliantContactSubsystem serialContact(serialSystem, serialTracker),
+                              parallelContact(parallelSystem, parallelTracker);
+    buildSystem(serialSystem, serialMatter, serialContact, false);
+    buildSystem(parallelSystem, parallelMatter, parallelContact, true);
+
+    SimTK_TEST(!serialContact.getUseParallelForces());
+    SimTK_TEST(parallelContact.getUseParallelForces());
+    SimTK_TEST(parallelContact.getNumberOfThreads() == 3);
+    SimTK_TEST_MUST_THROW(parallelContact.setNumberOfThreads(0));
+
+    int numForces = 0;
+    for (int config=0; config < 10; ++config) {
+        State serialState = serialSystem.getDefaultState();
+        State parallelState = parallelSystem.getDefaultState();
+        setState(config, serialState);
+        setState(config, parallelState);
+
+        // Potential energy can be calculated at Position stage, without
+        // the forces.
+        serialSystem.realize(serialState, Stage::Position);
+        parallelSystem.realize(parallelState, Stage::Position);
+        const Real pe = serialSystem.calcPotentialEnergy(serialState);
+        SimTK_TEST(pe > 0);
+        SimTK_TEST(parallelSystem.calcPotentialEnergy(parallelState) == pe);
+
+        serialSystem.realize(serialState, Stage::Dynamics);
+        parallelSystem.realize(parallelState, Stage::Dynamics);
+
+        const int n = serialContact.getNumContactForces(serialState);
+        SimTK_TEST(parallelContact.getNumContactForces(parallelState) == n);
+        for (int i=0; i < n; ++i) {
+            const ContactForce& s =
+                serialContact.getContactForce(serialState, i);
+            const ContactForce& p =
+                parallelContact.getContactForce(parallelState, i);
+            SimTK_TEST(p.getContactPoint() == s.getContactPoint());
+            SimTK_TEST(p.getForceOnSurface2()[0] == s.getForceOnSurface2()[0]);
+            SimTK_TEST(p.getForceOnSurface2()[1] == s.getForceOnSurface2()[1]);
+            SimTK_TEST(p.getPotentialEnergy() == s.getPotentialEnergy());
+            SimTK_TEST(p.getPowerDissipation() == s.getPowerDissipation());
+        }
+        numForces += n;
+
+        const Vector_<SpatialVec>& serialForces =
+            serialSystem.getRigidBodyForces(serialState, Stage::Dynamics);
+        const Vector_<SpatialVec>& parallelForces =
+            parallelSystem.getRigidBodyForces(parallelState, Stage::Dynamics);
+        SimTK_TEST_EQ(parallelForces, serialForces);
+
+        // Doing it again must give exactly the same answer.
+        State again = parallelSystem.getDefaultState();
+        setState(config, again);
+        parallelSystem.realize(again, Stage::Dynamics);
+        const Vector_<SpatialVec>& againForces =
+            parallelSystem.getRigidBodyForces(again, Stage::Dynamics);
+        for (int b=0; b < againForces.size(); ++b) {
+            SimTK_TEST(againForces[b][0] == parallelForces[b][0]);
+            SimTK_TEST(againForces[b][1] == parallelForces[b][1]);
+        }
+    }
+    // Make sure this was a real test.
+    SimTK_TEST(numForces > 100);
+}
+
+int main() {
+    SimTK_START_TEST("TestParallelContactForces");
+        SimTK_SUBTEST(testSameForces);
+    SimTK_END_TEST();
+}
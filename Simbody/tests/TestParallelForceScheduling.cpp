@@ -0,0 +1,264 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that GeneralForceSubsystem produces the same forces whether its
+// custom forces are evaluated serially or scheduled among several threads,
+// including forces that report the bodies they affect (and so use sparse
+// accumulation), forces that don't, and position-only forces that go through
+// the subsystem's force cache.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+using namespace SimTK;
+
+namespace {
+
+const int NumBodies = 30;
+
+// A position-only spring between the origins of two bodies, which says which
+// bodies it affects.
+class LinkSpring : public Force::Custom::Implementation {
+public:
+    LinkSpring(const MobilizedBody& b1, const MobilizedBody& b2,
+               bool parallel)
+    :   b1(b1), b2(b2), parallel(parallel) {}
+    void calcForce(const State& state, Vector_<SpatialVec>& bodyForces,
+                   Vector_<Vec3>&, Vector&) const override {
+        const Vec3 d = b2.getBodyOriginLocation(state)
+                     - b1.getBodyOriginLocation(state);
+        const Vec3 f = 10*(d.norm() - 0.5)*d.normalize();
+        b1.applyBodyForce(state, SpatialVec(Vec3(0), f), bodyForces);
+        b2.applyBodyForce(state, SpatialVec(Vec3(0), -f), bodyForces);
+    }
+    Real calcPotentialEnergy(const State& state) const override {
+        const Real x = (b2.getBodyOriginLocation(state)
+                        - b1.getBodyOriginLocation(state)).norm() - 0.5;
+        return 5*x*x;
+    }
+    bool dependsOnlyOnPositions() const override {return true;}
+    bool shouldBeParallelIfPossible() const override {return parallel;}
+    bool getBodiesAffected(Array_<MobilizedBodyIndex>& bodies) const override {
+        bodies.push_back(b1.getMobilizedBodyIndex());
+        bodies.push_back(b2.getMobilizedBodyIndex());
+        return true;
+    }
+private:
+    const MobilizedBody& b1;
+    const MobilizedBody& b2;
+    bool                 parallel;
+};
+
+// Velocity-dependent drag on every mobility and on every body; doesn't
+// report what it affects.
+class Drag : public Force::Custom::Implementation {
+public:
+    Drag(const SimbodyMatterSubsystem& matter, Real c, bool parallel)
+    :   matter(matter), c(c), parallel(parallel) {}
+    void calcForce(const State& state, Vector_<SpatialVec>& bodyForces,
+                   Vector_<Vec3>&, Vector& mobilityForces) const override {
+        mobilityForces -= c*state.getU();
+        for (MobilizedBodyIndex mbx(1); mbx < matter.getNumBodies(); ++mbx) {
+            const MobilizedBody& mobod = matter.getMobilizedBody(mbx);
+            mobod.applyBodyForce(state,
+                SpatialVec(Vec3(0), -c*mobod.getBodyOriginVelocity(state)),
+                bodyForces);
+        }
+    }
+    Real calcPotentialEnergy(const State&) const override {return 0;}
+    bool shouldBeParallelIfPossible() const override {return parallel;}
+private:
+    const SimbodyMatterSubsystem& matter;
+    Real                          c;
+    bool                          parallel;
+};
+
+// A force that fails.
+class Broken : public Force::Custom::Implementation {
+public:
+    void calcForce(const State&, Vector_<SpatialVec>&,
+                   Vector_<Vec3>&, Vector&) const override {
+        SimTK_ERRCHK_ALWAYS(false, "Broken::calcForce()", "Broken force.");
+    }
+    Real calcPotentialEnergy(const State&) const override {return 0;}
+    bool shouldBeParallelIfPossible() const override {return true;}
+};
+
+struct Model {
+    Model(bool parallel) : matter(system), forces(system) {
+        Force::Gravity(forces, matter, -YAxis, 9.8);
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        for (int i=0; i < NumBodies; ++i)
+            bodies.push_back(MobilizedBody::Translation(matter.Ground(),
+                                 Vec3(0.5*i, 0, 0), body, Vec3(0)));
+        for (int i=0; i+1 < NumBodies; ++i)
+            Force::Custom(forces,
+                          new LinkSpring(bodies[i], bodies[i+1], parallel));
+        // A built-in position-only force, which is never parallel.
+        Force::TwoPointLinearSpring(forces, bodies[0], Vec3(0),
+                                    bodies.back(), Vec3(0), 3, 1);
+        for (int i=0; i < 3; ++i)
+            drag.push_back(Force::Custom(forces,
+                                         new Drag(matter, 0.1*(i+1), parallel)));
+        if (parallel) forces.setNumberOfThreads(3);
+        system.realizeTopology();
+    }
+
+    MultibodySystem             system;
+    SimbodyMatterSubsystem      matter;
+    GeneralForceSubsystem       forces;
+    Array_<MobilizedBody>       bodies;
+    Array_<Force::Custom>       drag;
+};
+
+void setState(int config, State& state) {
+    Random::Uniform rand(-0.2, 0.2); rand.setSeed(config+1);
+    for (int i=0; i < state.getNQ(); ++i) {
+        state.updQ()[i] = rand.getValue();
+        state.updU()[i] = rand.getValue();
+    }
+}
+
+void compareForces(const Model& serial, const State& serialState,
+                   const Model& parallel, const State& parallelState) {
+    serial.system.realize(serialState, Stage::Dynamics);
+    parallel.system.realize(parallelState, Stage::Dynamics);
+    SimTK_TEST_EQ(
+        parallel.system.getRigidBodyForces(parallelState, Stage::Dynamics),
+        serial.system.getRigidBodyForces(serialState, Stage::Dynamics));
+    SimTK_TEST_EQ(
+        parallel.system.getMobilityForces(parallelState, Stage::Dynamics),
+        serial.system.getMobilityForces(serialState, Stage::Dynamics));
+}
+
+}
+
+void testSameForces() {
+    Model serial(false), parallel(true);
+    SimTK_TEST(parallel.forces.getNumberOfThreads() == 3);
+
+    State serialState = serial.system.getDefaultState();
+    State parallelState = parallel.system.getDefaultState();
+    for (int config=0; config < 10; ++config) {
+        setState(config, serialState);
+        setState(config, parallelState);
+        compareForces(serial, serialState, parallel, parallelState);
+
+        // Changing only velocities reuses the cached position-only forces.
+        serialState.updU() *= 2;
+        parallelState.updU() *= 2;
+        compareForces(serial, serialState, parallel, parallelState);
+
+        // Make sure nothing is left over in the threads' accumulators.
+        serialState.updU() = 0;
+        parallelState.updU() = 0;
+        compareForces(serial, serialState, parallel, parallelState);
+    }
+
+    // Disabling some of the forces changes the work items.
+    serial.drag[1].disable(serialState);
+    parallel.drag[1].disable(parallelState);
+    setState(11, serialState);
+    setState(11, parallelState);
+    compareForces(serial, serialState, parallel, parallelState);
+
+    // A copied State carries its measured costs and scratch space along.
+    State copy = parallelState;
+    setState(12, copy);
+    setState(12, serialState);
+    compareForces(serial, serialState, parallel, copy);
+}
+
+// The forces must be summed in the same order however many threads there are
+// and however the measured costs turn out, so repeated evaluations are
+// bitwise identical. With one thread every force goes straight into the
+// System's arrays in ForceIndex order, as it does with no parallel forces.
+void testReproducibleSums() {
+    Model serial(false), parallel(true);
+    State serialState = serial.system.getDefaultState();
+    State state = parallel.system.getDefaultState();
+    setState(3, state);
+    parallel.system.realize(state, Stage::Dynamics);
+    const Vector_<SpatialVec> reference =
+        parallel.system.getRigidBodyForces(state, Stage::Dynamics);
+    const Vector mobilityReference =
+        parallel.system.getMobilityForces(state, Stage::Dynamics);
+
+    for (int nThreads=2; nThreads <= 5; ++nThreads) {
+        parallel.forces.setNumberOfThreads(nThreads);
+        for (int rep=0; rep < 5; ++rep) {
+            setState(3, state);
+            parallel.system.realize(state, Stage::Dynamics);
+            const Vector_<SpatialVec>& F =
+                parallel.system.getRigidBodyForces(state, Stage::Dynamics);
+            const Vector& M =
+                parallel.system.getMobilityForces(state, Stage::Dynamics);
+            for (int i=0; i < F.size(); ++i)
+                SimTK_TEST(F[i] == reference[i]);
+            for (int i=0; i < M.size(); ++i)
+                SimTK_TEST(M[i] == mobilityReference[i]);
+        }
+    }
+
+    parallel.forces.setNumberOfThreads(1);
+    setState(3, state);
+    setState(3, serialState);
+    parallel.system.realize(state, Stage::Dynamics);
+    serial.system.realize(serialState, Stage::Dynamics);
+    const Vector_<SpatialVec>& F =
+        parallel.system.getRigidBodyForces(state, Stage::Dynamics);
+    const Vector_<SpatialVec>& Fserial =
+        serial.system.getRigidBodyForces(serialState, Stage::Dynamics);
+    for (int i=0; i < F.size(); ++i)
+        SimTK_TEST(F[i] == Fserial[i]);
+}
+
+void testExceptionFromParallelForce() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    MobilizedBody::Translation(matter.Ground(),
+        Body::Rigid(MassProperties(1, Vec3(0), UnitInertia(1))));
+    for (int i=0; i < 4; ++i)
+        Force::Custom(forces, new Drag(matter, 1, true));
+    Force::Custom broken(forces, new Broken());
+    forces.setNumberOfThreads(3);
+    system.realizeTopology();
+    State state = system.getDefaultState();
+    for (int i=0; i < state.getNU(); ++i) state.updU()[i] = i+1;
+    SimTK_TEST_MUST_THROW(system.realize(state, Stage::Dynamics));
+
+    // Nothing from the failed evaluation may leak into the next one.
+    broken.disable(state);
+    system.realize(state, Stage::Dynamics);
+    SimTK_TEST_EQ(system.getMobilityForces(state, Stage::Dynamics),
+                  -4*state.getU());
+}
+
+int main() {
+    SimTK_START_TEST("TestParallelForceScheduling");
+        SimTK_SUBTEST(testSameForces);
+        SimTK_SUBTEST(testReproducibleSums);
+        SimTK_SUBTEST(testExceptionFromParallelForce);
+    SimTK_END_TEST();
+}
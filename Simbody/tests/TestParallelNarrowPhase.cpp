@@ -0,0 +1,150 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that the parallel narrow phase in ContactTrackerSubsystem produces
+// exactly the same active contacts as the serial one, in the same order and
+// with the same conditions and consistently assigned ContactIds, as a mix of
+// spheres and meshes moves about over a half space.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+using namespace SimTK;
+
+namespace {
+
+const int NumBodies = 24;
+const int NumSteps  = 30;
+
+void buildSystem(MultibodySystem& system, SimbodyMatterSubsystem& matter,
+                 ContactTrackerSubsystem& tracker, bool useParallel) {
+    const ContactMaterial material(1e6, 0.1, 0.8, 0.5, 0.1);
+    matter.Ground().updBody().addContactSurface(
+        Transform(Rotation(-Pi/2, ZAxis)), // half space is y < 0
+        ContactSurface(ContactGeometry::HalfSpace(), material));
+
+    const PolygonalMesh brick = PolygonalMesh::createBrickMesh(Vec3(0.1), 2);
+    for (int i=0; i < NumBodies; ++i) {
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        if (i % 3 == 0)
+            body.addContactSurface(Transform(),
+                ContactSurface(ContactGeometry::Sphere(0.1), material));
+        else
+            body.addContactSurface(Transform(),
+                ContactSurface(ContactGeometry::TriangleMesh(brick), material));
+        MobilizedBody::Translation(matter.Ground(), body);
+    }
+
+    if (useParallel) {
+        tracker.setUseParallelNarrowPhase(true);
+        tracker.setNumberOfThreads(3);
+    }
+    system.realizeTopology();
+}
+
+// Bodies start in a tight row just above the ground, then sink and wander so
+// that contacts come and go and neighbors bump into one another.
+void setPositions(int step, State& state) {
+    Vector& q = state.updQ();
+    for (int i=0; i < NumBodies; ++i) {
+        const Real phase = 0.7*i + 0.3*step;
+        q[3*i]   = 0.17*i + 0.03*std::sin(phase);
+        q[3*i+1] = 0.08 + 0.05*std::cos(phase);
+        q[3*i+2] = 0.02*std::sin(2*phase);
+    }
+}
+
+void recordHistory(const MultibodySystem& system,
+                   const ContactTrackerSubsystem& tracker, State state,
+                   Array_<Array_<Contact> >& history) {
+    history.clear();
+    for (int step=0; step < NumSteps; ++step) {
+        setPositions(step, state);
+        system.realize(state, Stage::Position);
+        const ContactSnapshot& snapshot = tracker.getActiveContacts(state);
+        history.push_back();
+        for (int i=0; i < snapshot.getNumContacts(); ++i)
+            history.back().push_back(snapshot.getContact(i));
+        state.autoUpdateDiscreteVariables();
+    }
+}
+
+}
+
+void testSameContacts() {
+    MultibodySystem serialSystem, parallelSystem;
+    SimbodyMatterSubsystem serialMatter(serialSystem),
+                           parallelMatter(parallelSystem);
+    ContactTrackerSubsystem serialTracker(serialSystem),
+                            parallelTracker(parallelSystem);
+    buildSystem(serialSystem, serialMatter, serialTracker, false);
+    buildSystem(parallelSystem, parallelMatter, parallelTracker, true);
+
+    SimTK_TEST(!serialTracker.getUseParallelNarrowPhase());
+    SimTK_TEST(parallelTracker.getUseParallelNarrowPhase());
+    SimTK_TEST(parallelTracker.getNumberOfThreads() == 3);
+    SimTK_TEST_MUST_THROW(parallelTracker.setNumberOfThreads(0));
+
+    // ContactIds come from a global counter so run one system to completion
+    // before starting the other; then the ids should differ by a constant.
+    Array_<Array_<Contact> > serial, parallel;
+    recordHistory(serialSystem, serialTracker,
+                  serialSystem.getDefaultState(), serial);
+    recordHistory(parallelSystem, parallelTracker,
+                  parallelSystem.getDefaultState(), parallel);
+
+    int numContacts = 0, numMeshContacts = 0, numOngoing = 0;
+    const int offset = parallel[0].empty() ? 0
+        : parallel[0][0].getContactId() - serial[0][0].getContactId();
+    for (int step=0; step < NumSteps; ++step) {
+        const Array_<Contact>& s = serial[step];
+        const Array_<Contact>& p = parallel[step];
+        SimTK_TEST(s.size() == p.size());
+        if (s.size() != p.size()) continue;
+        for (unsigned i=0; i < s.size(); ++i) {
+            SimTK_TEST(p[i].getSurface1() == s[i].getSurface1());
+            SimTK_TEST(p[i].getSurface2() == s[i].getSurface2());
+            SimTK_TEST(p[i].getTypeId() == s[i].getTypeId());
+            SimTK_TEST(p[i].getCondition() == s[i].getCondition());
+            SimTK_TEST(p[i].getContactId() - s[i].getContactId() == offset);
+            SimTK_TEST(p[i].getTransform().p() == s[i].getTransform().p());
+            if (TriangleMeshContact::isInstance(s[i])) {
+                const TriangleMeshContact& sm = TriangleMeshContact::getAs(s[i]);
+                const TriangleMeshContact& pm = TriangleMeshContact::getAs(p[i]);
+                SimTK_TEST(pm.getSurface1Faces() == sm.getSurface1Faces());
+                SimTK_TEST(pm.getSurface2Faces() == sm.getSurface2Faces());
+                ++numMeshContacts;
+            }
+            if (s[i].getCondition() == Contact::Ongoing) ++numOngoing;
+            ++numContacts;
+        }
+    }
+    // Make sure this was a real test.
+    SimTK_TEST(numContacts > 100 && numMeshContacts > 50 && numOngoing > 50);
+}
+
+int main() {
+    SimTK_START_TEST("TestParallelNarrowPhase");
+        SimTK_SUBTEST(testSameContacts);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,186 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that the level-parallel tree sweeps produce results that are bitwise
+// identical to the ordinary serial sweeps. We use a wide, branching tree so
+// that every level is wide enough to be split among the worker threads.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using std::cout; using std::endl;
+
+namespace {
+
+const int NumLimbs = 60;
+
+// Build a tree with NumLimbs three-body limbs attached to a free-floating
+// torso, using a variety of mobilizers so that quaternions, angles and
+// prescribed-free mobilities all get exercised.
+void buildWideTree(SimbodyMatterSubsystem& matter,
+                   GeneralForceSubsystem& forces) {
+    Force::Gravity gravity(forces, matter, -YAxis, 9.81);
+
+    Body::Rigid body(MassProperties(1, Vec3(0.1,0.2,0.3),
+                                    UnitInertia(1.1,1.2,1.3,0.01,0.02,0.03)));
+    MobilizedBody::Free torso(matter.Ground(), body);
+    for (int i=0; i < NumLimbs; ++i) {
+        const Rotation R(i*Pi/NumLimbs, XAxis);
+        MobilizedBody::Ball upper(torso, Transform(R, Vec3(0.5,0,0)),
+                                  body, Vec3(0,1,0));
+        MobilizedBody::Pin middle(upper, Vec3(0,-0.5,0), body, Vec3(0,0.5,0));
+        MobilizedBody::Universal lower(middle, Vec3(0,-0.5,0),
+                                       body, Vec3(0,0.5,0));
+        Force::MobilityLinearSpring(forces, middle, 0, 10, 0.1);
+    }
+}
+
+bool isBitwiseEqual(const Vector& a, const Vector& b) {
+    if (a.size() != b.size()) return false;
+    for (int i=0; i < a.size(); ++i)
+        if (a[i] != b[i]) return false;
+    return true;
+}
+
+bool isBitwiseEqual(const Vector_<SpatialVec>& a, const Vector_<SpatialVec>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (int i=0; i < a.size(); ++i)
+        if (a[i] != b[i]) return false;
+    return true;
+}
+
+// Realize the given state to Acceleration and evaluate a collection of
+// operators, returning all the results concatenated for easy comparison.
+void evaluate(const MultibodySystem& system, State& state,
+              Vector& results, Vector_<SpatialVec>& bodyResults)
+{
+    const SimbodyMatterSubsystem& matter = system.getMatterSubsystem();
+    system.realize(state, Stage::Acceleration);
+    const int nu = state.getNU();
+
+    Vector f(nu), MInvf, Mf, residual;
+    for (int i=0; i < nu; ++i) f[i] = std::sin(i+1.);
+    matter.multiplyByMInv(state, f, MInvf);
+    matter.multiplyByM(state, f, Mf);
+    matter.calcResidualForceIgnoringConstraints(state, f,
+        Vector_<SpatialVec>(matter.getNumBodies(), SpatialVec(Vec3(0))),
+        MInvf, residual);
+
+    results.resize(0);
+    const Vector* pieces[] = {&state.getQErr(), &state.getQDot(),
+                              &state.getUDot(), &state.getQDotDot(),
+                              &MInvf, &Mf, &residual};
+    for (const Vector* v : pieces) {
+        const int n = results.size();
+        results.resizeKeep(n + v->size());
+        results(n, v->size()) = *v;
+    }
+
+    bodyResults.resize(3*matter.getNumBodies());
+    for (MobodIndex mbx(0); mbx < matter.getNumBodies(); ++mbx) {
+        const MobilizedBody& mobod = matter.getMobilizedBody(mbx);
+        const Transform& X_GB = mobod.getBodyTransform(state);
+        bodyResults[3*mbx]   = SpatialVec(X_GB.p(), X_GB.R().col(0));
+        bodyResults[3*mbx+1] = mobod.getBodyVelocity(state);
+        bodyResults[3*mbx+2] = mobod.getBodyAcceleration(state);
+    }
+}
+
+}
+
+void testMatchesSerial() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    buildWideTree(matter, forces);
+    system.realizeTopology();
+
+    State state = system.getDefaultState();
+    Random::Uniform uniform(-1, 1);
+    uniform.setSeed(42);
+    for (int i=0; i < state.getNQ(); ++i) state.updQ()[i] = uniform.getValue();
+    for (int i=0; i < state.getNU(); ++i) state.updU()[i] = uniform.getValue();
+
+    SimTK_TEST(!matter.getUseParallelTreeSweeps());
+    State serialState = state;
+    Vector serial; Vector_<SpatialVec> serialBodies;
+    evaluate(system, serialState, serial, serialBodies);
+
+    // Use more threads than there are likely to be cores so that the work
+    // really is divided up even on a small test machine.
+    matter.setUseParallelTreeSweeps(true);
+    matter.setNumberOfThreads(4);
+    SimTK_TEST(matter.getUseParallelTreeSweeps());
+    SimTK_TEST(matter.getNumberOfThreads() == 4);
+
+    for (int trial=0; trial < 3; ++trial) {
+        State parallelState = state;
+        Vector parallel; Vector_<SpatialVec> parallelBodies;
+        evaluate(system, parallelState, parallel, parallelBodies);
+        SimTK_TEST(isBitwiseEqual(serial, parallel));
+        SimTK_TEST(isBitwiseEqual(serialBodies, parallelBodies));
+    }
+
+    matter.setUseParallelTreeSweeps(false);
+    State againState = state;
+    Vector again; Vector_<SpatialVec> againBodies;
+    evaluate(system, againState, again, againBodies);
+    SimTK_TEST(isBitwiseEqual(serial, again));
+}
+
+// A simulation run with parallel sweeps should follow exactly the same
+// trajectory as the serial one.
+void testSimulationMatchesSerial() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    buildWideTree(matter, forces);
+    system.realizeTopology();
+
+    State initState = system.getDefaultState();
+    initState.updU()[0] = 0.5;
+
+    Vector finalQ[2];
+    for (int pass=0; pass < 2; ++pass) {
+        matter.setUseParallelTreeSweeps(pass == 1);
+        matter.setNumberOfThreads(3);
+        RungeKuttaMersonIntegrator integ(system);
+        integ.setAccuracy(1e-4);
+        TimeStepper ts(system, integ);
+        ts.initialize(initState);
+        ts.stepTo(0.05);
+        finalQ[pass] = integ.getState().getQ();
+    }
+    SimTK_TEST(isBitwiseEqual(finalQ[0], finalQ[1]));
+}
+
+int main() {
+    SimTK_START_TEST("TestParallelTreeSweeps");
+        SimTK_SUBTEST(testMatchesSerial);
+        SimTK_SUBTEST(testSimulationMatchesSerial);
+    SimTK_END_TEST();
+}
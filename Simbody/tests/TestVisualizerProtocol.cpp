@@ -0,0 +1,325 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check the parts of the simulator-to-GUI protocol that don't need a running
+// simbody-visualizer: the shared memory ring buffer used to send scenes, and
+// the encoding of scene elements that are unchanged from the previous scene.
+
+#include "SimTKsimbody.h"
+#include "SimTKcommon/Testing.h"
+#include "../Visualizer/src/VisualizerProtocol.h"
+
+#include <thread>
+
+using namespace SimTK;
+
+namespace {
+
+// A ring buffer with a small data area, as it would be laid out in shared
+// memory.
+class TestRing {
+public:
+    explicit TestRing(unsigned capacity) 
+    :   memory(sizeof(SharedSceneBuffer) + capacity) {
+        ring = new (memory.data()) SharedSceneBuffer;
+        ring->capacity = capacity;
+        ring->writePos = 0;
+        ring->readPos = 0;
+        ring->notifyPending = 0;
+    }
+    ~TestRing() {ring->~SharedSceneBuffer();}
+    SharedSceneBuffer& upd() {return *ring;}
+private:
+    std::vector<std::max_align_t> memory; // suitably aligned
+    SharedSceneBuffer* ring;
+};
+
+// A fake scene of the given size, preceded by its size as the simulator
+// sends it.
+std::vector<unsigned char> makeScene(unsigned sceneBytes, unsigned char seed) {
+    std::vector<unsigned char> data(sizeof(unsigned) + sceneBytes);
+    memcpy(data.data(), &sceneBytes, sizeof(unsigned));
+    for (unsigned i=0; i < sceneBytes; ++i)
+        data[sizeof(unsigned)+i] = (unsigned char)(seed + 7*i);
+    return data;
+}
+
+
+typedef std::vector<unsigned char> Record;
+
+// A scene element record with the given command and arbitrary contents 
+// chosen by seed. Text records get textLength characters.
+Record makeRecord(unsigned char command, unsigned char seed, 
+                  short textLength=0) {
+    std::size_t nBytes = 0;
+    switch (command) {
+    case AddSolidMesh:
+    case AddPointMesh:
+    case AddWireframeMesh:  nBytes = MeshRecordBytes; break;
+    case AddLine:           nBytes = LineRecordBytes; break;
+    case AddCoords:         nBytes = CoordsRecordBytes; break;
+    case AddText:           nBytes = TextRecordHeaderBytes + textLength; break;
+    }
+    Record record(nBytes);
+    for (std::size_t i=0; i < nBytes; ++i)
+        record[i] = (unsigned char)(seed + 11*i);
+    record[0] = command;
+    if (command == AddText)
+        memcpy(&record[TextRecordHeaderBytes - sizeof(short)], &textLength,
+               sizeof(short));
+    return record;
+}
+
+// Send a scene of the given records through the encoder, with a mesh 
+// definition in the middle of it.
+const std::vector<unsigned char>& 
+encodeScene(SceneEncoder& encoder, const std::vector<Record>& records) {
+    encoder.beginScene(1.5f);
+    for (std::size_t i=0; i < records.size(); ++i) {
+        if (i == records.size()/2) {
+            const unsigned short counts[] = {1, 0}; // vertices, faces
+            const float vertex[] = {1, 2, 3};
+            encoder.append(&DefineMesh, 1);
+            encoder.append(counts, sizeof(counts));
+            encoder.append(vertex, sizeof(vertex));
+        }
+        encoder.appendRecord(records[i].data(), (unsigned)records[i].size());
+    }
+    return encoder.finishScene();
+}
+
+// Parse a scene the way simbody-visualizer does and return the element 
+// records it contains. Also report how many of them were sent in full 
+// rather than repeated from the previous scene.
+std::vector<Record> decodeScene(const std::vector<unsigned char>& data, 
+                                SceneRecords& sceneRecords, int& numSent) {
+    unsigned sceneBytes;
+    memcpy(&sceneBytes, &data[1], sizeof(unsigned));
+    SimTK_TEST(data[0] == StartOfScene);
+    SimTK_TEST(sceneBytes == data.size() - (1 + sizeof(unsigned)));
+
+    std::size_t pos = 1 + sizeof(unsigned) + sizeof(float); // skip time
+    numSent = 0;
+    sceneRecords.beginScene();
+    bool finished = false;
+    while (!finished) {
+        SimTK_TEST(pos < data.size());
+        const unsigned char command = data[pos++];
+        switch (command) {
+        case EndOfScene:
+            finished = true;
+            break;
+        case RepeatRecords: {
+            unsigned short count;
+            memcpy(&count, &data[pos], sizeof(short));
+            pos += sizeof(short);
+            SimTK_TEST(sceneRecords.repeat(count));
+            break;
+        }
+        case DefineMesh: {
+            unsigned short counts[2];
+            memcpy(counts, &data[pos], sizeof(counts));
+            pos += sizeof(counts) + 3*counts[0]*sizeof(float) 
+                                  + 3*counts[1]*sizeof(short);
+            break;
+        }
+        default: {
+            const std::size_t nBytes = 
+                getSceneRecordBytes(&data[pos-1], data.size() - (pos-1));
+            SimTK_TEST(nBytes > 0);
+            sceneRecords.add(&data[pos-1], nBytes);
+            pos += nBytes - 1;
+            ++numSent;
+        }
+        }
+    }
+    SimTK_TEST(pos == data.size());
+
+    std::vector<Record> records;
+    for (int i=0; i < sceneRecords.getNumRecords(); ++i)
+        records.push_back(Record(sceneRecords.getRecord(i), 
+                                 sceneRecords.getRecord(i) 
+                                    + sceneRecords.getRecordBytes(i)));
+    sceneRecords.endScene();
+    return records;
+}
+
+}
+
+// Every kind of scene element must come out exactly as drawn, whether it was
+// sent in full or repeated from the previous scene, and only the elements
+// that changed should be sent.
+void testSceneRecordsRoundTrip() {
+    SceneEncoder encoder;
+    SceneRecords decoded;
+    int numSent;
+
+    std::vector<Record> scene;
+    scene.push_back(makeRecord(AddSolidMesh, 1));
+    scene.push_back(makeRecord(AddLine, 2));
+    scene.push_back(makeRecord(AddText, 3, 5));
+    scene.push_back(makeRecord(AddCoords, 4));
+    scene.push_back(makeRecord(AddWireframeMesh, 5));
+    scene.push_back(makeRecord(AddText, 6, 0));
+
+    // Nothing to repeat in the first scene.
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent) 
+               == scene);
+    SimTK_TEST(numSent == 6);
+    encoder.sceneWasSent();
+
+    // An unchanged scene is just the time, one repeat, and the mesh 
+    // definition.
+    const std::vector<unsigned char>& same = encodeScene(encoder, scene);
+    SimTK_TEST(decodeScene(same, decoded, numSent) == scene);
+    SimTK_TEST(numSent == 0);
+    SimTK_TEST(same.size() == 1 + sizeof(unsigned) + sizeof(float) 
+                              + 2*(1 + sizeof(short)) + 1 
+                              + 2*sizeof(short) + 3*sizeof(float) + 1);
+    encoder.sceneWasSent();
+
+    // Change a line, a frame, and the length of some text, and add
+    // elements beyond the end of the previous scene.
+    scene[1] = makeRecord(AddLine, 20);
+    scene[3] = makeRecord(AddCoords, 40);
+    scene[5] = makeRecord(AddText, 6, 7);
+    scene.push_back(makeRecord(AddPointMesh, 7));
+    scene.push_back(makeRecord(AddText, 8, 3));
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent)
+               == scene);
+    SimTK_TEST(numSent == 5);
+    encoder.sceneWasSent();
+
+    // A scene the GUI never gets must not be the basis for the next one.
+    std::vector<Record> dropped(scene);
+    dropped[0] = makeRecord(AddSolidMesh, 10);
+    dropped[2] = makeRecord(AddText, 30, 5);
+    encodeScene(encoder, dropped);
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent)
+               == scene);
+    SimTK_TEST(numSent == 0);
+    encoder.sceneWasSent();
+
+    // Fewer elements than before.
+    scene.resize(3);
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent)
+               == scene);
+    SimTK_TEST(numSent == 0);
+}
+
+// A run of unchanged elements longer than a RepeatRecords command can count
+// must be split.
+void testLongRunsOfRepeats() {
+    SceneEncoder encoder;
+    SceneRecords decoded;
+    int numSent;
+
+    std::vector<Record> scene;
+    for (int i=0; i < 70000; ++i)
+        scene.push_back(makeRecord(i%3 ? AddLine : AddCoords, 
+                                   (unsigned char)i));
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent)
+               == scene);
+    encoder.sceneWasSent();
+    SimTK_TEST(decodeScene(encodeScene(encoder, scene), decoded, numSent)
+               == scene);
+    SimTK_TEST(numSent == 0);
+}
+
+// Scenes must come out exactly as they went in, including those that wrap
+// around the end of the data area, and a scene that doesn't fit must be
+// refused without disturbing the ones already there.
+void testRingBufferRoundTrip() {
+    TestRing storage(64);
+    SharedSceneBuffer& ring = storage.upd();
+    std::vector<unsigned char> scene;
+    for (unsigned char n=0; n < 50; ++n) {
+        const unsigned sceneBytes = 1 + (13*n) % 40;
+        const std::vector<unsigned char> data = makeScene(sceneBytes, n);
+        SimTK_TEST(ring.write(data.data(), (unsigned)data.size()));
+        ring.readScene(scene);
+        SimTK_TEST(scene.size() == sceneBytes);
+        SimTK_TEST(std::equal(scene.begin(), scene.end(), 
+                              data.begin() + sizeof(unsigned)));
+        SimTK_TEST(ring.readPos.load() == ring.writePos.load());
+    }
+
+    const std::vector<unsigned char> a = makeScene(20, 1), b = makeScene(20, 2),
+                                     c = makeScene(30, 3);
+    SimTK_TEST(ring.write(a.data(), (unsigned)a.size()));
+    SimTK_TEST(ring.write(b.data(), (unsigned)b.size()));
+    const unsigned writePos = ring.writePos.load();
+    SimTK_TEST(!ring.write(c.data(), (unsigned)c.size())); // no room
+    SimTK_TEST(ring.writePos.load() == writePos);
+    ring.readScene(scene);
+    SimTK_TEST(std::equal(scene.begin(), scene.end(), a.begin()+sizeof(unsigned)));
+    SimTK_TEST(ring.write(c.data(), (unsigned)c.size())); // room now
+    ring.readScene(scene);
+    SimTK_TEST(std::equal(scene.begin(), scene.end(), b.begin()+sizeof(unsigned)));
+    ring.readScene(scene);
+    SimTK_TEST(std::equal(scene.begin(), scene.end(), c.begin()+sizeof(unsigned)));
+}
+
+// Waiting for the GUI to read the buffer must end: when the GUI has read 
+// everything, when it has disconnected, or when it stops making progress.
+void testRingBufferWaitIsBounded() {
+    TestRing storage(256);
+    SharedSceneBuffer& ring = storage.upd();
+    std::atomic<bool> disconnected(false);
+
+    SimTK_TEST(ring.waitUntilRead(disconnected, 10)); // nothing to read
+
+    const std::vector<unsigned char> data = makeScene(20, 0);
+    for (int i=0; i < 5; ++i)
+        SimTK_TEST(ring.write(data.data(), (unsigned)data.size()));
+
+    // No reader at all.
+    const double start = realTime();
+    SimTK_TEST(!ring.waitUntilRead(disconnected, 0.05));
+    SimTK_TEST(realTime() - start < 5);
+
+    disconnected = true;
+    SimTK_TEST(!ring.waitUntilRead(disconnected, 10));
+    disconnected = false;
+
+    // A slow reader that keeps making progress is waited for.
+    std::thread reader([&ring]() {
+        std::vector<unsigned char> scene;
+        for (int i=0; i < 5; ++i) {
+            sleepInSec(0.01);
+            ring.readScene(scene);
+        }
+    });
+    SimTK_TEST(ring.waitUntilRead(disconnected, 1));
+    reader.join();
+    SimTK_TEST(ring.readPos.load() == ring.writePos.load());
+}
+
+int main() {
+    SimTK_START_TEST("TestVisualizerProtocol");
+        SimTK_SUBTEST(testRingBufferRoundTrip);
+        SimTK_SUBTEST(testRingBufferWaitIsBounded);
+        SimTK_SUBTEST(testSceneRecordsRoundTrip);
+        SimTK_SUBTEST(testLongRunsOfRepeats);
+    SimTK_END_TEST();
+}